@@ -0,0 +1,414 @@
+// agent_rpc.h
+// Wire protocol between a coordinator and `fairness_benchmark agent` on another host.
+//
+// A tenant section with `host = ADDR[:PORT]` runs on that host's agent. The
+// coordinator forks one proxy per remote tenant; the proxy stands in for the
+// tenant at the local start barrier and talks to the agent over one TCP
+// connection, in order:
+//
+//   HELLO  ->  version, token    <- HELLO_ACK   version, hostname, clock sync status
+//                                               (or DONE with an error for a wrong token)
+//   PING   -> (kClockProbes x)   <- PONG        agent CLOCK_REALTIME at receipt
+//   PLAN   ->                                   [agent] run settings + the tenant's section
+//                                <- READY       engine prepared, waiting for its start
+//   START  ->  epoch on the agent's CLOCK_REALTIME (or CANCEL)
+//                                <- FILE ...    every result file, relative path + content
+//                                <- DONE        status=0 on success
+//
+// Start epochs are exchanged in wall-clock time, the one clock two hosts can
+// share. The probes measure the offset between the hosts' realtime clocks
+// NTP-style (the probe with the lowest round trip wins), so the epoch is
+// corrected even when the clocks are not disciplined. Both sides report what
+// the kernel knows about their clock discipline (adjtimex: unsynchronized
+// flag, estimated and maximum error); with chrony or PTP in sync, the
+// measured offset should stay within the error estimates.
+//
+// The agent runs as root and acts on the plans it gets, so it listens on
+// loopback unless --listen names an address, and every session must present
+// the shared token (--agent-token / --agent-token-file) in its HELLO. The
+// token travels in clear: on untrusted networks, tunnel the port (ssh -L).
+//
+// Frames: FrameHeader (magic "FBRP", op, payload length), then the payload.
+// Text payloads are key=value lines.
+
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/timex.h>
+#include <unistd.h>
+
+namespace rpc {
+
+constexpr uint16_t kDefaultPort = 7470;
+constexpr const char* kDefaultListen = "127.0.0.1:7470";
+constexpr uint32_t kVersion = 1;
+constexpr int kClockProbes = 8;
+constexpr uint64_t kMaxTextBytes = 1ULL << 20;   // Plans and status lines
+constexpr uint64_t kMaxFileBytes = 16ULL << 30;  // One result file (latency logs can be large)
+
+enum class Op : uint32_t { Hello = 1, HelloAck, Ping, Pong, Plan, Ready, Start, Cancel, File, Done };
+
+#pragma pack(push, 1)
+struct FrameHeader {
+    char magic[4];
+    uint32_t op;      // Op
+    uint64_t length;  // Payload bytes after the header
+};
+#pragma pack(pop)
+
+inline bool write_all(int fd, const void* data, size_t n) {
+    const char* p = static_cast<const char*>(data);
+    while (n > 0) {
+        ssize_t w = send(fd, p, n, MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return false;
+        p += w;
+        n -= static_cast<size_t>(w);
+    }
+    return true;
+}
+
+inline bool read_all(int fd, void* data, size_t n) {
+    char* p = static_cast<char*>(data);
+    while (n > 0) {
+        ssize_t r = recv(fd, p, n, 0);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        p += r;
+        n -= static_cast<size_t>(r);
+    }
+    return true;
+}
+
+inline bool send_frame(int fd, Op op, const std::string& payload) {
+    FrameHeader h;
+    memcpy(h.magic, "FBRP", 4);
+    h.op = static_cast<uint32_t>(op);
+    h.length = payload.size();
+    return write_all(fd, &h, sizeof(h)) && write_all(fd, payload.data(), payload.size());
+}
+
+inline bool recv_header(int fd, FrameHeader& h, std::string& error) {
+    if (!read_all(fd, &h, sizeof(h))) {
+        error = "connection closed";
+        return false;
+    }
+    if (memcmp(h.magic, "FBRP", 4) != 0) {
+        error = "not a fairness_benchmark agent frame";
+        return false;
+    }
+    return true;
+}
+
+// Checked against the op's limit before anything is allocated
+inline bool recv_payload(int fd, const FrameHeader& h, std::string& payload, std::string& error) {
+    uint64_t limit = static_cast<Op>(h.op) == Op::File ? kMaxFileBytes : kMaxTextBytes;
+    if (h.length > limit) {
+        error = "frame of " + std::to_string(h.length) + " bytes is too large";
+        return false;
+    }
+    payload.resize(h.length);
+    if (h.length > 0 && !read_all(fd, &payload[0], h.length)) {
+        error = "connection closed mid-frame";
+        return false;
+    }
+    return true;
+}
+
+// Any frame but FILE, unless `files`: only the coordinator collecting results takes those
+inline bool recv_frame(int fd, Op& op, std::string& payload, std::string& error, bool files = false) {
+    FrameHeader h;
+    if (!recv_header(fd, h, error)) return false;
+    op = static_cast<Op>(h.op);
+    if (op == Op::File && !files) {
+        error = "unexpected file frame";
+        return false;
+    }
+    return recv_payload(fd, h, payload, error);
+}
+
+// Receive one frame and insist on its op; a mismatch is rejected before its payload is read
+inline bool expect(int fd, Op want, std::string& payload, std::string& error) {
+    FrameHeader h;
+    if (!recv_header(fd, h, error)) return false;
+    if (static_cast<Op>(h.op) != want) {
+        error = "unexpected frame " + std::to_string(h.op) + ", expected " +
+                std::to_string(static_cast<uint32_t>(want));
+        return false;
+    }
+    return recv_payload(fd, h, payload, error);
+}
+
+inline std::string format_fields(const std::map<std::string, std::string>& fields) {
+    std::string out;
+    for (const auto& [key, value] : fields) out += key + "=" + value + "\n";
+    return out;
+}
+
+inline std::map<std::string, std::string> parse_fields(const std::string& text) {
+    std::map<std::string, std::string> fields;
+    std::istringstream in(text);
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t eq = line.find('=');
+        if (eq != std::string::npos) fields[line.substr(0, eq)] = line.substr(eq + 1);
+    }
+    return fields;
+}
+
+// FILE payload: relative path, newline, content; the content is streamed from the file
+inline bool send_file(int fd, const std::string& relative, const std::string& path) {
+    int in = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) return false;
+    struct stat st;
+    if (fstat(in, &st) != 0) {
+        close(in);
+        return false;
+    }
+    std::string name = relative + "\n";
+    FrameHeader h;
+    memcpy(h.magic, "FBRP", 4);
+    h.op = static_cast<uint32_t>(Op::File);
+    h.length = name.size() + static_cast<uint64_t>(st.st_size);
+    bool ok = write_all(fd, &h, sizeof(h)) && write_all(fd, name.data(), name.size());
+    static constexpr size_t kChunk = 1 << 20;
+    std::string chunk(kChunk, '\0');
+    uint64_t left = static_cast<uint64_t>(st.st_size);
+    while (ok && left > 0) {
+        // The frame length is already on the wire: a file that shrinks underneath fails the session
+        ssize_t r = read(in, &chunk[0], std::min<uint64_t>(left, kChunk));
+        if (r < 0 && errno == EINTR) continue;
+        ok = r > 0 && write_all(fd, chunk.data(), static_cast<size_t>(r));
+        if (ok) left -= static_cast<uint64_t>(r);
+    }
+    close(in);
+    return ok;
+}
+
+// Split a FILE payload into its path and the offset of the content; false for
+// paths that would leave the output directory
+inline bool split_file(const std::string& payload, std::string& relative, size_t& content_at) {
+    size_t nl = payload.find('\n');
+    if (nl == std::string::npos || nl == 0) return false;
+    relative = payload.substr(0, nl);
+    if (relative[0] == '/' || relative.find("..") != std::string::npos) return false;
+    content_at = nl + 1;
+    return true;
+}
+
+// A whole decimal number, nothing else (peer-supplied fields must not throw)
+inline bool parse_int(const std::string& text, int64_t& value) {
+    if (text.empty()) return false;
+    errno = 0;
+    char* end = nullptr;
+    long long v = strtoll(text.c_str(), &end, 10);
+    if (errno != 0 || *end != '\0') return false;
+    value = v;
+    return true;
+}
+
+inline uint64_t realtime_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+inline uint64_t monotonic_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// A CLOCK_MONOTONIC instant on this host's CLOCK_REALTIME, and back
+inline uint64_t monotonic_to_realtime(uint64_t mono_ns) { return mono_ns - monotonic_now_ns() + realtime_ns(); }
+inline uint64_t realtime_to_monotonic(uint64_t real_ns) { return real_ns - realtime_ns() + monotonic_now_ns(); }
+
+// What the kernel knows of this host's clock discipline (NTP, chrony, PTP via phc2sys)
+struct ClockStatus {
+    bool synced = false;
+    int64_t est_error_us = -1;
+    int64_t max_error_us = -1;
+
+    std::map<std::string, std::string> fields(const std::string& prefix) const {
+        return {{prefix + "synced", synced ? "1" : "0"},
+                {prefix + "est_error_us", std::to_string(est_error_us)},
+                {prefix + "max_error_us", std::to_string(max_error_us)}};
+    }
+    // False for a present but malformed field; missing ones read as unknown (-1)
+    static bool from(const std::map<std::string, std::string>& fields, const std::string& prefix, ClockStatus& s) {
+        auto get = [&](const std::string& key, int64_t& value) {
+            auto it = fields.find(prefix + key);
+            if (it == fields.end()) return true;
+            return parse_int(it->second, value);
+        };
+        auto synced = fields.find(prefix + "synced");
+        s.synced = synced != fields.end() && synced->second == "1";
+        return get("est_error_us", s.est_error_us) && get("max_error_us", s.max_error_us);
+    }
+};
+
+inline ClockStatus clock_status() {
+    ClockStatus s;
+    struct timex tx;
+    memset(&tx, 0, sizeof(tx));
+    int state = adjtimex(&tx);
+    if (state < 0) return s;
+    s.synced = state != TIME_ERROR && !(tx.status & STA_UNSYNC);
+    s.est_error_us = tx.esterror;
+    s.max_error_us = tx.maxerror;
+    return s;
+}
+
+// Realtime offset of a peer (peer minus local) from probe timestamps, NTP-style
+struct ClockProbe {
+    uint64_t sent_ns;      // Local realtime when the probe left
+    uint64_t peer_ns;      // Peer realtime when it answered
+    uint64_t received_ns;  // Local realtime when the answer came back
+
+    uint64_t rtt_ns() const { return received_ns - sent_ns; }
+    int64_t offset_ns() const {
+        return static_cast<int64_t>(peer_ns) - static_cast<int64_t>(sent_ns + rtt_ns() / 2);
+    }
+};
+
+inline void tune_socket(int fd) {
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+}
+
+// ADDR[:PORT] (IPv6 as [ADDR]:PORT)
+inline bool split_host(const std::string& spec, std::string& host, std::string& port) {
+    host = spec;
+    port = std::to_string(kDefaultPort);
+    if (!spec.empty() && spec[0] == '[') {
+        size_t close = spec.find(']');
+        if (close == std::string::npos) return false;
+        host = spec.substr(1, close - 1);
+        if (close + 1 < spec.size()) {
+            if (spec[close + 1] != ':') return false;
+            port = spec.substr(close + 2);
+        }
+    } else if (spec.find(':') != std::string::npos && spec.find(':') == spec.rfind(':')) {
+        host = spec.substr(0, spec.find(':'));
+        port = spec.substr(spec.find(':') + 1);
+    }
+    return !host.empty() && !port.empty();
+}
+
+inline int connect_to(const std::string& spec, std::string& error) {
+    std::string host, port;
+    if (!split_host(spec, host, port)) {
+        error = "bad host '" + spec + "', expected ADDR[:PORT]";
+        return -1;
+    }
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* found = nullptr;
+    int rc = getaddrinfo(host.c_str(), port.c_str(), &hints, &found);
+    if (rc != 0) {
+        error = "Cannot resolve " + host + ": " + gai_strerror(rc);
+        return -1;
+    }
+    int fd = -1;
+    for (struct addrinfo* ai = found; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) continue;
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) break;
+        error = "Cannot connect to " + spec + ": " + strerror(errno);
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(found);
+    if (fd >= 0) tune_socket(fd);
+    return fd;
+}
+
+// ADDR:PORT to listen on; the agent defaults to loopback (kDefaultListen)
+inline int listen_on(const std::string& spec, std::string& error) {
+    std::string host, port;
+    if (!split_host(spec, host, port)) {
+        error = "bad listen address '" + spec + "', expected ADDR:PORT";
+        return -1;
+    }
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE | AI_NUMERICSERV;
+    struct addrinfo* found = nullptr;
+    int rc = getaddrinfo(host.c_str(), port.c_str(), &hints, &found);
+    if (rc != 0) {
+        error = "Cannot resolve " + host + ": " + gai_strerror(rc);
+        return -1;
+    }
+    int fd = -1;
+    for (struct addrinfo* ai = found; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) continue;
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && listen(fd, 16) == 0) break;
+        error = "Cannot listen on " + spec + ": " + strerror(errno);
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(found);
+    return fd;
+}
+
+// Shared secret from --agent-token-file: its first line, surrounding whitespace trimmed
+inline bool read_token_file(const std::string& path, std::string& token, std::string& error) {
+    std::ifstream in(path);
+    if (!in || !std::getline(in, token)) {
+        error = "Cannot read agent token from " + path;
+        return false;
+    }
+    size_t begin = token.find_first_not_of(" \t\r");
+    size_t end = token.find_last_not_of(" \t\r");
+    token = begin == std::string::npos ? "" : token.substr(begin, end - begin + 1);
+    if (token.empty()) {
+        error = "Agent token file " + path + " is empty";
+        return false;
+    }
+    return true;
+}
+
+// Constant-time comparison, so the HELLO check does not leak how much of a guess matched
+inline bool token_matches(const std::string& expected, const std::string& offered) {
+    unsigned char diff = expected.size() == offered.size() ? 0 : 1;
+    for (size_t i = 0; i < expected.size(); i++) {
+        diff |= static_cast<unsigned char>(expected[i] ^ (i < offered.size() ? offered[i] : 0));
+    }
+    return diff == 0 && !expected.empty();
+}
+
+// Names from a plan that become paths on the agent (label, group): [A-Za-z0-9_.-]+, no ".."
+inline bool safe_name(const std::string& name) {
+    if (name.empty() || name.find("..") != std::string::npos) return false;
+    for (char c : name) {
+        if (!isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '.' && c != '-') return false;
+    }
+    return true;
+}
+
+}  // namespace rpc
@@ -0,0 +1,142 @@
+// arrival_schedule.h
+// Open-loop arrival times for rate-paced native engine phases.
+//
+// A closed-loop limiter (fio's --rate_iops, arrival = closed) only issues
+// the next request once a slot is free, and drops the time a stall cost, so
+// a client stuck behind writeback just sends fewer requests and its tail
+// latency never includes the ones it failed to send (coordinated omission).
+// Open-loop workers instead follow a schedule of intended send times fixed
+// by the arrival process alone. Each request is timed from its intended
+// time, so waiting for a free slot counts towards its latency, as it would
+// for a client of a real service.
+//
+// Processes (mean gap = 1 / per-job rate):
+//   constant            evenly spaced; jobs are staggered across one gap
+//   poisson             exponential gaps, independent per job
+//   onoff:ON_MS:OFF_MS  poisson at the full rate during ON, silent during OFF;
+//                       every job shares the same windows, so bursts add up
+//
+// Schedules are precomputed per worker in blocks of kBlock arrivals, off
+// the issue path. Waits sleep with clock_nanosleep until kSpinNs before the
+// deadline and spin the rest, since a timer wakeup alone can be tens of
+// microseconds late.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <time.h>
+
+#include "latency_recorder.h"
+
+namespace arrival {
+
+using latency::monotonic_ns;
+
+enum class Kind { Closed, Constant, Poisson, OnOff };
+
+struct Spec {
+    Kind kind = Kind::Closed;
+    uint64_t on_ns = 0;   // OnOff windows
+    uint64_t off_ns = 0;
+
+    bool open_loop() const { return kind != Kind::Closed; }
+};
+
+inline bool parse(const std::string& text, Spec& out, std::string& error) {
+    out = Spec();
+    if (text.empty() || text == "closed") return true;
+    if (text == "constant") {
+        out.kind = Kind::Constant;
+        return true;
+    }
+    if (text == "poisson") {
+        out.kind = Kind::Poisson;
+        return true;
+    }
+    double on_ms = 0, off_ms = 0;
+    char tail = 0;
+    if (sscanf(text.c_str(), "onoff:%lf:%lf%c", &on_ms, &off_ms, &tail) == 2 && on_ms > 0 && off_ms >= 0) {
+        out.kind = Kind::OnOff;
+        out.on_ns = static_cast<uint64_t>(on_ms * 1e6);
+        out.off_ns = static_cast<uint64_t>(off_ms * 1e6);
+        return true;
+    }
+    error = "unknown arrival process '" + text + "' (closed, constant, poisson, onoff:ON_MS:OFF_MS)";
+    return false;
+}
+
+constexpr uint64_t kSpinNs = 50000;
+constexpr size_t kBlock = 4096;
+
+// Sleep until kSpinNs before `deadline_ns`, then spin on the clock
+inline void wait_until(uint64_t deadline_ns) {
+    uint64_t now = monotonic_ns();
+    if (deadline_ns > now + kSpinNs) {
+        uint64_t wake = deadline_ns - kSpinNs;
+        timespec ts;
+        ts.tv_sec = static_cast<time_t>(wake / 1000000000ULL);
+        ts.tv_nsec = static_cast<long>(wake % 1000000000ULL);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) != 0) {}
+    }
+    while (monotonic_ns() < deadline_ns) {}
+}
+
+// Intended send times of one worker, starting at start_ns
+class Schedule {
+public:
+    // job/jobs stagger constant schedules; seed makes poisson ones independent
+    Schedule(const Spec& spec, uint64_t mean_gap_ns, uint64_t start_ns, int job, int jobs, uint64_t seed)
+        : spec(spec), gap(static_cast<double>(std::max<uint64_t>(mean_gap_ns, 1))), start(start_ns), state(seed) {
+        if (spec.kind == Kind::Constant) active_ns = gap * job / std::max(jobs, 1);
+        times.reserve(kBlock);
+        refill();
+    }
+
+    uint64_t next() const { return times[pos]; }
+
+    void advance() {
+        if (++pos == times.size()) refill();
+    }
+
+private:
+    Spec spec;
+    double gap;
+    uint64_t start;
+    uint64_t state;
+    double active_ns = 0;  // Arrival clock counting only ON time
+    std::vector<uint64_t> times;
+    size_t pos = 0;
+
+    double uniform() {
+        // splitmix64, top 53 bits as (0, 1]
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z ^= z >> 31;
+        return (static_cast<double>(z >> 11) + 1.0) / 9007199254740992.0;
+    }
+
+    uint64_t to_wall(double t) const {
+        if (spec.kind != Kind::OnOff) return start + static_cast<uint64_t>(t);
+        // Insert an OFF window after every ON window of arrival time
+        uint64_t on = static_cast<uint64_t>(t);
+        return start + on / spec.on_ns * (spec.on_ns + spec.off_ns) + on % spec.on_ns;
+    }
+
+    void refill() {
+        times.clear();
+        pos = 0;
+        for (size_t i = 0; i < kBlock; i++) {
+            times.push_back(to_wall(active_ns));
+            active_ns += spec.kind == Kind::Constant ? gap : -std::log(uniform()) * gap;
+        }
+    }
+};
+
+}  // namespace arrival
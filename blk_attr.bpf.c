@@ -0,0 +1,160 @@
+// SPDX-License-Identifier: GPL-2.0
+/* blk_attr.bpf.c
+ * Per-cgroup block request latency split into queue and device time.
+ *
+ * block_rq_insert stamps a request when it enters the I/O scheduler,
+ * block_rq_issue when the driver gets it and block_rq_complete when the
+ * device is done. Each request is tagged at issue with the cgroup of its
+ * bio's blkcg (the page owner for writeback, not the flusher thread) and
+ * its origin: read, synchronous write or background writeback. Latencies
+ * go straight into per-CPU log2 histograms, so the per-request cost is two
+ * hash updates and nothing is copied to user space; the loader drains the
+ * histograms once per interval.
+ *
+ * Requests that bypass the scheduler never see block_rq_insert; their queue
+ * time is measured from the request's allocation (rq->start_time_ns).
+ */
+
+#include "vmlinux.h"
+#include <bpf/bpf_core_read.h>
+#include <bpf/bpf_helpers.h>
+#include <bpf/bpf_tracing.h>
+
+#include "blk_attr.h"
+
+char LICENSE[] SEC("license") = "GPL";
+
+#define REQ_OP_BITS 8
+#define REQ_OP_MASK ((1 << REQ_OP_BITS) - 1)
+
+struct {
+    __uint(type, BPF_MAP_TYPE_HASH);
+    __uint(max_entries, BLK_ATTR_MAX_INFLIGHT);
+    __type(key, __u64);
+    __type(value, struct blk_attr_start);
+} inflight SEC(".maps");
+
+struct {
+    __uint(type, BPF_MAP_TYPE_PERCPU_HASH);
+    __uint(max_entries, BLK_ATTR_MAX_KEYS);
+    __type(key, struct blk_attr_key);
+    __type(value, struct blk_attr_hist);
+} hists SEC(".maps");
+
+/* Only account devices matching this dev_t (set by the loader, 0 = all) */
+const volatile __u32 target_dev = 0;
+
+static __always_inline __u32 log2_slot(__u64 v)
+{
+    __u32 r = 0, shift;
+    shift = (v > 0xFFFFFFFFULL) << 5; v >>= shift; r |= shift;
+    shift = (v > 0xFFFF) << 4; v >>= shift; r |= shift;
+    shift = (v > 0xFF) << 3; v >>= shift; r |= shift;
+    shift = (v > 0xF) << 2; v >>= shift; r |= shift;
+    shift = (v > 0x3) << 1; v >>= shift; r |= shift;
+    r |= (v >> 1);
+    return r < BLK_ATTR_SLOTS ? r : BLK_ATTR_SLOTS - 1;
+}
+
+static __always_inline bool wanted(struct request *rq)
+{
+    if (!target_dev)
+        return true;
+    struct gendisk *disk = BPF_CORE_READ(rq, q, disk);
+    if (!disk)
+        return false;
+    __u32 dev = (BPF_CORE_READ(disk, major) << 20) | BPF_CORE_READ(disk, first_minor);
+    return dev == target_dev;
+}
+
+static __always_inline __u64 request_cgroup(struct request *rq)
+{
+    struct bio *bio = BPF_CORE_READ(rq, bio);
+    if (!bio || !bpf_core_field_exists(bio->bi_blkg))
+        return 0;
+    return BPF_CORE_READ(bio, bi_blkg, blkcg, css.cgroup, kn, id);
+}
+
+static __always_inline __u32 request_origin(struct request *rq)
+{
+    __u32 flags = BPF_CORE_READ(rq, cmd_flags);
+    __u32 op = flags & REQ_OP_MASK;
+    if (op == REQ_OP_READ)
+        return BLK_ATTR_READ;
+    if (op != REQ_OP_WRITE)
+        return BLK_ATTR_OTHER;
+    __u32 sync = 1U << bpf_core_enum_value(enum req_flag_bits, __REQ_SYNC);
+    __u32 background = 1U << bpf_core_enum_value(enum req_flag_bits, __REQ_BACKGROUND);
+    /* Flusher writeback is unsynchronized (or marked background); fsync/O_DIRECT writes are REQ_SYNC */
+    return (flags & background) || !(flags & sync) ? BLK_ATTR_WRITEBACK : BLK_ATTR_WRITE;
+}
+
+static __always_inline void account(__u64 cgroup_id, __u32 origin, __u32 component, __u64 ns, __u32 bytes)
+{
+    struct blk_attr_key key = {.cgroup_id = cgroup_id, .origin = origin, .component = component};
+    struct blk_attr_hist *h = bpf_map_lookup_elem(&hists, &key);
+    if (!h) {
+        static const struct blk_attr_hist zero;
+        bpf_map_update_elem(&hists, &key, &zero, BPF_NOEXIST);
+        h = bpf_map_lookup_elem(&hists, &key);
+        if (!h)
+            return;
+    }
+    /* Per-CPU values: plain increments are safe */
+    h->slots[log2_slot(ns)]++;
+    h->count++;
+    h->sum_ns += ns;
+    h->bytes += bytes;
+}
+
+SEC("tp_btf/block_rq_insert")
+int BPF_PROG(on_insert, struct request *rq)
+{
+    if (!wanted(rq))
+        return 0;
+    __u64 key = (__u64)rq;
+    struct blk_attr_start start = {.insert_ns = bpf_ktime_get_ns()};
+    bpf_map_update_elem(&inflight, &key, &start, BPF_ANY);
+    return 0;
+}
+
+SEC("tp_btf/block_rq_issue")
+int BPF_PROG(on_issue, struct request *rq)
+{
+    if (!wanted(rq))
+        return 0;
+    __u64 now = bpf_ktime_get_ns();
+    __u64 key = (__u64)rq;
+    struct blk_attr_start fresh = {};
+    struct blk_attr_start *start = bpf_map_lookup_elem(&inflight, &key);
+    if (!start)
+        start = &fresh;
+
+    __u64 queued_at = start->insert_ns;
+    if (!queued_at)
+        queued_at = BPF_CORE_READ(rq, start_time_ns);
+    start->issue_ns = now;
+    start->cgroup_id = request_cgroup(rq);
+    start->origin = request_origin(rq);
+    start->bytes = BPF_CORE_READ(rq, __data_len);
+    if (start == &fresh)
+        bpf_map_update_elem(&inflight, &key, &fresh, BPF_ANY);
+
+    if (queued_at && queued_at <= now)
+        account(start->cgroup_id, start->origin, BLK_ATTR_QUEUE, now - queued_at, 0);
+    return 0;
+}
+
+SEC("tp_btf/block_rq_complete")
+int BPF_PROG(on_complete, struct request *rq, int error, unsigned int nr_bytes)
+{
+    __u64 key = (__u64)rq;
+    struct blk_attr_start *start = bpf_map_lookup_elem(&inflight, &key);
+    if (!start)
+        return 0;
+    __u64 now = bpf_ktime_get_ns();
+    if (start->issue_ns && start->issue_ns <= now)
+        account(start->cgroup_id, start->origin, BLK_ATTR_DEVICE, now - start->issue_ns, start->bytes);
+    bpf_map_delete_elem(&inflight, &key);
+    return 0;
+}
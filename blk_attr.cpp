@@ -0,0 +1,230 @@
+// blk_attr.cpp
+// Loader for blk_attr.bpf.c: per-cgroup block latency split into queue and
+// device time, drained from the BPF histograms once per interval.
+//
+// Built only by `make bpf` (needs clang, bpftool and libbpf). The benchmark
+// runs it next to the clients with --blk-attr, the way it runs iostat.
+//
+// Output is CSV, one row per (cgroup, origin, component) that saw requests
+// in the interval; percentiles are log2-bucket upper bounds:
+//   timestamp_ns,cgroup_id,cgroup,origin,component,count,bytes,mean_us,p50_us,p99_us,max_us
+// Timestamps are CLOCK_MONOTONIC, the same clock as the .lat windows.
+
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <bpf/bpf.h>
+#include <bpf/libbpf.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "blk_attr.h"
+#include "blk_attr.skel.h"
+
+namespace fs = std::filesystem;
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void on_signal(int) { stop_requested = 1; }
+
+static uint64_t monotonic_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+static const char* origin_name(uint32_t origin) {
+    switch (origin) {
+        case BLK_ATTR_READ: return "read";
+        case BLK_ATTR_WRITE: return "write";
+        case BLK_ATTR_WRITEBACK: return "writeback";
+        default: return "other";
+    }
+}
+
+struct KeyLess {
+    bool operator()(const blk_attr_key& a, const blk_attr_key& b) const {
+        return std::tie(a.cgroup_id, a.origin, a.component) < std::tie(b.cgroup_id, b.origin, b.component);
+    }
+};
+
+class Collector {
+public:
+    Collector(int map_fd, FILE* out) : map_fd(map_fd), out(out), ncpus(libbpf_num_possible_cpus()) {
+        refresh_cgroups();
+    }
+
+    void drain(uint64_t now) {
+        std::vector<blk_attr_hist> per_cpu(ncpus > 0 ? ncpus : 1);
+        blk_attr_key key;
+        blk_attr_key next;
+        bool first = true;
+        bool unknown = false;
+        while (bpf_map_get_next_key(map_fd, first ? nullptr : &key, &next) == 0) {
+            first = false;
+            key = next;
+            if (bpf_map_lookup_elem(map_fd, &key, per_cpu.data()) != 0) continue;
+            blk_attr_hist total;
+            memset(&total, 0, sizeof(total));
+            for (const auto& h : per_cpu) {
+                for (int s = 0; s < BLK_ATTR_SLOTS; s++) total.slots[s] += h.slots[s];
+                total.count += h.count;
+                total.sum_ns += h.sum_ns;
+                total.bytes += h.bytes;
+            }
+            blk_attr_hist& prev = previous[key];
+            blk_attr_hist delta;
+            for (int s = 0; s < BLK_ATTR_SLOTS; s++) delta.slots[s] = total.slots[s] - prev.slots[s];
+            delta.count = total.count - prev.count;
+            delta.sum_ns = total.sum_ns - prev.sum_ns;
+            delta.bytes = total.bytes - prev.bytes;
+            prev = total;
+            if (delta.count == 0) continue;
+            if (key.cgroup_id && !cgroup_names.count(key.cgroup_id)) unknown = true;
+            write_row(now, key, delta);
+        }
+        fflush(out);
+        // New tenants' cgroups are created while we run
+        if (unknown) refresh_cgroups();
+    }
+
+private:
+    int map_fd;
+    FILE* out;
+    int ncpus;
+    std::map<blk_attr_key, blk_attr_hist, KeyLess> previous;
+    std::map<uint64_t, std::string> cgroup_names;
+
+    // cgroup v2 ids are the inode numbers of the cgroup directories
+    void refresh_cgroups() {
+        std::error_code ec;
+        const fs::path root = "/sys/fs/cgroup";
+        struct stat st;
+        if (stat(root.c_str(), &st) == 0) cgroup_names[st.st_ino] = "/";
+        for (auto it = fs::recursive_directory_iterator(root, fs::directory_options::skip_permission_denied, ec);
+             it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (ec) break;
+            if (!it->is_directory(ec)) continue;
+            if (stat(it->path().c_str(), &st) == 0) {
+                cgroup_names[st.st_ino] = "/" + fs::relative(it->path(), root, ec).string();
+            }
+        }
+    }
+
+    static double slot_upper_us(int s) { return static_cast<double>(2ULL << s) / 1000.0; }
+
+    static double percentile_us(const blk_attr_hist& h, double pct) {
+        uint64_t target = static_cast<uint64_t>(h.count * pct / 100.0 + 0.5);
+        if (target == 0) target = 1;
+        uint64_t seen = 0;
+        for (int s = 0; s < BLK_ATTR_SLOTS; s++) {
+            seen += h.slots[s];
+            if (seen >= target) return slot_upper_us(s);
+        }
+        return slot_upper_us(BLK_ATTR_SLOTS - 1);
+    }
+
+    void write_row(uint64_t now, const blk_attr_key& key, const blk_attr_hist& h) {
+        int max_slot = 0;
+        for (int s = 0; s < BLK_ATTR_SLOTS; s++) {
+            if (h.slots[s]) max_slot = s;
+        }
+        auto name = cgroup_names.find(key.cgroup_id);
+        fprintf(out, "%llu,%llu,%s,%s,%s,%llu,%llu,%.1f,%.1f,%.1f,%.1f\n",
+                static_cast<unsigned long long>(now), static_cast<unsigned long long>(key.cgroup_id),
+                name != cgroup_names.end() ? name->second.c_str() : "", origin_name(key.origin),
+                key.component == BLK_ATTR_QUEUE ? "queue" : "device",
+                static_cast<unsigned long long>(h.count), static_cast<unsigned long long>(h.bytes),
+                h.sum_ns / 1000.0 / h.count, percentile_us(h, 50), percentile_us(h, 99), slot_upper_us(max_slot));
+    }
+};
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s [-o FILE] [-i INTERVAL_MS] [-d MAJ:MIN]\n"
+            "  -o FILE         CSV output (default: stdout)\n"
+            "  -i INTERVAL_MS  Drain period (default: 1000)\n"
+            "  -d MAJ:MIN      Only account this disk (default: all)\n"
+            "Runs until SIGINT/SIGTERM.\n",
+            prog);
+}
+
+int main(int argc, char** argv) {
+    const char* output = nullptr;
+    int interval_ms = 1000;
+    unsigned dev_major = 0, dev_minor = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "o:i:d:h")) != -1) {
+        switch (opt) {
+            case 'o': output = optarg; break;
+            case 'i': interval_ms = atoi(optarg); break;
+            case 'd':
+                if (sscanf(optarg, "%u:%u", &dev_major, &dev_minor) != 2) {
+                    fprintf(stderr, "ERROR: -d expects MAJ:MIN\n");
+                    return 1;
+                }
+                break;
+            default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (interval_ms <= 0) {
+        fprintf(stderr, "ERROR: -i must be > 0\n");
+        return 1;
+    }
+
+    FILE* out = output ? fopen(output, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "ERROR: Cannot open %s: %s\n", output, strerror(errno));
+        return 1;
+    }
+
+    blk_attr_bpf* skel = blk_attr_bpf__open();
+    if (!skel) {
+        fprintf(stderr, "ERROR: Cannot open BPF object: %s\n", strerror(errno));
+        return 1;
+    }
+    // Kernel dev_t layout (MKDEV), as gendisk major/first_minor combine to
+    skel->rodata->target_dev = (dev_major << 20) | dev_minor;
+    int err = blk_attr_bpf__load(skel);
+    if (!err) err = blk_attr_bpf__attach(skel);
+    if (err) {
+        fprintf(stderr, "ERROR: Cannot load/attach BPF programs: %s (needs root and a BTF-enabled kernel)\n",
+                strerror(-err));
+        blk_attr_bpf__destroy(skel);
+        return 1;
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    fprintf(out, "timestamp_ns,cgroup_id,cgroup,origin,component,count,bytes,mean_us,p50_us,p99_us,max_us\n");
+    fflush(out);
+
+    Collector collector(bpf_map__fd(skel->maps.hists), out);
+    uint64_t next = monotonic_ns() + interval_ms * 1000000ULL;
+    while (!stop_requested) {
+        timespec ts;
+        ts.tv_sec = next / 1000000000ULL;
+        ts.tv_nsec = next % 1000000000ULL;
+        // Interrupted by the stop signal: fall through to the final drain
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+        uint64_t now = monotonic_ns();
+        collector.drain(now);
+        next += interval_ms * 1000000ULL;
+        if (next <= now) next = now + interval_ms * 1000000ULL;
+    }
+
+    blk_attr_bpf__destroy(skel);
+    if (out != stdout) fclose(out);
+    return 0;
+}
@@ -0,0 +1,53 @@
+/* blk_attr.h
+ * Map layouts shared by blk_attr.bpf.c and its loader (blk_attr.cpp).
+ *
+ * Kept C-compatible: the BPF side sees it after vmlinux.h, the loader
+ * after <linux/types.h>.
+ */
+
+#pragma once
+
+#ifndef __VMLINUX_H__
+#include <linux/types.h>
+#endif
+
+#define BLK_ATTR_SLOTS 32          /* log2(ns) buckets: slot s holds [2^s, 2^(s+1)) ns */
+#define BLK_ATTR_MAX_INFLIGHT 65536
+#define BLK_ATTR_MAX_KEYS 4096
+
+enum blk_attr_origin {
+    BLK_ATTR_READ = 0,
+    BLK_ATTR_WRITE = 1,            /* Synchronous writes: O_DIRECT, O_SYNC, fsync-driven */
+    BLK_ATTR_WRITEBACK = 2,        /* Asynchronous writes issued by page-cache writeback */
+    BLK_ATTR_OTHER = 3,            /* Flush, discard, ... */
+    BLK_ATTR_NUM_ORIGINS = 4,
+};
+
+enum blk_attr_component {
+    BLK_ATTR_QUEUE = 0,            /* Insert (or allocation) -> issue to the driver */
+    BLK_ATTR_DEVICE = 1,           /* Issue -> completion */
+    BLK_ATTR_NUM_COMPONENTS = 2,
+};
+
+struct blk_attr_key {
+    __u64 cgroup_id;               /* cgroup v2 inode number of the request's blkcg, 0 = root/unknown */
+    __u32 origin;                  /* enum blk_attr_origin */
+    __u32 component;               /* enum blk_attr_component */
+};
+
+/* Per-CPU value; the loader sums CPUs and diffs consecutive drains */
+struct blk_attr_hist {
+    __u64 slots[BLK_ATTR_SLOTS];
+    __u64 count;
+    __u64 sum_ns;
+    __u64 bytes;
+};
+
+/* In-flight request state, keyed by struct request pointer */
+struct blk_attr_start {
+    __u64 insert_ns;               /* 0 if the request bypassed the scheduler */
+    __u64 issue_ns;
+    __u64 cgroup_id;
+    __u32 origin;
+    __u32 bytes;
+};
@@ -0,0 +1,147 @@
+// buffer_arena.h
+// Per-worker I/O buffer arena backed by huge pages.
+//
+// Each native engine worker maps one arena at startup holding a buffer per
+// queue slot, carved at a 4K-aligned stride so every buffer is valid for
+// O_DIRECT and the whole arena can be registered with io_uring as one
+// fixed buffer. Slots recycle their buffers through the engine's free-slot
+// list; nothing is allocated after startup.
+//
+// Backing, by preference:
+//   1g / 2m  hugetlb pages (MAP_HUGETLB). These are charged to the hugetlb
+//            controller, not to memory.current (unless cgroup2 is mounted
+//            with memory_hugetlb_accounting), so load generator buffers do
+//            not distort the page-cache numbers being measured. They need
+//            pages reserved in /proc/sys/vm/nr_hugepages (or the 1G pool).
+//   thp      anonymous memory with MADV_HUGEPAGE: fewer TLB misses, but
+//            charged to memory.current like any anonymous memory.
+//   4k       plain anonymous memory.
+// auto tries 2m, then thp, for arenas of at least kAutoHugeBytes, and uses
+// 4k pages below that. summary() says what a worker actually got.
+
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "topology.h"
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+namespace arena {
+
+enum class HugePages { Auto, Huge1G, Huge2M, Transparent, None };
+
+inline bool parse_hugepages(const std::string& name, HugePages& out) {
+    if (name == "auto") out = HugePages::Auto;
+    else if (name == "1g") out = HugePages::Huge1G;
+    else if (name == "2m") out = HugePages::Huge2M;
+    else if (name == "thp") out = HugePages::Transparent;
+    else if (name == "4k" || name == "none") out = HugePages::None;
+    else return false;
+    return true;
+}
+
+inline const char* hugepages_name(HugePages mode) {
+    switch (mode) {
+    case HugePages::Auto: return "auto";
+    case HugePages::Huge1G: return "1g";
+    case HugePages::Huge2M: return "2m";
+    case HugePages::Transparent: return "thp";
+    case HugePages::None: return "4k";
+    }
+    return "auto";
+}
+
+constexpr size_t kBufferAlign = 4096;
+constexpr size_t kAutoHugeBytes = 1ULL << 20;
+
+class BufferArena {
+public:
+    BufferArena() = default;
+    ~BufferArena() {
+        if (base) munmap(base, mapped);
+    }
+
+    BufferArena(const BufferArena&) = delete;
+    BufferArena& operator=(const BufferArena&) = delete;
+
+    // `count` buffers of at least `buffer_len` bytes; node >= 0 binds the arena there before first touch.
+    // An explicit hugetlb size that cannot be mapped is an error; auto falls back quietly.
+    bool init(size_t buffer_len, size_t count, HugePages mode, int node, std::string& error) {
+        stride = (buffer_len + kBufferAlign - 1) / kBufferAlign * kBufferAlign;
+        usable = stride * count;
+        bool want_huge = mode == HugePages::Auto ? usable >= kAutoHugeBytes : mode != HugePages::None;
+
+        if (mode == HugePages::Huge1G && !map_hugetlb(1ULL << 30, MAP_HUGE_1GB, "1G hugetlb", error)) return false;
+        if (mode == HugePages::Huge2M && !map_hugetlb(2ULL << 20, MAP_HUGE_2MB, "2M hugetlb", error)) return false;
+        if (mode == HugePages::Auto && want_huge) map_hugetlb(2ULL << 20, MAP_HUGE_2MB, "2M hugetlb", error);
+        if (!base && !map_anonymous(want_huge, error)) return false;
+        error.clear();
+
+        if (node >= 0 && !topology::bind_memory(base, mapped, node, error)) return false;
+        return true;
+    }
+
+    char* buffer(size_t i) const { return static_cast<char*>(base) + i * stride; }
+    void* data() const { return base; }
+    size_t size() const { return usable; }
+    size_t mapped_bytes() const { return mapped; }
+    const std::string& backing() const { return backing_name; }
+    // Whether the arena counts towards the cgroup's memory.current
+    bool charged_to_memcg() const { return charged; }
+
+private:
+    void* base = nullptr;
+    size_t mapped = 0;
+    size_t stride = 0;
+    size_t usable = 0;
+    std::string backing_name;
+    bool charged = true;
+
+    bool map_hugetlb(size_t page, int size_flag, const char* name, std::string& error) {
+        size_t len = (usable + page - 1) / page * page;
+        void* p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | size_flag,
+                       -1, 0);
+        if (p == MAP_FAILED) {
+            error = std::string("Cannot map ") + name + " pages for I/O buffers: " + strerror(errno) +
+                    " (reserve them in /sys/kernel/mm/hugepages)";
+            return false;
+        }
+        base = p;
+        mapped = len;
+        backing_name = name;
+        charged = false;
+        return true;
+    }
+
+    bool map_anonymous(bool transparent, std::string& error) {
+        const size_t huge = 2ULL << 20;
+        size_t len = transparent ? (usable + huge - 1) / huge * huge : usable;
+        void* p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) {
+            error = std::string("Cannot map I/O buffers: ") + strerror(errno);
+            return false;
+        }
+        base = p;
+        mapped = len;
+        backing_name = transparent && madvise(p, len, MADV_HUGEPAGE) == 0 ? "THP" : "4K";
+        charged = true;
+        return true;
+    }
+};
+
+}  // namespace arena
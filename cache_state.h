@@ -0,0 +1,267 @@
+// cache_state.h
+// Page-cache state of the test files: evict, snapshot and restore.
+//
+// drop_caches empties every cache on the host. It costs the shared machine
+// its working sets and leaves the benchmark a cold start that takes a full
+// warmup phase to undo. This module touches only the benchmark's own files:
+//
+//   evict    sync each test file, then POSIX_FADV_DONTNEED it. Dirty pages
+//            are written first, since fadvise cannot drop them.
+//   capture  record which pages of each file are resident (mincore over a
+//            read-only mapping; nothing is faulted in) as page runs.
+//   restore  read every recorded run back from a pool of threads, with
+//            readahead off (POSIX_FADV_RANDOM) so only those pages load, then
+//            count again with mincore to measure what landed.
+//
+// Snapshots are text, keyed by file path and size:
+//   file <size_bytes> <resident_pages> <path>
+//   r <first_page> <pages>            (one line per resident run)
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace cache_state {
+
+// drop: system-wide drop_caches. evict: the test files only.
+// warm: evict, then restore the snapshot taken at the end of an earlier run's warmup.
+enum class Mode { Drop, Evict, Warm };
+
+inline bool parse_mode(const std::string& name, Mode& out) {
+    if (name == "drop") out = Mode::Drop;
+    else if (name == "evict") out = Mode::Evict;
+    else if (name == "warm") out = Mode::Warm;
+    else return false;
+    return true;
+}
+
+inline const char* mode_name(Mode mode) {
+    return mode == Mode::Drop ? "drop" : mode == Mode::Evict ? "evict" : "warm";
+}
+
+constexpr uint64_t kScanChunkBytes = 64ULL << 20;    // mincore vector per call
+constexpr uint64_t kRestoreChunkBytes = 8ULL << 20;  // Unit of work for the restore threads
+constexpr int kRestoreThreads = 8;                   // Enough to keep a device queue busy
+
+struct FileState {
+    std::string path;
+    uint64_t size = 0;
+    uint64_t resident_pages = 0;
+    std::vector<std::pair<uint64_t, uint64_t>> runs;  // (first page, pages), ascending
+};
+
+inline uint64_t page_size() { return static_cast<uint64_t>(sysconf(_SC_PAGESIZE)); }
+
+inline bool evict_file(const std::string& path, std::string& error) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "Cannot open " + path + ": " + strerror(errno);
+        return false;
+    }
+    fdatasync(fd);
+    int rc = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+    if (rc != 0) {
+        error = "Cannot evict " + path + ": " + strerror(rc);
+        return false;
+    }
+    return true;
+}
+
+// Resident page runs of one file
+inline bool capture_file(const std::string& path, FileState& out, std::string& error) {
+    out = FileState();
+    out.path = path;
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "Cannot open " + path + ": " + strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        error = "Cannot size " + path;
+        return false;
+    }
+    out.size = static_cast<uint64_t>(st.st_size);
+    void* map = mmap(nullptr, out.size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        error = "Cannot map " + path + ": " + strerror(errno);
+        return false;
+    }
+    const uint64_t page = page_size();
+    const uint64_t pages = (out.size + page - 1) / page;
+    std::vector<unsigned char> vec(kScanChunkBytes / page);
+    uint64_t run_start = 0;
+    bool in_run = false;
+    for (uint64_t first = 0; first < pages; first += vec.size()) {
+        uint64_t n = std::min<uint64_t>(vec.size(), pages - first);
+        if (mincore(static_cast<char*>(map) + first * page, n * page, vec.data()) != 0) {
+            error = "mincore on " + path + ": " + strerror(errno);
+            munmap(map, out.size);
+            return false;
+        }
+        for (uint64_t i = 0; i < n; i++) {
+            bool resident = vec[i] & 1;
+            if (resident && !in_run) run_start = first + i;
+            if (!resident && in_run) out.runs.push_back({run_start, first + i - run_start});
+            in_run = resident;
+            out.resident_pages += resident;
+        }
+    }
+    if (in_run) out.runs.push_back({run_start, pages - run_start});
+    munmap(map, out.size);
+    return true;
+}
+
+inline bool save(const std::string& path, const std::vector<FileState>& files, std::string& error) {
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp);
+        if (!out) {
+            error = "Cannot write " + tmp;
+            return false;
+        }
+        for (const auto& f : files) {
+            out << "file " << f.size << " " << f.resident_pages << " " << f.path << "\n";
+            for (const auto& [first, n] : f.runs) out << "r " << first << " " << n << "\n";
+        }
+        if (!out) {
+            error = "Cannot write " + tmp;
+            return false;
+        }
+    }
+    if (rename(tmp.c_str(), path.c_str()) != 0) {
+        error = "Cannot rename " + tmp + ": " + strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+inline bool load(const std::string& path, std::vector<FileState>& files, std::string& error) {
+    files.clear();
+    std::ifstream in(path);
+    if (!in) {
+        error = "Cannot open " + path;
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string tag;
+        fields >> tag;
+        if (tag == "file") {
+            FileState f;
+            fields >> f.size >> f.resident_pages >> std::ws;
+            std::getline(fields, f.path);
+            if (f.path.empty()) {
+                error = path + ": bad line '" + line + "'";
+                return false;
+            }
+            files.push_back(std::move(f));
+        } else if (tag == "r" && !files.empty()) {
+            uint64_t first = 0, n = 0;
+            if (!(fields >> first >> n)) {
+                error = path + ": bad line '" + line + "'";
+                return false;
+            }
+            files.back().runs.push_back({first, n});
+        }
+    }
+    return true;
+}
+
+// A snapshot applies while every file still exists with its recorded size
+inline bool matches(const std::vector<FileState>& files) {
+    if (files.empty()) return false;
+    for (const auto& f : files) {
+        struct stat st;
+        if (stat(f.path.c_str(), &st) != 0 || static_cast<uint64_t>(st.st_size) != f.size) return false;
+    }
+    return true;
+}
+
+struct RestoreResult {
+    uint64_t requested_pages = 0;
+    uint64_t resident_pages = 0;  // Counted after the readahead
+    double seconds = 0;
+};
+
+// Read every recorded run back into the cache, kRestoreThreads at a time
+inline bool restore(const std::vector<FileState>& files, RestoreResult& result, std::string& error) {
+    struct Chunk {
+        int fd;
+        uint64_t offset;
+        uint64_t len;
+    };
+    const uint64_t page = page_size();
+    auto started = std::chrono::steady_clock::now();
+    result = RestoreResult();
+    std::vector<int> fds;
+    std::vector<Chunk> chunks;
+    for (const auto& f : files) {
+        int fd = open(f.path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            error = "Cannot open " + f.path + ": " + strerror(errno);
+            for (int open_fd : fds) close(open_fd);
+            return false;
+        }
+        // No readahead around the runs: restore exactly the recorded pages
+        posix_fadvise(fd, 0, 0, POSIX_FADV_RANDOM);
+        fds.push_back(fd);
+        for (const auto& [first, n] : f.runs) {
+            for (uint64_t off = first * page; off < (first + n) * page; off += kRestoreChunkBytes) {
+                chunks.push_back({fd, off, std::min<uint64_t>(kRestoreChunkBytes, (first + n) * page - off)});
+            }
+            result.requested_pages += n;
+        }
+    }
+
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> threads;
+    int count = static_cast<int>(std::min<size_t>(kRestoreThreads, std::max<size_t>(chunks.size(), 1)));
+    for (int t = 0; t < count; t++) {
+        threads.emplace_back([&]() {
+            std::vector<char> buf(kRestoreChunkBytes);
+            for (size_t i = next++; i < chunks.size(); i = next++) {
+                // Blocking reads, so the pages are resident on return
+                uint64_t done = 0;
+                while (done < chunks[i].len) {
+                    ssize_t n = pread(chunks[i].fd, buf.data(), chunks[i].len - done,
+                                      static_cast<off_t>(chunks[i].offset + done));
+                    if (n <= 0) break;
+                    done += static_cast<uint64_t>(n);
+                }
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+    for (int fd : fds) close(fd);
+
+    for (const auto& f : files) {
+        FileState now;
+        std::string scan_error;
+        if (capture_file(f.path, now, scan_error)) result.resident_pages += now.resident_pages;
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return true;
+}
+
+}  // namespace cache_state
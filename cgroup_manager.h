@@ -0,0 +1,247 @@
+// cgroup_manager.h
+// Direct cgroup v2 management through cgroupfs.
+//
+// The base directory (/sys/fs/cgroup, or user.slice under systemd) is
+// resolved once; each managed cgroup's directory is opened once and control
+// files are written with openat/write on that descriptor. Nothing forks a
+// shell, so setting up a cgroup costs a handful of syscalls.
+//
+// Clients are launched with clone3(CLONE_INTO_CGROUP): the child is created
+// inside its cgroup and never runs a single instruction outside it. Kernels
+// or hierarchies that cannot do that fall back to fork() plus a pipe
+// handshake; the child waits until the parent has written its PID to
+// cgroup.procs before it starts, so it cannot issue I/O from the wrong cgroup.
+//
+// Raw clone3 bypasses glibc's fork handlers, so spawn() must be called
+// while the calling process has no other threads.
+
+#pragma once
+
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/sched.h>
+#include <sys/stat.h>
+#include <sys/statfs.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifndef CGROUP2_SUPER_MAGIC
+#define CGROUP2_SUPER_MAGIC 0x63677270
+#endif
+
+namespace cgroup {
+
+class CgroupManager {
+public:
+    CgroupManager() = default;
+    ~CgroupManager() {
+        for (auto& [name, fd] : dir_fds) close(fd);
+    }
+
+    CgroupManager(const CgroupManager&) = delete;
+    CgroupManager& operator=(const CgroupManager&) = delete;
+
+    // Resolve the base directory once
+    void init() {
+        struct stat st;
+        systemd = (stat("/sys/fs/cgroup/system.slice", &st) == 0 && S_ISDIR(st.st_mode));
+        base_path = systemd ? "/sys/fs/cgroup/user.slice" : "/sys/fs/cgroup";
+        struct statfs sfs;
+        unified = (statfs("/sys/fs/cgroup", &sfs) == 0 && sfs.f_type == CGROUP2_SUPER_MAGIC);
+    }
+
+    bool is_systemd() const { return systemd; }
+    bool is_unified() const { return unified; }
+    const std::string& base() const { return base_path; }
+    std::string path(const std::string& name) const { return base_path + "/" + name; }
+
+    // mkdir -p the cgroup and enable cpu/cpuset/memory/io in every ancestor from the base down
+    bool create(const std::string& name, std::string& error) {
+        std::string current = base_path;
+        enable_controllers(current);
+        size_t start = 0;
+        while (start < name.size()) {
+            size_t slash = name.find('/', start);
+            std::string component = name.substr(start, slash == std::string::npos ? std::string::npos : slash - start);
+            start = (slash == std::string::npos) ? name.size() : slash + 1;
+            if (component.empty()) continue;
+            current += "/" + component;
+            if (mkdir(current.c_str(), 0755) != 0 && errno != EEXIST) {
+                error = "Cannot create " + current + ": " + strerror(errno);
+                return false;
+            }
+            if (start < name.size()) enable_controllers(current);
+        }
+        return open_dir(name, error) >= 0;
+    }
+
+    bool has_file(const std::string& name, const std::string& file) {
+        std::string error;
+        int dfd = open_dir(name, error);
+        if (dfd < 0) return false;
+        return faccessat(dfd, file.c_str(), F_OK, 0) == 0;
+    }
+
+    bool write_file(const std::string& name, const std::string& file, const std::string& value,
+                    std::string& error) {
+        int dfd = open_dir(name, error);
+        if (dfd < 0) return false;
+        int fd = openat(dfd, file.c_str(), O_WRONLY | O_CLOEXEC);
+        if (fd < 0) {
+            error = "Cannot open " + path(name) + "/" + file + ": " + strerror(errno);
+            return false;
+        }
+        ssize_t n = write(fd, value.data(), value.size());
+        int saved_errno = errno;
+        close(fd);
+        if (n != static_cast<ssize_t>(value.size())) {
+            error = "Cannot write '" + value + "' to " + path(name) + "/" + file + ": " +
+                    (n < 0 ? strerror(saved_errno) : "short write");
+            return false;
+        }
+        return true;
+    }
+
+    bool add_pid(const std::string& name, pid_t pid, std::string& error) {
+        return write_file(name, "cgroup.procs", std::to_string(pid), error);
+    }
+
+    // SIGKILL every process in the cgroup and wait (bounded) for it to empty
+    void kill_all(const std::string& name) {
+        std::string error;
+        if (open_dir(name, error) < 0) return;
+        if (!write_file(name, "cgroup.kill", "1", error)) {
+            for (pid_t pid : read_pids(name)) kill(pid, SIGKILL);
+        }
+        for (int i = 0; i < 100 && !read_pids(name).empty(); i++) usleep(10000);
+    }
+
+    bool remove(const std::string& name) {
+        auto it = dir_fds.find(name);
+        if (it != dir_fds.end()) {
+            close(it->second);
+            dir_fds.erase(it);
+        }
+        std::string dir = path(name);
+        // Killed members can take a moment to leave; rmdir fails with EBUSY until then
+        for (int i = 0; i < 50; i++) {
+            if (rmdir(dir.c_str()) == 0 || errno == ENOENT) return true;
+            if (errno != EBUSY) return false;
+            usleep(10000);
+        }
+        return false;
+    }
+
+    // Like fork(), but the child starts inside cgroup `name` (empty = no cgroup).
+    // Returns the child PID in the parent, 0 in the child, -1 if no child was
+    // created. If the child could not be placed it still runs, outside the
+    // cgroup, and `error` says why.
+    pid_t spawn(const std::string& name, std::string& error) {
+        if (name.empty()) return fork();
+
+        int dfd = open_dir(name, error);
+        if (dfd < 0) return -1;
+
+        clone_args args;
+        memset(&args, 0, sizeof(args));
+        args.flags = CLONE_INTO_CGROUP;
+        args.exit_signal = SIGCHLD;
+        args.cgroup = static_cast<uint64_t>(dfd);
+        long pid = syscall(SYS_clone3, &args, sizeof(args));
+        if (pid >= 0) return static_cast<pid_t>(pid);
+        // ENOSYS/E2BIG (pre-5.7 kernel), EOPNOTSUPP/EBADF (not a v2 cgroup), seccomp filters...
+        return spawn_with_handshake(name, error);
+    }
+
+private:
+    std::string base_path = "/sys/fs/cgroup";
+    bool systemd = false;
+    bool unified = false;
+    std::map<std::string, int> dir_fds;
+
+    int open_dir(const std::string& name, std::string& error) {
+        auto it = dir_fds.find(name);
+        if (it != dir_fds.end()) return it->second;
+        std::string dir = path(name);
+        int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) {
+            error = "Cannot open cgroup " + dir + ": " + strerror(errno);
+            return -1;
+        }
+        dir_fds[name] = fd;
+        return fd;
+    }
+
+    // Controllers are enabled one at a time so one missing controller doesn't block the rest
+    void enable_controllers(const std::string& dir) {
+        std::string file = dir + "/cgroup.subtree_control";
+        for (const char* controller : {"+cpu", "+cpuset", "+memory", "+io"}) {
+            int fd = open(file.c_str(), O_WRONLY | O_CLOEXEC);
+            if (fd < 0) return;
+            [[maybe_unused]] ssize_t n = write(fd, controller, strlen(controller));
+            close(fd);
+        }
+    }
+
+    std::vector<pid_t> read_pids(const std::string& name) {
+        std::vector<pid_t> pids;
+        std::string error;
+        int dfd = open_dir(name, error);
+        if (dfd < 0) return pids;
+        int fd = openat(dfd, "cgroup.procs", O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return pids;
+        char buf[4096];
+        std::string content;
+        ssize_t n;
+        while ((n = read(fd, buf, sizeof(buf))) > 0) content.append(buf, n);
+        close(fd);
+        size_t pos = 0;
+        while (pos < content.size()) {
+            size_t end = content.find('\n', pos);
+            if (end == std::string::npos) end = content.size();
+            if (end > pos) pids.push_back(static_cast<pid_t>(std::stol(content.substr(pos, end - pos))));
+            pos = end + 1;
+        }
+        return pids;
+    }
+
+    // fork(), then hold the child until the parent has tried to move it into the cgroup
+    pid_t spawn_with_handshake(const std::string& name, std::string& error) {
+        int fds[2];
+        if (pipe2(fds, O_CLOEXEC) != 0) {
+            error = std::string("pipe failed: ") + strerror(errno);
+            return -1;
+        }
+        pid_t pid = fork();
+        if (pid < 0) {
+            error = std::string("fork failed: ") + strerror(errno);
+            close(fds[0]);
+            close(fds[1]);
+            return -1;
+        }
+        if (pid == 0) {
+            close(fds[1]);
+            char go = 0;
+            ssize_t n = read(fds[0], &go, 1);
+            close(fds[0]);
+            if (n != 1) _exit(1);
+            return 0;
+        }
+        close(fds[0]);
+        add_pid(name, pid, error);
+        char go = 1;
+        [[maybe_unused]] ssize_t n = write(fds[1], &go, 1);
+        close(fds[1]);
+        return pid;
+    }
+};
+
+}  // namespace cgroup
@@ -7,45 +7,74 @@
 #include <fstream>
 #include <filesystem>
 #include <chrono>
+#include <functional>
 #include <iomanip>
 #include <sstream>
+#include <thread>
 #include <cstdlib>
 #include <unistd.h>
 #include <sys/wait.h>
 #include <signal.h>
 #include <cstring>
+#include <fcntl.h>
+
+#include "agent_rpc.h"
+#include "cache_state.h"
+#include "cgroup_manager.h"
+#include "file_provisioner.h"
+#include "native_engine.h"
+#include "phase_aggregator.h"
+#include "policy_host.h"
+#include "psi_monitor.h"
+#include "perf_counters.h"
+#include "residency_sampler.h"
+#include "run_length.h"
+#include "results_analysis.h"
+#include "slo_controller.h"
+#include "slo_monitor.h"
+#include "sweep_plan.h"
+#include "telemetry_sampler.h"
+#include "tenant_sync.h"
+#include "topology.h"
+#include "workload_config.h"
 
 namespace fs = std::filesystem;
 
-struct PhaseConfig {
-    int runtime;
-    std::string block_size;
-    int iodepth;
-    std::string pattern;
-    std::string ioengine;
-    int numjobs;          // Per-phase numjobs (0 = use workload default)
-    std::string file_size; // Per-phase file_size (empty = use workload default)
-    int rate_iops;        // Per-phase rate_iops (0 = unlimited)
+using bench::CgroupConfig;
+using bench::ConfigSection;
+using bench::PhaseConfig;
+using bench::WorkloadConfig;
+using bench::WriterConfig;
+using bench::apply_workload_key;
+using bench::is_trace_pattern;
+using bench::resolve_writer;
+using bench::resolved_entries;
+
+// Telemetry running alongside one workload run; PSI events land in the sampler's file
+struct TelemetrySession {
+    std::unique_ptr<telemetry::Sampler> sampler;
+    std::unique_ptr<psi::PsiMonitor> psi;
+    std::unique_ptr<residency::Sampler> residency;
+
+    void stop() {
+        if (psi) psi->stop();
+        if (sampler) sampler->stop();
+        if (residency) residency->stop();
+    }
 };
 
-struct WorkloadConfig {
-    std::string description;
-    std::string file_size;
-    int numjobs;
-    int rate_iops;        // Workload-level rate_iops (0 = unlimited)
-    // Legacy single-phase config (for backward compatibility)
-    std::string block_size;
-    int runtime;
-    int iodepth;
-    std::string pattern;
-    std::string ioengine;
-    // Multi-phase config
-    std::vector<PhaseConfig> phases;
+// One concurrently running client: results go to <label>_<mode>*, cgroup from cgroups[cgroup_key]
+struct TenantSpec {
+    std::string label;
+    std::string cgroup_key;
+    const WorkloadConfig* config;
 };
 
-struct CgroupConfig {
-    std::string cgroup_name;
-    std::map<std::string, std::string> settings;
+// What ties one native engine run to the rest of the benchmark (all optional)
+struct EngineHooks {
+    std::function<uint64_t()> wait_start;   // Block at a start shared with other tenants (empty = start now)
+    slo::Reporter* slo_reporter = nullptr;  // Online SLO metric and early stop
+    runlen::Estimator* estimator = nullptr; // Adaptive run length
 };
 
 class FairnessBenchmark {
@@ -53,11 +82,42 @@ private:
     std::string config_file;
     std::string output_dir;
     bool verbose;
-    std::map<std::string, WorkloadConfig> workloads;
+    bench::Workloads workloads;
+    std::vector<ConfigSection> config_sections;
+    sweep::Plan sweep_plan;
+    bool has_sweep_plan = false;
+    int shard_index = 0;            // --shard K/N: run points with ordinal % N == K-1
+    int shard_count = 1;
     std::map<std::string, CgroupConfig> cgroups;
+    std::map<std::string, std::string> tenant_cgroup_defaults;  // [tenant_default] settings for multi mode
+    cgroup::CgroupManager cgroup_manager;
     std::string cgroup_config_file;
     bool use_cgroups;
     std::string cache_mode_filter;  // "both", "cached", or "direct"
+    std::string engine;             // "fio" or "native"
+    provision::Options fill_options;  // Test file content (--fill)
+    int sample_interval_ms;         // Telemetry sampling period (0 = off)
+    int residency_interval_ms;      // Test file page-cache residency scan period (0 = off)
+    int psi_threshold_ms;           // PSI trigger stall threshold (0 = off)
+    int psi_window_ms;              // PSI trigger window
+    std::string controller;         // "none" or "dirty_slo"
+    int slo_p99_us;                 // client1 p99 target for the controller
+    int drain_target_ms;            // Longest acceptable client2 dirty-backlog drain
+    int controller_interval_ms;
+    int mrc_samples;                // Native engine: SHARDS sample set per phase (0 = no MRC)
+    arena::HugePages hugepages;     // Native engine: backing of the per-worker I/O buffer arenas
+    cache_state::Mode cache_state_mode; // How each run starts cold (or warm)
+    static constexpr int kWarmStartRuntimeS = 2;  // Warmup phase length once a snapshot is restored
+    std::string slo_baseline;       // Directory with <tenant>_alone results for online SLO metrics (empty = off)
+    double slo_factor;              // SLO = factor x p99 alone
+    double slo_settle_pp;           // Early stop at this 95% CI half-width of the violation fraction (0 = off)
+    double adaptive_ci_pct;         // End phases once p99 is known to +-this percent (0 = fixed runtime)
+    int adaptive_min_s;             // Shortest phase under --adaptive-ci
+    bool blk_attr;                  // Run the eBPF block attribution collector (./blk_attr)
+    bool perf_counters;             // Sample per-tenant perf counters and kswapd CPU time into telemetry
+    sweep::Overrides active_overrides;  // Overrides the workloads were built with (sent to agents)
+    policy::Spec policy_spec;       // [policy] of the cgroup config (cache policy plugin or process)
+    std::string agent_token;        // Shared secret of the agents (--agent-token / --agent-token-file)
 
     std::string get_timestamp() {
         auto now = std::chrono::system_clock::now();
@@ -80,7 +140,7 @@ private:
     }
 
     bool check_dependencies() {
-        if (system("which fio > /dev/null 2>&1") != 0) {
+        if (engine == "fio" && system("which fio > /dev/null 2>&1") != 0) {
             log("ERROR: fio is required but not installed");
             return false;
         }
@@ -96,11 +156,20 @@ private:
     void setup() {
         log("Setting up fairness benchmark...");
 
+        // The results store outlives the directory, so runs into it can be compared
+        std::string store_path = output_dir + "/results.fbc";
+        std::string kept_store;
+        if (fs::exists(store_path)) {
+            kept_store = output_dir + ".results.fbc";
+            fs::rename(store_path, kept_store);
+        }
         if (fs::exists(output_dir)) {
             fs::remove_all(output_dir);
         }
         fs::create_directories(output_dir);
+        if (!kept_store.empty()) fs::rename(kept_store, store_path);
         fs::create_directories(output_dir + "/iostat");
+        fs::create_directories(output_dir + "/telemetry");
 
         // Create metadata
         std::ofstream metadata(output_dir + "/metadata.txt");
@@ -146,12 +215,6 @@ private:
             log("Cleaning up cgroups...");
         }
 
-        // Determine if running under systemd
-        std::string systemd_check = "test -d /sys/fs/cgroup/system.slice 2>/dev/null";
-        bool is_systemd = (system(systemd_check.c_str()) == 0);
-
-        std::string base_path = is_systemd ? "/sys/fs/cgroup/user.slice" : "/sys/fs/cgroup";
-
         // Sort cgroups by path depth (children before parents for cleanup)
         std::vector<std::pair<std::string, int>> sorted_cgroups;
         for (const auto& [client_name, cgroup] : cgroups) {
@@ -166,27 +229,90 @@ private:
         // Remove all configured cgroups in reverse order (children before parents)
         for (const auto& [client_name, depth] : sorted_cgroups) {
             const auto& cgroup = cgroups[client_name];
-            std::string cgroup_path = base_path + "/" + cgroup.cgroup_name;
 
-            // Kill any processes in the cgroup first
-            std::string kill_cmd = "sudo kill -9 $(cat " + cgroup_path + "/cgroup.procs 2>/dev/null) 2>/dev/null || true";
-            run_system(kill_cmd);
-
-            // Remove the cgroup directory
-            std::string rmdir_cmd = "sudo rmdir " + cgroup_path + " 2>/dev/null || true";
-            run_system(rmdir_cmd);
-
-            if (verbose) {
+            // Kill any processes in the cgroup first, then remove the directory
+            cgroup_manager.kill_all(cgroup.cgroup_name);
+            if (cgroup_manager.remove(cgroup.cgroup_name) && verbose) {
                 log("  Removed cgroup: " + cgroup.cgroup_name);
             }
         }
 
-        // Also try to remove parent "clients" cgroup if it exists
-        std::string parent_path = base_path + "/clients";
-        std::string kill_parent = "sudo kill -9 $(cat " + parent_path + "/cgroup.procs 2>/dev/null) 2>/dev/null || true";
-        run_system(kill_parent);
-        std::string rmdir_parent = "sudo rmdir " + parent_path + " 2>/dev/null || true";
-        run_system(rmdir_parent);
+        // Remove intermediate parents (e.g. "clients", "tenants"), deepest first
+        std::set<std::string> parents = {"clients"};
+        for (const auto& [client_name, cgroup] : cgroups) {
+            for (size_t pos = cgroup.cgroup_name.find('/'); pos != std::string::npos;
+                 pos = cgroup.cgroup_name.find('/', pos + 1)) {
+                parents.insert(cgroup.cgroup_name.substr(0, pos));
+            }
+        }
+        for (auto it = parents.rbegin(); it != parents.rend(); ++it) {
+            cgroup_manager.kill_all(*it);
+            cgroup_manager.remove(*it);
+        }
+    }
+
+    // Start a run cold: drop every cache on the host, or just evict the test files
+    void reset_cache(const std::set<std::string>& test_files) {
+        if (cache_state_mode == cache_state::Mode::Drop) {
+            drop_caches();
+            return;
+        }
+        log("Evicting " + std::to_string(test_files.size()) + " test file(s) from the page cache...");
+        for (const auto& file : test_files) {
+            std::string error;
+            if (!cache_state::evict_file(file, error)) log("WARNING: " + error);
+        }
+    }
+
+    // Snapshot of the test files' cache state at the end of a group's warmup phases
+    std::string cache_snapshot_path(const std::string& group_label) {
+        return ".cache_state/" + fs::path(config_file).stem().string() + "_" + group_label + ".cst";
+    }
+
+    bool restore_cache_snapshot(const std::string& path) {
+        std::vector<cache_state::FileState> files;
+        std::string error;
+        if (!fs::exists(path) || !cache_state::load(path, files, error) || !cache_state::matches(files)) {
+            if (!error.empty()) log("WARNING: " + error);
+            return false;
+        }
+        cache_state::RestoreResult result;
+        if (!cache_state::restore(files, result, error)) {
+            log("WARNING: Cannot restore " + path + ": " + error);
+            return false;
+        }
+        const double page_mb = cache_state::page_size() / 1048576.0;
+        std::ostringstream msg;
+        msg << std::fixed << std::setprecision(1) << "Restored warmup cache state: " << result.resident_pages * page_mb
+            << "/" << result.requested_pages * page_mb << " MB resident after " << result.seconds << "s (" << path
+            << ")";
+        log(msg.str());
+        return true;
+    }
+
+    void save_cache_snapshot(const std::string& path, const std::set<std::string>& test_files) {
+        std::vector<cache_state::FileState> files;
+        uint64_t pages = 0;
+        for (const auto& file : test_files) {
+            cache_state::FileState state;
+            std::string error;
+            if (!cache_state::capture_file(file, state, error)) {
+                log("WARNING: Cache state not saved: " + error);
+                return;
+            }
+            pages += state.resident_pages;
+            files.push_back(std::move(state));
+        }
+        std::string error;
+        fs::create_directories(fs::path(path).parent_path());
+        if (!cache_state::save(path, files, error)) {
+            log("WARNING: Cache state not saved: " + error);
+            return;
+        }
+        std::ostringstream msg;
+        msg << std::fixed << std::setprecision(1) << "  Saved warmup cache state: "
+            << pages * (cache_state::page_size() / 1048576.0) << " MB resident (" << path << ")";
+        log(msg.str());
     }
 
     void drop_caches() {
@@ -200,6 +326,226 @@ private:
         run_system("sync");
     }
 
+    // Resolved cgroupfs directory of a client's cgroup, empty if not configured
+    std::string cgroup_dir(const std::string& client_name) {
+        auto it = cgroups.find(client_name);
+        if (!use_cgroups || it == cgroups.end()) return "";
+        return cgroup_manager.path(it->second.cgroup_name);
+    }
+
+    // Per-cgroup queue/device latency from the eBPF collector (make bpf) into blkattr/<label>.csv
+    pid_t start_blk_attr(const std::string& label) {
+        if (!blk_attr) return -1;
+        std::string collector = fs::current_path().string() + "/blk_attr";
+        if (access(collector.c_str(), X_OK) != 0) {
+            log("WARNING: --blk-attr needs ./blk_attr (build it with 'make bpf'), block attribution disabled");
+            return -1;
+        }
+        fs::create_directories(output_dir + "/blkattr");
+        std::string out_file = output_dir + "/blkattr/" + label + ".csv";
+        std::string err_file = output_dir + "/blkattr/" + label + ".log";
+        std::string devno = control::disk_devno_for(fs::current_path().string());
+        pid_t pid = fork();
+        if (pid == 0) {
+            [[maybe_unused]] FILE* err = freopen(err_file.c_str(), "w", stderr);
+            if (devno.empty()) {
+                execl(collector.c_str(), "blk_attr", "-o", out_file.c_str(), nullptr);
+            } else {
+                execl(collector.c_str(), "blk_attr", "-o", out_file.c_str(), "-d", devno.c_str(), nullptr);
+            }
+            exit(1);
+        }
+        return pid;
+    }
+
+    void stop_blk_attr(pid_t pid) {
+        if (pid <= 0) return;
+        // SIGTERM makes the collector drain its maps one last time
+        kill(pid, SIGTERM);
+        waitpid(pid, nullptr, 0);
+    }
+
+    // Page-cache residency of each test file into telemetry/<label>.res
+    std::unique_ptr<residency::Sampler> start_residency(const std::string& label,
+                                                        const std::set<std::string>& test_files) {
+        if (residency_interval_ms <= 0 || test_files.empty()) return nullptr;
+        auto sampler = std::make_unique<residency::Sampler>(residency_interval_ms * 1000000ULL);
+        std::string error;
+        for (const auto& file : test_files) {
+            if (!sampler->add_file(file, error)) log("WARNING: " + error);
+        }
+        if (sampler->num_files() == 0) return nullptr;
+        if (!sampler->open(output_dir + "/telemetry/" + label + ".res", error)) {
+            log("WARNING: " + error);
+            return nullptr;
+        }
+        sampler->start();
+        return sampler;
+    }
+
+    // Every test file a workload touches, across its phases
+    std::set<std::string> test_files_of(const WorkloadConfig& config) {
+        std::string script_dir = fs::current_path().string();
+        std::set<std::string> files = {script_dir + "/test_file_" + config.file_size};
+        for (const auto& phase : config.phases) {
+            if (!phase.file_size.empty()) files.insert(script_dir + "/test_file_" + phase.file_size);
+        }
+        return files;
+    }
+
+    // --perf-counters: each client cgroup's CPU-side counters and the kswapd threads' CPU time
+    void add_perf_sources(telemetry::Sampler& sampler, const std::vector<std::string>& clients) {
+        std::string error;
+        auto kswapd = std::make_shared<perf::KswapdTime>();
+        if (kswapd->open(error)) {
+            sampler.add_sampled_source("kswapd", telemetry::kSourceKswapd, perf::kswapd_columns(),
+                                       [kswapd](uint64_t* values) { return kswapd->sample(values); });
+        } else {
+            log("WARNING: " + error);
+        }
+        if (!use_cgroups && !clients.empty()) {
+            log("WARNING: --perf-counters counts per tenant cgroup, none without cgroups");
+            return;
+        }
+        for (const auto& client : clients) {
+            std::string dir = cgroup_dir(client);
+            if (dir.empty()) continue;
+            auto counters = std::make_shared<perf::CgroupCounters>();
+            std::string missing;
+            if (!counters->open(dir, missing, error)) {
+                // Permissions and PMU support are the same for every cgroup
+                log("WARNING: " + error + ", perf counters disabled");
+                return;
+            }
+            if (!missing.empty()) log("WARNING: " + client + ": no " + missing + " counter here, recorded as 0");
+            sampler.add_sampled_source(client + ":cpu", telemetry::kSourcePerf, perf::counter_columns(),
+                                       [counters](uint64_t* values) { return counters->sample(values); });
+        }
+    }
+
+    // Sample vmstat plus each client's memory.stat (and perf counters) into telemetry/<label>.tel,
+    // with PSI triggers of the system and every configured cgroup as events,
+    // and the test files' residency into telemetry/<label>.res
+    TelemetrySession start_telemetry(const std::string& label, const std::vector<std::string>& clients,
+                                     const std::set<std::string>& test_files) {
+        TelemetrySession session;
+        session.residency = start_residency(label, test_files);
+        if (sample_interval_ms <= 0) return session;
+
+        auto sampler = std::make_unique<telemetry::Sampler>(sample_interval_ms * 1000000ULL);
+        std::string error;
+        if (!sampler->add_vmstat(error)) {
+            log("WARNING: " + error);
+        }
+        for (const auto& client : clients) {
+            std::string dir = cgroup_dir(client);
+            if (dir.empty()) continue;
+            if (!sampler->add_memory_stat(client, dir, error)) {
+                log("WARNING: " + error);
+            }
+        }
+        if (perf_counters) add_perf_sources(*sampler, clients);
+        if (sampler->num_sources() == 0) {
+            log("WARNING: No telemetry sources available, sampling disabled");
+            return session;
+        }
+
+        if (psi_threshold_ms > 0) {
+            auto monitor = std::make_unique<psi::PsiMonitor>(psi_threshold_ms * 1000ULL, psi_window_ms * 1000ULL);
+            if (!monitor->add_system(error)) {
+                log("WARNING: " + error);
+            }
+            for (const auto& [client_name, cgroup] : cgroups) {
+                std::string dir = cgroup_dir(client_name);
+                if (dir.empty() || !fs::exists(dir)) continue;
+                if (!monitor->add_target(client_name, dir, error)) {
+                    log("WARNING: " + error);
+                }
+            }
+            if (!monitor->triggers().empty()) {
+                // One event source per target and resource; column 0 says some (0) or full (1)
+                std::map<std::string, int> source_ids;
+                for (const auto& trigger : monitor->triggers()) {
+                    std::string name = trigger.target + ":" + psi::resource_name(trigger.resource);
+                    if (source_ids.count(name)) continue;
+                    source_ids[name] = sampler->add_event_source(
+                        name, telemetry::kSourcePsiEvent,
+                        {"kind_full", "some_total_us", "full_total_us", "threshold_us", "window_us"});
+                }
+                telemetry::Sampler* sink = sampler.get();
+                monitor->subscribe([sink, source_ids](const psi::PsiEvent& event) {
+                    auto it = source_ids.find(event.target + ":" + psi::resource_name(event.resource));
+                    if (it == source_ids.end()) return;
+                    uint64_t values[] = {event.kind, event.some_total_us, event.full_total_us,
+                                         event.threshold_us, event.window_us};
+                    sink->append(it->second, event.timestamp_ns, values, 5);
+                });
+                if (monitor->window_rounded()) {
+                    log("WARNING: PSI window rounded up to a multiple of 2s (needs CAP_SYS_RESOURCE for shorter windows)");
+                }
+                session.psi = std::move(monitor);
+            }
+        }
+
+        if (!sampler->open(output_dir + "/telemetry/" + label + ".tel", error)) {
+            log("WARNING: " + error);
+            session.psi.reset();
+            return session;
+        }
+        sampler->start();
+        session.sampler = std::move(sampler);
+        if (session.psi && !session.psi->start(error)) {
+            log("WARNING: PSI monitor not started: " + error);
+            session.psi.reset();
+        }
+        return session;
+    }
+
+    // dirty_slo: throttle client2 so client1 stays inside its p99 SLO
+    std::unique_ptr<control::DirtySloController> start_controller(const std::string& cache_mode,
+                                                                  psi::PsiMonitor* psi_monitor) {
+        if (controller != "dirty_slo") return nullptr;
+
+        std::string noisy_dir = cgroup_dir("client2_bursty");
+        if (noisy_dir.empty()) {
+            log("WARNING: dirty_slo controller needs a cgroup for client2_bursty, controller disabled");
+            return nullptr;
+        }
+
+        control::ControllerOptions options;
+        options.interval_ns = controller_interval_ms * 1000000ULL;
+        options.slo_p99_ns = slo_p99_us * 1000ULL;
+        options.drain_target_ns = drain_target_ms * 1000000ULL;
+        options.noisy_cgroup_dir = noisy_dir;
+        options.protected_cgroup_dir = cgroup_dir("client1_steady");
+        if (engine == "native") {
+            options.protected_lat_file = output_dir + "/client1_" + cache_mode + ".lat";
+            if (mrc_samples > 0) options.protected_mrc_file = output_dir + "/client1_" + cache_mode + ".mrc";
+        }
+        options.io_device = control::disk_devno_for(fs::current_path().string());
+        options.log_file = output_dir + "/controller_" + cache_mode + ".csv";
+
+        auto ctl = std::make_unique<control::DirtySloController>(options);
+        std::string error;
+        if (!ctl->start(error)) {
+            log("WARNING: dirty_slo controller not started: " + error);
+            return nullptr;
+        }
+        for (const auto& warning : ctl->get_warnings()) {
+            log("WARNING: " + warning);
+        }
+        if (psi_monitor) {
+            // Stalls of the protected tenant trigger an immediate tick
+            control::DirtySloController* target = ctl.get();
+            psi_monitor->subscribe([target](const psi::PsiEvent& event) {
+                if (event.target == "client1_steady") target->notify_pressure();
+            });
+        }
+        log("  dirty_slo controller: p99 SLO " + std::to_string(slo_p99_us) + "us, drain target " +
+            std::to_string(drain_target_ms) + "ms, every " + std::to_string(controller_interval_ms) + "ms");
+        return ctl;
+    }
+
     bool parse_cgroup_config() {
         if (!fs::exists(cgroup_config_file)) {
             log("Cgroup config file not found: " + cgroup_config_file + ", skipping cgroups");
@@ -259,12 +605,45 @@ private:
         if (!current_client.empty()) {
             cgroups[current_client] = current_cgroup;
         }
+        for (auto& [client, cgroup] : cgroups) expand_numa_node(client, cgroup.settings);
+
+        // [tenant_default] is a template for multi mode, not a cgroup of its own
+        auto defaults = cgroups.find("tenant_default");
+        if (defaults != cgroups.end()) {
+            tenant_cgroup_defaults = defaults->second.settings;
+            cgroups.erase(defaults);
+        }
+        // [policy] names the cache policy run alongside each concurrent test
+        auto policy_section = cgroups.find("policy");
+        if (policy_section != cgroups.end()) {
+            std::string error;
+            if (!policy::parse_spec(policy_section->second.settings, policy_spec, error)) {
+                log("ERROR: " + cgroup_config_file + ": " + error);
+                return false;
+            }
+            cgroups.erase(policy_section);
+        }
 
         file.close();
         log("Loaded cgroup config for " + std::to_string(cgroups.size()) + " clients");
         return true;
     }
 
+    // numa_node = N becomes cpuset.mems = N plus cpuset.cpus = the node's CPUs (unless set explicitly)
+    void expand_numa_node(const std::string& section, std::map<std::string, std::string>& settings) {
+        auto it = settings.find("numa_node");
+        if (it == settings.end()) return;
+        std::string value = it->second;
+        settings.erase(it);
+        std::vector<int> cpus = topology::Topology::discover().node_cpus(atoi(value.c_str()));
+        if (cpus.empty()) {
+            log("WARNING: [" + section + "] numa_node = " + value + " has no online CPUs, ignoring it");
+            return;
+        }
+        if (!settings.count("cpuset.cpus")) settings["cpuset.cpus"] = topology::format_cpulist(cpus);
+        settings["cpuset.mems"] = value;
+    }
+
     bool setup_cgroup(const std::string& client_name) {
         if (!use_cgroups) return true;
 
@@ -276,58 +655,21 @@ private:
 
         const auto& cgroup = it->second;
 
-        // For systemd-managed systems, use systemd slice hierarchy
-        // Check if running under systemd
-        std::string systemd_check = "test -d /sys/fs/cgroup/system.slice 2>/dev/null";
-        bool is_systemd = (system(systemd_check.c_str()) == 0);
-
-        std::string cgroup_path;
-        if (is_systemd) {
-            // Create under user.slice or a custom slice
-            cgroup_path = "/sys/fs/cgroup/user.slice/" + cgroup.cgroup_name;
-        } else {
-            cgroup_path = "/sys/fs/cgroup/" + cgroup.cgroup_name;
-        }
-
-        // Create cgroup directory (may be nested like clients/client1)
-        std::string mkdir_cmd = "sudo mkdir -p " + cgroup_path + " 2>/dev/null";
-        if (system(mkdir_cmd.c_str()) != 0) {
-            log("WARNING: Failed to create cgroup " + cgroup_path + ", running without cgroup");
+        // Create cgroup directory (may be nested like clients/client1) with
+        // cpu/cpuset/memory/io enabled in every ancestor
+        std::string error;
+        if (!cgroup_manager.create(cgroup.cgroup_name, error)) {
+            log("WARNING: " + error + ", running without cgroup");
             return true;
         }
 
-        // Enable controllers in all parent directories up to root
-        std::string base_path = is_systemd ? "/sys/fs/cgroup/user.slice" : "/sys/fs/cgroup";
-
-        // Enable controllers in base path
-        std::string enable_cmd = "echo '+cpu +memory +io' | sudo tee " + base_path + "/cgroup.subtree_control > /dev/null 2>&1";
-        run_system(enable_cmd);
-
-        // If cgroup_name contains '/', enable controllers in intermediate directories
-        size_t slash_pos = cgroup.cgroup_name.find('/');
-        if (slash_pos != std::string::npos) {
-            std::string intermediate = cgroup.cgroup_name.substr(0, slash_pos);
-            std::string intermediate_path = base_path + "/" + intermediate;
-
-            // Create intermediate directory
-            std::string mkdir_intermediate = "sudo mkdir -p " + intermediate_path + " 2>/dev/null";
-            run_system(mkdir_intermediate);
-
-            // Enable controllers in intermediate directory
-            std::string enable_intermediate = "echo '+cpu +memory +io' | sudo tee " + intermediate_path + "/cgroup.subtree_control > /dev/null 2>&1";
-            run_system(enable_intermediate);
-        }
-
         // Apply cgroup settings
         int success_count = 0;
         int fail_count = 0;
 
         for (const auto& [key, value] : cgroup.settings) {
-            std::string setting_file = cgroup_path + "/" + key;
-
             // Check if the controller file exists first
-            std::string check_cmd = "test -f " + setting_file;
-            if (system(check_cmd.c_str()) != 0) {
+            if (!cgroup_manager.has_file(cgroup.cgroup_name, key)) {
                 // File doesn't exist, controller might not be enabled
                 fail_count++;
                 if (verbose) {
@@ -336,8 +678,7 @@ private:
                 continue;
             }
 
-            std::string set_cmd = "echo '" + value + "' | sudo tee " + setting_file + " > /dev/null 2>&1";
-            if (system(set_cmd.c_str()) == 0) {
+            if (cgroup_manager.write_file(cgroup.cgroup_name, key, value, error)) {
                 success_count++;
                 if (verbose) {
                     log("✓ Set " + key + " = " + value + " for cgroup " + cgroup.cgroup_name);
@@ -345,7 +686,8 @@ private:
             } else {
                 fail_count++;
                 if (verbose) {
-                    log("WARNING: Failed to set " + key + " = " + value + " for cgroup " + cgroup.cgroup_name);
+                    log("WARNING: Failed to set " + key + " = " + value + " for cgroup " +
+                        cgroup.cgroup_name + ": " + error);
                 }
             }
         }
@@ -353,7 +695,7 @@ private:
         if (success_count > 0) {
             log("Setup cgroup: " + cgroup.cgroup_name + " (" + std::to_string(success_count) +
                 " settings applied, " + std::to_string(fail_count) + " failed)");
-        } else if (is_systemd) {
+        } else if (cgroup_manager.is_systemd()) {
             log("INFO: Running under systemd - cgroup controllers managed by systemd");
         } else {
             log("WARNING: No cgroup settings applied for " + cgroup.cgroup_name + " (controllers may not be available)");
@@ -362,96 +704,325 @@ private:
         return true;
     }
 
-    bool add_pid_to_cgroup(const std::string& client_name, pid_t pid) {
-        if (!use_cgroups) return true;
-
+    // fork() that places the child in the client's cgroup before it runs
+    pid_t spawn_client(const std::string& client_name) {
         auto it = cgroups.find(client_name);
-        if (it == cgroups.end()) return true;
-
-        const auto& cgroup = it->second;
+        std::string cgroup_name = (use_cgroups && it != cgroups.end()) ? it->second.cgroup_name : "";
+        std::string error;
+        pid_t pid = cgroup_manager.spawn(cgroup_name, error);
+        if (pid > 0 && !error.empty()) {
+            log("WARNING: " + client_name + " running outside its cgroup: " + error);
+        } else if (pid < 0) {
+            log("ERROR: Failed to launch " + client_name + (error.empty() ? "" : ": " + error));
+        }
+        return pid;
+    }
 
-        // Determine the correct path (systemd vs non-systemd)
-        std::string systemd_check = "test -d /sys/fs/cgroup/system.slice 2>/dev/null";
-        bool is_systemd = (system(systemd_check.c_str()) == 0);
+    uintmax_t get_size_bytes(const std::string& size_str) {
+        // Parse size strings like "1G", "16G", "512M", "2T", etc.
+        return provision::parse_size(size_str);
+    }
 
-        std::string cgroup_path;
-        if (is_systemd) {
-            cgroup_path = "/sys/fs/cgroup/user.slice/" + cgroup.cgroup_name;
-        } else {
-            cgroup_path = "/sys/fs/cgroup/" + cgroup.cgroup_name;
+    void create_test_file(const std::string& file_size, const std::string& test_file) {
+        uintmax_t size_bytes = get_size_bytes(file_size);
+        if (size_bytes == 0) {
+            log("ERROR: Invalid file size: " + file_size);
+            exit(1);
         }
 
-        std::string procs_file = cgroup_path + "/cgroup.procs";
+        if (provision::is_current(test_file, size_bytes, fill_options)) {
+            log("Using existing " + file_size + " test file: " + test_file);
+            return;
+        }
 
-        std::string add_cmd = "echo " + std::to_string(pid) + " | sudo tee " + procs_file + " > /dev/null 2>&1";
-        if (system(add_cmd.c_str()) != 0) {
-            if (verbose) {
-                log("WARNING: Failed to add PID " + std::to_string(pid) + " to cgroup " + cgroup.cgroup_name);
-            }
-            return false;
+        log("Creating " + file_size + " test file (" + provision::content_name(fill_options.content) +
+            " content): " + test_file);
+        provision::Result result;
+        std::string error;
+        if (!provision::provision_file(test_file, size_bytes, fill_options, result, error)) {
+            log("ERROR: " + error);
+            exit(1);
         }
+        std::ostringstream msg;
+        msg << std::fixed << std::setprecision(1) << "Test file created: " << test_file << " ("
+            << size_bytes / (1024.0 * 1024 * 1024) / std::max(result.seconds, 1e-6) << " GB/s, "
+            << result.threads << " threads" << (result.direct ? ", O_DIRECT" : ", buffered") << ")";
+        log(msg.str());
+    }
 
-        return true;
+    // fio options for an ioengine name; io_uring_sqpoll is our alias for
+    // io_uring with a kernel SQ poller, registered buffers and fixed files
+    std::string fio_ioengine_args(const std::string& ioengine) {
+        if (ioengine.empty()) return "";
+        if (ioengine == "io_uring_sqpoll") {
+            return " --ioengine=io_uring --sqthread_poll=1 --fixedbufs=1 --registerfiles=1";
+        }
+        return " --ioengine=" + ioengine;
     }
 
-    uintmax_t get_size_bytes(const std::string& size_str) {
-        // Parse size strings like "1G", "16G", "512M", "2T", etc.
-        if (size_str.empty()) return 0;
-
-        uintmax_t multiplier = 1;
-        char unit = size_str.back();
-
-        // Determine multiplier based on unit
-        if (unit == 'K' || unit == 'k') {
-            multiplier = 1024ULL;
-        } else if (unit == 'M' || unit == 'm') {
-            multiplier = 1024ULL * 1024;
-        } else if (unit == 'G' || unit == 'g') {
-            multiplier = 1024ULL * 1024 * 1024;
-        } else if (unit == 'T' || unit == 't') {
-            multiplier = 1024ULL * 1024 * 1024 * 1024;
-        } else {
-            // No unit, assume bytes
-            return std::stoull(size_str);
+
+    // fio's --random_distribution for a distribution spec; false if fio has no equivalent
+    static bool fio_distribution_args(const std::string& spec, std::string& args) {
+        args.clear();
+        if (spec.empty() || spec == "uniform") return true;
+        if (spec.compare(0, 5, "zipf:") == 0) {
+            args = " --random_distribution=" + spec;
+            return true;
+        }
+        double fraction = 0, probability = 0;
+        if (sscanf(spec.c_str(), "hotset:%lf:%lf", &fraction, &probability) == 2) {
+            // zoned:<access %>/<size %>:...
+            int hot_access = static_cast<int>(std::lround(probability * 100));
+            int hot_size = static_cast<int>(std::lround(fraction * 100));
+            args = " --random_distribution=zoned:" + std::to_string(hot_access) + "/" + std::to_string(hot_size) +
+                   ":" + std::to_string(100 - hot_access) + "/" + std::to_string(100 - hot_size);
+            return true;
         }
+        return false;
+    }
 
-        // Extract numeric part
-        std::string numeric = size_str.substr(0, size_str.length() - 1);
-        return std::stoull(numeric) * multiplier;
+    // fio's write rate limit for a resolved writer profile (dirty_rate is across jobs, --rate per job)
+    std::string fio_writer_args(const WriterConfig& writer, int numjobs) {
+        uintmax_t bytes = get_size_bytes(writer.dirty_rate);
+        if (bytes == 0) return "";
+        return " --rate=," + std::to_string(std::max<uintmax_t>(1, bytes / std::max(numjobs, 1)));
     }
 
-    void create_test_file(const std::string& file_size, const std::string& test_file) {
-        if (fs::exists(test_file)) {
-            auto actual_size = fs::file_size(test_file);
-            auto expected_size = get_size_bytes(file_size);
+    static bool is_closed_loop(const std::string& arrival) { return arrival.empty() || arrival == "closed"; }
+
+    // Trace replay, pareto:ALPHA, hotspot, periodic syncs, checkpoints and open-loop arrivals are native-only
+    bool check_fio_patterns(const WorkloadConfig& config) {
+        std::string args;
+        auto writer_ok = [](const WriterConfig& w) { return w.sync_interval_ms == 0 && w.checkpoint_interval_s == 0; };
+        bool ok = !is_trace_pattern(config.pattern) && fio_distribution_args(config.distribution, args) &&
+                  writer_ok(config.writer) && is_closed_loop(config.arrival);
+        for (const auto& phase : config.phases) {
+            ok = ok && !is_trace_pattern(phase.pattern) && fio_distribution_args(phase.distribution, args) &&
+                 writer_ok(phase.writer) && is_closed_loop(phase.arrival);
+        }
+        if (!ok) {
+            log("ERROR: trace:<file> patterns, pareto/hotspot distributions, sync_interval_ms, checkpoints "
+                "and open-loop arrivals require the native engine (-e native)");
+        }
+        return ok;
+    }
 
-            if (actual_size >= expected_size) {
-                log("Using existing " + file_size + " test file: " + test_file);
-                return;
+    // Resolve a workload into native engine phases, applying the same
+    // per-phase fallbacks to workload defaults as the fio command builder
+    bool build_engine_phases(const std::string& name_prefix, const WorkloadConfig& config,
+                             std::vector<native::EnginePhase>& out) {
+        std::string script_dir = fs::current_path().string();
+        std::vector<PhaseConfig> phases = config.phases;
+        bool is_multi_phase = !phases.empty();
+        if (!is_multi_phase) {
+            phases.push_back(bench::legacy_phase(config));
+        }
+
+        for (size_t phase_idx = 0; phase_idx < phases.size(); phase_idx++) {
+            const auto& phase = phases[phase_idx];
+            native::EnginePhase ep;
+            ep.name = is_multi_phase ? name_prefix + "_phase" + std::to_string(phase_idx + 1) : name_prefix;
+            ep.output_file = output_dir + "/" + ep.name + ".json";
+
+            std::string phase_file_size = phase.file_size.empty() ? config.file_size : phase.file_size;
+            ep.file = script_dir + "/test_file_" + phase_file_size;
+            ep.file_size = get_size_bytes(phase_file_size);
+            ep.block_size = get_size_bytes(phase.block_size);
+            ep.runtime = phase.runtime;
+            ep.iodepth = phase.iodepth > 0 ? phase.iodepth : 1;
+            ep.numjobs = (phase.numjobs > 0) ? phase.numjobs : std::max(config.numjobs, 1);
+            ep.rate_iops = (phase.rate_iops > 0) ? phase.rate_iops : config.rate_iops;
+            ep.ioengine = phase.ioengine;
+
+            if (is_trace_pattern(phase.pattern)) {
+                ep.pattern = native::IoPattern::Trace;
+                ep.trace_file = phase.pattern.substr(6);
+                double speed = phase.trace_speed > 0 ? phase.trace_speed : config.trace_speed;
+                ep.trace_speed = speed > 0 ? speed : 1.0;
+            } else if (!native::parse_pattern(phase.pattern, ep.pattern)) {
+                log("ERROR: Pattern '" + phase.pattern + "' is not supported by the native engine");
+                return false;
             }
+            ep.distribution = phase.distribution.empty() ? config.distribution : phase.distribution;
+            if (!ep.distribution.empty() && ep.block_size > 0) {
+                // Report the effective working set the distribution gives this file
+                dist::OffsetDistribution distribution;
+                std::string error;
+                if (!distribution.init(ep.distribution, ep.file_size / ep.block_size, error)) {
+                    log("ERROR: " + ep.name + ": " + error);
+                    return false;
+                }
+                std::ostringstream msg;
+                msg << std::fixed << std::setprecision(1) << "    " << ep.name << " " << ep.distribution
+                    << ": 50%/90%/99% of accesses hit "
+                    << distribution.blocks_for_share(0.5) * ep.block_size / 1048576.0 << "/"
+                    << distribution.blocks_for_share(0.9) * ep.block_size / 1048576.0 << "/"
+                    << distribution.blocks_for_share(0.99) * ep.block_size / 1048576.0 << " MB";
+                log(msg.str());
+            }
+            if (!apply_writer_profile(resolve_writer(phase.writer, config.writer), ep)) return false;
+            std::string error;
+            if (!arrival::parse(phase.arrival.empty() ? config.arrival : phase.arrival, ep.arrival, error)) {
+                log("ERROR: " + ep.name + ": " + error);
+                return false;
+            }
+            out.push_back(ep);
         }
+        return true;
+    }
 
-        log("Creating " + file_size + " test file: " + test_file);
+    bool apply_writer_profile(const WriterConfig& writer, native::EnginePhase& ep) {
+        if (!native::parse_sync_mode(writer.sync, ep.sync)) {
+            log("ERROR: " + ep.name + ": unknown sync mode '" + writer.sync +
+                "' (none, fsync, fdatasync, sync_file_range)");
+            return false;
+        }
+        if (!writer.dirty_rate.empty() && (ep.dirty_rate = get_size_bytes(writer.dirty_rate)) == 0) {
+            log("ERROR: " + ep.name + ": invalid dirty_rate '" + writer.dirty_rate + "'");
+            return false;
+        }
+        if (!writer.checkpoint_size.empty() && (ep.checkpoint_bytes = get_size_bytes(writer.checkpoint_size)) == 0) {
+            log("ERROR: " + ep.name + ": invalid checkpoint_size '" + writer.checkpoint_size + "'");
+            return false;
+        }
+        ep.sync_interval_ns = static_cast<uint64_t>(std::max(writer.sync_interval_ms, 0)) * 1000000ULL;
+        ep.checkpoint_interval_ns = static_cast<uint64_t>(std::max(writer.checkpoint_interval_s, 0)) * 1000000000ULL;
+        return true;
+    }
 
-        // Parse size to determine dd parameters
-        uintmax_t size_bytes = get_size_bytes(file_size);
-        if (size_bytes == 0) {
-            log("ERROR: Invalid file size: " + file_size);
-            exit(1);
+    // Workers take the requested CPUs in topology::spread order, restricted to our cpuset
+    bool resolve_placement(const WorkloadConfig& config, std::vector<native::WorkerPlacement>& placement) {
+        placement.clear();
+        if (config.cpus.empty() && config.numa_node < 0) return true;
+        topology::Topology topo = topology::Topology::discover();
+        std::vector<int> wanted;
+        if (!config.cpus.empty()) {
+            if (!topology::parse_cpulist(config.cpus, wanted)) {
+                log("ERROR: Invalid cpus list '" + config.cpus + "'");
+                return false;
+            }
+        } else {
+            wanted = topo.node_cpus(config.numa_node);
+            if (wanted.empty()) {
+                log("ERROR: NUMA node " + std::to_string(config.numa_node) + " has no online CPUs");
+                return false;
+            }
+        }
+        std::vector<int> allowed = topology::allowed_cpus();
+        std::vector<int> usable;
+        for (int c : wanted) {
+            if (std::find(allowed.begin(), allowed.end(), c) != allowed.end()) usable.push_back(c);
+        }
+        usable = topo.spread(usable);
+        if (usable.empty()) {
+            log("ERROR: None of CPUs " + topology::format_cpulist(wanted) + " are in this client's cpuset (" +
+                topology::format_cpulist(allowed) + ")");
+            return false;
+        }
+        if (usable.size() < wanted.size()) {
+            log("WARNING: Only CPUs " + topology::format_cpulist(usable) + " of " +
+                topology::format_cpulist(wanted) + " are in this client's cpuset");
+        }
+        std::set<int> nodes;
+        for (int c : usable) {
+            int node = topo.node_of(c);
+            nodes.insert(node);
+            placement.push_back({c, config.numa_node >= 0 ? config.numa_node : node});
+        }
+        std::string node_list;
+        for (int n : nodes) node_list += (node_list.empty() ? "" : ",") + std::to_string(n);
+        log("    Placement: workers on CPUs " + topology::format_cpulist(usable) + " (node " + node_list +
+            "), buffers node-local");
+        return true;
+    }
+
+    // label names the per-window latency file (<label>.lat) written next to the JSON results
+    bool run_native_engine(const std::vector<native::EnginePhase>& phases, const WorkloadConfig& config,
+                           const std::string& cache_mode, const std::string& label,
+                           EngineHooks hooks = EngineHooks()) {
+        native::EngineOptions options;
+        options.wait_start = std::move(hooks.wait_start);
+        slo::Reporter* slo_reporter = hooks.slo_reporter;
+        runlen::Estimator* estimator = hooks.estimator;
+        if (slo_reporter || estimator) {
+            options.window_observer = [slo_reporter, estimator](uint64_t window, int phase, int dir,
+                                                                const latency::Histogram& h) {
+                if (slo_reporter) slo_reporter->observe(window, phase, dir, h);
+                if (estimator) estimator->observe(window, phase, dir, h);
+            };
+        }
+        if (slo_reporter) options.stop_flag = slo_reporter->stop_flag();
+        if (estimator) options.schedule_shift = estimator->shift();
+        if (!resolve_placement(config, options.placement)) return false;
+        options.direct = (cache_mode == "direct");
+        options.latency_file = output_dir + "/" + label + ".lat";
+        options.client = label;
+        options.mrc_samples = static_cast<size_t>(mrc_samples);
+        options.mrc_file = output_dir + "/" + label + ".mrc";
+        options.hugepages = hugepages;
+
+        native::NativeEngine native_engine(phases, options);
+        bool ok = native_engine.run();
+        if (slo_reporter) slo_reporter->finish();
+        for (const auto& warning : native_engine.warnings()) {
+            log("WARNING: " + warning);
+        }
+        if (!ok) {
+            log("ERROR: Native engine failed: " + native_engine.error());
+            return false;
+        }
+        if (!native_engine.arena_summary().empty()) log("    I/O buffers: " + native_engine.arena_summary());
+        if (options.wait_start) {
+            log("    Shared start: last worker began " + std::to_string(native_engine.start_skew_ns() / 1000) +
+                "us after the epoch");
         }
+        for (const auto& m : native_engine.mrc_results()) {
+            std::ostringstream msg;
+            msg << std::fixed << std::setprecision(1) << "    " << m.phase << ": cache for 90%/99% of reachable hits "
+                << m.bytes_for_90 / 1048576.0 << "/" << m.bytes_for_99 / 1048576.0 << " MB (sample rate "
+                << std::setprecision(4) << m.sample_rate << ", " << fs::path(m.file).filename().string() << ")";
+            log(msg.str());
+        }
+        return true;
+    }
 
-        // Use 1MB block size and calculate count
-        uintmax_t block_size = 1024 * 1024; // 1MB
-        uintmax_t count = size_bytes / block_size;
+    void merge_phase_results(const std::string& test_name, size_t num_phases, const std::string& output_file) {
+        // Aggregate every completed phase into one result plus a per-phase time series
+        std::vector<results::PhaseSummary> phases;
+        std::vector<int> phase_numbers;
+        for (size_t phase_idx = 1; phase_idx <= num_phases; phase_idx++) {
+            std::string phase_file = output_dir + "/" + test_name + "_phase" +
+                                    std::to_string(phase_idx) + ".json";
+            if (!fs::exists(phase_file) || fs::file_size(phase_file) == 0) {
+                log("  Warning: Missing result for " + test_name + " phase" + std::to_string(phase_idx));
+                continue;
+            }
+            results::PhaseSummary summary;
+            std::string error;
+            if (!results::parse_fio_json(phase_file, summary, error)) {
+                log("  Warning: " + error);
+                continue;
+            }
+            phases.push_back(std::move(summary));
+            phase_numbers.push_back(static_cast<int>(phase_idx));
+        }
 
-        // Build dd command
-        std::ostringstream cmd;
-        cmd << "dd if=/dev/urandom of=" << test_file
-            << " bs=1M count=" << count
-            << " 2>/dev/null";
+        if (phases.empty()) {
+            log("  Warning: No valid phase results to merge for " + test_name);
+            return;
+        }
 
-        run_system(cmd.str());
-        log("Test file created: " + test_file);
+        results::PhaseSummary combined = results::merge_phases(phases);
+        std::string series_file = output_dir + "/" + test_name + "_phases.csv";
+        if (!results::write_combined_json(output_file, test_name, combined, phases.size()) ||
+            !results::write_phase_series(series_file, phase_numbers, phases)) {
+            log("  Warning: Could not write merged results for " + test_name);
+            return;
+        }
+        if (verbose) {
+            log("  Merged " + std::to_string(phases.size()) + "/" + std::to_string(num_phases) +
+                " phases into " + output_file);
+        }
     }
 
     bool run_workload(const std::string& workload_name) {
@@ -462,6 +1033,9 @@ private:
         }
 
         const auto& config = it->second;
+        if (engine != "native" && !check_fio_patterns(config)) {
+            return false;
+        }
         log("Running workload: " + workload_name);
 
         // Determine if this is a multi-phase workload
@@ -503,10 +1077,47 @@ private:
                 execl("/usr/bin/iostat", "iostat", "-d", "-w", "1", nullptr);
                 exit(1);
             }
+            pid_t blk_attr_pid = start_blk_attr(test_name);
 
-            drop_caches();
+            reset_cache(test_files_of(config));
+            auto telemetry_session = start_telemetry(test_name, {}, test_files_of(config));
 
-            if (is_multi_phase) {
+            if (engine == "native") {
+                // All phases run back to back inside this process
+                for (const auto& phase : config.phases) {
+                    if (!phase.file_size.empty() && phase.file_size != config.file_size) {
+                        create_test_file(phase.file_size, script_dir + "/test_file_" + phase.file_size);
+                    }
+                }
+                std::vector<native::EnginePhase> phases;
+                if (build_engine_phases(test_name, config, phases)) {
+                    log("    Native engine: " + std::to_string(phases.size()) + " phase(s)");
+                    runlen::Controller run_length;
+                    open_run_length(run_length, 1);
+                    EngineHooks hooks;
+                    std::unique_ptr<runlen::Estimator> estimator;
+                    if (run_length.is_open()) {
+                        // The schedule starts when the engine is ready
+                        estimator = std::make_unique<runlen::Estimator>(run_length.estimator(0));
+                        hooks.estimator = estimator.get();
+                        hooks.wait_start = [this, &run_length, &config, &workload_name]() {
+                            uint64_t epoch = latency::monotonic_ns();
+                            std::vector<int> runtimes;
+                            for (const auto& phase : bench::effective_phases(config)) runtimes.push_back(phase.runtime);
+                            std::vector<tenant_sync::PhaseWindow> schedule;
+                            tenant_sync::append_schedule(schedule, workload_name, runtimes, epoch);
+                            start_run_length(run_length, {TenantSpec{workload_name, "", &config}},
+                                             schedule, nullptr);
+                            return epoch;
+                        };
+                    }
+                    run_native_engine(phases, config, cache_mode, test_name, std::move(hooks));
+                    if (run_length.is_open()) finish_run_length(run_length);
+                }
+                if (is_multi_phase) {
+                    merge_phase_results(test_name, config.phases.size(), output_file);
+                }
+            } else if (is_multi_phase) {
                 // Run phases sequentially
                 for (size_t phase_idx = 0; phase_idx < config.phases.size(); phase_idx++) {
                     const auto& phase = config.phases[phase_idx];
@@ -546,13 +1157,16 @@ private:
                             << " --numjobs=" << phase_numjobs
                             << " --iodepth=" << phase.iodepth;
 
-                    if (!phase.ioengine.empty()) {
-                        fio_cmd << " --ioengine=" << phase.ioengine;
-                    }
+                    fio_cmd << fio_ioengine_args(phase.ioengine);
+                    std::string distribution_args;
+                    fio_distribution_args(phase.distribution.empty() ? config.distribution : phase.distribution,
+                                          distribution_args);
+                    fio_cmd << distribution_args;
 
                     if (phase_rate_iops > 0) {
                         fio_cmd << " --rate_iops=" << phase_rate_iops;
                     }
+                    fio_cmd << fio_writer_args(resolve_writer(phase.writer, config.writer), phase_numjobs);
 
                     fio_cmd << " --group_reporting=1"
                             << " --output-format=json"
@@ -575,26 +1189,7 @@ private:
                     // Don't drop caches between phases - maintain state
                 }
 
-                // Merge phase results into single output file (simplified: use last completed phase)
-                // In production, you'd want to aggregate all phase metrics
-                if (config.phases.size() > 0) {
-                    // Try phases in reverse order, use first non-empty one
-                    bool merged = false;
-                    for (size_t phase_idx = config.phases.size(); phase_idx >= 1 && !merged; phase_idx--) {
-                        std::string phase_file = output_dir + "/" + test_name + "_phase" +
-                                                std::to_string(phase_idx) + ".json";
-                        if (fs::exists(phase_file) && fs::file_size(phase_file) > 0) {
-                            fs::copy_file(phase_file, output_file, fs::copy_options::overwrite_existing);
-                            merged = true;
-                            if (verbose) {
-                                log("  Merged phase" + std::to_string(phase_idx) + " into combined result");
-                            }
-                        }
-                    }
-                    if (!merged) {
-                        log("  Warning: No valid phase results to merge for " + test_name);
-                    }
-                }
+                merge_phase_results(test_name, config.phases.size(), output_file);
             } else {
                 // Single-phase workload (legacy behavior)
                 std::ostringstream fio_cmd;
@@ -609,13 +1204,15 @@ private:
                         << " --numjobs=" << config.numjobs
                         << " --iodepth=" << config.iodepth;
 
-                if (!config.ioengine.empty()) {
-                    fio_cmd << " --ioengine=" << config.ioengine;
-                }
+                fio_cmd << fio_ioengine_args(config.ioengine);
+                std::string distribution_args;
+                fio_distribution_args(config.distribution, distribution_args);
+                fio_cmd << distribution_args;
 
                 if (config.rate_iops > 0) {
                     fio_cmd << " --rate_iops=" << config.rate_iops;
                 }
+                fio_cmd << fio_writer_args(config.writer, config.numjobs);
 
                 fio_cmd << " --group_reporting=1"
                         << " --output-format=json"
@@ -643,6 +1240,9 @@ private:
                 log("  ✗ Failed: " + test_name);
             }
 
+            telemetry_session.stop();
+            stop_blk_attr(blk_attr_pid);
+
             // Stop iostat
             if (iostat_pid > 0) {
                 kill(iostat_pid, SIGTERM);
@@ -668,98 +1268,468 @@ private:
         log("Client1 (steady): " + client1_it->second.description);
         log("Client2 (bursty): " + client2_it->second.description);
 
-        // Create test files for both clients (including per-phase file sizes)
-        std::string script_dir = fs::current_path().string();
+        std::vector<TenantSpec> tenants = {
+            {"client1", "client1_steady", &client1_it->second},
+            {"client2", "client2_bursty", &client2_it->second},
+        };
+        return run_tenant_group(tenants, "concurrent", true);
+    }
 
-        // Collect all unique file sizes used by client1
-        std::set<std::string> all_file_sizes;
-        all_file_sizes.insert(client1_it->second.file_size);
-        for (const auto& phase : client1_it->second.phases) {
-            if (!phase.file_size.empty()) {
-                all_file_sizes.insert(phase.file_size);
+    // Every section with role = tenant, expanded by replicas (<section>_1 ... <section>_N)
+    std::vector<TenantSpec> collect_tenants() {
+        std::vector<TenantSpec> tenants;
+        for (const auto& [name, config] : workloads) {
+            if (config.role != "tenant") continue;
+            int replicas = std::max(config.replicas, 1);
+            for (int r = 1; r <= replicas; r++) {
+                std::string label = replicas > 1 ? name + "_" + std::to_string(r) : name;
+                tenants.push_back({label, label, &config});
             }
         }
+        return tenants;
+    }
 
-        // Collect all unique file sizes used by client2
-        all_file_sizes.insert(client2_it->second.file_size);
-        for (const auto& phase : client2_it->second.phases) {
-            if (!phase.file_size.empty()) {
-                all_file_sizes.insert(phase.file_size);
-            }
+    // Tenants without their own cgroup section get tenants/<label>, with the
+    // settings of [tenant_default] if the cgroup config has one
+    void add_tenant_cgroups() {
+        for (const auto& tenant : collect_tenants()) {
+            if (cgroups.count(tenant.cgroup_key)) continue;
+            cgroups[tenant.cgroup_key] = CgroupConfig{"tenants/" + tenant.label, tenant_cgroup_defaults};
         }
+    }
 
-        // Create all unique test files
-        for (const auto& file_size : all_file_sizes) {
-            std::string test_file = script_dir + "/test_file_" + file_size;
-            create_test_file(file_size, test_file);
+    bool run_multi_tenant() {
+        std::vector<TenantSpec> tenants = collect_tenants();
+        if (tenants.empty()) {
+            log("ERROR: Multi-tenant mode requires at least one section with 'role = tenant'");
+            return false;
         }
-
-        // Test cached and/or direct modes based on filter
-        std::vector<std::string> cache_modes;
-        if (cache_mode_filter == "both") {
-            cache_modes = {"cached", "direct"};
-        } else {
-            cache_modes = {cache_mode_filter};
+        log("Starting multi-tenant fairness test with " + std::to_string(tenants.size()) + " tenants");
+        for (const auto& tenant : tenants) {
+            log("  " + tenant.label + ": " + tenant.config->description);
         }
-        for (const auto& cache_mode : cache_modes) {
-            log("Running mode: " + cache_mode);
+        return run_tenant_group(tenants, "multi", false);
+    }
 
-            // Start iostat monitoring
-            std::string iostat_file = output_dir + "/iostat/concurrent_" + cache_mode + ".iostat";
-            pid_t iostat_pid = fork();
-            if (iostat_pid == 0) {
-                [[maybe_unused]] FILE* out = freopen(iostat_file.c_str(), "w", stdout);
-                [[maybe_unused]] FILE* err = freopen("/dev/null", "w", stderr);
-                execl("/usr/bin/iostat", "iostat", "-d", "-w", "1", nullptr);
-                exit(1);
-            }
+    // Per-tenant totals from each tenant's aggregated result, one row per tenant
+    // read_iops,write_iops,read_p99_us,read_p999_us,write_p99_us,write_p999_us,max_us
+    static void write_result_columns(std::ostream& out, const results::PhaseSummary& summary) {
+        const auto& rd = summary.dir[0];
+        const auto& wr = summary.dir[1];
+        out << rd.iops << "," << wr.iops << ","
+            << results::percentile_or_zero(rd, 99) / 1000 << "," << results::percentile_or_zero(rd, 99.9) / 1000 << ","
+            << results::percentile_or_zero(wr, 99) / 1000 << "," << results::percentile_or_zero(wr, 99.9) / 1000 << ","
+            << std::max(rd.clat_max, wr.clat_max) / 1000.0;
+    }
 
-            drop_caches();
+    void write_tenant_summary(const std::vector<TenantSpec>& tenants, const std::string& cache_mode,
+                              const std::string& summary_file) {
+        std::ofstream out(summary_file);
+        out << "tenants,tenant,read_iops,write_iops,read_p99_us,read_p999_us,write_p99_us,write_p999_us,max_us\n";
+        out << std::fixed << std::setprecision(1);
+        std::vector<double> p99s;
+        for (const auto& tenant : tenants) {
+            std::string result_file = output_dir + "/" + tenant.label + "_" + cache_mode + ".json";
+            results::PhaseSummary summary;
+            std::string error;
+            if (!fs::exists(result_file) || !results::parse_fio_json(result_file, summary, error)) {
+                log("  Warning: No result for tenant " + tenant.label);
+                continue;
+            }
+            out << tenants.size() << "," << tenant.label << ",";
+            write_result_columns(out, summary);
+            out << "\n";
+            p99s.push_back(std::max(results::percentile_or_zero(summary.dir[0], 99),
+                                    results::percentile_or_zero(summary.dir[1], 99)) / 1000);
+        }
+        if (!p99s.empty()) {
+            std::sort(p99s.begin(), p99s.end());
+            std::ostringstream msg;
+            msg << std::fixed << std::setprecision(1) << "  p99 across " << p99s.size() << " tenants: min "
+                << p99s.front() << "us, median " << p99s[p99s.size() / 2] << "us, max " << p99s.back() << "us";
+            log(msg.str());
+        }
+    }
 
-            // Spawn both clients concurrently
-            std::vector<pid_t> client_pids;
+    // The [policy] for this run's local tenants; false if it cannot start (the run would not test it)
+    bool start_policy(policy::Host& host, const std::vector<TenantSpec>& tenants, psi::PsiMonitor* psi) {
+        std::vector<policy::Tenant> local;
+        for (const auto& tenant : tenants) {
+            if (!tenant.config->host.empty()) continue;
+            std::set<std::string> files = test_files_of(*tenant.config);
+            local.push_back({tenant.label, tenant.cgroup_key, cgroup_dir(tenant.cgroup_key),
+                             std::vector<std::string>(files.begin(), files.end())});
+        }
+        std::string error;
+        if (!host.start(policy_spec, local, psi, [this](const std::string& msg) { log(msg); }, error)) {
+            log("ERROR: " + error);
+            return false;
+        }
+        log("  Policy: " + (policy_spec.plugin.empty() ? policy_spec.exec : policy_spec.plugin) +
+            (policy_spec.args.empty() ? "" : " (" + policy_spec.args + ")") + " for " + std::to_string(local.size()) +
+            " tenants");
+        return true;
+    }
 
-            // Launch client1
-            pid_t client1_pid = fork();
-            if (client1_pid == 0) {
-                // Add self to cgroup
-                add_pid_to_cgroup("client1_steady", getpid());
-                run_client_process("client1", client1_it->second, cache_mode);
-                exit(0);
+    // Online SLO metrics: thresholds of every tenant with a baseline, mapped before the tenants fork
+    void open_slo_monitor(slo::Monitor& monitor, const std::vector<TenantSpec>& tenants,
+                          const std::string& cache_mode) {
+        if (slo_baseline.empty()) return;
+        if (engine != "native") {
+            log("WARNING: --slo-baseline needs the native engine's latency recorder, online SLO metrics disabled");
+            return;
+        }
+        std::vector<std::string> labels;
+        for (const auto& tenant : tenants) labels.push_back(tenant.label);
+        std::string error;
+        if (!monitor.open(labels, error)) {
+            log("WARNING: " + error + ", online SLO metrics disabled");
+            return;
+        }
+        for (size_t t = 0; t < tenants.size(); t++) {
+            size_t nphases = bench::effective_phases(*tenants[t].config).size();
+            slo::SlotData& slot = monitor.setup(static_cast<int>(t));
+            slot.nphases = static_cast<uint32_t>(nphases);
+            if (!tenants[t].config->host.empty()) {
+                log("  No online SLO for " + tenants[t].label + ": runs on " + tenants[t].config->host);
+                continue;
             }
-            client_pids.push_back(client1_pid);
-            // Add child to cgroup from parent side
-            add_pid_to_cgroup("client1_steady", client1_pid);
-
-            // Launch client2
-            pid_t client2_pid = fork();
-            if (client2_pid == 0) {
-                // Add self to cgroup
-                add_pid_to_cgroup("client2_bursty", getpid());
-                run_client_process("client2", client2_it->second, cache_mode);
-                exit(0);
+            if (!slo::load_baseline(slo_baseline, tenants[t].label, cache_mode, nphases, slo_factor, slot, error)) {
+                if (verbose) log("  No SLO for " + tenants[t].label + ": " + error);
+                continue;
+            }
+            slot.active = 1;
+            std::ostringstream msg;
+            msg << std::fixed << std::setprecision(0) << "  SLO " << tenants[t].label << ": " << slo_factor
+                << "x p99 alone =";
+            for (size_t p = 0; p < nphases && p < static_cast<size_t>(slo::kMaxPhases); p++) {
+                msg << (p ? ", " : " ") << "phase " << p + 1 << " " << slot.threshold_ns[p][0] / 1000.0 << "/"
+                    << slot.threshold_ns[p][1] / 1000.0 << "us";
             }
-            client_pids.push_back(client2_pid);
-            // Add child to cgroup from parent side
-            add_pid_to_cgroup("client2_bursty", client2_pid);
+            log(msg.str() + " (read/write)");
+        }
+    }
 
-            // Wait for both clients to complete
-            for (pid_t pid : client_pids) {
+    // Early stop only when every tenant sees the stop flag (no remote tenants)
+    void start_slo_monitor(slo::Monitor& monitor, const std::vector<tenant_sync::PhaseWindow>& schedule,
+                           bool allow_early_stop) {
+        slo::MonitorOptions options;
+        options.settle_pp = allow_early_stop ? slo_settle_pp : 0;
+        if (!allow_early_stop && slo_settle_pp > 0) {
+            log("WARNING: --slo-settle cannot stop remote tenants early, phases keep their runtime");
+        }
+        options.socket_path = output_dir + "/slo.sock";
+        // Tenants' last phases: the latest start among them
+        std::map<std::string, uint64_t> last_start;
+        for (const auto& w : schedule) last_start[w.tenant] = std::max(last_start[w.tenant], w.start_ns);
+        for (const auto& [tenant, start] : last_start) {
+            options.last_phase_start_ns = std::max(options.last_phase_start_ns, start);
+        }
+        std::string error;
+        if (!monitor.start(options, [this](const std::string& msg) { log(msg); }, error)) {
+            log("WARNING: " + error + ", SLO snapshots only on stdout");
+            options.socket_path.clear();
+            monitor.start(options, [this](const std::string& msg) { log(msg); }, error);
+        }
+    }
+
+    void finish_slo_monitor(slo::Monitor& monitor, const std::vector<tenant_sync::PhaseWindow>& schedule,
+                            const std::string& summary_file) {
+        monitor.stop();
+        if (monitor.stopped_early()) {
+            uint64_t planned_end = 0;
+            for (const auto& w : schedule) planned_end = std::max(planned_end, w.end_ns);
+            uint64_t saved = planned_end > monitor.stop_time_ns() ? planned_end - monitor.stop_time_ns() : 0;
+            log("  Early stop saved " + std::to_string(saved / 1000000000ULL) + "s of the last phase");
+        }
+        if (!monitor.write_summary(summary_file)) {
+            log("WARNING: Cannot write " + summary_file);
+            return;
+        }
+        log("  SLO violations per tenant and phase: " + fs::path(summary_file).filename().string());
+    }
+
+    // Adaptive run length: the shared shift and per-tenant estimates, mapped before the tenants fork
+    void open_run_length(runlen::Controller& controller, size_t tenants) {
+        if (adaptive_ci_pct <= 0) return;
+        if (engine != "native") {
+            log("WARNING: --adaptive-ci needs the native engine's latency recorder, phases keep their runtime");
+            return;
+        }
+        std::string error;
+        if (!controller.open(tenants, adaptive_ci_pct, adaptive_min_s, error)) {
+            log("WARNING: " + error + ", phases keep their runtime");
+        }
+    }
+
+    void start_run_length(runlen::Controller& controller, const std::vector<TenantSpec>& tenants,
+                          const std::vector<tenant_sync::PhaseWindow>& schedule, const slo::Monitor* monitor) {
+        std::vector<std::string> labels;
+        std::vector<int> warmups;
+        for (const auto& tenant : tenants) {
+            labels.push_back(tenant.label);
+            warmups.push_back(tenant.config->warmup_phases);
+        }
+        // With --slo-settle, an SLO tenant's violation fraction must have settled too
+        runlen::Controller::Check check;
+        if (monitor && monitor->is_open() && slo_settle_pp > 0) {
+            double settle_pp = slo_settle_pp;
+            check = [monitor, settle_pp](int tenant, int phase, std::string& detail) {
+                slo::SlotData d = monitor->read(tenant);
+                if (!d.active) return true;
+                double ci = slo::ci_half_width(d);
+                if (d.phase != static_cast<uint32_t>(phase) || ci * 100 > settle_pp) return false;
+                std::ostringstream text;
+                text << std::fixed << std::setprecision(2) << ", SLO " << 100 * d.mean << "% +-" << 100 * ci << "pp";
+                detail = text.str();
+                return true;
+            };
+        }
+        controller.start(schedule, labels, warmups, check, [this](const std::string& msg) { log(msg); });
+        std::ostringstream msg;
+        msg << "  Adaptive run length: phases end once p99 is within +-" << adaptive_ci_pct << "% (95% CI), after "
+            << adaptive_min_s << "s at least";
+        log(msg.str());
+    }
+
+    // The schedule as it ran
+    std::vector<tenant_sync::PhaseWindow> finish_run_length(runlen::Controller& controller) {
+        controller.stop();
+        if (!controller.cuts().empty()) {
+            std::ostringstream msg;
+            msg << std::fixed << std::setprecision(1) << "  Adaptive run length saved " << controller.saved_ns() / 1e9
+                << "s (" << controller.cuts().size() << " phase boundaries moved)";
+            log(msg.str());
+        }
+        return controller.actual_schedule();
+    }
+
+    bool run_tenant_group(const std::vector<TenantSpec>& tenants, const std::string& group_label,
+                          bool with_controller) {
+        // Create test files for all tenants (including per-phase file sizes)
+        std::string script_dir = fs::current_path().string();
+
+        // Collect all unique file sizes used by any tenant
+        std::set<std::string> all_file_sizes;
+        for (const auto& tenant : tenants) {
+            if (!tenant.config->host.empty()) continue;  // The agent creates its own
+            all_file_sizes.insert(tenant.config->file_size);
+            for (const auto& phase : tenant.config->phases) {
+                if (!phase.file_size.empty()) {
+                    all_file_sizes.insert(phase.file_size);
+                }
+            }
+        }
+
+        // Create all unique test files
+        std::set<std::string> test_files;
+        for (const auto& file_size : all_file_sizes) {
+            std::string test_file = script_dir + "/test_file_" + file_size;
+            create_test_file(file_size, test_file);
+            test_files.insert(test_file);
+        }
+
+        std::vector<std::string> cgroup_keys;
+        bool any_remote = false;
+        for (const auto& tenant : tenants) {
+            if (!tenant.config->host.empty()) {
+                any_remote = true;
+                continue;
+            }
+            cgroup_keys.push_back(tenant.cgroup_key);
+        }
+        if (any_remote && use_cgroups) {
+            log("  Remote tenants run outside this host's cgroups, on their agents' hosts");
+        }
+
+        // Test cached and/or direct modes based on filter
+        std::vector<std::string> cache_modes;
+        if (cache_mode_filter == "both") {
+            cache_modes = {"cached", "direct"};
+        } else {
+            cache_modes = {cache_mode_filter};
+        }
+        for (const auto& cache_mode : cache_modes) {
+            log("Running mode: " + cache_mode);
+
+            // Mapped before iostat and blk_attr are forked, so failing here leaves nothing behind
+            tenant_sync::StartBarrier barrier;
+            std::string barrier_error;
+            if (!barrier.open(barrier_error)) {
+                log("ERROR: " + barrier_error);
+                return false;
+            }
+
+            // Start iostat monitoring
+            std::string iostat_file = output_dir + "/iostat/" + group_label + "_" + cache_mode + ".iostat";
+            pid_t iostat_pid = fork();
+            if (iostat_pid == 0) {
+                [[maybe_unused]] FILE* out = freopen(iostat_file.c_str(), "w", stdout);
+                [[maybe_unused]] FILE* err = freopen("/dev/null", "w", stderr);
+                execl("/usr/bin/iostat", "iostat", "-d", "-w", "1", nullptr);
+                exit(1);
+            }
+            pid_t blk_attr_pid = start_blk_attr(group_label + "_" + cache_mode);
+
+            reset_cache(test_files);
+
+            // Warm start: restore the cache state an earlier run had after its warmup and cut the
+            // warmup phases short; without a snapshot, run them in full and save one at their end
+            std::vector<TenantSpec> run_tenants = tenants;
+            std::vector<WorkloadConfig> warm_configs(tenants.size());
+            std::string snapshot_file = cache_snapshot_path(group_label);
+            bool warm = cache_state_mode == cache_state::Mode::Warm && cache_mode == "cached" &&
+                        std::any_of(tenants.begin(), tenants.end(),
+                                    [](const TenantSpec& t) { return t.config->warmup_phases > 0; });
+            bool restored = warm && restore_cache_snapshot(snapshot_file);
+            for (size_t i = 0; restored && i < tenants.size(); i++) {
+                warm_configs[i] = *tenants[i].config;
+                for (int p = 0; p < warm_configs[i].warmup_phases; p++) {
+                    warm_configs[i].phases[p].runtime = std::min(warm_configs[i].phases[p].runtime, kWarmStartRuntimeS);
+                }
+                run_tenants[i].config = &warm_configs[i];
+            }
+
+            // Spawn all tenants, each born inside its cgroup; they prepare, then wait at the start barrier
+            slo::Monitor slo_monitor;
+            open_slo_monitor(slo_monitor, run_tenants, cache_mode);
+            runlen::Controller run_length;
+            if (any_remote && adaptive_ci_pct > 0) {
+                log("WARNING: --adaptive-ci cannot move the schedule of remote tenants, phases keep their runtime");
+            } else {
+                open_run_length(run_length, run_tenants.size());
+            }
+            std::vector<std::pair<pid_t, std::string>> client_pids;
+            std::vector<pid_t> pids;
+            std::vector<tenant_sync::PhaseWindow> schedule;
+            for (size_t t = 0; t < run_tenants.size(); t++) {
+                const TenantSpec& tenant = run_tenants[t];
+                if (!tenant.config->host.empty()) {
+                    // A proxy takes the tenant's place at the barrier and runs it on the agent
+                    pid_t pid = fork();
+                    if (pid == 0) {
+                        exit(run_remote_tenant(tenant, workload_name_of(tenants[t].config), cache_mode, group_label,
+                                               barrier) ? 0 : 1);
+                    }
+                    if (pid > 0) {
+                        client_pids.push_back({pid, tenant.label});
+                        pids.push_back(pid);
+                    }
+                    continue;
+                }
+                pid_t pid = spawn_client(tenant.cgroup_key);
+                if (pid == 0) {
+                    std::unique_ptr<slo::Reporter> reporter;
+                    std::unique_ptr<runlen::Estimator> estimator;
+                    if (slo_monitor.is_open()) {
+                        reporter = std::make_unique<slo::Reporter>(slo_monitor.reporter(static_cast<int>(t)));
+                    }
+                    if (run_length.is_open()) {
+                        estimator = std::make_unique<runlen::Estimator>(run_length.estimator(static_cast<int>(t)));
+                    }
+                    EngineHooks hooks;
+                    hooks.slo_reporter = reporter.get();
+                    hooks.estimator = estimator.get();
+                    run_client_process(tenant.label, *tenant.config, cache_mode,
+                                       [&barrier]() { return barrier.arrive_and_wait(); }, std::move(hooks));
+                    exit(0);
+                }
+                if (pid > 0) {
+                    client_pids.push_back({pid, tenant.label});
+                    pids.push_back(pid);
+                }
+            }
+
+            // Sampler thread starts after the clients: spawn() must not race other threads
+            auto telemetry_session = start_telemetry(group_label + "_" + cache_mode, cgroup_keys, test_files);
+            auto ctl = with_controller ? start_controller(cache_mode, telemetry_session.psi.get()) : nullptr;
+            policy::Host policy_host;
+            if (policy_spec.enabled() && !start_policy(policy_host, run_tenants, telemetry_session.psi.get())) {
+                barrier.cancel();
+                for (pid_t pid : pids) waitpid(pid, nullptr, 0);
+                telemetry_session.stop();
+                stop_blk_attr(blk_attr_pid);
+                if (iostat_pid > 0) {
+                    kill(iostat_pid, SIGTERM);
+                    waitpid(iostat_pid, nullptr, 0);
+                }
+                return false;
+            }
+
+            int ready = barrier.wait_ready(pids);
+            uint64_t epoch = barrier.release();
+            uint64_t warmup_end = epoch;
+            for (const auto& tenant : run_tenants) {
+                std::vector<int> runtimes;
+                for (const auto& phase : bench::effective_phases(*tenant.config)) runtimes.push_back(phase.runtime);
+                tenant_sync::append_schedule(schedule, tenant.label, runtimes, epoch);
+                if (tenant.config->warmup_phases > 0) {
+                    warmup_end = std::max(warmup_end, schedule[schedule.size() - runtimes.size() +
+                                                               tenant.config->warmup_phases - 1].end_ns);
+                }
+            }
+            std::thread snapshot_thread;
+            if (warm && !restored) {
+                snapshot_thread = std::thread([this, warmup_end, snapshot_file, &test_files]() {
+                    native::sleep_until_ns(warmup_end);
+                    save_cache_snapshot(snapshot_file, test_files);
+                });
+            }
+            std::string schedule_file = output_dir + "/" + group_label + "_" + cache_mode + "_phase_schedule.csv";
+            if (!tenant_sync::write_schedule(schedule_file, epoch, schedule)) {
+                log("WARNING: Cannot write " + schedule_file);
+            }
+            log("  Released " + std::to_string(ready) + "/" + std::to_string(tenants.size()) +
+                " clients, shared start in " + std::to_string(tenant_sync::kStartLeadNs / 1000000) + "ms (" +
+                fs::path(schedule_file).filename().string() + ")");
+            if (slo_monitor.is_open()) start_slo_monitor(slo_monitor, schedule, !any_remote);
+            if (run_length.is_open()) start_run_length(run_length, run_tenants, schedule, &slo_monitor);
+
+            // Wait for all clients to complete
+            for (const auto& [pid, label] : client_pids) {
                 int status;
                 waitpid(pid, &status, 0);
                 if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
-                    log("  ✓ Client completed successfully");
+                    log("  ✓ Client " + label + " completed successfully");
                 } else {
-                    log("  ✗ Client failed or was terminated");
+                    log("  ✗ Client " + label + " failed or was terminated");
                 }
             }
 
+            if (snapshot_thread.joinable()) snapshot_thread.join();
+            if (run_length.is_open()) {
+                schedule = finish_run_length(run_length);
+                if (!run_length.cuts().empty() && !tenant_sync::write_schedule(schedule_file, epoch, schedule)) {
+                    log("WARNING: Cannot write " + schedule_file);
+                }
+            }
+            if (slo_monitor.is_open()) {
+                finish_slo_monitor(slo_monitor, schedule, output_dir + "/" + group_label + "_" + cache_mode + "_slo.csv");
+            }
+            if (telemetry_session.psi) {
+                telemetry_session.psi->clear_subscribers();
+            }
+            if (policy_spec.enabled()) {
+                policy_host.stop();
+                if (!policy_spec.plugin.empty()) {
+                    log("  Policy: " + std::to_string(policy_host.ticks()) + " telemetry callbacks");
+                }
+            }
+            if (ctl) {
+                ctl->stop();
+                log("  dirty_slo controller: " + std::to_string(ctl->tightened()) + " tighten, " +
+                    std::to_string(ctl->relaxed()) + " relax decisions (controller_" + cache_mode + ".csv)");
+            }
+            telemetry_session.stop();
+            stop_blk_attr(blk_attr_pid);
+
             // Stop iostat
             if (iostat_pid > 0) {
                 kill(iostat_pid, SIGTERM);
                 waitpid(iostat_pid, nullptr, 0);
             }
 
+            write_tenant_summary(tenants, cache_mode, output_dir + "/" + group_label + "_" + cache_mode + "_summary.csv");
             log("Completed mode: " + cache_mode);
             sleep(2);
         }
@@ -767,15 +1737,55 @@ private:
         return true;
     }
 
+    // One tenant of a concurrent group: phases follow the group's shared epoch, which wait_start
+    // blocks for (the start barrier here, the coordinator's START on an agent); 0 = cancelled
     void run_client_process(const std::string& client_name, const WorkloadConfig& config,
-                           const std::string& cache_mode) {
+                           const std::string& cache_mode, std::function<uint64_t()> wait_start,
+                           EngineHooks hooks = EngineHooks()) {
         // Get script directory for creating test files
         std::string script_dir = fs::current_path().string();
 
-        // Run all phases for this client
-        for (size_t phase_idx = 0; phase_idx < config.phases.size(); phase_idx++) {
-            const auto& phase = config.phases[phase_idx];
-            std::string phase_name = client_name + "_" + cache_mode + "_phase" + std::to_string(phase_idx + 1);
+        if (engine == "native") {
+            // One long-lived engine: phase switches happen without leaving the process
+            std::vector<native::EnginePhase> phases;
+            std::string label = client_name + "_" + cache_mode;
+            hooks.wait_start = std::move(wait_start);
+            if (!build_engine_phases(label, config, phases) ||
+                !run_native_engine(phases, config, cache_mode, label, std::move(hooks))) {
+                exit(1);
+            }
+            if (!config.phases.empty()) {
+                merge_phase_results(label, config.phases.size(), output_dir + "/" + label + ".json");
+            }
+            return;
+        }
+        if (!check_fio_patterns(config)) {
+            exit(1);
+        }
+
+        // Run all phases for this client; a legacy single-phase workload runs as one unnamed phase
+        std::string label = client_name + "_" + cache_mode;
+        std::vector<PhaseConfig> phases = bench::effective_phases(config);
+        bool is_multi_phase = !config.phases.empty();
+        uint64_t epoch = wait_start();
+        if (epoch == 0) {
+            exit(1);
+        }
+        uint64_t phase_end = epoch;
+        for (size_t phase_idx = 0; phase_idx < phases.size(); phase_idx++) {
+            const auto& phase = phases[phase_idx];
+            // Each fio starts at its scheduled time and is cut off at the next boundary, so its
+            // startup delay shortens this phase instead of shifting every later one
+            uint64_t phase_start = phase_end;
+            phase_end += static_cast<uint64_t>(phase.runtime) * 1000000000ULL;
+            native::sleep_until_ns(phase_start);
+            uint64_t now = latency::monotonic_ns();
+            if (now + 1000000ULL >= phase_end) {
+                log("  Warning: " + label + " phase" + std::to_string(phase_idx + 1) + " skipped, already past its end");
+                continue;
+            }
+            uint64_t runtime_ms = (phase_end - now) / 1000000ULL;
+            std::string phase_name = is_multi_phase ? label + "_phase" + std::to_string(phase_idx + 1) : label;
             std::string phase_output = output_dir + "/" + phase_name + ".json";
             std::string log_prefix = output_dir + "/" + phase_name;
 
@@ -796,20 +1806,23 @@ private:
                     << " --name=" << phase_name
                     << " --filename=" << phase_test_file
                     << " --size=" << phase_file_size
-                    << " --runtime=" << phase.runtime
+                    << " --runtime=" << runtime_ms << "ms"
                     << " --time_based=1"
                     << " --rw=" << phase.pattern
                     << " --bs=" << phase.block_size
                     << " --numjobs=" << phase_numjobs
                     << " --iodepth=" << phase.iodepth;
 
-            if (!phase.ioengine.empty()) {
-                fio_cmd << " --ioengine=" << phase.ioengine;
-            }
+            fio_cmd << fio_ioengine_args(phase.ioengine);
+            std::string distribution_args;
+            fio_distribution_args(phase.distribution.empty() ? config.distribution : phase.distribution,
+                                  distribution_args);
+            fio_cmd << distribution_args;
 
             if (phase_rate_iops > 0) {
                 fio_cmd << " --rate_iops=" << phase_rate_iops;
             }
+            fio_cmd << fio_writer_args(resolve_writer(phase.writer, config.writer), phase_numjobs);
 
             // Add per-second logging
             fio_cmd << " --log_avg_msec=1000"
@@ -828,6 +1841,308 @@ private:
             // Execute fio
             run_system(fio_cmd.str());
         }
+
+        if (is_multi_phase) {
+            merge_phase_results(label, phases.size(), output_dir + "/" + label + ".json");
+        }
+    }
+
+    // Section a tenant's config was built from
+    std::string workload_name_of(const WorkloadConfig* config) {
+        for (const auto& [name, workload] : workloads) {
+            if (&workload == config) return name;
+        }
+        return "";
+    }
+
+    // What an agent needs to run one tenant: run settings, then the tenant's section as resolved here
+    std::string tenant_plan(const TenantSpec& tenant, const std::string& section_name, const std::string& cache_mode,
+                            const std::string& group_label) {
+        std::ostringstream plan;
+        plan << "[agent]\n"
+             << "label = " << tenant.label << "\n"
+             << "group = " << group_label << "\n"
+             << "cache_mode = " << cache_mode << "\n"
+             << "engine = " << engine << "\n"
+             << "fill = " << provision::content_name(fill_options.content) << "\n"
+             << "hugepages = " << arena::hugepages_name(hugepages) << "\n"
+             << "mrc_samples = " << mrc_samples << "\n"
+             << "sample_interval_ms = " << sample_interval_ms << "\n"
+             << "perf_counters = " << (perf_counters ? 1 : 0) << "\n"
+             << "residency_interval_ms = " << residency_interval_ms << "\n"
+             << "cache_state = " << cache_state::mode_name(cache_state_mode) << "\n"
+             << "verbose = " << (verbose ? 1 : 0) << "\n";
+        // Phase runtimes as scheduled here (a warm start shortens the warmup phases)
+        plan << "runtimes = ";
+        std::vector<PhaseConfig> phases = bench::effective_phases(*tenant.config);
+        for (size_t p = 0; p < phases.size(); p++) plan << (p ? "," : "") << phases[p].runtime;
+        plan << "\n[" << section_name << "]\n";
+        for (const auto& section : config_sections) {
+            if (section.name != section_name) continue;
+            for (const auto& [key, value] : resolved_entries(section, active_overrides)) {
+                if (key != "host") plan << key << " = " << value << "\n";
+            }
+        }
+        return plan.str();
+    }
+
+    // Proxy of a remote tenant (a child of the group): plan the run on the agent, forward the
+    // shared start, then write back every file the agent returns. True if the tenant succeeded.
+    bool run_remote_tenant(const TenantSpec& tenant, const std::string& section_name, const std::string& cache_mode,
+                           const std::string& group_label, tenant_sync::StartBarrier& barrier) {
+        const std::string& host = tenant.config->host;
+        if (agent_token.empty()) {
+            log("ERROR: Remote " + tenant.label + ": agents need the shared --agent-token or --agent-token-file");
+            return false;
+        }
+        std::string error;
+        int fd = rpc::connect_to(host, error);
+        if (fd < 0) {
+            log("ERROR: Remote " + tenant.label + ": " + error);
+            return false;
+        }
+        bool ok = drive_remote_tenant(fd, tenant, section_name, cache_mode, group_label, barrier);
+        close(fd);
+        return ok;
+    }
+
+    bool drive_remote_tenant(int fd, const TenantSpec& tenant, const std::string& section_name,
+                             const std::string& cache_mode, const std::string& group_label,
+                             tenant_sync::StartBarrier& barrier) {
+        const std::string where = "Remote " + tenant.label + " at " + tenant.config->host;
+        std::string payload, error;
+        auto fail = [&](const std::string& message) {
+            log("ERROR: " + where + ": " + message);
+            return false;
+        };
+
+        rpc::Op op;
+        if (!rpc::send_frame(fd, rpc::Op::Hello,
+                             rpc::format_fields({{"version", std::to_string(rpc::kVersion)}, {"token", agent_token}})) ||
+            !rpc::recv_frame(fd, op, payload, error)) {
+            return fail(error.empty() ? "handshake failed" : error);
+        }
+        if (op == rpc::Op::Done) return fail("agent refused the session: " + rpc::parse_fields(payload)["error"]);
+        if (op != rpc::Op::HelloAck) return fail("unexpected frame in the handshake");
+        auto agent = rpc::parse_fields(payload);
+        if (agent["version"] != std::to_string(rpc::kVersion)) {
+            return fail("agent speaks protocol version " + agent["version"] + ", this build " +
+                        std::to_string(rpc::kVersion));
+        }
+
+        // Clock offset from the probe with the lowest round trip
+        rpc::ClockProbe best{0, 0, 0};
+        for (int i = 0; i < rpc::kClockProbes; i++) {
+            rpc::ClockProbe probe;
+            probe.sent_ns = rpc::realtime_ns();
+            if (!rpc::send_frame(fd, rpc::Op::Ping, "") || !rpc::expect(fd, rpc::Op::Pong, payload, error)) {
+                return fail(error.empty() ? "clock probe failed" : error);
+            }
+            probe.received_ns = rpc::realtime_ns();
+            probe.peer_ns = std::strtoull(payload.c_str(), nullptr, 10);
+            if (i == 0 || probe.rtt_ns() < best.rtt_ns()) best = probe;
+        }
+        rpc::ClockStatus local_clock = rpc::clock_status();
+        rpc::ClockStatus agent_clock;
+        if (!rpc::ClockStatus::from(agent, "clock_", agent_clock)) return fail("malformed HELLO_ACK clock status");
+        std::ostringstream msg;
+        msg << std::fixed << std::setprecision(0) << "  " << where << " (" << agent["hostname"] << "): rtt "
+            << best.rtt_ns() / 1000.0 << "us, clock offset " << std::showpos << best.offset_ns() / 1000.0
+            << std::noshowpos << "us; agent clock " << (agent_clock.synced ? "synced" : "unsynced") << " (est. error "
+            << agent_clock.est_error_us << "us), local clock " << (local_clock.synced ? "synced" : "unsynced")
+            << " (est. error " << local_clock.est_error_us << "us)";
+        log(msg.str());
+        int64_t offset_us = std::llabs(best.offset_ns()) / 1000;
+        if (!agent_clock.synced || !local_clock.synced) {
+            log("WARNING: " + where + ": a clock is not disciplined (NTP/chrony/PTP), the start is aligned by the "
+                "measured offset alone, to within " + std::to_string(best.rtt_ns() / 2000) + "us");
+        } else if (offset_us > agent_clock.max_error_us + local_clock.max_error_us +
+                                   static_cast<int64_t>(best.rtt_ns() / 1000)) {
+            log("WARNING: " + where + ": clock offset beyond both hosts' reported maximum error");
+        }
+
+        if (!rpc::send_frame(fd, rpc::Op::Plan, tenant_plan(tenant, section_name, cache_mode, group_label))) {
+            return fail("cannot send the plan");
+        }
+        if (!rpc::recv_frame(fd, op, payload, error)) return fail(error);
+        if (op == rpc::Op::Done) return fail("agent could not prepare the run: " + rpc::parse_fields(payload)["error"]);
+        if (op != rpc::Op::Ready) return fail("unexpected frame while the agent prepared");
+
+        uint64_t epoch = barrier.arrive_and_wait();
+        if (epoch == 0) {
+            rpc::send_frame(fd, rpc::Op::Cancel, "");
+            return false;
+        }
+        uint64_t agent_epoch = rpc::monotonic_to_realtime(epoch) + best.offset_ns();
+        if (!rpc::send_frame(fd, rpc::Op::Start, rpc::format_fields({{"epoch_ns", std::to_string(agent_epoch)}}))) {
+            return fail("cannot send the start");
+        }
+
+        // Results, logs and telemetry come back into this run's output directory
+        size_t files = 0;
+        uint64_t bytes = 0;
+        while (true) {
+            if (!rpc::recv_frame(fd, op, payload, error, true)) return fail(error);
+            if (op == rpc::Op::Done) break;
+            std::string relative;
+            size_t content_at = 0;
+            if (op != rpc::Op::File || !rpc::split_file(payload, relative, content_at)) {
+                return fail("bad file frame");
+            }
+            fs::path path = fs::path(output_dir) / relative;
+            fs::create_directories(path.parent_path());
+            std::ofstream out(path, std::ios::binary);
+            out.write(payload.data() + content_at, static_cast<std::streamsize>(payload.size() - content_at));
+            if (!out) return fail("cannot write " + path.string());
+            files++;
+            bytes += payload.size() - content_at;
+        }
+        auto status = rpc::parse_fields(payload);
+        std::ostringstream back;
+        back << std::fixed << std::setprecision(1) << "  " << where << ": " << files << " files ("
+             << bytes / 1048576.0 << " MB) returned";
+        log(back.str());
+        if (status["status"] != "0") return fail("tenant failed on the agent" +
+                                                 (status["error"].empty() ? "" : ": " + status["error"]));
+        return true;
+    }
+
+    // One coordinator connection on the agent: runs its tenant in a session directory, ships it back
+    bool serve_agent_session(int fd, const std::string& base_dir) {
+        std::string payload, error;
+        auto done = [&](bool ok, const std::string& message) {
+            if (!ok) log("ERROR: Agent session: " + message);
+            rpc::send_frame(fd, rpc::Op::Done, rpc::format_fields({{"status", ok ? "0" : "1"}, {"error", message}}));
+            return ok;
+        };
+        if (!rpc::expect(fd, rpc::Op::Hello, payload, error)) {
+            log("ERROR: Agent session: " + error);
+            return false;
+        }
+        if (!rpc::token_matches(agent_token, rpc::parse_fields(payload)["token"])) {
+            return done(false, "wrong or missing agent token");
+        }
+        char hostname[256] = {};
+        gethostname(hostname, sizeof(hostname) - 1);
+        auto ack = rpc::clock_status().fields("clock_");
+        ack["version"] = std::to_string(rpc::kVersion);
+        ack["hostname"] = hostname;
+        if (!rpc::send_frame(fd, rpc::Op::HelloAck, rpc::format_fields(ack))) return false;
+
+        // Clock probes until the plan arrives
+        rpc::Op op;
+        while (true) {
+            if (!rpc::recv_frame(fd, op, payload, error)) {
+                log("ERROR: Agent session: " + error);
+                return false;
+            }
+            if (op == rpc::Op::Plan) break;
+            if (op != rpc::Op::Ping) return done(false, "unexpected frame before the plan");
+            if (!rpc::send_frame(fd, rpc::Op::Pong, std::to_string(rpc::realtime_ns()))) return false;
+        }
+
+        // [agent] settings, then the tenant's section
+        std::istringstream plan_text(payload);
+        std::vector<ConfigSection> sections;
+        bench::parse_sections(plan_text, sections);
+        std::map<std::string, std::string> settings;
+        std::vector<ConfigSection> workload_sections;
+        for (const auto& section : sections) {
+            if (section.name != "agent") {
+                workload_sections.push_back(section);
+                continue;
+            }
+            for (const auto& [key, value] : section.entries) settings[key] = value;
+        }
+        bench::Workloads planned;
+        if (workload_sections.size() != 1 || !bench::build_workloads(workload_sections, {}, planned, error)) {
+            return done(false, "bad plan: " + (error.empty() ? "expected one workload section" : error));
+        }
+        const std::string label = settings["label"];
+        const std::string cache_mode = settings["cache_mode"];
+        // Both become paths under the session directory
+        if (!rpc::safe_name(label) || !rpc::safe_name(settings["group"])) {
+            return done(false, "bad plan: label and group must match [A-Za-z0-9_.-]+");
+        }
+        engine = settings["engine"];
+        verbose = settings["verbose"] == "1";
+        mrc_samples = std::atoi(settings["mrc_samples"].c_str());
+        sample_interval_ms = std::atoi(settings["sample_interval_ms"].c_str());
+        perf_counters = settings["perf_counters"] == "1";
+        residency_interval_ms = std::atoi(settings["residency_interval_ms"].c_str());
+        if (label.empty() || (cache_mode != "cached" && cache_mode != "direct") ||
+            (engine != "fio" && engine != "native") ||
+            !provision::parse_content(settings["fill"], fill_options.content) ||
+            !arena::parse_hugepages(settings["hugepages"], hugepages) ||
+            !cache_state::parse_mode(settings["cache_state"], cache_state_mode)) {
+            return done(false, "bad [agent] settings in the plan");
+        }
+        WorkloadConfig config = planned.begin()->second;
+        std::istringstream runtimes(settings["runtimes"]);
+        std::string runtime;
+        for (size_t p = 0; std::getline(runtimes, runtime, ','); p++) {
+            if (config.phases.empty()) config.runtime = std::atoi(runtime.c_str());
+            else if (p < config.phases.size()) config.phases[p].runtime = std::atoi(runtime.c_str());
+        }
+        if (engine == "fio" && system("which fio > /dev/null 2>&1") != 0) {
+            return done(false, "fio is not installed on the agent");
+        }
+
+        // Session directory: everything in it goes back to the coordinator
+        output_dir = base_dir + "/" + label + "_" + cache_mode + "_" + std::to_string(getpid());
+        fs::create_directories(output_dir + "/telemetry");
+        log("Agent: running " + label + " (" + cache_mode + ", " + engine + ") for the coordinator");
+
+        // Test files in the agent's working directory, cache reset as the coordinator does it
+        std::string script_dir = fs::current_path().string();
+        std::set<std::string> test_files;
+        std::set<std::string> sizes = {config.file_size};
+        for (const auto& phase : config.phases) {
+            if (!phase.file_size.empty()) sizes.insert(phase.file_size);
+        }
+        for (const auto& file_size : sizes) {
+            if (file_size.empty()) continue;
+            create_test_file(file_size, script_dir + "/test_file_" + file_size);
+            test_files.insert(script_dir + "/test_file_" + file_size);
+        }
+        if (cache_state_mode == cache_state::Mode::Warm) cache_state_mode = cache_state::Mode::Evict;
+        reset_cache(test_files);
+
+        // The tenant runs in a child (its failures exit); READY and START go over this connection
+        pid_t pid = fork();
+        if (pid == 0) {
+            auto wait_start = [fd]() -> uint64_t {
+                std::string frame, frame_error;
+                rpc::Op start_op;
+                if (!rpc::send_frame(fd, rpc::Op::Ready, "") || !rpc::recv_frame(fd, start_op, frame, frame_error) ||
+                    start_op != rpc::Op::Start) {
+                    return 0;
+                }
+                uint64_t epoch_ns = std::strtoull(rpc::parse_fields(frame)["epoch_ns"].c_str(), nullptr, 10);
+                return rpc::realtime_to_monotonic(epoch_ns);
+            };
+            run_client_process(label, config, cache_mode, wait_start);
+            exit(0);
+        }
+        if (pid < 0) return done(false, std::string("fork: ") + strerror(errno));
+        auto telemetry_session = start_telemetry(settings["group"] + "_" + cache_mode + "_" + label, {}, test_files);
+        int status = 0;
+        waitpid(pid, &status, 0);
+        telemetry_session.stop();
+        bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+
+        for (const auto& entry : fs::recursive_directory_iterator(output_dir)) {
+            if (!entry.is_regular_file()) continue;
+            std::string relative = fs::relative(entry.path(), output_dir).string();
+            if (!rpc::send_file(fd, relative, entry.path().string())) {
+                log("ERROR: Agent session: cannot send " + relative);
+                return false;
+            }
+        }
+        std::error_code ec;
+        fs::remove_all(output_dir, ec);
+        log("Agent: " + label + (ok ? " completed" : " failed"));
+        return done(ok, ok ? "" : "tenant process failed");
     }
 
     void run_all_workloads() {
@@ -879,96 +2194,42 @@ private:
         log("Summary saved to " + output_dir + "/summary.txt");
     }
 
-    bool parse_config_file() {
-        std::ifstream file(config_file);
-        if (!file.is_open()) {
-            log("ERROR: Cannot open config file: " + config_file);
+    // (Re)build and validate `workloads` from the parsed sections
+    bool build_workloads(const sweep::Overrides& overrides) {
+        active_overrides = overrides;
+        std::string error;
+        if (!bench::build_workloads(config_sections, overrides, workloads, error)) {
+            log("ERROR: " + config_file + ": " + error);
             return false;
         }
+        return true;
+    }
 
-        std::string line, current_section;
-        WorkloadConfig current_workload;
-        std::map<int, PhaseConfig> phase_map; // Temporary storage for phases
-
-        while (std::getline(file, line)) {
-            // Skip empty lines and comments
-            if (line.empty() || line[0] == '#' || line[0] == ';') {
-                continue;
-            }
-
-            // Section header [workload_name]
-            if (line[0] == '[' && line.back() == ']') {
-                if (!current_section.empty()) {
-                    // Convert phase_map to phases vector
-                    for (const auto& [phase_num, phase_config] : phase_map) {
-                        current_workload.phases.push_back(phase_config);
-                    }
-                    workloads[current_section] = current_workload;
-                }
-                current_section = line.substr(1, line.length() - 2);
-                current_workload = WorkloadConfig(); // Reset
-                phase_map.clear();
+    // Read the config once; [sweep] holds the sweep grid, every other section is a workload
+    bool parse_config_file() {
+        std::vector<ConfigSection> sections;
+        std::string error;
+        if (!bench::read_sections(config_file, sections, error)) {
+            log("ERROR: " + error);
+            return false;
+        }
+        config_sections.clear();
+        sweep_plan = sweep::Plan();
+        has_sweep_plan = false;
+        for (auto& section : sections) {
+            if (section.name != "sweep") {
+                config_sections.push_back(std::move(section));
                 continue;
             }
-
-            // Key=value pairs
-            size_t eq_pos = line.find('=');
-            if (eq_pos != std::string::npos) {
-                std::string key = line.substr(0, eq_pos);
-                std::string value = line.substr(eq_pos + 1);
-
-                // Trim whitespace
-                key.erase(0, key.find_first_not_of(" \t"));
-                key.erase(key.find_last_not_of(" \t") + 1);
-                value.erase(0, value.find_first_not_of(" \t"));
-                value.erase(value.find_last_not_of(" \t") + 1);
-
-                // Check for phase-specific parameters (phase_N_*)
-                if (key.substr(0, 6) == "phase_") {
-                    size_t underscore_pos = key.find('_', 6);
-                    if (underscore_pos != std::string::npos) {
-                        int phase_num = std::stoi(key.substr(6, underscore_pos - 6));
-                        std::string param = key.substr(underscore_pos + 1);
-
-                        // Initialize phase if needed
-                        if (phase_map.find(phase_num) == phase_map.end()) {
-                            phase_map[phase_num] = PhaseConfig{0, "", 0, "", "", 0, "", 0};
-                        }
-
-                        if (param == "runtime") phase_map[phase_num].runtime = std::stoi(value);
-                        else if (param == "block_size") phase_map[phase_num].block_size = value;
-                        else if (param == "iodepth") phase_map[phase_num].iodepth = std::stoi(value);
-                        else if (param == "pattern") phase_map[phase_num].pattern = value;
-                        else if (param == "ioengine") phase_map[phase_num].ioengine = value;
-                        else if (param == "numjobs") phase_map[phase_num].numjobs = std::stoi(value);
-                        else if (param == "file_size") phase_map[phase_num].file_size = value;
-                        else if (param == "rate_iops") phase_map[phase_num].rate_iops = std::stoi(value);
-                    }
+            has_sweep_plan = true;
+            for (const auto& [key, value] : section.entries) {
+                if (!sweep::add_key(sweep_plan, key, value, error)) {
+                    log("ERROR: " + config_file + ": " + error);
+                    return false;
                 }
-                // Legacy single-phase parameters
-                else if (key == "description") current_workload.description = value;
-                else if (key == "file_size") current_workload.file_size = value;
-                else if (key == "block_size") current_workload.block_size = value;
-                else if (key == "runtime") current_workload.runtime = std::stoi(value);
-                else if (key == "numjobs") current_workload.numjobs = std::stoi(value);
-                else if (key == "iodepth") current_workload.iodepth = std::stoi(value);
-                else if (key == "pattern") current_workload.pattern = value;
-                else if (key == "ioengine") current_workload.ioengine = value;
-                else if (key == "rate_iops") current_workload.rate_iops = std::stoi(value);
-            }
-        }
-
-        // Add the last workload
-        if (!current_section.empty()) {
-            // Convert phase_map to phases vector
-            for (const auto& [phase_num, phase_config] : phase_map) {
-                current_workload.phases.push_back(phase_config);
             }
-            workloads[current_section] = current_workload;
         }
-
-        file.close();
-        return !workloads.empty();
+        return build_workloads({});
     }
 
 public:
@@ -977,27 +2238,194 @@ public:
                           verbose(false),
                           cgroup_config_file("cgroup_config.ini"),
                           use_cgroups(true),
-                          cache_mode_filter("both") {}
+                          cache_mode_filter("both"),
+                          engine("fio"),
+                          sample_interval_ms(1000),
+                          residency_interval_ms(1000),
+                          psi_threshold_ms(50),
+                          psi_window_ms(500),
+                          controller("none"),
+                          slo_p99_us(1000),
+                          drain_target_ms(500),
+                          controller_interval_ms(250),
+                          mrc_samples(8192),
+                          hugepages(arena::HugePages::Auto),
+                          cache_state_mode(cache_state::Mode::Drop),
+                          slo_factor(2.0),
+                          slo_settle_pp(0),
+                          adaptive_ci_pct(0),
+                          adaptive_min_s(10),
+                          blk_attr(false),
+                          perf_counters(false) {}
+
+    int pack_trace(const std::string& in_path, const std::string& out_path) {
+        uint64_t count = 0;
+        std::string error;
+        auto start = std::chrono::steady_clock::now();
+        if (!trace::pack_csv(in_path, out_path, count, error)) {
+            log("ERROR: " + error);
+            return 1;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        log("Packed " + std::to_string(count) + " trace records into " + out_path + " in " +
+            std::to_string(seconds) + "s");
+        return 0;
+    }
+
+    // Load what this run left in output_dir into the columnar store at `store_path`
+    void store_results(const std::string& store_path, const std::string& run_id,
+                       std::vector<std::pair<std::string, std::string>> labels) {
+        labels.insert(labels.begin(), {{"config", config_file}, {"engine", engine}});
+        size_t rows = 0;
+        std::string error;
+        if (!analysis::collect(output_dir, run_id, labels, store_path, rows, error)) {
+            log("WARNING: Results not stored: " + error);
+            return;
+        }
+        log("Stored " + std::to_string(rows) + " result rows as run " + run_id + " in " + store_path);
+    }
+
+    int analyze_results(std::string path, const analysis::Options& options) {
+        // A results directory stands for its store
+        if (fs::is_directory(path)) {
+            for (const char* name : {"sweep_results.fbc", "results.fbc"}) {
+                if (fs::exists(path + "/" + name)) {
+                    path += std::string("/") + name;
+                    break;
+                }
+            }
+        }
+        std::string error;
+        if (!analysis::analyze(path, options, std::cout, error)) {
+            log("ERROR: " + error);
+            return 1;
+        }
+        return 0;
+    }
+
+    // agent: serve remote tenants for coordinators holding `token`, one forked session per connection
+    int run_agent(const std::string& listen, const std::string& token, const std::string& dir, bool verbose_log) {
+        verbose = verbose_log;
+        use_cgroups = false;
+        agent_token = token;
+        std::string error;
+        int listener = rpc::listen_on(listen, error);
+        if (listener < 0) {
+            log("ERROR: " + error);
+            return 1;
+        }
+        fs::create_directories(dir);
+        log("Agent listening on " + listen + ", test files in " + fs::current_path().string() +
+            ", sessions staged in " + dir);
+        while (true) {
+            int fd = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+            // Sessions that ended meanwhile
+            while (waitpid(-1, nullptr, WNOHANG) > 0) {
+            }
+            if (fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                log(std::string("ERROR: accept: ") + strerror(errno));
+                close(listener);
+                return 1;
+            }
+            rpc::tune_socket(fd);
+            pid_t pid = fork();
+            if (pid == 0) {
+                close(listener);
+                bool ok = serve_agent_session(fd, dir);
+                close(fd);
+                exit(ok ? 0 : 1);
+            }
+            if (pid < 0) log(std::string("ERROR: fork: ") + strerror(errno));
+            close(fd);
+        }
+    }
 
     void show_usage(const std::string& program_name) {
         std::cout << "Usage: " << program_name << " [OPTIONS] [MODE]\n\n"
                   << "Run fairness benchmark tests using fairness_configs.ini\n\n"
                   << "MODES:\n"
                   << "    dual                  Run concurrent dual-client fairness test (default)\n"
-                  << "    all                   Run all sequential workloads\n"
+                  << "    multi                 Run every 'role = tenant' section concurrently\n"
+                  << "    sweep                 Run the parameter grid of the [sweep] section\n"
+                  << "    trace-pack IN OUT     Convert a CSV trace (timestamp_ns,offset,length,op) for replay\n"
+                  << "    analyze PATH          Fairness, p99 vs baseline and SLO violations from a results store\n"
+                  << "                          (results.fbc, sweep_results.fbc or their directory);\n"
+                  << "                          --slo-us N (default 1000), --baseline RUN (default: first run)\n"
+                  << "    agent                 Run remote tenants (sections with 'host = ADDR[:PORT]') for a\n"
+                  << "                          coordinator holding the same --agent-token(-file); --listen\n"
+                  << "                          [ADDR:]PORT (default 127.0.0.1:7470), -o DIR (default\n"
+                  << "                          agent_sessions); test files go in the working directory\n"
+                  << "    sequential            Run every workload section one after another\n"
+                  << "    all                   Same as sequential\n"
                   << "    <workload_name>       Run specific workload\n\n"
                   << "OPTIONS:\n"
                   << "    -c, --config FILE        Use custom config file (default: fairness_configs.ini)\n"
                   << "    -o, --output DIR         Output directory (default: fairness_results)\n"
                   << "    -m, --mode MODE          Cache mode: both, cached, or direct (default: both)\n"
+                  << "    -e, --engine ENGINE      Load generator: fio or native (default: fio)\n"
                   << "    --cgroup-config FILE     Use custom cgroup config file (default: cgroup_config.ini)\n"
+                  << "    --agent-token TOKEN      Shared secret presented to the agents of remote tenants\n"
+                  << "    --agent-token-file FILE  Same, read from the first line of FILE\n"
                   << "    --no-cgroup              Disable cgroup configuration\n"
+                  << "    --blk-attr               Split block latency into queue/device time per cgroup (eBPF, 'make bpf')\n"
+                  << "    --shard K/N              sweep: run only every Nth point, starting at the Kth\n"
+                  << "    --fill MODE              Test file content: random or zero (default: random)\n"
+                  << "    --sample-interval-ms N   Telemetry sampling period, 0 disables (default: 1000)\n"
+                  << "    --perf-counters          Also sample cycles, instructions, LLC misses, context switches and page\n"
+                  << "                             faults per tenant cgroup and kswapd CPU time (needs CAP_PERFMON)\n"
+                  << "    --residency-interval-ms N  Test file page-cache residency scan period, 0 disables (default: 1000)\n"
+                  << "    --mrc-samples N          Native engine: pages tracked per phase for MRCs, 0 disables (default: 8192)\n"
+                  << "    --hugepages MODE         Native engine I/O buffers: auto, 1g, 2m, thp or 4k (default: auto)\n"
+                  << "    --cache-state MODE       Cold start per run: drop (all caches), evict (test files only),\n"
+                  << "                             or warm (evict, then restore the post-warmup state) (default: drop)\n"
+                  << "    --slo-baseline DIR       Live SLO-violation metric per tenant against DIR/<tenant>_alone_<mode>\n"
+                  << "                             results (native engine; snapshot on <output>/slo.sock)\n"
+                  << "    --slo-factor F           SLO = F x the tenant's p99 alone (default: 2)\n"
+                  << "    --slo-settle PP          End the run once every SLO tenant's violation fraction in its last\n"
+                  << "                             phase is known to +-PP percentage points (95% CI), 0 = never (default: 0)\n"
+                  << "    --adaptive-ci PCT        Native engine: end each phase once its p99 is within +-PCT% (95% CI,\n"
+                  << "                             batch means); runtime stays the upper bound, 0 = off (default: 0)\n"
+                  << "    --adaptive-min-s N       Shortest phase under --adaptive-ci in seconds (default: 10)\n"
+                  << "    --psi-trigger T/W        PSI trigger: T ms of stall per W ms window, 'off' disables (default: 50/500)\n"
+                  << "    --controller MODE        Runtime throttling in dual mode: none or dirty_slo (default: none)\n"
+                  << "    --slo-p99-us N           dirty_slo: client1 p99 target in microseconds (default: 1000)\n"
+                  << "    --drain-target-ms N      dirty_slo: max projected drain time of client2's dirty pages (default: 500)\n"
+                  << "    --controller-interval-ms N  dirty_slo: control loop period (default: 250)\n"
                   << "    -v, --verbose            Verbose output\n"
                   << "    -h, --help               Show this help message\n\n"
+                  << "NATIVE ENGINE:\n"
+                  << "    Runs every phase of a client inside one process\n"
+                  << "    ioengine: psync, libaio, io_uring or io_uring_sqpoll\n"
+                  << "    Records every request; exact per-second p50/p99/p999/max go to <client>.lat\n"
+                  << "    Phase switches have no fio startup gap between them\n"
+                  << "    pattern = trace:<file> replays a packed trace open loop (trace_speed scales time)\n"
+                  << "    Each phase's LRU miss ratio curve goes to <phase>_mrc.csv (SHARDS sampling)\n\n"
+                  << "SEQUENTIAL MODE:\n"
+                  << "    Runs each workload section alone, every selected cache mode in turn\n"
+                  << "    Uses the selected engine, telemetry and cgroups like the concurrent modes\n"
+                  << "    Started as sequential_benchmark (make's symlink), defaults to this mode without cgroups\n\n"
                   << "DUAL-CLIENT MODE:\n"
                   << "    Runs client1_steady and client2_bursty concurrently\n"
                   << "    Logs per-second IOPS, bandwidth, and latency\n"
-                  << "    Monitors system I/O with iostat at 1-second intervals\n\n"
+                  << "    Monitors system I/O with iostat at 1-second intervals\n"
+                  << "    Samples /proc/vmstat and each client's memory.stat into telemetry/*.tel\n"
+                  << "    Scans the test files' page-cache residency (mincore) into telemetry/*.res\n"
+                  << "    --controller=dirty_slo adjusts client2's memory.high/io.weight at runtime\n"
+                  << "    from its dirty backlog and client1's p99; decisions go to controller_<mode>.csv\n"
+                  << "    With the native engine it also sets client1's memory.low from client1's live MRC\n\n"
+                  << "MULTI-TENANT MODE:\n"
+                  << "    Launches every section with 'role = tenant' (x 'replicas') in its own cgroup\n"
+                  << "    Tenants without a cgroup section get tenants/<name> with [tenant_default] settings\n"
+                  << "    All tenants start together; per-tenant p99s go to multi_<mode>_summary.csv\n"
+                  << "    dual and multi start tenants from one shared epoch; phase boundaries go to\n"
+                  << "    <group>_<mode>_phase_schedule.csv\n\n"
+                  << "SWEEP MODE:\n"
+                  << "    [sweep] declares mode, repetitions and grid.<section>.<key> = v1,v2 or start:stop:step\n"
+                  << "    Each point runs into <output>/points/<fingerprint>/ and is skipped once it has a DONE marker,\n"
+                  << "    so an interrupted sweep resumes; the output directory is never wiped\n"
+                  << "    Hosts sharing an output directory (e.g. over NFS) split the points between them;\n"
+                  << "    one sweep per host, since runs on one host share cgroup names, test files and page cache\n\n"
                   << "EXAMPLES:\n"
                   << "    " << program_name << "                                    # Run dual-client fairness test (both modes)\n"
                   << "    " << program_name << " dual                               # Run dual-client fairness test (both modes)\n"
@@ -1005,9 +2433,15 @@ public:
                   << "    " << program_name << " -m direct dual                     # Run dual-client in direct mode only\n"
                   << "    " << program_name << " --cgroup-config custom.ini dual    # Use custom cgroup config\n"
                   << "    " << program_name << " --no-cgroup dual                   # Run without cgroup configuration\n"
-                  << "    " << program_name << " -v dual                            # Run dual-client with verbose output\n";
+                  << "    " << program_name << " -v dual                            # Run dual-client with verbose output\n"
+                  << "    " << program_name << " -e native dual                     # Run dual-client with the native engine\n"
+                  << "    " << program_name << " -c test_configs.ini sequential     # Run every workload on its own\n"
+                  << "    " << program_name << " -c multi_tenant_configs.ini multi  # Run all tenants concurrently\n"
+                  << "    " << program_name << " -c sweep_configs.ini sweep         # Run (or resume) a parameter sweep\n";
     }
 
+    void disable_cgroups() { use_cgroups = false; }
+
     bool parse_args(int argc, char* argv[]) {
         std::string workload = "all";
 
@@ -1039,6 +2473,28 @@ public:
                     log("ERROR: --mode requires a value (both, cached, or direct)");
                     return false;
                 }
+            } else if (arg == "-e" || arg == "--engine") {
+                if (i + 1 < argc) {
+                    engine = argv[++i];
+                    if (engine != "fio" && engine != "native") {
+                        log("ERROR: --engine must be 'fio' or 'native'");
+                        return false;
+                    }
+                } else {
+                    log("ERROR: --engine requires a value (fio or native)");
+                    return false;
+                }
+            } else if (arg == "--agent-token" || arg == "--agent-token-file") {
+                if (i + 1 >= argc) {
+                    log("ERROR: " + arg + " requires a value");
+                    return false;
+                }
+                std::string error;
+                if (arg == "--agent-token") agent_token = argv[++i];
+                else if (!rpc::read_token_file(argv[++i], agent_token, error)) {
+                    log("ERROR: " + error);
+                    return false;
+                }
             } else if (arg == "--cgroup-config") {
                 if (i + 1 < argc) {
                     cgroup_config_file = argv[++i];
@@ -1046,6 +2502,148 @@ public:
                     log("ERROR: --cgroup-config requires a filename");
                     return false;
                 }
+            } else if (arg == "--shard") {
+                int k = 0, n = 0;
+                if (i + 1 >= argc || sscanf(argv[i + 1], "%d/%d", &k, &n) != 2 || n < 1 || k < 1 || k > n) {
+                    log("ERROR: --shard requires K/N with 1 <= K <= N");
+                    return false;
+                }
+                shard_index = k - 1;
+                shard_count = n;
+                i++;
+            } else if (arg == "--fill") {
+                if (i + 1 >= argc || !provision::parse_content(argv[i + 1], fill_options.content)) {
+                    log("ERROR: --fill requires 'random' or 'zero'");
+                    return false;
+                }
+                i++;
+            } else if (arg == "--sample-interval-ms") {
+                if (i + 1 < argc) {
+                    sample_interval_ms = std::atoi(argv[++i]);
+                    if (sample_interval_ms < 0) {
+                        log("ERROR: --sample-interval-ms must be >= 0");
+                        return false;
+                    }
+                } else {
+                    log("ERROR: --sample-interval-ms requires a value in milliseconds");
+                    return false;
+                }
+            } else if (arg == "--residency-interval-ms") {
+                if (i + 1 < argc) {
+                    residency_interval_ms = std::atoi(argv[++i]);
+                    if (residency_interval_ms < 0) {
+                        log("ERROR: --residency-interval-ms must be >= 0");
+                        return false;
+                    }
+                } else {
+                    log("ERROR: --residency-interval-ms requires a value in milliseconds");
+                    return false;
+                }
+            } else if (arg == "--mrc-samples") {
+                if (i + 1 < argc) {
+                    mrc_samples = std::atoi(argv[++i]);
+                    if (mrc_samples < 0) {
+                        log("ERROR: --mrc-samples must be >= 0");
+                        return false;
+                    }
+                } else {
+                    log("ERROR: --mrc-samples requires a value");
+                    return false;
+                }
+            } else if (arg == "--hugepages") {
+                if (i + 1 >= argc || !arena::parse_hugepages(argv[i + 1], hugepages)) {
+                    log("ERROR: --hugepages requires auto, 1g, 2m, thp or 4k");
+                    return false;
+                }
+                i++;
+            } else if (arg == "--cache-state") {
+                if (i + 1 >= argc || !cache_state::parse_mode(argv[i + 1], cache_state_mode)) {
+                    log("ERROR: --cache-state requires drop, evict or warm");
+                    return false;
+                }
+                i++;
+            } else if (arg == "--slo-baseline") {
+                if (i + 1 >= argc) {
+                    log("ERROR: --slo-baseline requires a results directory");
+                    return false;
+                }
+                slo_baseline = argv[++i];
+            } else if (arg == "--slo-factor" || arg == "--slo-settle") {
+                if (i + 1 >= argc) {
+                    log("ERROR: " + arg + " requires a value");
+                    return false;
+                }
+                double value = std::atof(argv[++i]);
+                if (arg == "--slo-factor" ? value <= 0 : value < 0) {
+                    log("ERROR: " + arg + " must be " + (arg == "--slo-factor" ? "> 0" : ">= 0"));
+                    return false;
+                }
+                if (arg == "--slo-factor") slo_factor = value;
+                else slo_settle_pp = value;
+            } else if (arg == "--adaptive-ci" || arg == "--adaptive-min-s") {
+                if (i + 1 >= argc) {
+                    log("ERROR: " + arg + " requires a value");
+                    return false;
+                }
+                double value = std::atof(argv[++i]);
+                if (arg == "--adaptive-ci" ? value < 0 : value < 1) {
+                    log("ERROR: " + arg + " must be " + (arg == "--adaptive-ci" ? ">= 0" : ">= 1"));
+                    return false;
+                }
+                if (arg == "--adaptive-ci") adaptive_ci_pct = value;
+                else adaptive_min_s = static_cast<int>(value);
+            } else if (arg == "--psi-trigger") {
+                if (i + 1 >= argc) {
+                    log("ERROR: --psi-trigger requires THRESHOLD_MS/WINDOW_MS or 'off'");
+                    return false;
+                }
+                std::string value = argv[++i];
+                size_t slash = value.find('/');
+                if (value == "off") {
+                    psi_threshold_ms = 0;
+                } else if (slash != std::string::npos) {
+                    // The kernel accepts windows of 500ms to 10s
+                    psi_threshold_ms = std::atoi(value.substr(0, slash).c_str());
+                    psi_window_ms = std::atoi(value.substr(slash + 1).c_str());
+                    if (psi_threshold_ms <= 0 || psi_window_ms < 500 || psi_window_ms > 10000 ||
+                        psi_threshold_ms >= psi_window_ms) {
+                        log("ERROR: --psi-trigger window must be 500-10000ms and longer than the threshold");
+                        return false;
+                    }
+                } else {
+                    log("ERROR: --psi-trigger must be THRESHOLD_MS/WINDOW_MS or 'off'");
+                    return false;
+                }
+            } else if (arg == "--controller" || arg.rfind("--controller=", 0) == 0) {
+                if (arg != "--controller") {
+                    controller = arg.substr(strlen("--controller="));
+                } else if (i + 1 < argc) {
+                    controller = argv[++i];
+                } else {
+                    log("ERROR: --controller requires a value (none or dirty_slo)");
+                    return false;
+                }
+                if (controller != "none" && controller != "dirty_slo") {
+                    log("ERROR: --controller must be 'none' or 'dirty_slo'");
+                    return false;
+                }
+            } else if (arg == "--slo-p99-us" || arg == "--drain-target-ms" || arg == "--controller-interval-ms") {
+                if (i + 1 >= argc) {
+                    log("ERROR: " + arg + " requires a value");
+                    return false;
+                }
+                int value = std::atoi(argv[++i]);
+                if (value <= 0) {
+                    log("ERROR: " + arg + " must be > 0");
+                    return false;
+                }
+                if (arg == "--slo-p99-us") slo_p99_us = value;
+                else if (arg == "--drain-target-ms") drain_target_ms = value;
+                else controller_interval_ms = value;
+            } else if (arg == "--blk-attr") {
+                blk_attr = true;
+            } else if (arg == "--perf-counters") {
+                perf_counters = true;
             } else if (arg == "--no-cgroup") {
                 use_cgroups = false;
             } else if (arg == "-v" || arg == "--verbose") {
@@ -1061,28 +2659,214 @@ public:
         return true;
     }
 
-    int run(const std::string& mode) {
-        if (!check_dependencies()) {
-            return 1;
+    // Everything that changes a point's results: resolved workloads, run options and cgroup settings
+    uint64_t point_fingerprint(const sweep::Point& point, const std::string& cgroup_text) {
+        std::ostringstream text;
+        text << "mode=" << sweep_plan.mode << "\nrepetition=" << point.repetition << "\nengine=" << engine
+             << "\ncache_mode=" << cache_mode_filter << "\nfill=" << provision::content_name(fill_options.content)
+             << "\ncontroller=" << controller << "," << slo_p99_us << "," << drain_target_ms << ","
+             << controller_interval_ms << "\nmrc_samples=" << mrc_samples << "\ncgroups=" << (use_cgroups ? cgroup_text : "off") << "\n";
+        // Default left out so fingerprints of existing sweeps still match
+        if (cache_state_mode != cache_state::Mode::Drop) {
+            text << "cache_state=" << cache_state::mode_name(cache_state_mode) << "\n";
+        }
+        if (adaptive_ci_pct > 0) text << "adaptive=" << adaptive_ci_pct << "," << adaptive_min_s << "\n";
+        // An early stop shortens the point, so its rule is part of the point
+        if (slo_settle_pp > 0 && !slo_baseline.empty()) {
+            text << "slo=" << fs::absolute(slo_baseline).string() << "," << slo_factor << "," << slo_settle_pp << "\n";
         }
+        for (const auto& section : config_sections) {
+            text << "[" << section.name << "]\n";
+            for (const auto& [key, value] : resolved_entries(section, point.overrides)) {
+                text << key << "=" << value << "\n";
+            }
+        }
+        return sweep::fnv1a(text.str());
+    }
 
-        if (!parse_config_file()) {
-            log("ERROR: Failed to parse config file");
-            return 1;
+    std::string describe_point(const sweep::Point& point) {
+        std::string desc;
+        for (size_t a = 0; a < sweep_plan.axes.size(); a++) {
+            desc += sweep::axis_name(sweep_plan.axes[a]) + "=" + point.values[a] + " ";
         }
+        return desc + "rep=" + std::to_string(point.repetition);
+    }
 
-        // Parse cgroup configuration
-        parse_cgroup_config();
+    // Grid keys must name an existing section and a workload parameter that accepts every value
+    bool validate_sweep_plan() {
+        if (!has_sweep_plan) {
+            log("ERROR: Sweep mode requires a [sweep] section in " + config_file);
+            return false;
+        }
+        if (sweep_plan.mode == "sweep") {
+            log("ERROR: [sweep] mode cannot be 'sweep'");
+            return false;
+        }
+        for (const auto& axis : sweep_plan.axes) {
+            if (workloads.find(axis.section) == workloads.end()) {
+                log("ERROR: Grid key " + sweep::axis_name(axis) + " names unknown section '" + axis.section + "'");
+                return false;
+            }
+            for (const auto& value : axis.values) {
+                WorkloadConfig probe;
+                std::map<int, PhaseConfig> phase_map;
+                bool known = false;
+                try {
+                    known = apply_workload_key(probe, phase_map, axis.key, value);
+                } catch (const std::exception&) {
+                    log("ERROR: Invalid value '" + value + "' for grid key " + sweep::axis_name(axis));
+                    return false;
+                }
+                if (!known) {
+                    log("ERROR: Grid key " + sweep::axis_name(axis) + " is not a workload parameter");
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
 
-        log("Starting fairness benchmark");
-        log("Mode: " + mode + ", Config: " + config_file);
-        log("Cache mode: " + cache_mode_filter + ", Cgroups: " + (use_cgroups ? "enabled" : "disabled"));
+    // One row per client result of every finished point, labelled with the point's grid values
+    void write_sweep_results(const std::vector<sweep::Point>& points, const std::string& base_dir) {
+        std::ofstream out(base_dir + "/sweep_results.csv");
+        out << "fingerprint,repetition";
+        for (const auto& axis : sweep_plan.axes) out << "," << sweep::axis_name(axis);
+        out << ",client,cache_mode,read_iops,write_iops,read_p99_us,read_p999_us,write_p99_us,write_p999_us,max_us\n";
+        out << std::fixed << std::setprecision(1);
+        for (const auto& point : points) {
+            std::string point_dir = base_dir + "/points/" + sweep::hex(point.fingerprint);
+            if (!fs::exists(point_dir + "/DONE")) continue;
+            std::vector<fs::path> result_files;
+            for (const auto& entry : fs::directory_iterator(point_dir)) {
+                std::string stem = entry.path().stem().string();
+                if (entry.path().extension() == ".json" && stem.find("_phase") == std::string::npos) {
+                    result_files.push_back(entry.path());
+                }
+            }
+            std::sort(result_files.begin(), result_files.end());
+            for (const auto& file : result_files) {
+                // <client>_<cache mode>.json
+                std::string stem = file.stem().string();
+                size_t us = stem.rfind('_');
+                if (us == std::string::npos) continue;
+                results::PhaseSummary summary;
+                std::string error;
+                if (!results::parse_fio_json(file.string(), summary, error)) continue;
+                out << sweep::hex(point.fingerprint) << "," << point.repetition;
+                for (const auto& value : point.values) out << "," << value;
+                out << "," << stem.substr(0, us) << "," << stem.substr(us + 1) << ",";
+                write_result_columns(out, summary);
+                out << "\n";
+            }
+        }
+    }
 
-        setup();
+    bool run_sweep() {
+        if (!validate_sweep_plan()) {
+            return false;
+        }
 
-        // Setup all cgroups once at the beginning
-        setup_all_cgroups();
+        std::string cgroup_text;
+        if (use_cgroups) {
+            std::ifstream cgroup_file(cgroup_config_file);
+            cgroup_text.assign(std::istreambuf_iterator<char>(cgroup_file), std::istreambuf_iterator<char>());
+        }
+        std::vector<sweep::Point> points = sweep::expand(sweep_plan);
+        for (auto& point : points) {
+            point.fingerprint = point_fingerprint(point, cgroup_text);
+        }
+        // Every point's plan must validate before the first one runs
+        for (const auto& point : points) {
+            if (!build_workloads(point.overrides)) {
+                log("ERROR: Sweep point " + describe_point(point) + " is not a valid config");
+                return false;
+            }
+        }
+
+        // Two sweeps on one host would clean up each other's cgroups, share test files and one page cache
+        sweep::PointLock host_lock;
+        if (!host_lock.acquire(sweep::kHostLock)) {
+            log(std::string("ERROR: Another sweep is running on this host (") + sweep::kHostLock +
+                "); split a sweep across hosts, not processes");
+            return false;
+        }
+
+        // Results accumulate across invocations: no remove_all of the output directory
+        std::string base_dir = output_dir;
+        fs::create_directories(base_dir + "/points");
+        log("Sweep: " + std::to_string(points.size()) + " points (" + std::to_string(sweep_plan.axes.size()) +
+            " axes x " + std::to_string(sweep_plan.repetitions) + " repetitions), mode " + sweep_plan.mode +
+            (shard_count > 1 ? ", shard " + std::to_string(shard_index + 1) + "/" + std::to_string(shard_count) : ""));
+
+        int ran = 0, cached = 0, busy = 0, failed = 0;
+        for (const auto& point : points) {
+            if (static_cast<int>(point.ordinal % shard_count) != shard_index) continue;
+            std::string point_dir = base_dir + "/points/" + sweep::hex(point.fingerprint);
+            if (fs::exists(point_dir + "/DONE")) {
+                cached++;
+                continue;
+            }
+            sweep::PointLock lock;
+            if (!lock.acquire(point_dir + ".lock")) {
+                log("Sweep point " + describe_point(point) + " is running elsewhere, skipping");
+                busy++;
+                continue;
+            }
+            // Another process may have finished it between the check and the lock
+            if (fs::exists(point_dir + "/DONE")) {
+                cached++;
+                continue;
+            }
+
+            log("Sweep point " + std::to_string(point.ordinal + 1) + "/" + std::to_string(points.size()) + ": " +
+                describe_point(point));
+            build_workloads(point.overrides);
+            output_dir = point_dir;
+            setup();
+            {
+                std::ofstream point_file(point_dir + "/point.ini");
+                point_file << "fingerprint = " << sweep::hex(point.fingerprint) << "\n"
+                           << "repetition = " << point.repetition << "\n";
+                for (size_t a = 0; a < sweep_plan.axes.size(); a++) {
+                    point_file << sweep::axis_name(sweep_plan.axes[a]) << " = " << point.values[a] << "\n";
+                }
+            }
+            if (use_cgroups && sweep_plan.mode == "multi") {
+                add_tenant_cgroups();
+            }
+            setup_all_cgroups();
+            bool ok = run_mode(sweep_plan.mode);
+            generate_summary();
+            cleanup_cgroups();
+            output_dir = base_dir;
+
+            if (ok) {
+                // Stored before DONE: a crash in between re-runs the point, and analysis keeps its last batch
+                std::vector<std::pair<std::string, std::string>> labels = {
+                    {"mode", sweep_plan.mode}, {"repetition", std::to_string(point.repetition)}};
+                for (size_t a = 0; a < sweep_plan.axes.size(); a++) {
+                    labels.push_back({sweep::axis_name(sweep_plan.axes[a]), point.values[a]});
+                }
+                output_dir = point_dir;
+                store_results(base_dir + "/sweep_results.fbc", sweep::hex(point.fingerprint), labels);
+                output_dir = base_dir;
+                std::ofstream(point_dir + "/DONE") << get_timestamp() << "\n";
+                ran++;
+            } else {
+                log("  ✗ Sweep point failed; it will be retried on the next run");
+                failed++;
+            }
+        }
+
+        write_sweep_results(points, base_dir);
+        log("Sweep: " + std::to_string(ran) + " run, " + std::to_string(cached) + " cached, " +
+            std::to_string(busy) + " busy elsewhere, " + std::to_string(failed) + " failed");
+        log("✅ Sweep results: " + base_dir + "/sweep_results.csv");
+        return failed == 0;
+    }
 
+    // Run one benchmark mode into output_dir
+    bool run_mode(const std::string& mode) {
         // Check if config has dual-client setup
         bool has_dual_clients = (workloads.find("client1_steady") != workloads.end() &&
                                  workloads.find("client2_bursty") != workloads.end());
@@ -1090,20 +2874,70 @@ public:
         if (mode == "dual") {
             if (!has_dual_clients) {
                 log("ERROR: Dual-client mode requires 'client1_steady' and 'client2_bursty' in config");
-                return 1;
+                return false;
             }
             if (!run_concurrent_clients()) {
-                return 1;
+                return false;
+            }
+        } else if (mode == "multi") {
+            if (!run_multi_tenant()) {
+                return false;
             }
-        } else if (mode == "all") {
+        } else if (mode == "sequential" || mode == "all") {
             run_all_workloads();
         } else {
             if (!run_workload(mode)) {
-                return 1;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    int run(const std::string& mode) {
+        if (!check_dependencies()) {
+            return 1;
+        }
+
+        if (!parse_config_file()) {
+            log("ERROR: Failed to parse config file");
+            return 1;
+        }
+
+        // Parse cgroup configuration
+        if (!parse_cgroup_config()) {
+            return 1;
+        }
+
+        log("Starting fairness benchmark");
+        log("Mode: " + mode + ", Config: " + config_file);
+        log("Cache mode: " + cache_mode_filter + ", Cgroups: " + (use_cgroups ? "enabled" : "disabled") +
+            ", Engine: " + engine);
+
+        if (mode == "sweep") {
+            if (use_cgroups) {
+                cgroup_manager.init();
+            }
+            return run_sweep() ? 0 : 1;
+        }
+
+        setup();
+
+        // Setup all cgroups once at the beginning
+        if (use_cgroups) {
+            cgroup_manager.init();
+            if (mode == "multi") {
+                add_tenant_cgroups();
             }
         }
+        setup_all_cgroups();
+
+        if (!run_mode(mode)) {
+            return 1;
+        }
 
         generate_summary();
+        store_results(output_dir + "/results.fbc", mode + "@" + get_timestamp(),
+                      {{"mode", mode}, {"cache_mode", cache_mode_filter}});
 
         // Final cleanup
         cleanup_cgroups();
@@ -1116,11 +2950,84 @@ public:
 int main(int argc, char* argv[]) {
     FairnessBenchmark benchmark;
 
-    if (!benchmark.parse_args(argc, argv)) {
-        return 1;
+    // trace-pack IN.csv OUT.trc: convert a captured trace for pattern = trace:<file>
+    if (argc > 1 && strcmp(argv[1], "trace-pack") == 0) {
+        if (argc != 4) {
+            std::cerr << "Usage: " << argv[0] << " trace-pack IN.csv OUT.trc\n";
+            return 1;
+        }
+        return benchmark.pack_trace(argv[2], argv[3]);
     }
 
+    // analyze PATH [--slo-us N] [--baseline RUN]: read a results store
+    if (argc > 1 && strcmp(argv[1], "analyze") == 0) {
+        analysis::Options options;
+        std::string path;
+        for (int i = 2; i < argc; i++) {
+            if (strcmp(argv[i], "--slo-us") == 0 && i + 1 < argc) {
+                options.slo_us = std::atof(argv[++i]);
+            } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+                options.baseline = argv[++i];
+            } else if (path.empty() && argv[i][0] != '-') {
+                path = argv[i];
+            } else {
+                path.clear();
+                break;
+            }
+        }
+        if (path.empty() || options.slo_us <= 0) {
+            std::cerr << "Usage: " << argv[0] << " analyze PATH [--slo-us N] [--baseline RUN]\n";
+            return 1;
+        }
+        return benchmark.analyze_results(path, options);
+    }
+
+    // agent [--listen [ADDR:]PORT] --agent-token(-file) T [-o DIR] [-v]: run remote tenants for coordinators
+    if (argc > 1 && strcmp(argv[1], "agent") == 0) {
+        std::string listen = rpc::kDefaultListen;
+        std::string token, error;
+        std::string dir = "agent_sessions";
+        bool verbose = false;
+        bool usage = false;
+        for (int i = 2; i < argc; i++) {
+            if (strcmp(argv[i], "--listen") == 0 && i + 1 < argc) {
+                // A bare port stays on loopback
+                listen = argv[++i];
+                if (listen.find_first_not_of("0123456789") == std::string::npos) listen = "127.0.0.1:" + listen;
+            } else if (strcmp(argv[i], "--agent-token") == 0 && i + 1 < argc) {
+                token = argv[++i];
+            } else if (strcmp(argv[i], "--agent-token-file") == 0 && i + 1 < argc) {
+                if (!rpc::read_token_file(argv[++i], token, error)) {
+                    std::cerr << "ERROR: " << error << "\n";
+                    return 1;
+                }
+            } else if ((strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--output") == 0) && i + 1 < argc) {
+                dir = argv[++i];
+            } else if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0) {
+                verbose = true;
+            } else {
+                usage = true;
+                break;
+            }
+        }
+        if (usage || token.empty()) {
+            if (!usage) std::cerr << "ERROR: the agent needs a shared --agent-token or --agent-token-file\n";
+            std::cerr << "Usage: " << argv[0] << " agent [--listen [ADDR:]PORT] (--agent-token TOKEN | "
+                      << "--agent-token-file FILE) [-o DIR] [-v]\n";
+            return 1;
+        }
+        return benchmark.run_agent(listen, token, dir, verbose);
+    }
+
+    // Started as sequential_benchmark: the old standalone defaults
     std::string mode = "dual";  // Default to dual-client mode
+    if (fs::path(argv[0]).filename() == "sequential_benchmark") {
+        mode = "sequential";
+        benchmark.disable_cgroups();
+    }
+    if (!benchmark.parse_args(argc, argv)) {
+        return 1;
+    }
     if (argc > 1) {
         // Find the mode argument (the one that's not an option)
         for (int i = 1; i < argc; i++) {
@@ -1129,6 +3036,21 @@ int main(int argc, char* argv[]) {
                 (i == 1 || (strcmp(argv[i-1], "-c") != 0 && strcmp(argv[i-1], "--config") != 0 &&
                            strcmp(argv[i-1], "-o") != 0 && strcmp(argv[i-1], "--output") != 0 &&
                            strcmp(argv[i-1], "-m") != 0 && strcmp(argv[i-1], "--mode") != 0 &&
+                           strcmp(argv[i-1], "-e") != 0 && strcmp(argv[i-1], "--engine") != 0 &&
+                           strcmp(argv[i-1], "--fill") != 0 && strcmp(argv[i-1], "--shard") != 0 &&
+                           strcmp(argv[i-1], "--sample-interval-ms") != 0 &&
+                           strcmp(argv[i-1], "--mrc-samples") != 0 && strcmp(argv[i-1], "--hugepages") != 0 &&
+                           strcmp(argv[i-1], "--cache-state") != 0 &&
+                           strcmp(argv[i-1], "--slo-baseline") != 0 && strcmp(argv[i-1], "--slo-factor") != 0 &&
+                           strcmp(argv[i-1], "--slo-settle") != 0 && strcmp(argv[i-1], "--adaptive-ci") != 0 &&
+                           strcmp(argv[i-1], "--adaptive-min-s") != 0 &&
+                           strcmp(argv[i-1], "--residency-interval-ms") != 0 &&
+                           strcmp(argv[i-1], "--psi-trigger") != 0 &&
+                           strcmp(argv[i-1], "--controller") != 0 && strcmp(argv[i-1], "--slo-p99-us") != 0 &&
+                           strcmp(argv[i-1], "--drain-target-ms") != 0 &&
+                           strcmp(argv[i-1], "--controller-interval-ms") != 0 &&
+                           strcmp(argv[i-1], "--agent-token") != 0 &&
+                           strcmp(argv[i-1], "--agent-token-file") != 0 &&
                            strcmp(argv[i-1], "--cgroup-config") != 0))) {
                 mode = arg;
                 break;
@@ -0,0 +1,251 @@
+// file_provisioner.h
+// Built-in creation of benchmark test files.
+//
+// A file is fallocated to its full size up front (one extent allocation, no
+// fragmentation from concurrent appends) and then filled by one thread per
+// core. Threads claim 8MB chunks from a shared counter and write them with
+// O_DIRECT from aligned buffers, so filling a 32G file neither floods the
+// page cache nor waits on /dev/urandom.
+//
+// Random content comes from xoshiro256** seeded per chunk (splitmix64 of
+// seed and chunk index): incompressible, deterministic for a given seed,
+// and independent of how many threads wrote it. Zero content is written
+// explicitly so extents are real data, as dd from /dev/zero would leave them.
+//
+// A "<file>.manifest" sidecar records size, content mode and seed. An
+// existing file is reused only when its size and the manifest still match
+// (write workloads rewrite blocks in place, so mtime is deliberately not
+// part of it); the manifest is written last, so an interrupted fill is
+// never mistaken for a complete one.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace provision {
+
+enum class Content { kRandom, kZero };
+
+inline const char* content_name(Content c) { return c == Content::kZero ? "zero" : "random"; }
+
+inline bool parse_content(const std::string& name, Content& out) {
+    if (name == "random") out = Content::kRandom;
+    else if (name == "zero") out = Content::kZero;
+    else return false;
+    return true;
+}
+
+// "4k", "512M", "16G", "2T" or plain bytes; 0 if malformed
+inline uint64_t parse_size(const std::string& size_str) {
+    if (size_str.empty()) return 0;
+    uint64_t multiplier = 1;
+    switch (size_str.back()) {
+        case 'K': case 'k': multiplier = 1024ULL; break;
+        case 'M': case 'm': multiplier = 1024ULL * 1024; break;
+        case 'G': case 'g': multiplier = 1024ULL * 1024 * 1024; break;
+        case 'T': case 't': multiplier = 1024ULL * 1024 * 1024 * 1024; break;
+        default: break;
+    }
+    std::string numeric = multiplier == 1 ? size_str : size_str.substr(0, size_str.size() - 1);
+    char* end = nullptr;
+    unsigned long long n = strtoull(numeric.c_str(), &end, 10);
+    if (numeric.empty() || *end != '\0') return 0;
+    return n * multiplier;
+}
+
+struct Options {
+    Content content = Content::kRandom;
+    uint64_t seed = 0x5eed5eed5eed5eedULL;
+    int threads = 0;                    // 0 = one per online CPU
+    size_t chunk_bytes = 8 << 20;
+};
+
+struct Result {
+    bool reused = false;
+    double seconds = 0;
+    int threads = 0;
+    bool direct = false;                // O_DIRECT writes (false: buffered + fdatasync)
+};
+
+inline uint64_t splitmix64(uint64_t& x) {
+    uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// xoshiro256** (Blackman & Vigna)
+class Xoshiro256 {
+public:
+    explicit Xoshiro256(uint64_t seed) {
+        for (auto& word : s) word = splitmix64(seed);
+    }
+
+    uint64_t next() {
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    void fill(void* buf, size_t bytes) {
+        uint64_t* words = static_cast<uint64_t*>(buf);
+        for (size_t i = 0; i < bytes / 8; i++) words[i] = next();
+    }
+
+private:
+    uint64_t s[4];
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+};
+
+inline std::string manifest_path(const std::string& path) { return path + ".manifest"; }
+
+inline std::string manifest_text(uint64_t size, const Options& options) {
+    return "version=1\nsize=" + std::to_string(size) + "\ncontent=" + content_name(options.content) +
+           "\nseed=" + std::to_string(options.content == Content::kZero ? 0 : options.seed) + "\n";
+}
+
+// True if path exists with exactly `size` bytes and a manifest matching `options`
+inline bool is_current(const std::string& path, uint64_t size, const Options& options) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || static_cast<uint64_t>(st.st_size) != size) return false;
+    std::ifstream in(manifest_path(path));
+    if (!in) return false;
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return content == manifest_text(size, options);
+}
+
+// Fill [chunk * chunk_bytes, ...) for every chunk claimed from `next_chunk`
+inline bool fill_chunks(int direct_fd, int buffered_fd, uint64_t size, const Options& options,
+                        std::atomic<uint64_t>& next_chunk, std::string& error) {
+    void* raw = nullptr;
+    if (posix_memalign(&raw, 4096, options.chunk_bytes) != 0) {
+        error = "Cannot allocate fill buffer";
+        return false;
+    }
+    char* buf = static_cast<char*>(raw);
+    if (options.content == Content::kZero) memset(buf, 0, options.chunk_bytes);
+
+    uint64_t num_chunks = (size + options.chunk_bytes - 1) / options.chunk_bytes;
+    bool ok = true;
+    for (uint64_t chunk = next_chunk.fetch_add(1); chunk < num_chunks && ok; chunk = next_chunk.fetch_add(1)) {
+        uint64_t offset = chunk * options.chunk_bytes;
+        size_t len = static_cast<size_t>(std::min<uint64_t>(options.chunk_bytes, size - offset));
+        if (options.content == Content::kRandom) {
+            uint64_t chunk_seed = options.seed ^ (chunk * 0xd1b54a32d192ed03ULL);
+            Xoshiro256(chunk_seed).fill(buf, (len + 7) & ~size_t(7));
+        }
+        // O_DIRECT needs 4k-aligned lengths; an unaligned tail goes through the page cache
+        size_t aligned = direct_fd >= 0 ? len & ~size_t(4095) : 0;
+        size_t done = 0;
+        while (done < len) {
+            bool use_direct = done < aligned;
+            size_t want = use_direct ? aligned - done : len - done;
+            ssize_t n = pwrite(use_direct ? direct_fd : buffered_fd, buf + done, want, offset + done);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                error = std::string("write failed: ") + (n < 0 ? strerror(errno) : "no progress");
+                ok = false;
+                break;
+            }
+            done += static_cast<size_t>(n);
+        }
+    }
+    free(raw);
+    return ok;
+}
+
+// Create (or reuse) a test file of `size` bytes; false with `error` set on failure
+inline bool provision_file(const std::string& path, uint64_t size, const Options& options,
+                           Result& result, std::string& error) {
+    result = Result();
+    if (size == 0) {
+        error = "Invalid file size for " + path;
+        return false;
+    }
+    if (is_current(path, size, options)) {
+        result.reused = true;
+        return true;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    unlink(manifest_path(path).c_str());
+    int buffered_fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (buffered_fd < 0) {
+        error = "Cannot create " + path + ": " + strerror(errno);
+        return false;
+    }
+    // Filesystems without fallocate (tmpfs on old kernels, some FUSE) just get a sparse file
+    if (fallocate(buffered_fd, 0, 0, static_cast<off_t>(size)) != 0 &&
+        ftruncate(buffered_fd, static_cast<off_t>(size)) != 0) {
+        error = "Cannot size " + path + ": " + strerror(errno);
+        close(buffered_fd);
+        return false;
+    }
+    // tmpfs and some network filesystems refuse O_DIRECT
+    int direct_fd = open(path.c_str(), O_WRONLY | O_DIRECT | O_CLOEXEC);
+    result.direct = direct_fd >= 0;
+
+    int threads = options.threads > 0 ? options.threads : static_cast<int>(std::thread::hardware_concurrency());
+    uint64_t num_chunks = (size + options.chunk_bytes - 1) / options.chunk_bytes;
+    threads = static_cast<int>(std::max<uint64_t>(1, std::min<uint64_t>(std::max(threads, 1), num_chunks)));
+    result.threads = threads;
+
+    std::atomic<uint64_t> next_chunk{0};
+    std::vector<std::string> errors(threads);
+    std::vector<char> ok(threads, 0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            ok[t] = fill_chunks(direct_fd, buffered_fd, size, options, next_chunk, errors[t]);
+        });
+    }
+    for (auto& w : workers) w.join();
+
+    bool success = std::all_of(ok.begin(), ok.end(), [](char v) { return v != 0; });
+    if (!success) {
+        for (const auto& e : errors) {
+            if (!e.empty()) {
+                error = "Cannot fill " + path + ": " + e;
+                break;
+            }
+        }
+    } else if (fdatasync(buffered_fd) != 0) {
+        error = "Cannot sync " + path + ": " + strerror(errno);
+        success = false;
+    }
+    if (direct_fd >= 0) close(direct_fd);
+    close(buffered_fd);
+    if (!success) return false;
+
+    std::ofstream manifest(manifest_path(path));
+    manifest << manifest_text(size, options);
+    if (!manifest) {
+        error = "Cannot write " + manifest_path(path);
+        return false;
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+}  // namespace provision
@@ -0,0 +1,363 @@
+// harness_bench.cpp
+// Microbenchmarks of the harness itself (make bench): what the benchmark costs
+// the measurements it takes.
+//
+//   BM_HistogramRecord   LatencyRecorder::record(), once per completed I/O
+//   BM_ClockRead         monotonic_ns(), twice per I/O
+//   BM_StatFileSample    one pread + parse of a sampled stat file, per file
+//   BM_BackendRead       prep + submit + reap of 4k cached reads, per backend
+//                        and queue depth (time per iteration = one batch)
+//   BM_PacerLateness     how late arrival::wait_until() (sleep, then spin)
+//                        and a plain clock_nanosleep wake up; the reported
+//                        time is the mean lateness, p99_late_ns its tail
+//   BM_CgroupWrite       one memory.high write, as setup (open + write) and
+//                        as the dirty_slo controller does it (pwrite to a kept fd)
+//
+// Google Benchmark runs them; --track=FILE writes the median time of every
+// benchmark as "name<TAB>ns" lines, and --baseline=FILE compares against an
+// earlier one. A benchmark that got slower by more than --tolerance-pct
+// (default 25) and by at least --min-regression-ns (default 500) fails the
+// run; the per-I/O ones (histogram, clock, backends) also fail on any
+// slowdown beyond --max-regression-ns (default 2000), however long they
+// take. Added hot-path work shows up here instead of as a p99 shift.
+// `make bench` tracks each commit in bench_results/<commit>.tsv against
+// bench_results/baseline.tsv (`make bench-baseline` records one).
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+
+#include "arrival_schedule.h"
+#include "cgroup_manager.h"
+#include "latency_recorder.h"
+#include "native_engine.h"
+#include "telemetry_sampler.h"
+
+namespace {
+
+constexpr uint64_t kFileBytes = 16ULL << 20;
+constexpr uint32_t kBlockBytes = 4096;
+const char* kBenchFile = "harness_bench_file";
+const char* kBenchCgroup = "fairness_bench_probe";
+
+// ---------------------------------------------------------------------------
+// Hot path
+// ---------------------------------------------------------------------------
+
+void BM_HistogramRecord(benchmark::State& state) {
+    latency::LatencyRecorder recorder(1, latency::monotonic_ns(), 1000000000ULL, {0});
+    uint64_t now = latency::monotonic_ns();
+    uint64_t x = 88172645463325252ULL;
+    for (auto _ : state) {
+        // xorshift latencies up to ~16ms spread the updates across buckets
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        now += 1000;
+        recorder.record(0, static_cast<int>(x & 1), now, x >> 40);
+    }
+    benchmark::DoNotOptimize(recorder.phase_histogram(0, 0).count);
+}
+BENCHMARK(BM_HistogramRecord);
+
+void BM_ClockRead(benchmark::State& state) {
+    for (auto _ : state) benchmark::DoNotOptimize(latency::monotonic_ns());
+}
+BENCHMARK(BM_ClockRead);
+
+// ---------------------------------------------------------------------------
+// Telemetry
+// ---------------------------------------------------------------------------
+
+void BM_StatFileSample(benchmark::State& state, std::string path, std::vector<const char*> keys) {
+    telemetry::StatFile file(path, keys);
+    std::string error;
+    if (!file.open_file(error)) {
+        state.SkipWithError(error.c_str());
+        return;
+    }
+    uint64_t values[telemetry::kMaxColumns];
+    for (auto _ : state) {
+        if (!file.sample(values)) {
+            state.SkipWithError(("Cannot read " + path).c_str());
+            return;
+        }
+        benchmark::DoNotOptimize(values[0]);
+    }
+}
+
+// The cgroup this process runs in, for its memory.stat
+std::string own_cgroup_dir() {
+    std::ifstream in("/proc/self/cgroup");
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.compare(0, 3, "0::") == 0) return "/sys/fs/cgroup" + line.substr(3);
+    }
+    return "";
+}
+
+void register_stat_files() {
+    benchmark::RegisterBenchmark("BM_StatFileSample/vmstat", BM_StatFileSample, std::string("/proc/vmstat"),
+                                 telemetry::vmstat_columns());
+    benchmark::RegisterBenchmark("BM_StatFileSample/memory.stat", BM_StatFileSample,
+                                 own_cgroup_dir() + "/memory.stat", telemetry::memory_stat_columns());
+    benchmark::RegisterBenchmark("BM_StatFileSample/pressure", BM_StatFileSample,
+                                 std::string("/proc/pressure/memory"), std::vector<const char*>{"some", "full"});
+}
+
+// ---------------------------------------------------------------------------
+// I/O submission
+// ---------------------------------------------------------------------------
+
+// A cached test file, created once per process
+int bench_file_fd() {
+    static int fd = -1;
+    if (fd >= 0) return fd;
+    fd = open(kBenchFile, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) return -1;
+    std::vector<char> chunk(1 << 20, 'x');
+    for (uint64_t off = 0; off < kFileBytes; off += chunk.size()) {
+        if (pwrite(fd, chunk.data(), chunk.size(), static_cast<off_t>(off)) < 0) break;
+    }
+    for (uint64_t off = 0; off < kFileBytes; off += chunk.size()) {
+        if (pread(fd, chunk.data(), chunk.size(), static_cast<off_t>(off)) < 0) break;
+    }
+    return fd;
+}
+
+void BM_BackendRead(benchmark::State& state, std::string ioengine) {
+    int fd = bench_file_fd();
+    if (fd < 0) {
+        state.SkipWithError("Cannot create the test file");
+        return;
+    }
+    auto backend = native::make_backend(ioengine);
+    int depth = backend->max_depth(static_cast<int>(state.range(0)));
+    std::string error;
+    if (!backend->init(depth, error)) {
+        state.SkipWithError(error.c_str());
+        return;
+    }
+    void* buffers = nullptr;
+    if (posix_memalign(&buffers, kBlockBytes, static_cast<size_t>(depth) * kBlockBytes) != 0) {
+        state.SkipWithError("Cannot allocate buffers");
+        return;
+    }
+    std::string warning;
+    backend->register_resources(buffers, static_cast<size_t>(depth) * kBlockBytes, {fd}, warning);
+    std::vector<native::Completion> done(depth);
+    const uint64_t blocks = kFileBytes / kBlockBytes;
+    uint64_t next = 0;
+    for (auto _ : state) {
+        for (int i = 0; i < depth; i++) {
+            next = (next * 2862933555777941757ULL + 3037000493ULL);
+            backend->prep(static_cast<uint32_t>(i), fd, static_cast<char*>(buffers) + i * kBlockBytes, kBlockBytes,
+                          (next % blocks) * kBlockBytes, false);
+        }
+        if (backend->submit() != depth) {
+            state.SkipWithError("submit accepted fewer requests than prepped");
+            break;
+        }
+        int reaped = 0;
+        while (reaped < depth) {
+            int n = backend->reap(depth - reaped, 1000000000LL, done.data(), depth - reaped);
+            if (n <= 0) break;
+            reaped += n;
+        }
+        if (reaped != depth) {
+            state.SkipWithError("requests did not complete");
+            break;
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * depth);
+    free(buffers);
+}
+BENCHMARK_CAPTURE(BM_BackendRead, psync, std::string("psync"))->Arg(1);
+BENCHMARK_CAPTURE(BM_BackendRead, libaio, std::string("libaio"))->Arg(1)->Arg(32);
+BENCHMARK_CAPTURE(BM_BackendRead, io_uring, std::string("io_uring"))->Arg(1)->Arg(32);
+
+// ---------------------------------------------------------------------------
+// Pacing
+// ---------------------------------------------------------------------------
+
+// Manual time: each iteration reports how late the wakeup for a deadline `gap` ahead was
+void BM_PacerLateness(benchmark::State& state, bool spin) {
+    const uint64_t gap = static_cast<uint64_t>(state.range(0)) * 1000;
+    std::vector<uint64_t> late;
+    for (auto _ : state) {
+        uint64_t deadline = latency::monotonic_ns() + gap;
+        if (spin) arrival::wait_until(deadline);
+        else native::sleep_until_ns(deadline);
+        uint64_t now = latency::monotonic_ns();
+        uint64_t l = now > deadline ? now - deadline : 0;
+        late.push_back(l);
+        state.SetIterationTime(static_cast<double>(l) / 1e9);
+    }
+    if (late.empty()) return;
+    std::sort(late.begin(), late.end());
+    state.counters["p99_late_ns"] = static_cast<double>(late[late.size() * 99 / 100]);
+    state.counters["max_late_ns"] = static_cast<double>(late.back());
+}
+// Fixed iteration counts: manual time adds up only the lateness, so the default run-until-0.5s would never end
+BENCHMARK_CAPTURE(BM_PacerLateness, wait_until, true)->Arg(20)->Arg(100)->Iterations(5000)->UseManualTime();
+BENCHMARK_CAPTURE(BM_PacerLateness, wait_until, true)->Arg(1000)->Iterations(1000)->UseManualTime();
+BENCHMARK_CAPTURE(BM_PacerLateness, nanosleep, false)->Arg(100)->Iterations(5000)->UseManualTime();
+BENCHMARK_CAPTURE(BM_PacerLateness, nanosleep, false)->Arg(1000)->Iterations(1000)->UseManualTime();
+
+// ---------------------------------------------------------------------------
+// cgroupfs
+// ---------------------------------------------------------------------------
+
+void BM_CgroupWrite(benchmark::State& state, bool kept_fd) {
+    cgroup::CgroupManager manager;
+    manager.init();
+    std::string error;
+    if (!manager.is_unified() || !manager.create(kBenchCgroup, error) || !manager.has_file(kBenchCgroup, "memory.high")) {
+        state.SkipWithError(error.empty() ? "no cgroup v2 memory controller" : error.c_str());
+        manager.remove(kBenchCgroup);
+        return;
+    }
+    int fd = open((manager.path(kBenchCgroup) + "/memory.high").c_str(), O_RDWR | O_CLOEXEC);
+    const std::string values[2] = {"max", "1073741824"};
+    size_t i = 0;
+    for (auto _ : state) {
+        const std::string& v = values[i++ & 1];
+        bool ok = kept_fd ? pwrite(fd, v.data(), v.size(), 0) == static_cast<ssize_t>(v.size())
+                          : manager.write_file(kBenchCgroup, "memory.high", v, error);
+        if (!ok) {
+            state.SkipWithError("Cannot write memory.high");
+            break;
+        }
+    }
+    if (fd >= 0) close(fd);
+    manager.remove(kBenchCgroup);
+}
+BENCHMARK_CAPTURE(BM_CgroupWrite, open_write, false);
+BENCHMARK_CAPTURE(BM_CgroupWrite, kept_fd, true);
+
+// ---------------------------------------------------------------------------
+// Tracking
+// ---------------------------------------------------------------------------
+
+// Console output as usual, plus the median (or only) real time of each benchmark in ns
+class TrackingReporter : public benchmark::ConsoleReporter {
+public:
+    std::map<std::string, double> times;
+
+    void ReportRuns(const std::vector<Run>& runs) override {
+        for (const auto& run : runs) {
+            if (run.error_occurred) continue;
+            bool median = run.run_type == Run::RT_Aggregate && run.aggregate_name == "median";
+            if (run.run_type == Run::RT_Aggregate && !median) continue;
+            std::string name = run.run_name.str();
+            if (!median && times.count(name)) continue;  // Repetitions: the median replaces them
+            times[name] = run.GetAdjustedRealTime() * 1e9 / benchmark::GetTimeUnitMultiplier(run.time_unit);
+        }
+        ConsoleReporter::ReportRuns(runs);
+    }
+};
+
+bool write_tracking(const std::string& path, const std::map<std::string, double>& times) {
+    FILE* out = fopen(path.c_str(), "w");
+    if (!out) return false;
+    for (const auto& [name, ns] : times) fprintf(out, "%s\t%.1f\n", name.c_str(), ns);
+    return fclose(out) == 0;
+}
+
+std::map<std::string, double> read_tracking(const std::string& path) {
+    std::map<std::string, double> times;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t tab = line.find('\t');
+        if (tab != std::string::npos) times[line.substr(0, tab)] = std::atof(line.c_str() + tab + 1);
+    }
+    return times;
+}
+
+// Benchmarks timing work done once per I/O, held to max_ns in count_regressions()
+bool is_per_io(const std::string& name) {
+    for (const char* prefix : {"BM_HistogramRecord", "BM_ClockRead", "BM_BackendRead"}) {
+        if (name.compare(0, strlen(prefix), prefix) == 0) return true;
+    }
+    return false;
+}
+
+// Slower than the baseline by more than tolerance_pct and min_ns, or by more than
+// max_ns for a per-I/O benchmark; prints the comparison
+int count_regressions(const std::map<std::string, double>& baseline, const std::map<std::string, double>& current,
+                      double tolerance_pct, double min_ns, double max_ns) {
+    int regressions = 0;
+    printf("\n%-64s %12s %12s %9s\n", "Benchmark vs baseline", "baseline_ns", "current_ns", "change");
+    for (const auto& [name, ns] : current) {
+        auto it = baseline.find(name);
+        if (it == baseline.end()) {
+            printf("%-64s %12s %12.1f %9s\n", name.c_str(), "-", ns, "new");
+            continue;
+        }
+        double delta = ns - it->second;
+        double limit = std::max(it->second * tolerance_pct / 100.0, min_ns);
+        if (is_per_io(name)) limit = std::min(limit, max_ns);
+        bool regressed = delta > limit;
+        printf("%-64s %12.1f %12.1f %+8.1f%%%s\n", name.c_str(), it->second, ns,
+               it->second > 0 ? 100.0 * delta / it->second : 0.0, regressed ? "  REGRESSION" : "");
+        regressions += regressed;
+    }
+    return regressions;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string track, baseline;
+    double tolerance_pct = 25, min_regression_ns = 500, max_regression_ns = 2000;
+    // Own flags first; the rest go to Google Benchmark
+    std::vector<char*> rest = {argv[0]};
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 8, "--track=") == 0) track = arg.substr(8);
+        else if (arg.compare(0, 11, "--baseline=") == 0) baseline = arg.substr(11);
+        else if (arg.compare(0, 16, "--tolerance-pct=") == 0) tolerance_pct = std::atof(arg.c_str() + 16);
+        else if (arg.compare(0, 20, "--min-regression-ns=") == 0) min_regression_ns = std::atof(arg.c_str() + 20);
+        else if (arg.compare(0, 20, "--max-regression-ns=") == 0) max_regression_ns = std::atof(arg.c_str() + 20);
+        else rest.push_back(argv[i]);
+    }
+    int bench_argc = static_cast<int>(rest.size());
+    benchmark::Initialize(&bench_argc, rest.data());
+    if (benchmark::ReportUnrecognizedArguments(bench_argc, rest.data())) return 1;
+    register_stat_files();
+
+    TrackingReporter reporter;
+    benchmark::RunSpecifiedBenchmarks(&reporter);
+    benchmark::Shutdown();
+    unlink(kBenchFile);
+
+    if (!track.empty() && !write_tracking(track, reporter.times)) {
+        fprintf(stderr, "ERROR: Cannot write %s\n", track.c_str());
+        return 1;
+    }
+    if (baseline.empty()) return 0;
+    std::map<std::string, double> base = read_tracking(baseline);
+    if (base.empty()) {
+        fprintf(stderr, "ERROR: No results in baseline %s\n", baseline.c_str());
+        return 1;
+    }
+    int regressions = count_regressions(base, reporter.times, tolerance_pct, min_regression_ns, max_regression_ns);
+    if (regressions > 0) {
+        printf("%d benchmark(s) regressed beyond %.0f%% and %.0fns (per-I/O: or %.0fns)\n", regressions,
+               tolerance_pct, min_regression_ns, max_regression_ns);
+        return 1;
+    }
+    return 0;
+}
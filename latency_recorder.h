@@ -0,0 +1,423 @@
+// latency_recorder.h
+// Per-request latency capture for the native engine.
+//
+// Every completion is recorded into a log-linear histogram (HDR style: 256
+// linear sub-buckets per power of two, < 0.4% relative error) owned by the
+// worker that observed it. Each worker keeps one histogram per direction for
+// each of kSlots consecutive windows; the worker is the only writer of its
+// current slot and a collector thread drains a slot only after its window
+// has closed, so recording is wait-free and never allocates.
+//
+// A worker preempted past the grace period may still be inside record()
+// when its window is drained. The collector closes the window first: it
+// advances `open_from`, issues a process-wide barrier (membarrier, so the
+// worker side needs only a compiler fence) and lets any record() already
+// in flight finish before reading. A worker whose window is already closed
+// does not touch the slot; it counts the sample in late_samples() instead,
+// so no window ever holds a request from another window.
+//
+// At each window boundary the collector merges all workers' slots and
+// appends one record per direction to a binary file: summary percentiles
+// plus the sparse bucket counts, so any threshold (e.g. an SLO) can be
+// evaluated later without re-running.
+//
+// File layout (little endian, fixed width):
+//   LatencyFileHeader
+//   repeated { WindowRecord, BucketCount[record.nbuckets] }
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace latency {
+
+// Same clock as the telemetry stream so the two can be joined exactly
+inline uint64_t monotonic_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+constexpr int kSubBucketBits = 8;
+constexpr int kSubBuckets = 1 << kSubBucketBits;
+constexpr int kHalfBuckets = kSubBuckets / 2;
+constexpr int kMaxShift = 40;  // Values up to ~2^48 ns (78 hours)
+constexpr int kNumBuckets = kSubBuckets + kMaxShift * kHalfBuckets;
+
+inline int bucket_index(uint64_t value) {
+    if (value < static_cast<uint64_t>(kSubBuckets)) return static_cast<int>(value);
+    int exponent = 63 - __builtin_clzll(value);
+    int shift = exponent - (kSubBucketBits - 1);
+    if (shift > kMaxShift) return kNumBuckets - 1;
+    return kSubBuckets + (shift - 1) * kHalfBuckets + static_cast<int>((value >> shift) - kHalfBuckets);
+}
+
+// Highest value that maps to a bucket (reported percentiles never under-state)
+inline uint64_t bucket_upper(int index) {
+    if (index < kSubBuckets) return static_cast<uint64_t>(index);
+    int shift = (index - kSubBuckets) / kHalfBuckets + 1;
+    uint64_t sub = static_cast<uint64_t>((index - kSubBuckets) % kHalfBuckets + kHalfBuckets);
+    return ((sub + 1) << shift) - 1;
+}
+
+// Plain histogram used for merged windows and per-phase totals
+struct Histogram {
+    std::vector<uint64_t> counts;
+    uint64_t count = 0;
+    uint64_t min = UINT64_MAX;
+    uint64_t max = 0;
+    double sum = 0;
+
+    Histogram() : counts(kNumBuckets, 0) {}
+
+    void clear() {
+        std::fill(counts.begin(), counts.end(), 0);
+        count = 0;
+        min = UINT64_MAX;
+        max = 0;
+        sum = 0;
+    }
+
+    void merge(const Histogram& o) {
+        for (int i = 0; i < kNumBuckets; i++) counts[i] += o.counts[i];
+        count += o.count;
+        min = std::min(min, o.min);
+        max = std::max(max, o.max);
+        sum += o.sum;
+    }
+
+    // q in [0, 100]; clamps to the exact observed max
+    uint64_t percentile(double q) const {
+        if (count == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(q / 100.0 * count + 0.5);
+        if (rank == 0) rank = 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < kNumBuckets; i++) {
+            seen += counts[i];
+            if (seen >= rank) return std::min(bucket_upper(i), max);
+        }
+        return max;
+    }
+};
+
+#pragma pack(push, 1)
+struct LatencyFileHeader {
+    char magic[8];            // "FBLAT001"
+    uint32_t version;
+    uint32_t sub_bucket_bits;
+    uint64_t epoch_ns;        // CLOCK_MONOTONIC time of window 0
+    uint64_t window_ns;
+    char client[64];
+};
+
+struct WindowRecord {
+    uint64_t window_start_ns; // CLOCK_MONOTONIC
+    uint32_t window_index;
+    uint16_t phase;
+    uint8_t dir;              // 0 = read, 1 = write
+    uint8_t reserved;
+    uint64_t count;
+    uint64_t min_ns;
+    uint64_t max_ns;
+    uint64_t mean_ns;
+    uint64_t p50_ns;
+    uint64_t p90_ns;
+    uint64_t p99_ns;
+    uint64_t p999_ns;
+    uint64_t p9999_ns;
+    uint32_t nbuckets;        // BucketCount entries that follow
+};
+
+struct BucketCount {
+    uint32_t index;
+    uint32_t count;
+};
+#pragma pack(pop)
+
+class LatencyRecorder {
+public:
+    static constexpr int kSlots = 3;
+    // Collector thread, once per closed window and direction that saw requests
+    using WindowObserver = std::function<void(uint64_t window_index, int phase, int dir, const Histogram&)>;
+
+    // phase_offsets_ns: start of each phase relative to epoch, ascending
+    LatencyRecorder(int workers, uint64_t epoch_ns, uint64_t window_ns,
+                    std::vector<uint64_t> phase_offsets_ns)
+        : epoch(epoch_ns), window(window_ns), phase_offsets(std::move(phase_offsets_ns)),
+          worker_state(workers), phase_totals(phase_offsets.size() * 2),
+          phase_begin(new std::atomic<uint64_t>[phase_offsets.size()]) {
+        for (size_t i = 0; i < phase_offsets.size(); i++) phase_begin[i].store(phase_offsets[i]);
+        for (auto& ws : worker_state) {
+            ws.window_end = epoch + window;
+        }
+        // Without it (kernel < 4.14) each record() pays a full fence instead
+        expedited = syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0;
+    }
+
+    ~LatencyRecorder() { stop(); }
+
+    bool open(const std::string& path, const std::string& client, std::string& error) {
+        out = fopen(path.c_str(), "wb");
+        if (!out) {
+            error = "Cannot open latency file " + path + ": " + strerror(errno);
+            return false;
+        }
+        LatencyFileHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, "FBLAT001", 8);
+        header.version = 1;
+        header.sub_bucket_bits = kSubBucketBits;
+        header.epoch_ns = epoch;
+        header.window_ns = window;
+        strncpy(header.client, client.c_str(), sizeof(header.client) - 1);
+        fwrite(&header, sizeof(header), 1, out);
+        return true;
+    }
+
+    // Call before start()
+    void set_observer(WindowObserver fn) { observer = std::move(fn); }
+
+    void start() {
+        collector = std::thread([this]() { collect_loop(); });
+    }
+
+    // Flush every remaining window; call after all workers have stopped
+    void stop() {
+        if (!collector.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cv.notify_all();
+        collector.join();
+        if (out) {
+            fclose(out);
+            out = nullptr;
+        }
+    }
+
+    // Hot path: called by worker `w` only
+    inline void record(int w, int dir, uint64_t now_ns, uint64_t lat_ns) {
+        WorkerState& ws = worker_state[w];
+        while (now_ns >= ws.window_end) {
+            ws.window_end += window;
+            ws.slot = (ws.slot + 1) % kSlots;
+            ws.window_index++;
+        }
+        ws.busy.store(1, std::memory_order_relaxed);
+        barrier_pair(false);
+        if (ws.window_index < open_from.load(std::memory_order_acquire)) {
+            ws.late.store(ws.late.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            ws.busy.store(0, std::memory_order_release);
+            return;
+        }
+        SlotHistogram& h = ws.at(ws.slot, dir);
+        auto bump = [](std::atomic<uint64_t>& a, uint64_t v) {
+            a.store(a.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+        };
+        bump(h.counts[bucket_index(lat_ns)], 1);
+        bump(h.count, 1);
+        bump(h.sum, lat_ns);
+        if (lat_ns > h.max.load(std::memory_order_relaxed)) h.max.store(lat_ns, std::memory_order_relaxed);
+        if (lat_ns < h.min.load(std::memory_order_relaxed)) h.min.store(lat_ns, std::memory_order_relaxed);
+        ws.busy.store(0, std::memory_order_release);
+    }
+
+    // The schedule moved (adaptive run length): phase `phase` actually began at start_ns
+    void begin_phase(size_t phase, uint64_t start_ns) {
+        if (phase < phase_offsets.size()) phase_begin[phase].store(start_ns - epoch, std::memory_order_relaxed);
+    }
+
+    // Valid after stop(): completions recorded after their window was drained
+    uint64_t late_samples() const {
+        uint64_t n = 0;
+        for (const auto& ws : worker_state) n += ws.late.load(std::memory_order_relaxed);
+        return n;
+    }
+
+    // Valid after stop(): merged histogram of every window in a phase
+    const Histogram& phase_histogram(size_t phase, int dir) const {
+        return phase_totals[phase * 2 + dir];
+    }
+
+private:
+    struct SlotHistogram {
+        std::atomic<uint64_t> counts[kNumBuckets];
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> sum{0};
+        std::atomic<uint64_t> min{UINT64_MAX};
+        std::atomic<uint64_t> max{0};
+
+        SlotHistogram() {
+            for (auto& c : counts) c.store(0, std::memory_order_relaxed);
+        }
+    };
+
+    struct alignas(64) WorkerState {
+        uint64_t window_end = 0;
+        int slot = 0;
+        uint64_t window_index = 0;
+        std::atomic<int> busy{0};       // Inside record(); read by the collector
+        std::atomic<uint64_t> late{0};  // Samples whose window had already been drained
+        std::unique_ptr<SlotHistogram[]> histograms{new SlotHistogram[kSlots * 2]};
+
+        SlotHistogram& at(int s, int dir) { return histograms[s * 2 + dir]; }
+    };
+
+    // Completions stamped just before a boundary may be recorded slightly after it
+    static constexpr uint64_t kGraceNs = 20000000ULL;
+
+    uint64_t epoch;
+    uint64_t window;
+    std::vector<uint64_t> phase_offsets;
+    std::vector<WorkerState> worker_state;
+    std::vector<Histogram> phase_totals;  // [phase * 2 + dir]
+    std::unique_ptr<std::atomic<uint64_t>[]> phase_begin;  // Offsets from epoch, updated by begin_phase()
+
+    std::atomic<uint64_t> open_from{0};  // First window not yet drained
+    bool expedited = false;              // The collector's barrier is membarrier()
+
+    FILE* out = nullptr;
+    WindowObserver observer;
+    std::thread collector;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping = false;
+
+    Histogram merged;
+    std::vector<BucketCount> sparse;
+
+    // Pairs the worker's busy store with the collector's open_from store: the
+    // collector side is membarrier(), which lets the worker side be free
+    void barrier_pair(bool collector) {
+        if (expedited) {
+            if (!collector) {
+                std::atomic_signal_fence(std::memory_order_seq_cst);
+                return;
+            }
+            if (syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0) == 0) return;
+        }
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    // After this no worker writes to the window's slot until it is reused
+    void close_window(uint64_t window_index) {
+        open_from.store(window_index + 1, std::memory_order_relaxed);
+        barrier_pair(true);
+        // Only a record() that started before the store can still be writing; it never blocks
+        for (auto& ws : worker_state) {
+            while (ws.busy.load(std::memory_order_acquire)) std::this_thread::yield();
+        }
+    }
+
+    int phase_of(uint64_t window_index) const {
+        uint64_t offset = window_index * window;
+        int phase = 0;
+        for (size_t i = 0; i < phase_offsets.size(); i++) {
+            if (offset >= phase_begin[i].load(std::memory_order_relaxed)) phase = static_cast<int>(i);
+        }
+        return phase;
+    }
+
+    void collect_loop() {
+        uint64_t next_window = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            uint64_t due = epoch + (next_window + 1) * window + kGraceNs;
+            auto deadline = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(due));
+            bool stop_now = cv.wait_until(lock, deadline, [this]() { return stopping; });
+            if (stop_now) break;
+            lock.unlock();
+            drain(next_window++);
+            lock.lock();
+        }
+        lock.unlock();
+        // Workers are done: flush whatever is left, including the partial window
+        uint64_t last = (monotonic_ns() - epoch) / window;
+        while (next_window <= last) drain(next_window++);
+    }
+
+    void drain(uint64_t window_index) {
+        int slot = static_cast<int>(window_index % kSlots);
+        close_window(window_index);
+        for (int dir = 0; dir < 2; dir++) {
+            merged.clear();
+            for (auto& ws : worker_state) {
+                SlotHistogram& h = ws.at(slot, dir);
+                uint64_t n = h.count.load(std::memory_order_relaxed);
+                if (n == 0) continue;
+                for (int i = 0; i < kNumBuckets; i++) {
+                    uint64_t c = h.counts[i].load(std::memory_order_relaxed);
+                    if (c) {
+                        merged.counts[i] += c;
+                        h.counts[i].store(0, std::memory_order_relaxed);
+                    }
+                }
+                merged.count += n;
+                merged.sum += h.sum.load(std::memory_order_relaxed);
+                merged.min = std::min(merged.min, h.min.load(std::memory_order_relaxed));
+                merged.max = std::max(merged.max, h.max.load(std::memory_order_relaxed));
+                h.count.store(0, std::memory_order_relaxed);
+                h.sum.store(0, std::memory_order_relaxed);
+                h.min.store(UINT64_MAX, std::memory_order_relaxed);
+                h.max.store(0, std::memory_order_relaxed);
+            }
+            if (merged.count == 0) continue;
+
+            int phase = phase_of(window_index);
+            if (!phase_totals.empty()) phase_totals[phase * 2 + dir].merge(merged);
+            write_window(window_index, phase, dir);
+            if (observer) observer(window_index, phase, dir, merged);
+        }
+        if (out) fflush(out);
+    }
+
+    void write_window(uint64_t window_index, int phase, int dir) {
+        if (!out) return;
+        sparse.clear();
+        for (int i = 0; i < kNumBuckets; i++) {
+            if (merged.counts[i]) {
+                sparse.push_back({static_cast<uint32_t>(i),
+                                  static_cast<uint32_t>(std::min<uint64_t>(merged.counts[i], UINT32_MAX))});
+            }
+        }
+
+        WindowRecord rec;
+        memset(&rec, 0, sizeof(rec));
+        rec.window_start_ns = epoch + window_index * window;
+        rec.window_index = static_cast<uint32_t>(window_index);
+        rec.phase = static_cast<uint16_t>(phase);
+        rec.dir = static_cast<uint8_t>(dir);
+        rec.count = merged.count;
+        rec.min_ns = merged.min;
+        rec.max_ns = merged.max;
+        rec.mean_ns = static_cast<uint64_t>(merged.sum / merged.count);
+        rec.p50_ns = merged.percentile(50);
+        rec.p90_ns = merged.percentile(90);
+        rec.p99_ns = merged.percentile(99);
+        rec.p999_ns = merged.percentile(99.9);
+        rec.p9999_ns = merged.percentile(99.99);
+        rec.nbuckets = static_cast<uint32_t>(sparse.size());
+        fwrite(&rec, sizeof(rec), 1, out);
+        fwrite(sparse.data(), sizeof(BucketCount), sparse.size(), out);
+    }
+};
+
+}  // namespace latency
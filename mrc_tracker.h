@@ -0,0 +1,262 @@
+// mrc_tracker.h
+// Online miss-ratio curves from spatially sampled reuse distances (SHARDS).
+//
+// Every page the native engine touches is hashed; only pages whose hash
+// falls below a threshold T are tracked, so the tracker sees a uniform
+// random R = T/2^64 fraction of the address space and each of those pages'
+// every access. For a tracked page the LRU reuse distance (distinct tracked
+// pages touched since its previous access) is divided by R to estimate the
+// distance over all pages, and the histogram of those distances gives the
+// LRU miss ratio for every cache size at once.
+//
+// Memory is constant (SHARDS fixed-size variant): at most max_samples pages
+// are tracked. When a new page would exceed that, the page with the largest
+// hash is dropped, T is lowered to its hash and the histogram is rescaled
+// to the new rate. Distances come from a Fenwick tree over a ring of
+// logical access times that is compacted when it wraps.
+//
+// The hash filter is lock-free; only sampled accesses take the mutex, which
+// once the sample set is full is a max_samples / working-set fraction of
+// them. The final curve applies the SHARDS_adj correction: the difference
+// between the expected (references * R) and observed sampled accesses is
+// credited to the smallest distance.
+//
+// Curves are written as CSV ("cache_bytes,miss_ratio" after '#' comments),
+// one point per histogram bin, which is what the dirty_slo controller reads
+// to size the protected tenant's memory.low.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mrc {
+
+constexpr uint64_t kPageSize = 4096;
+
+struct CurvePoint {
+    uint64_t cache_pages;
+    double miss_ratio;
+};
+
+// Stateless splitmix64 finalizer: a fixed pseudo-random hash per page
+inline uint64_t page_hash(uint64_t page) {
+    uint64_t z = page + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+class ShardsTracker {
+public:
+    explicit ShardsTracker(size_t max_samples)
+        : max_samples(std::max<size_t>(max_samples, 16)), tree(4 * this->max_samples + 1, 0) {
+        entries.reserve(this->max_samples + 1);
+    }
+
+    ShardsTracker(const ShardsTracker&) = delete;
+    ShardsTracker& operator=(const ShardsTracker&) = delete;
+
+    // Called from any worker for every request: [offset, offset + len)
+    void access(uint64_t offset, uint64_t len) {
+        uint64_t first = offset / kPageSize;
+        uint64_t last = (offset + std::max<uint64_t>(len, 1) - 1) / kPageSize;
+        for (uint64_t page = first; page <= last; page++) {
+            uint64_t h = page_hash(page);
+            if (h < threshold.load(std::memory_order_relaxed)) record(page, h);
+        }
+    }
+
+    static uint64_t pages_in(uint64_t offset, uint64_t len) {
+        return (offset + std::max<uint64_t>(len, 1) - 1) / kPageSize - offset / kPageSize + 1;
+    }
+
+    // Total pages accessed (sampled or not); enables the SHARDS_adj correction
+    void set_references(uint64_t pages) {
+        std::lock_guard<std::mutex> lock(mutex);
+        references = pages;
+    }
+
+    double sample_rate() const {
+        return static_cast<double>(threshold.load(std::memory_order_relaxed)) / 18446744073709551616.0;
+    }
+
+    size_t sampled_pages() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.size();
+    }
+
+    // Miss ratio at each bin boundary, ending with the cold-miss floor
+    std::vector<CurvePoint> curve() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<double> bins(histogram, histogram + kBins);
+        double total = cold;
+        for (double b : bins) total += b;
+        if (references > 0) {
+            double expected = references * sample_rate();
+            bins[0] = std::max(0.0, bins[0] + expected - total);
+            total = cold;
+            for (double b : bins) total += b;
+        }
+        std::vector<CurvePoint> points;
+        if (total <= 0) return points;
+
+        size_t last = kBins;
+        while (last > 0 && bins[last - 1] <= 0) last--;
+        // Misses at cache size C: accesses with distance >= C, plus cold misses
+        double misses = total;
+        for (size_t b = 0; b < last; b++) {
+            points.push_back({bin_lower(b), misses / total});
+            misses -= bins[b];
+        }
+        points.push_back({last > 0 ? bin_lower(last) : 1, cold / total});
+        return points;
+    }
+
+private:
+    struct Entry {
+        uint64_t time;          // Logical time of the last access
+    };
+
+    // Distances below 16 pages get a bin each; above, 16 bins per power of two
+    static constexpr int kSubBits = 4;
+    static constexpr size_t kBins = (64 - kSubBits + 1) << kSubBits;
+
+    const size_t max_samples;
+    std::atomic<uint64_t> threshold{UINT64_MAX};
+    mutable std::mutex mutex;
+    std::unordered_map<uint64_t, Entry> entries;
+    std::priority_queue<std::pair<uint64_t, uint64_t>> by_hash;  // (hash, page), largest first
+    std::vector<int32_t> tree;                                    // Fenwick tree, 1-based
+    uint64_t clock = 0;
+    double histogram[kBins] = {};
+    double cold = 0;
+    uint64_t references = 0;
+
+    static size_t bin_index(uint64_t d) {
+        if (d < (1u << kSubBits)) return static_cast<size_t>(d);
+        int msb = 63 - __builtin_clzll(d);
+        size_t sub = static_cast<size_t>((d >> (msb - kSubBits)) & ((1u << kSubBits) - 1));
+        return (static_cast<size_t>(msb - kSubBits + 1) << kSubBits) + sub;
+    }
+
+    static uint64_t bin_lower(size_t b) {
+        if (b < (1u << kSubBits)) return b;
+        int msb = static_cast<int>(b >> kSubBits) + kSubBits - 1;
+        uint64_t sub = b & ((1u << kSubBits) - 1);
+        if (msb >= 63) return UINT64_MAX;
+        return (1ULL << msb) | (sub << (msb - kSubBits));
+    }
+
+    void tree_add(uint64_t t, int32_t delta) {
+        for (size_t i = t + 1; i < tree.size(); i += i & (~i + 1)) tree[i] += delta;
+    }
+
+    // Set times in [0, t)
+    int64_t tree_prefix(uint64_t t) const {
+        int64_t sum = 0;
+        for (size_t i = t; i > 0; i -= i & (~i + 1)) sum += tree[i];
+        return sum;
+    }
+
+    void record(uint64_t page, uint64_t h) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (h >= threshold.load(std::memory_order_relaxed)) return;  // Lowered since the check
+        auto it = entries.find(page);
+        if (it != entries.end()) {
+            uint64_t t = it->second.time;
+            uint64_t distinct = static_cast<uint64_t>(tree_prefix(clock) - tree_prefix(t + 1));
+            double scaled = std::min(distinct / sample_rate(), 1e18);
+            histogram[bin_index(static_cast<uint64_t>(scaled))] += 1;
+            tree_add(t, -1);
+            it->second.time = clock;
+        } else {
+            cold += 1;
+            entries.emplace(page, Entry{clock});
+            by_hash.emplace(h, page);
+        }
+        tree_add(clock, 1);
+        clock++;
+        if (entries.size() > max_samples) evict();
+        if (clock + 1 >= tree.size()) compact();
+    }
+
+    // Drop the largest-hash page and lower the rate to exclude it
+    void evict() {
+        auto [h, page] = by_hash.top();
+        by_hash.pop();
+        auto it = entries.find(page);
+        tree_add(it->second.time, -1);
+        entries.erase(it);
+        double scale = static_cast<double>(h) / static_cast<double>(threshold.load(std::memory_order_relaxed));
+        threshold.store(h, std::memory_order_relaxed);
+        for (double& b : histogram) b *= scale;
+        cold *= scale;
+    }
+
+    // Renumber live entries 0..n-1 in access order when the time ring is used up
+    void compact() {
+        std::vector<std::pair<uint64_t, Entry*>> order;
+        order.reserve(entries.size());
+        for (auto& [page, entry] : entries) order.emplace_back(entry.time, &entry);
+        std::sort(order.begin(), order.end(),
+                  [](const auto& a, const auto& b) { return a.first < b.first; });
+        std::fill(tree.begin(), tree.end(), 0);
+        clock = 0;
+        for (auto& [time, entry] : order) {
+            entry->time = clock;
+            tree_add(clock, 1);
+            clock++;
+        }
+    }
+};
+
+// Smallest cache holding `share` (0-1) of the hits an unbounded cache would get
+inline uint64_t cache_for_share(const std::vector<CurvePoint>& points, double share) {
+    if (points.empty()) return 0;
+    double reachable = 1.0 - points.back().miss_ratio;
+    for (const auto& p : points) {
+        if (1.0 - p.miss_ratio >= share * reachable) return p.cache_pages;
+    }
+    return points.back().cache_pages;
+}
+
+// Written to path.tmp and renamed, so readers never see a partial curve
+inline bool write_csv(const std::string& path, const std::vector<CurvePoint>& points,
+                      double sample_rate, size_t sampled_pages, uint64_t references) {
+    std::string tmp = path + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "w");
+    if (!f) return false;
+    fprintf(f, "# shards sample_rate=%.6g sampled_pages=%zu references=%llu\ncache_bytes,miss_ratio\n",
+            sample_rate, sampled_pages, static_cast<unsigned long long>(references));
+    for (const auto& p : points) {
+        fprintf(f, "%llu,%.6f\n", static_cast<unsigned long long>(p.cache_pages * kPageSize), p.miss_ratio);
+    }
+    bool ok = fclose(f) == 0;
+    return ok && rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+inline bool read_csv(const std::string& path, std::vector<CurvePoint>& points) {
+    FILE* f = fopen(path.c_str(), "r");
+    if (!f) return false;
+    points.clear();
+    char line[128];
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long long bytes;
+        double miss;
+        if (sscanf(line, "%llu,%lf", &bytes, &miss) == 2) points.push_back({bytes / kPageSize, miss});
+    }
+    fclose(f);
+    return !points.empty();
+}
+
+}  // namespace mrc
@@ -0,0 +1,1479 @@
+// native_engine.h
+// Built-in load generator used in place of per-phase fio invocations.
+//
+// One NativeEngine instance runs every phase of a workload inside the calling
+// process. Worker threads are created once (max numjobs over all phases) and
+// follow a fixed schedule of phase deadlines measured from a common start
+// time, so a phase switch is just a change of parameters between two
+// submissions - no process startup, no file layout, no idle gap.
+//
+// Results are written per phase in a subset of fio's JSON schema so the
+// existing analysis tooling keeps working unchanged.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/aio_abi.h>
+#include <linux/io_uring.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "arrival_schedule.h"
+#include "buffer_arena.h"
+#include "latency_recorder.h"
+#include "mrc_tracker.h"
+#include "offset_distribution.h"
+#include "topology.h"
+#include "trace_replay.h"
+
+namespace native {
+
+using latency::monotonic_ns;
+
+inline void sleep_until_ns(uint64_t deadline_ns) {
+    timespec ts;
+    ts.tv_sec = deadline_ns / 1000000000ULL;
+    ts.tv_nsec = deadline_ns % 1000000000ULL;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+}
+
+// Trace replays the requests of a captured trace (EnginePhase::trace_file) open loop
+enum class IoPattern { Read, Write, RandRead, RandWrite, ReadWrite, RandRW, Trace };
+
+// Map fio's --rw names onto the engine's patterns
+inline bool parse_pattern(const std::string& name, IoPattern& out) {
+    if (name == "read") out = IoPattern::Read;
+    else if (name == "write") out = IoPattern::Write;
+    else if (name == "randread") out = IoPattern::RandRead;
+    else if (name == "randwrite") out = IoPattern::RandWrite;
+    else if (name == "rw" || name == "readwrite") out = IoPattern::ReadWrite;
+    else if (name == "randrw") out = IoPattern::RandRW;
+    else return false;
+    return true;
+}
+
+inline bool pattern_is_random(IoPattern p) {
+    return p == IoPattern::RandRead || p == IoPattern::RandWrite || p == IoPattern::RandRW;
+}
+
+inline bool pattern_writes(IoPattern p) {
+    return p != IoPattern::Read && p != IoPattern::RandRead;
+}
+
+// How a writer phase flushes its dirty pages
+enum class SyncMode { None, Fsync, Fdatasync, SyncFileRange };
+
+inline bool parse_sync_mode(const std::string& name, SyncMode& out) {
+    if (name.empty() || name == "none") out = SyncMode::None;
+    else if (name == "fsync") out = SyncMode::Fsync;
+    else if (name == "fdatasync") out = SyncMode::Fdatasync;
+    else if (name == "sync_file_range") out = SyncMode::SyncFileRange;
+    else return false;
+    return true;
+}
+
+// sync_file_range only starts writeback of the dirty range; it returns without waiting
+inline int sync_file(int fd, SyncMode mode) {
+    switch (mode) {
+        case SyncMode::Fsync: return fsync(fd);
+        case SyncMode::Fdatasync: return fdatasync(fd);
+        case SyncMode::SyncFileRange: return sync_file_range(fd, 0, 0, SYNC_FILE_RANGE_WRITE);
+        default: return 0;
+    }
+}
+
+// Fully resolved phase: all workload-level fallbacks already applied
+struct EnginePhase {
+    std::string name;         // Output prefix, e.g. client1_cached_phase1
+    std::string output_file;  // fio-style JSON result for this phase
+    std::string file;         // Test file path
+    uint64_t file_size;       // Bytes of the file to address
+    uint64_t block_size;      // Bytes per request
+    int runtime;              // Seconds
+    int iodepth;
+    int numjobs;
+    int rate_iops;            // Per job, 0 = unlimited (same meaning as fio)
+    arrival::Spec arrival;    // How rate_iops/dirty_rate pace requests: closed loop or an open-loop process
+    IoPattern pattern;
+    std::string ioengine;     // psync, sync, pvsync, libaio, io_uring, io_uring_sqpoll
+    std::string distribution; // Random patterns: block distribution spec (see offset_distribution.h)
+    std::string trace_file;   // IoPattern::Trace: binary trace (see trace_replay.h)
+    double trace_speed = 1.0; // IoPattern::Trace: 2 = replay twice as fast as recorded
+    // Writer profile: how fast pages are dirtied and how they get flushed
+    uint64_t dirty_rate = 0;              // Bytes/s written across all jobs (paces the phase), 0 = unthrottled
+    SyncMode sync = SyncMode::None;       // Flush every sync_interval_ns, and after each checkpoint
+    uint64_t sync_interval_ns = 0;
+    uint64_t checkpoint_interval_ns = 0;  // Every interval job 0 writes checkpoint_bytes unthrottled,
+    uint64_t checkpoint_bytes = 0;        // drains them and syncs (fsync unless sync says otherwise)
+};
+
+// Where one worker thread runs (see topology.h)
+struct WorkerPlacement {
+    int cpu;
+    int node;                 // Bind the worker's buffers here, -1 = leave to first touch
+};
+
+struct EngineOptions {
+    bool direct = false;      // Open files with O_DIRECT
+    std::string latency_file; // Per-window latency histograms (empty = don't write)
+    std::string client;       // Label stored in the latency file header
+    size_t mrc_samples = 0;   // SHARDS sample set per phase (see mrc_tracker.h), 0 = no MRC
+    std::string mrc_file;     // Live MRC of the running phase, rewritten every second (empty = don't)
+    std::vector<WorkerPlacement> placement;  // Worker w runs on placement[w % size] (empty = unpinned)
+    arena::HugePages hugepages = arena::HugePages::Auto;  // Backing of each worker's buffer arena
+    // Called once setup is done: blocks until a start shared with other processes and returns
+    // its CLOCK_MONOTONIC time, which becomes phase 1's start (0 = cancelled). Empty = start now.
+    std::function<uint64_t()> wait_start;
+    // Every closed latency window, per direction (see LatencyRecorder::set_observer)
+    latency::LatencyRecorder::WindowObserver window_observer;
+    // The run ends early once this reads nonzero; may live in memory shared with another process
+    const std::atomic<uint32_t>* stop_flag = nullptr;
+    // Phase boundaries not reached yet move this much earlier (adaptive run length, see run_length.h)
+    const std::atomic<uint64_t>* schedule_shift = nullptr;
+};
+
+// Per-phase miss ratio curve written next to the phase's JSON result
+struct PhaseMrc {
+    std::string phase;
+    std::string file;          // <phase>_mrc.csv
+    double sample_rate;
+    uint64_t bytes_for_90;     // Cache holding 90% of the hits an unbounded cache would get
+    uint64_t bytes_for_99;
+};
+
+// ---------------------------------------------------------------------------
+// Submission backends
+// ---------------------------------------------------------------------------
+
+struct Completion {
+    uint32_t slot;
+    int64_t result;
+};
+
+class IoBackend {
+public:
+    virtual ~IoBackend() = default;
+    virtual bool init(int max_depth, std::string& error) = 0;
+    // Queue a request for the next submit(); slot identifies it on completion
+    virtual void prep(uint32_t slot, int fd, void* buf, uint32_t len, uint64_t offset, bool is_write) = 0;
+    // Push all prepped requests to the kernel; returns number accepted
+    virtual int submit() = 0;
+    // Wait for at least min_nr completions or until timeout_ns elapses
+    virtual int reap(int min_nr, int64_t timeout_ns, Completion* out, int max_nr) = 0;
+    // Effective queue depth this backend can sustain
+    virtual int max_depth(int requested) const { return requested; }
+    // Optional pre-registration of the worker's buffer region and files.
+    // Backends that cannot use them fall back silently; warning says why.
+    virtual void register_resources(void* /*buffers*/, size_t /*length*/,
+                                    const std::vector<int>& /*fds*/, std::string& /*warning*/) {}
+};
+
+// Synchronous pread/pwrite: the request completes inside submit()
+class PsyncBackend : public IoBackend {
+    struct Pending { uint32_t slot; int fd; void* buf; uint32_t len; uint64_t offset; bool is_write; };
+    std::vector<Pending> pending;
+    std::vector<Completion> done;
+
+public:
+    bool init(int max_depth, std::string&) override {
+        pending.reserve(max_depth);
+        done.reserve(max_depth);
+        return true;
+    }
+
+    int max_depth(int) const override { return 1; }
+
+    void prep(uint32_t slot, int fd, void* buf, uint32_t len, uint64_t offset, bool is_write) override {
+        pending.push_back({slot, fd, buf, len, offset, is_write});
+    }
+
+    int submit() override {
+        int n = static_cast<int>(pending.size());
+        for (const auto& p : pending) {
+            ssize_t r = p.is_write ? pwrite(p.fd, p.buf, p.len, p.offset)
+                                   : pread(p.fd, p.buf, p.len, p.offset);
+            done.push_back({p.slot, r < 0 ? -static_cast<int64_t>(errno) : r});
+        }
+        pending.clear();
+        return n;
+    }
+
+    int reap(int, int64_t, Completion* out, int max_nr) override {
+        int n = 0;
+        while (n < max_nr && !done.empty()) {
+            out[n++] = done.back();
+            done.pop_back();
+        }
+        return n;
+    }
+};
+
+// Linux native AIO through raw syscalls (no libaio dependency)
+class LibaioBackend : public IoBackend {
+    aio_context_t ctx = 0;
+    std::vector<iocb> cbs;
+    std::vector<iocb*> queue;
+    std::vector<io_event> events;
+
+public:
+    ~LibaioBackend() override {
+        if (ctx) syscall(SYS_io_destroy, ctx);
+    }
+
+    bool init(int max_depth, std::string& error) override {
+        if (syscall(SYS_io_setup, max_depth, &ctx) < 0) {
+            error = std::string("io_setup failed: ") + strerror(errno);
+            return false;
+        }
+        cbs.resize(max_depth);
+        queue.reserve(max_depth);
+        events.resize(max_depth);
+        return true;
+    }
+
+    void prep(uint32_t slot, int fd, void* buf, uint32_t len, uint64_t offset, bool is_write) override {
+        iocb& cb = cbs[slot];
+        memset(&cb, 0, sizeof(cb));
+        cb.aio_data = slot;
+        cb.aio_lio_opcode = is_write ? IOCB_CMD_PWRITE : IOCB_CMD_PREAD;
+        cb.aio_fildes = fd;
+        cb.aio_buf = reinterpret_cast<uint64_t>(buf);
+        cb.aio_nbytes = len;
+        cb.aio_offset = offset;
+        queue.push_back(&cb);
+    }
+
+    int submit() override {
+        int total = 0;
+        while (total < static_cast<int>(queue.size())) {
+            long r = syscall(SYS_io_submit, ctx, queue.size() - total, queue.data() + total);
+            if (r <= 0) break;
+            total += r;
+        }
+        queue.clear();
+        return total;
+    }
+
+    int reap(int min_nr, int64_t timeout_ns, Completion* out, int max_nr) override {
+        timespec ts;
+        ts.tv_sec = timeout_ns / 1000000000LL;
+        ts.tv_nsec = timeout_ns % 1000000000LL;
+        long r = syscall(SYS_io_getevents, ctx, min_nr, max_nr, events.data(),
+                         timeout_ns < 0 ? nullptr : &ts);
+        if (r <= 0) return 0;
+        for (long i = 0; i < r; i++) {
+            out[i].slot = static_cast<uint32_t>(events[i].data);
+            out[i].result = events[i].res;
+        }
+        return static_cast<int>(r);
+    }
+};
+
+// io_uring through raw syscalls (no liburing dependency). The worker's whole
+// buffer region is registered as one fixed buffer and every test file as a
+// fixed file, so the hot path does no page pinning or fd lookups. With
+// sqpoll a kernel thread consumes the SQ ring and submission is syscall-free.
+class IoUringBackend : public IoBackend {
+    int ring_fd = -1;
+    bool sqpoll;
+    unsigned features = 0;
+
+    // SQ ring
+    void* sq_ptr = nullptr;
+    size_t sq_len = 0;
+    unsigned* sq_head = nullptr;
+    unsigned* sq_tail = nullptr;
+    unsigned* sq_mask = nullptr;
+    unsigned* sq_flags = nullptr;
+    unsigned* sq_array = nullptr;
+    io_uring_sqe* sqes = nullptr;
+    size_t sqes_len = 0;
+
+    // CQ ring
+    void* cq_ptr = nullptr;
+    size_t cq_len = 0;
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned* cq_mask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    unsigned local_tail = 0;   // SQEs written but not yet published
+    unsigned to_submit = 0;
+
+    bool fixed_buffers = false;
+    char* buffer_base = nullptr;
+    size_t buffer_len = 0;
+    std::vector<int> fixed_fds;  // Index in this vector = fixed file slot
+
+    static int sys_setup(unsigned entries, io_uring_params* p) {
+        return static_cast<int>(syscall(__NR_io_uring_setup, entries, p));
+    }
+    static int sys_enter(int fd, unsigned submit, unsigned min_complete, unsigned flags,
+                         const void* arg, size_t argsz) {
+        return static_cast<int>(syscall(__NR_io_uring_enter, fd, submit, min_complete, flags, arg, argsz));
+    }
+    static int sys_register(int fd, unsigned opcode, const void* arg, unsigned nr) {
+        return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nr));
+    }
+
+public:
+    explicit IoUringBackend(bool sqpoll) : sqpoll(sqpoll) {}
+
+    ~IoUringBackend() override {
+        if (sqes) munmap(sqes, sqes_len);
+        if (cq_ptr && cq_ptr != sq_ptr) munmap(cq_ptr, cq_len);
+        if (sq_ptr) munmap(sq_ptr, sq_len);
+        if (ring_fd >= 0) close(ring_fd);
+    }
+
+    bool init(int max_depth, std::string& error) override {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        if (sqpoll) {
+            params.flags |= IORING_SETUP_SQPOLL;
+            params.sq_thread_idle = 2000;  // ms before the poller sleeps
+        }
+        ring_fd = sys_setup(static_cast<unsigned>(max_depth), &params);
+        if (ring_fd < 0) {
+            error = std::string("io_uring_setup failed: ") + strerror(errno);
+            return false;
+        }
+        features = params.features;
+
+        sq_len = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_len = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (features & IORING_FEAT_SINGLE_MMAP) {
+            sq_len = cq_len = std::max(sq_len, cq_len);
+        }
+        sq_ptr = mmap(nullptr, sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring_fd, IORING_OFF_SQ_RING);
+        if (sq_ptr == MAP_FAILED) {
+            sq_ptr = nullptr;
+            error = std::string("io_uring SQ ring mmap failed: ") + strerror(errno);
+            return false;
+        }
+        if (features & IORING_FEAT_SINGLE_MMAP) {
+            cq_ptr = sq_ptr;
+        } else {
+            cq_ptr = mmap(nullptr, cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          ring_fd, IORING_OFF_CQ_RING);
+            if (cq_ptr == MAP_FAILED) {
+                cq_ptr = nullptr;
+                error = std::string("io_uring CQ ring mmap failed: ") + strerror(errno);
+                return false;
+            }
+        }
+        sqes_len = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqe_mem = mmap(nullptr, sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                             ring_fd, IORING_OFF_SQES);
+        if (sqe_mem == MAP_FAILED) {
+            error = std::string("io_uring SQE mmap failed: ") + strerror(errno);
+            return false;
+        }
+        sqes = static_cast<io_uring_sqe*>(sqe_mem);
+
+        char* sq = static_cast<char*>(sq_ptr);
+        sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_flags = reinterpret_cast<unsigned*>(sq + params.sq_off.flags);
+        sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        char* cq = static_cast<char*>(cq_ptr);
+        cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        // Identity mapping of SQ array slots onto SQEs, set once
+        for (unsigned i = 0; i < params.sq_entries; i++) sq_array[i] = i;
+        local_tail = *sq_tail;
+        return true;
+    }
+
+    void register_resources(void* buffers, size_t length, const std::vector<int>& fds,
+                            std::string& warning) override {
+        iovec iov;
+        iov.iov_base = buffers;
+        iov.iov_len = length;
+        if (sys_register(ring_fd, IORING_REGISTER_BUFFERS, &iov, 1) == 0) {
+            fixed_buffers = true;
+            buffer_base = static_cast<char*>(buffers);
+            buffer_len = length;
+        } else {
+            warning += std::string("io_uring buffer registration failed (") + strerror(errno) +
+                       "), using unregistered buffers. ";
+        }
+        if (!fds.empty() &&
+            sys_register(ring_fd, IORING_REGISTER_FILES, fds.data(), static_cast<unsigned>(fds.size())) == 0) {
+            fixed_fds = fds;
+        } else if (!fds.empty()) {
+            warning += std::string("io_uring file registration failed (") + strerror(errno) +
+                       "), using regular file descriptors. ";
+        }
+    }
+
+    void prep(uint32_t slot, int fd, void* buf, uint32_t len, uint64_t offset, bool is_write) override {
+        io_uring_sqe* sqe = &sqes[local_tail & *sq_mask];
+        memset(sqe, 0, sizeof(*sqe));
+
+        int file_index = -1;
+        for (size_t i = 0; i < fixed_fds.size(); i++) {
+            if (fixed_fds[i] == fd) {
+                file_index = static_cast<int>(i);
+                break;
+            }
+        }
+        if (file_index >= 0) {
+            sqe->fd = file_index;
+            sqe->flags = IOSQE_FIXED_FILE;
+        } else {
+            sqe->fd = fd;
+        }
+
+        char* p = static_cast<char*>(buf);
+        if (fixed_buffers && p >= buffer_base && p + len <= buffer_base + buffer_len) {
+            sqe->opcode = is_write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+            sqe->buf_index = 0;
+        } else {
+            sqe->opcode = is_write ? IORING_OP_WRITE : IORING_OP_READ;
+        }
+        sqe->addr = reinterpret_cast<uint64_t>(buf);
+        sqe->len = len;
+        sqe->off = offset;
+        sqe->user_data = slot;
+
+        local_tail++;
+        to_submit++;
+    }
+
+    int submit() override {
+        if (to_submit == 0) return 0;
+        unsigned n = to_submit;
+        to_submit = 0;
+        // Publish the new tail; the kernel (or SQ poller) reads it with acquire
+        __atomic_store_n(sq_tail, local_tail, __ATOMIC_RELEASE);
+
+        if (sqpoll) {
+            // The poller picks entries up on its own unless it went idle
+            if (__atomic_load_n(sq_flags, __ATOMIC_ACQUIRE) & IORING_SQ_NEED_WAKEUP) {
+                sys_enter(ring_fd, n, 0, IORING_ENTER_SQ_WAKEUP, nullptr, 0);
+            }
+            return static_cast<int>(n);
+        }
+
+        int r = sys_enter(ring_fd, n, 0, 0, nullptr, 0);
+        // Withdraw anything the kernel did not consume so the caller can reuse those slots
+        unsigned head = __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+        if (head != local_tail) {
+            local_tail = head;
+            __atomic_store_n(sq_tail, local_tail, __ATOMIC_RELEASE);
+        }
+        return r < 0 ? 0 : r;
+    }
+
+    int reap(int min_nr, int64_t timeout_ns, Completion* out, int max_nr) override {
+        int n = drain_cq(out, max_nr);
+        if (n >= min_nr || timeout_ns == 0) return n;
+
+        if (features & IORING_FEAT_EXT_ARG) {
+            __kernel_timespec ts;
+            ts.tv_sec = timeout_ns / 1000000000LL;
+            ts.tv_nsec = timeout_ns % 1000000000LL;
+            io_uring_getevents_arg arg;
+            memset(&arg, 0, sizeof(arg));
+            arg.ts = timeout_ns < 0 ? 0 : reinterpret_cast<uint64_t>(&ts);
+            sys_enter(ring_fd, 0, static_cast<unsigned>(min_nr - n),
+                      IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+        } else {
+            // Pre-5.11 kernels: no timed wait, poll the CQ until the deadline
+            uint64_t deadline = timeout_ns < 0 ? UINT64_MAX : monotonic_ns() + timeout_ns;
+            while (__atomic_load_n(cq_tail, __ATOMIC_ACQUIRE) == *cq_head && monotonic_ns() < deadline) {
+                sched_yield();
+            }
+        }
+        return n + drain_cq(out + n, max_nr - n);
+    }
+
+private:
+    int drain_cq(Completion* out, int max_nr) {
+        unsigned head = *cq_head;
+        unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+        int n = 0;
+        while (head != tail && n < max_nr) {
+            const io_uring_cqe& cqe = cqes[head & *cq_mask];
+            out[n].slot = static_cast<uint32_t>(cqe.user_data);
+            out[n].result = cqe.res;
+            n++;
+            head++;
+        }
+        __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+        return n;
+    }
+};
+
+inline std::unique_ptr<IoBackend> make_backend(const std::string& ioengine) {
+    if (ioengine == "libaio") return std::make_unique<LibaioBackend>();
+    if (ioengine == "io_uring") return std::make_unique<IoUringBackend>(false);
+    if (ioengine == "io_uring_sqpoll") return std::make_unique<IoUringBackend>(true);
+    return std::make_unique<PsyncBackend>();
+}
+
+inline bool backend_supported(const std::string& ioengine) {
+    return ioengine.empty() || ioengine == "psync" || ioengine == "sync" ||
+           ioengine == "pvsync" || ioengine == "libaio" ||
+           ioengine == "io_uring" || ioengine == "io_uring_sqpoll";
+}
+
+// ---------------------------------------------------------------------------
+// Statistics
+// ---------------------------------------------------------------------------
+
+struct DirStats {
+    uint64_t ios = 0;
+    uint64_t bytes = 0;
+    uint64_t errors = 0;
+    uint64_t lat_min = UINT64_MAX;
+    uint64_t lat_max = 0;
+    double lat_sum = 0;
+    double lat_sq = 0;
+
+    void record(uint64_t lat_ns, uint64_t len) {
+        ios++;
+        bytes += len;
+        if (lat_ns < lat_min) lat_min = lat_ns;
+        if (lat_ns > lat_max) lat_max = lat_ns;
+        lat_sum += lat_ns;
+        lat_sq += static_cast<double>(lat_ns) * lat_ns;
+    }
+
+    void merge(const DirStats& o) {
+        ios += o.ios;
+        bytes += o.bytes;
+        errors += o.errors;
+        lat_min = std::min(lat_min, o.lat_min);
+        lat_max = std::max(lat_max, o.lat_max);
+        lat_sum += o.lat_sum;
+        lat_sq += o.lat_sq;
+    }
+};
+
+struct PhaseStats {
+    DirStats dir[2];                     // [0] = read, [1] = write
+    std::vector<uint64_t> per_second[2]; // Completions per second of the phase
+    uint64_t elapsed_ns = 0;             // Start of phase to last completion
+    uint64_t issued = 0;                 // Trace replay / open loop: requests issued
+    uint64_t late = 0;                   // Trace replay / open loop: issued > kLateNs after their intended time
+    uint64_t pages = 0;                  // Pages referenced, for the MRC's SHARDS_adj correction
+    DirStats sync;                       // Checkpoint syncs (worker 0) or interval syncs (syncer thread)
+};
+
+// ---------------------------------------------------------------------------
+// Engine
+// ---------------------------------------------------------------------------
+
+class NativeEngine {
+public:
+    NativeEngine(std::vector<EnginePhase> phases, EngineOptions options)
+        : phases(std::move(phases)), options(options) {}
+
+    ~NativeEngine() {
+        for (auto& [path, fd] : fds) close(fd);
+    }
+
+    const std::string& error() const { return last_error; }
+    // Non-fatal conditions worth reporting (e.g. io_uring registration fallbacks)
+    const std::vector<std::string>& warnings() const { return warning_list; }
+    // Backing of the worker buffer arenas, e.g. "2 x 64.0MB in 2M hugetlb pages"
+    const std::string& arena_summary() const { return arena_text; }
+    // Latest first issue of any worker after phase 1's start (how closely workers met a shared start)
+    uint64_t start_skew_ns() const { return start_skew.load(); }
+    // Filled by run() when EngineOptions::mrc_samples > 0
+    const std::vector<PhaseMrc>& mrc_results() const { return mrc_list; }
+
+    // Run every phase back to back; returns false if the engine could not start
+    bool run() {
+        if (phases.empty()) return true;
+        if (!load_traces() || !validate() || !build_distributions() || !open_files()) return false;
+
+        int workers = 0;
+        for (const auto& p : phases) workers = std::max(workers, p.numjobs);
+
+        worker_stats.assign(workers, {});
+        for (auto& ws : worker_stats) {
+            ws.resize(phases.size());
+            for (size_t i = 0; i < phases.size(); i++) {
+                ws[i].per_second[0].assign(phases[i].runtime, 0);
+                ws[i].per_second[1].assign(phases[i].runtime, 0);
+            }
+        }
+
+        // Absolute phase boundaries shared by every worker (and by other tenants on a shared start)
+        uint64_t start = monotonic_ns();
+        if (options.wait_start) {
+            start = options.wait_start();
+            if (start == 0) {
+                last_error = "shared start was cancelled";
+                return false;
+            }
+        }
+        phase_start.resize(phases.size());
+        phase_end.resize(phases.size());
+        uint64_t t = start;
+        for (size_t i = 0; i < phases.size(); i++) {
+            phase_start[i] = t;
+            t += static_cast<uint64_t>(phases[i].runtime) * 1000000000ULL;
+            phase_end[i] = t;
+        }
+
+        std::vector<uint64_t> offsets;
+        for (uint64_t ps : phase_start) offsets.push_back(ps - start);
+        recorder = std::make_unique<latency::LatencyRecorder>(workers, start, kWindowNs, offsets);
+        if (!options.latency_file.empty() &&
+            !recorder->open(options.latency_file, options.client, last_error)) {
+            return false;
+        }
+        if (options.window_observer) recorder->set_observer(options.window_observer);
+        recorder->start();
+
+        trackers.resize(phases.size());
+        if (options.mrc_samples > 0) {
+            for (auto& t : trackers) t = std::make_unique<mrc::ShardsTracker>(options.mrc_samples);
+        }
+        std::thread publisher;
+        if (options.mrc_samples > 0 && !options.mrc_file.empty()) {
+            publisher = std::thread([this]() { publish_mrc_loop(); });
+        }
+        sync_stats.assign(phases.size(), {});
+        std::thread syncer;
+        if (std::any_of(phases.begin(), phases.end(), [](const EnginePhase& p) { return p.sync_interval_ns > 0; })) {
+            syncer = std::thread([this]() { sync_loop(); });
+        }
+
+        std::vector<std::thread> threads;
+        for (int w = 0; w < workers; w++) {
+            threads.emplace_back([this, w]() { worker_main(w); });
+        }
+        for (auto& th : threads) th.join();
+        recorder->stop();
+        if (uint64_t late = recorder->late_samples()) {
+            add_warning(std::to_string(late) + " completions were recorded after their latency window closed "
+                        "and are missing from the per-window and phase percentiles (worker preempted > 20ms)");
+        }
+        {
+            std::lock_guard<std::mutex> lock(helper_mutex);
+            helpers_stop = true;
+        }
+        helper_cv.notify_all();
+        if (publisher.joinable()) publisher.join();
+        if (syncer.joinable()) syncer.join();
+
+        if (failed.load()) return false;
+        for (size_t i = 0; i < phases.size(); i++) {
+            write_phase_result(i);
+            write_phase_mrc(i);
+            report_replay_lag(i);
+        }
+        return true;
+    }
+
+private:
+    std::vector<EnginePhase> phases;
+    EngineOptions options;
+    std::map<std::string, int> fds;
+    std::map<std::string, std::unique_ptr<trace::TraceFile>> traces;
+    std::vector<std::unique_ptr<dist::OffsetDistribution>> distributions;  // Per phase, null = uniform
+    std::vector<std::unique_ptr<mrc::ShardsTracker>> trackers;             // Per phase, null = no MRC
+    std::vector<PhaseMrc> mrc_list;
+    std::vector<DirStats> sync_stats;                                     // Per phase, from sync_loop
+    std::mutex helper_mutex;                                               // MRC publisher and syncer threads
+    std::condition_variable helper_cv;
+    bool helpers_stop = false;
+    std::vector<uint64_t> phase_start;
+    std::vector<uint64_t> phase_end;
+    std::vector<std::vector<PhaseStats>> worker_stats;  // [worker][phase]
+    std::unique_ptr<latency::LatencyRecorder> recorder;
+    std::atomic<bool> failed{false};
+    std::atomic<uint64_t> start_skew{0};
+    std::mutex error_mutex;
+    std::string last_error;
+    std::vector<std::string> warning_list;
+    std::string arena_text;
+
+    bool stop_requested() const {
+        return options.stop_flag && options.stop_flag->load(std::memory_order_relaxed) != 0;
+    }
+
+    // Phase boundaries as they stand now: a boundary already passed stays in the past
+    uint64_t schedule_shift() const {
+        return options.schedule_shift ? options.schedule_shift->load(std::memory_order_relaxed) : 0;
+    }
+    uint64_t start_of(size_t i) const { return phase_start[i] - schedule_shift(); }
+    uint64_t end_of(size_t i) const { return phase_end[i] - schedule_shift(); }
+
+    // Waits end by kStopPollNs when the schedule can move or stop under them
+    uint64_t wake_by(uint64_t t) const {
+        if (!options.stop_flag && !options.schedule_shift) return t;
+        return std::min(t, monotonic_ns() + kStopPollNs);
+    }
+
+    void describe_arena(const arena::BufferArena& buffers) {
+        int workers = static_cast<int>(worker_stats.size());
+        std::ostringstream text;
+        text << std::fixed << std::setprecision(1) << workers << " x ";
+        if (buffers.mapped_bytes() >= 1048576) text << buffers.mapped_bytes() / 1048576.0 << "MB";
+        else text << buffers.mapped_bytes() / 1024 << "KB";
+        text << " in " << buffers.backing() << " pages"
+             << (buffers.charged_to_memcg() ? " (counted in memory.current)" : " (outside memory.current)");
+        std::lock_guard<std::mutex> lock(error_mutex);
+        arena_text = text.str();
+    }
+
+    void add_warning(const std::string& message) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        warning_list.push_back(message);
+    }
+
+    void fail(const std::string& message) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!failed.exchange(true)) last_error = message;
+    }
+
+    static constexpr uint64_t kAlign = 4096;
+    static constexpr uint64_t kWindowNs = 1000000000ULL;
+    static constexpr uint64_t kStopPollNs = 10000000ULL;  // Wait granularity while the schedule can change
+
+    // Replay requests issued later than this behind their recorded time count as late
+    static constexpr uint64_t kLateNs = 1000000ULL;
+
+    // Map every trace once; a trace phase's buffers are sized by its largest request
+    bool load_traces() {
+        for (auto& p : phases) {
+            if (p.pattern != IoPattern::Trace) continue;
+            if (!traces.count(p.trace_file)) {
+                auto tf = std::make_unique<trace::TraceFile>();
+                if (!tf->open_file(p.trace_file, last_error)) {
+                    last_error = p.name + ": " + last_error;
+                    return false;
+                }
+                traces[p.trace_file] = std::move(tf);
+            }
+            const auto& hdr = traces[p.trace_file]->header();
+            p.block_size = (hdr.max_length + kAlign - 1) / kAlign * kAlign;
+            if (hdr.max_offset > p.file_size) {
+                add_warning(p.name + ": trace addresses " + std::to_string(hdr.max_offset >> 20) +
+                            "MB but the test file has " + std::to_string(p.file_size >> 20) +
+                            "MB; offsets are wrapped into the file");
+            }
+        }
+        return true;
+    }
+
+    // Alias tables are built once and shared read-only by every worker
+    bool build_distributions() {
+        distributions.resize(phases.size());
+        for (size_t i = 0; i < phases.size(); i++) {
+            const auto& p = phases[i];
+            if (p.distribution.empty()) continue;
+            if (!pattern_is_random(p.pattern)) {
+                last_error = p.name + ": distribution '" + p.distribution + "' needs a random pattern";
+                return false;
+            }
+            distributions[i] = std::make_unique<dist::OffsetDistribution>();
+            if (!distributions[i]->init(p.distribution, p.file_size / p.block_size, last_error)) {
+                last_error = p.name + ": " + last_error;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool validate() {
+        for (const auto& p : phases) {
+            if (p.pattern == IoPattern::Trace && !(p.trace_speed > 0)) {
+                last_error = p.name + ": trace_speed must be positive";
+                return false;
+            }
+            if (p.block_size == 0 || p.block_size % 512 != 0) {
+                last_error = p.name + ": block_size must be a non-zero multiple of 512";
+                return false;
+            }
+            if (p.file_size < p.block_size) {
+                last_error = p.name + ": file_size is smaller than block_size";
+                return false;
+            }
+            if (p.numjobs <= 0 || p.iodepth <= 0 || p.runtime <= 0) {
+                last_error = p.name + ": numjobs, iodepth and runtime must be positive";
+                return false;
+            }
+            if (!backend_supported(p.ioengine)) {
+                last_error = p.name + ": ioengine '" + p.ioengine + "' is not supported by the native engine";
+                return false;
+            }
+            if (p.dirty_rate > 0 && p.rate_iops > 0) {
+                last_error = p.name + ": dirty_rate and rate_iops both set the pace; use one";
+                return false;
+            }
+            if (p.dirty_rate > 0 && !pattern_writes(p.pattern)) {
+                last_error = p.name + ": dirty_rate needs a write pattern";
+                return false;
+            }
+            if (p.sync_interval_ns > 0 && p.sync == SyncMode::None) {
+                last_error = p.name + ": sync_interval_ms needs a sync mode";
+                return false;
+            }
+            if ((p.checkpoint_interval_ns > 0) != (p.checkpoint_bytes > 0)) {
+                last_error = p.name + ": checkpoint_interval_s and checkpoint_size go together";
+                return false;
+            }
+            if (p.arrival.open_loop() && p.rate_iops <= 0 && p.dirty_rate == 0) {
+                last_error = p.name + ": an open-loop arrival process needs rate_iops or dirty_rate";
+                return false;
+            }
+            if (p.pattern == IoPattern::Trace && (p.dirty_rate > 0 || p.checkpoint_bytes > 0)) {
+                last_error = p.name + ": trace replay keeps the recorded pace; dirty_rate and checkpoints don't apply";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool open_files() {
+        std::map<std::string, bool> needs_write;
+        for (const auto& p : phases) {
+            bool writes = p.pattern == IoPattern::Trace ? traces[p.trace_file]->header().num_writes > 0
+                                                        : pattern_writes(p.pattern) || p.checkpoint_bytes > 0;
+            needs_write[p.file] = needs_write[p.file] || writes;
+        }
+        for (const auto& [path, writes] : needs_write) {
+            int flags = (writes ? O_RDWR : O_RDONLY) | (options.direct ? O_DIRECT : 0);
+            int fd = open(path.c_str(), flags);
+            if (fd < 0) {
+                last_error = "Cannot open " + path + ": " + strerror(errno);
+                return false;
+            }
+            fds[path] = fd;
+        }
+        return true;
+    }
+
+    struct Slot {
+        uint64_t submit_ns;
+        uint32_t len;
+        bool is_write;
+    };
+
+    void worker_main(int w) {
+        const WorkerPlacement* place =
+            options.placement.empty() ? nullptr : &options.placement[w % options.placement.size()];
+        std::string place_error;
+        if (place && !topology::pin_thread(place->cpu, place_error)) add_warning(place_error);
+
+        int max_depth = 1;
+        uint64_t max_bs = 0;
+        for (const auto& p : phases) {
+            max_depth = std::max(max_depth, p.iodepth);
+            max_bs = std::max(max_bs, p.block_size);
+        }
+
+        // One buffer per slot, mapped (and bound to the worker's node) before the fill below touches it
+        arena::BufferArena buffers;
+        std::string arena_error;
+        if (!buffers.init(max_bs, max_depth, options.hugepages, place ? place->node : -1, arena_error)) {
+            fail(arena_error);
+            return;
+        }
+        if (w == 0) describe_arena(buffers);
+        void* mem = buffers.data();
+        const size_t buffer_len = buffers.size();
+        // Incompressible payload for writes
+        uint64_t seed = 0x9E3779B97F4A7C15ULL ^ (static_cast<uint64_t>(w) << 32);
+        auto* words = static_cast<uint64_t*>(mem);
+        for (uint64_t i = 0; i < buffer_len / sizeof(uint64_t); i++) {
+            words[i] = next_random(seed);
+        }
+
+        std::vector<int> file_fds;
+        for (const auto& [path, fd] : fds) file_fds.push_back(fd);
+
+        // One backend per ioengine name, created up front so switching is free
+        std::map<std::string, std::unique_ptr<IoBackend>> backends;
+        for (const auto& p : phases) {
+            if (backends.count(p.ioengine)) continue;
+            auto backend = make_backend(p.ioengine);
+            std::string err;
+            if (!backend->init(max_depth, err)) {
+                fail(p.ioengine + ": " + err);
+                return;
+            }
+            std::string warning;
+            backend->register_resources(mem, buffer_len, file_fds, warning);
+            if (!warning.empty() && w == 0) add_warning(p.ioengine + ": " + warning);
+            backends[p.ioengine] = std::move(backend);
+        }
+
+        std::vector<Slot> slots(max_depth);
+        std::vector<Completion> completions(max_depth);
+        std::string cursor_file;
+        uint64_t cursor = 0;
+
+        // A shared start may still be ahead: setup above runs inside the lead time
+        arrival::wait_until(phase_start[0]);
+        uint64_t skew = monotonic_ns() - phase_start[0];
+        uint64_t seen = start_skew.load();
+        while (skew > seen && !start_skew.compare_exchange_weak(seen, skew)) {}
+
+        for (size_t i = 0; i < phases.size(); i++) {
+            const auto& phase = phases[i];
+            if (stop_requested()) break;
+            if (w == 0) recorder->begin_phase(i, start_of(i));
+            if (w >= phase.numjobs) {
+                // Idle in this phase; an early stop must still wake it
+                for (uint64_t now = monotonic_ns(); now < end_of(i) && !stop_requested(); now = monotonic_ns()) {
+                    sleep_until_ns(std::min(end_of(i), now + kStopPollNs));
+                }
+                continue;
+            }
+            if (cursor_file != phase.file) {
+                cursor_file = phase.file;
+                cursor = 0;
+            }
+            run_phase(w, i, *backends[phase.ioengine], buffers, slots, completions, seed, cursor,
+                      worker_stats[w][i]);
+        }
+    }
+
+    void run_phase(int w, size_t idx, IoBackend& backend, const arena::BufferArena& buffers,
+                   std::vector<Slot>& slots, std::vector<Completion>& completions,
+                   uint64_t& seed, uint64_t& cursor, PhaseStats& stats) {
+        const auto& phase = phases[idx];
+        if (phase.pattern == IoPattern::Trace) {
+            run_trace_phase(w, idx, backend, buffers, slots, completions, stats);
+            return;
+        }
+        const int fd = fds[phase.file];
+        const int depth = std::min(backend.max_depth(phase.iodepth), static_cast<int>(slots.size()));
+        const uint64_t blocks = phase.file_size / phase.block_size;
+        const uint64_t start = start_of(idx);
+        uint64_t deadline = end_of(idx);
+        const uint64_t interval = phase.rate_iops > 0 ? 1000000000ULL / phase.rate_iops
+                                  : phase.dirty_rate > 0 ? dirty_rate_interval(phase) : 0;
+        const dist::OffsetDistribution* distribution = distributions[idx].get();
+        mrc::ShardsTracker* tracker = trackers[idx].get();
+        auto random_word = [&seed]() { return next_random(seed); };
+        // Open loop: requests are due at fixed times and timed from them, however late they go out
+        std::unique_ptr<arrival::Schedule> schedule;
+        if (interval && phase.arrival.open_loop()) {
+            schedule = std::make_unique<arrival::Schedule>(phase.arrival, interval, start, w, phase.numjobs,
+                                                           next_random(seed));
+        }
+
+        std::vector<uint32_t> free_slots;
+        std::vector<uint32_t> batch;
+        free_slots.reserve(depth);
+        batch.reserve(depth);
+        for (int s = depth - 1; s >= 0; s--) free_slots.push_back(s);
+
+        uint64_t next_issue = start;
+        uint64_t last_completion = start;
+        int inflight = 0;
+
+        // Checkpoints run on job 0 only, one at a time: a late one starts when the previous has synced
+        const bool checkpoints = w == 0 && phase.checkpoint_interval_ns > 0;
+        uint64_t next_checkpoint = checkpoints ? start + phase.checkpoint_interval_ns : UINT64_MAX;
+        uint64_t burst_left = 0;  // Checkpoint bytes still to issue
+        bool flushing = false;    // Checkpoint issued; sync once its writes have completed
+
+        auto handle = [&](int n) {
+            uint64_t now = monotonic_ns();
+            for (int c = 0; c < n; c++) {
+                const Completion& comp = completions[c];
+                const Slot& slot = slots[comp.slot];
+                int d = slot.is_write ? 1 : 0;
+                if (comp.result < 0 || static_cast<uint64_t>(comp.result) != slot.len) {
+                    stats.dir[d].errors++;
+                } else {
+                    uint64_t lat = now - slot.submit_ns;
+                    stats.dir[d].record(lat, slot.len);
+                    recorder->record(w, d, now, lat);
+                    uint64_t sec = (now - start) / 1000000000ULL;
+                    if (sec < stats.per_second[d].size()) stats.per_second[d][sec]++;
+                }
+                free_slots.push_back(comp.slot);
+                inflight--;
+            }
+            if (n > 0) last_completion = now;
+        };
+
+        while (true) {
+            uint64_t now = monotonic_ns();
+            deadline = end_of(idx);
+            if (now >= deadline || stop_requested()) break;
+
+            if (flushing && inflight == 0) {
+                run_sync(fd, phase.sync == SyncMode::None ? SyncMode::Fsync : phase.sync, stats.sync);
+                flushing = false;
+                now = monotonic_ns();
+            }
+            if (!flushing && burst_left == 0 && now >= next_checkpoint) {
+                burst_left = phase.checkpoint_bytes;
+                next_checkpoint = std::max(next_checkpoint + phase.checkpoint_interval_ns, now);
+            }
+
+            // Fill the queue, honouring the rate limit; checkpoint writes ignore it
+            batch.clear();
+            while (!free_slots.empty() && !flushing) {
+                const bool burst = burst_left > 0;
+                uint64_t submit_ns = now;
+                if (schedule && !burst) {
+                    if (now < schedule->next()) break;
+                    submit_ns = schedule->next();
+                    schedule->advance();
+                    stats.issued++;
+                    if (now - submit_ns > kLateNs) stats.late++;
+                } else if (interval && !burst) {
+                    if (now < next_issue) break;
+                    // Closed loop: time lost to a stall is not made up later
+                    next_issue = std::max(next_issue, now - interval) + interval;
+                }
+                uint32_t s = free_slots.back();
+                free_slots.pop_back();
+
+                bool is_write = burst || choose_write(phase.pattern, seed);
+                if (burst) {
+                    burst_left -= std::min(burst_left, phase.block_size);
+                    flushing = burst_left == 0;
+                }
+                uint64_t block;
+                if (distribution) {
+                    block = distribution->sample(random_word, now - start);
+                } else if (pattern_is_random(phase.pattern)) {
+                    block = next_random(seed) % blocks;
+                } else {
+                    block = cursor;
+                    cursor = (cursor + 1) % blocks;
+                }
+
+                slots[s].submit_ns = submit_ns;
+                slots[s].len = static_cast<uint32_t>(phase.block_size);
+                slots[s].is_write = is_write;
+                backend.prep(s, fd, buffers.buffer(s),
+                             slots[s].len, block * phase.block_size, is_write);
+                batch.push_back(s);
+                if (tracker) {
+                    tracker->access(block * phase.block_size, phase.block_size);
+                    stats.pages += mrc::ShardsTracker::pages_in(block * phase.block_size, phase.block_size);
+                }
+            }
+            if (!batch.empty()) {
+                int accepted = backend.submit();
+                inflight += accepted;
+                // Requests the kernel refused are recorded as errors and retried later
+                for (size_t r = accepted; r < batch.size(); r++) {
+                    stats.dir[slots[batch[r]].is_write ? 1 : 0].errors++;
+                    free_slots.push_back(batch[r]);
+                }
+                if (accepted == 0 && inflight == 0) {
+                    sleep_until_ns(std::min<uint64_t>(monotonic_ns() + 1000000ULL, deadline));
+                    continue;
+                }
+            }
+
+            now = monotonic_ns();
+            if (inflight > 0) {
+                // Block for a completion, but wake up in time for the next rate-limited issue
+                uint64_t wake = deadline;
+                if (schedule && !free_slots.empty()) wake = std::min(wake, schedule->next());
+                else if (interval && !free_slots.empty()) wake = std::min(wake, next_issue);
+                int64_t wait = wake_by(wake) > now ? static_cast<int64_t>(wake_by(wake) - now) : 0;
+                handle(backend.reap(1, wait, completions.data(), depth));
+            } else if (schedule) {
+                arrival::wait_until(wake_by(std::min(schedule->next(), deadline)));
+            } else if (interval && next_issue > now) {
+                sleep_until_ns(wake_by(std::min(next_issue, deadline)));
+            }
+        }
+
+        // Drain in-flight requests before the next phase reuses the slots
+        while (inflight > 0) {
+            handle(backend.reap(1, 1000000000LL, completions.data(), depth));
+        }
+        stats.elapsed_ns = last_completion - start;
+    }
+
+    // Open-loop replay: worker w issues trace records w, w + numjobs, ... at their
+    // recorded time (scaled by trace_speed), whatever the state of earlier requests.
+    // The trace repeats until the phase ends. Requests that find every slot busy
+    // are issued as soon as one frees up and count as late if that is > kLateNs.
+    void run_trace_phase(int w, size_t idx, IoBackend& backend, const arena::BufferArena& buffers,
+                         std::vector<Slot>& slots, std::vector<Completion>& completions,
+                         PhaseStats& stats) {
+        const auto& phase = phases[idx];
+        trace::TraceFile& tf = *traces[phase.trace_file];
+        const trace::TraceRecord* records = tf.records();
+        const uint64_t num_records = tf.header().num_records;
+        // One pass lasts the trace plus one mean inter-arrival gap, so passes don't overlap
+        const uint64_t pass_ns = tf.header().duration_ns + std::max<uint64_t>(1, tf.header().duration_ns / num_records);
+        const double ns_scale = 1.0 / phase.trace_speed;
+        const uint64_t stride = static_cast<uint64_t>(phase.numjobs);
+        const int fd = fds[phase.file];
+        const int depth = std::min(backend.max_depth(phase.iodepth), static_cast<int>(slots.size()));
+        const uint64_t start = start_of(idx);
+        uint64_t deadline = end_of(idx);
+        const uint64_t align = options.direct ? kAlign : 1;
+        mrc::ShardsTracker* tracker = trackers[idx].get();
+
+        std::vector<uint32_t> free_slots;
+        std::vector<uint32_t> batch;
+        free_slots.reserve(depth);
+        batch.reserve(depth);
+        for (int s = depth - 1; s >= 0; s--) free_slots.push_back(s);
+
+        uint64_t index = static_cast<uint64_t>(w) % num_records;
+        uint64_t pass = static_cast<uint64_t>(w) / num_records;
+        auto due_at = [&]() {
+            return start + static_cast<uint64_t>((records[index].timestamp_ns + pass * pass_ns) * ns_scale);
+        };
+        uint64_t next_due = due_at();
+        uint64_t last_completion = start;
+        int inflight = 0;
+
+        auto handle = [&](int n) {
+            uint64_t now = monotonic_ns();
+            for (int c = 0; c < n; c++) {
+                const Completion& comp = completions[c];
+                const Slot& slot = slots[comp.slot];
+                int d = slot.is_write ? 1 : 0;
+                if (comp.result < 0 || static_cast<uint64_t>(comp.result) != slot.len) {
+                    stats.dir[d].errors++;
+                } else {
+                    uint64_t lat = now - slot.submit_ns;
+                    stats.dir[d].record(lat, slot.len);
+                    recorder->record(w, d, now, lat);
+                    uint64_t sec = (now - start) / 1000000000ULL;
+                    if (sec < stats.per_second[d].size()) stats.per_second[d][sec]++;
+                }
+                free_slots.push_back(comp.slot);
+                inflight--;
+            }
+            if (n > 0) last_completion = now;
+        };
+
+        while (true) {
+            uint64_t now = monotonic_ns();
+            deadline = end_of(idx);
+            if (now >= deadline || stop_requested()) break;
+
+            // Issue everything that is due, as far as free slots allow
+            batch.clear();
+            while (!free_slots.empty() && next_due <= now) {
+                uint32_t s = free_slots.back();
+                free_slots.pop_back();
+
+                const trace::TraceRecord& rec = records[index];
+                uint64_t len = (rec.length + align - 1) / align * align;
+                uint64_t offset = rec.offset;
+                if (offset + len > phase.file_size) offset %= phase.file_size - len + 1;
+                offset -= offset % align;
+
+                // Open loop: latency counts from when the trace wanted the request, so time spent
+                // waiting for a free slot during a stall is part of it (no coordinated omission)
+                slots[s].submit_ns = next_due;
+                slots[s].len = static_cast<uint32_t>(len);
+                slots[s].is_write = rec.op == trace::kOpWrite;
+                backend.prep(s, fd, buffers.buffer(s), slots[s].len, offset, slots[s].is_write);
+                batch.push_back(s);
+                stats.issued++;
+                if (tracker) {
+                    tracker->access(offset, len);
+                    stats.pages += mrc::ShardsTracker::pages_in(offset, len);
+                }
+                if (now - next_due > kLateNs) stats.late++;
+
+                index += stride;
+                while (index >= num_records) {
+                    index -= num_records;
+                    pass++;
+                }
+                if (w == 0) tf.advance(index);
+                next_due = due_at();
+            }
+            if (!batch.empty()) {
+                int accepted = backend.submit();
+                inflight += accepted;
+                // Requests the kernel refused are recorded as errors; replay moves on
+                for (size_t r = accepted; r < batch.size(); r++) {
+                    stats.dir[slots[batch[r]].is_write ? 1 : 0].errors++;
+                    free_slots.push_back(batch[r]);
+                }
+            }
+
+            now = monotonic_ns();
+            uint64_t wake = std::min(next_due, deadline);
+            if (inflight > 0) {
+                // Block for a completion, but wake up in time for the next due request
+                if (free_slots.empty()) wake = deadline;
+                int64_t wait = wake_by(wake) > now ? static_cast<int64_t>(wake_by(wake) - now) : 0;
+                handle(backend.reap(1, wait, completions.data(), depth));
+            } else if (wake > now) {
+                sleep_until_ns(wake_by(wake));
+            }
+        }
+
+        while (inflight > 0) {
+            handle(backend.reap(1, 1000000000LL, completions.data(), depth));
+        }
+        stats.elapsed_ns = last_completion - start;
+    }
+
+    // Request interval per job that dirties phase.dirty_rate bytes/s across all jobs;
+    // mixed patterns write half their requests, so they issue twice as often
+    static uint64_t dirty_rate_interval(const EnginePhase& phase) {
+        bool mixed = phase.pattern == IoPattern::ReadWrite || phase.pattern == IoPattern::RandRW;
+        double write_share = mixed ? 0.5 : 1.0;
+        double ns = phase.block_size * phase.numjobs * write_share * 1e9 / phase.dirty_rate;
+        return std::max<uint64_t>(1, static_cast<uint64_t>(ns));
+    }
+
+    static void run_sync(int fd, SyncMode mode, DirStats& stats) {
+        uint64_t t0 = monotonic_ns();
+        if (sync_file(fd, mode) != 0) {
+            stats.errors++;
+            return;
+        }
+        stats.record(monotonic_ns() - t0, 0);
+    }
+
+    // Periodic syncs of every phase with a sync interval, timed from the phase start
+    void sync_loop() {
+        std::unique_lock<std::mutex> lock(helper_mutex);
+        for (size_t i = 0; i < phases.size(); i++) {
+            const auto& p = phases[i];
+            if (p.sync_interval_ns == 0) continue;
+            const int fd = fds[p.file];
+            for (uint64_t t = start_of(i) + p.sync_interval_ns; t < end_of(i); t += p.sync_interval_ns) {
+                auto due = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(t));
+                if (helper_cv.wait_until(lock, due, [this]() { return helpers_stop; })) return;
+                lock.unlock();
+                run_sync(fd, p.sync, sync_stats[i]);
+                lock.lock();
+            }
+        }
+    }
+
+    void report_replay_lag(size_t idx) {
+        const auto& phase = phases[idx];
+        if (phase.pattern != IoPattern::Trace && !phase.arrival.open_loop()) return;
+        uint64_t issued = 0, late = 0;
+        for (const auto& ws : worker_stats) {
+            issued += ws[idx].issued;
+            late += ws[idx].late;
+        }
+        // More than 1% late means the device or iodepth, not the schedule, set the pace.
+        // For open-loop phases that delay is already in the latencies; this just says how much.
+        if (issued > 0 && late * 100 > issued) {
+            add_warning(phase.name + ": " + std::to_string(late) + " of " + std::to_string(issued) +
+                        (phase.pattern == IoPattern::Trace
+                             ? " trace requests were issued more than 1ms behind schedule (raise iodepth or lower trace_speed)"
+                             : " requests were issued more than 1ms after their arrival time (raise iodepth or lower the rate)"));
+        }
+    }
+
+    // Once a second, rewrite options.mrc_file with the running phase's curve
+    void publish_mrc_loop() {
+        std::unique_lock<std::mutex> lock(helper_mutex);
+        while (!helper_cv.wait_for(lock, std::chrono::seconds(1), [this]() { return helpers_stop; })) {
+            uint64_t now = monotonic_ns();
+            size_t idx = 0;
+            while (idx + 1 < phases.size() && now >= end_of(idx)) idx++;
+            const mrc::ShardsTracker& t = *trackers[idx];
+            auto points = t.curve();
+            if (!points.empty()) mrc::write_csv(options.mrc_file, points, t.sample_rate(), t.sampled_pages(), 0);
+        }
+    }
+
+    void write_phase_mrc(size_t idx) {
+        mrc::ShardsTracker* t = trackers[idx].get();
+        if (!t || phases[idx].output_file.empty()) return;
+        uint64_t pages = 0;
+        for (const auto& ws : worker_stats) pages += ws[idx].pages;
+        t->set_references(pages);
+        auto points = t->curve();
+        if (points.empty()) return;
+
+        std::string file = phases[idx].output_file;
+        if (file.size() > 5 && file.compare(file.size() - 5, 5, ".json") == 0) file.resize(file.size() - 5);
+        file += "_mrc.csv";
+        if (!mrc::write_csv(file, points, t->sample_rate(), t->sampled_pages(), pages)) {
+            add_warning(phases[idx].name + ": cannot write " + file);
+            return;
+        }
+        mrc_list.push_back({phases[idx].name, file, t->sample_rate(),
+                            mrc::cache_for_share(points, 0.9) * mrc::kPageSize,
+                            mrc::cache_for_share(points, 0.99) * mrc::kPageSize});
+    }
+
+    static uint64_t next_random(uint64_t& state) {
+        // splitmix64
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    static bool choose_write(IoPattern p, uint64_t& seed) {
+        switch (p) {
+            case IoPattern::Write:
+            case IoPattern::RandWrite: return true;
+            case IoPattern::ReadWrite:
+            case IoPattern::RandRW: return next_random(seed) & 1;
+            default: return false;
+        }
+    }
+
+    // -----------------------------------------------------------------------
+    // fio-compatible JSON output
+    // -----------------------------------------------------------------------
+
+    static void write_lat_json(std::ostream& out, const char* key, const DirStats& ds,
+                               const latency::Histogram* hist) {
+        // Same percentile list fio reports by default
+        static const double kPercentiles[] = {1, 5, 10, 20, 30, 40, 50, 60, 70, 80, 90,
+                                              95, 99, 99.5, 99.9, 99.95, 99.99};
+        double mean = ds.ios ? ds.lat_sum / ds.ios : 0;
+        double var = ds.ios ? ds.lat_sq / ds.ios - mean * mean : 0;
+        out << "        \"" << key << "\" : {\n"
+            << "          \"min\" : " << (ds.ios ? ds.lat_min : 0) << ",\n"
+            << "          \"max\" : " << ds.lat_max << ",\n"
+            << "          \"mean\" : " << mean << ",\n"
+            << "          \"stddev\" : " << std::sqrt(std::max(0.0, var));
+        if (hist && hist->count > 0) {
+            out << ",\n          \"percentile\" : {\n";
+            size_t n = sizeof(kPercentiles) / sizeof(kPercentiles[0]);
+            for (size_t i = 0; i < n; i++) {
+                out << "            \"" << kPercentiles[i] << "\" : " << hist->percentile(kPercentiles[i])
+                    << (i + 1 < n ? ",\n" : "\n");
+            }
+            out << "          }";
+        }
+        out << "\n        }";
+    }
+
+    static void write_dir_json(std::ostream& out, const char* key, const DirStats& ds,
+                               const std::vector<uint64_t>& per_second,
+                               double runtime_s, bool active, const latency::Histogram* hist) {
+        double iops = runtime_s > 0 ? ds.ios / runtime_s : 0;
+        double bw = runtime_s > 0 ? ds.bytes / runtime_s : 0;
+
+        // Per-second IOPS samples, like fio's iops_min/max/stddev
+        double s_min = 0, s_max = 0, s_mean = 0, s_dev = 0;
+        size_t samples = active ? per_second.size() : 0;
+        if (samples > 0) {
+            s_min = static_cast<double>(per_second[0]);
+            for (uint64_t v : per_second) {
+                s_min = std::min(s_min, static_cast<double>(v));
+                s_max = std::max(s_max, static_cast<double>(v));
+                s_mean += v;
+            }
+            s_mean /= samples;
+            for (uint64_t v : per_second) s_dev += (v - s_mean) * (v - s_mean);
+            s_dev = std::sqrt(s_dev / samples);
+        }
+
+        out << "      \"" << key << "\" : {\n"
+            << "        \"io_bytes\" : " << ds.bytes << ",\n"
+            << "        \"io_kbytes\" : " << ds.bytes / 1024 << ",\n"
+            << "        \"bw_bytes\" : " << static_cast<uint64_t>(bw) << ",\n"
+            << "        \"bw\" : " << static_cast<uint64_t>(bw / 1024) << ",\n"
+            << "        \"iops\" : " << iops << ",\n"
+            // fio reports 0 for a direction without I/O; phase_aggregator divides by the runtime sum
+            << "        \"runtime\" : " << (active ? static_cast<uint64_t>(runtime_s * 1000) : 0) << ",\n"
+            << "        \"total_ios\" : " << ds.ios << ",\n"
+            << "        \"short_ios\" : " << ds.errors << ",\n";
+        write_lat_json(out, "clat_ns", ds, hist);
+        out << ",\n";
+        write_lat_json(out, "lat_ns", ds, nullptr);
+        out << ",\n"
+            << "        \"iops_min\" : " << static_cast<uint64_t>(s_min) << ",\n"
+            << "        \"iops_max\" : " << static_cast<uint64_t>(s_max) << ",\n"
+            << "        \"iops_mean\" : " << s_mean << ",\n"
+            << "        \"iops_stddev\" : " << s_dev << ",\n"
+            << "        \"iops_samples\" : " << samples << "\n"
+            << "      }";
+    }
+
+    void write_phase_result(size_t idx) {
+        const auto& phase = phases[idx];
+        if (phase.output_file.empty()) return;
+
+        PhaseStats total;
+        total.per_second[0].assign(phase.runtime, 0);
+        total.per_second[1].assign(phase.runtime, 0);
+        total.sync = sync_stats[idx];
+        for (const auto& ws : worker_stats) {
+            const PhaseStats& ps = ws[idx];
+            total.elapsed_ns = std::max(total.elapsed_ns, ps.elapsed_ns);
+            total.sync.merge(ps.sync);
+            for (int d = 0; d < 2; d++) {
+                total.dir[d].merge(ps.dir[d]);
+                for (size_t s = 0; s < total.per_second[d].size(); s++) {
+                    total.per_second[d][s] += ps.per_second[d][s];
+                }
+            }
+        }
+        double runtime_s = total.elapsed_ns / 1e9;
+        // Seconds the phase actually ran: an adaptive cut or an early stop ends it before its runtime,
+        // and the never-reached seconds must not count as zero-IOPS samples. A trailing partial
+        // second is dropped too (it would read as a dip), unless it is all there is.
+        size_t ran_s = std::max<size_t>(1, static_cast<size_t>(total.elapsed_ns / 1000000000ULL));
+        for (int d = 0; d < 2; d++) {
+            if (total.per_second[d].size() > ran_s) total.per_second[d].resize(ran_s);
+        }
+
+        std::ofstream out(phase.output_file);
+        out << std::fixed << std::setprecision(6);
+        out << "{\n"
+            << "  \"fio version\" : \"native-engine\",\n"
+            << "  \"jobs\" : [\n"
+            << "    {\n"
+            << "      \"jobname\" : \"" << phase.name << "\",\n"
+            << "      \"error\" : 0,\n";
+        write_dir_json(out, "read", total.dir[0], total.per_second[0], runtime_s, total.dir[0].ios > 0,
+                       &recorder->phase_histogram(idx, 0));
+        out << ",\n";
+        write_dir_json(out, "write", total.dir[1], total.per_second[1], runtime_s, total.dir[1].ios > 0,
+                       &recorder->phase_histogram(idx, 1));
+        // fio's layout for fsync/fdatasync latencies; sync_file_range is recorded here too
+        if (total.sync.ios > 0 || total.sync.errors > 0) {
+            out << ",\n      \"sync\" : {\n"
+                << "        \"total_ios\" : " << total.sync.ios << ",\n"
+                << "        \"errors\" : " << total.sync.errors << ",\n";
+            write_lat_json(out, "lat_ns", total.sync, nullptr);
+            out << "\n      }";
+        }
+        out << "\n    }\n  ]\n}\n";
+    }
+};
+
+}  // namespace native
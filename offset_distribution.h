@@ -0,0 +1,218 @@
+// offset_distribution.h
+// Skewed block distributions for the native engine's random patterns.
+//
+// A distribution ranks the file's blocks from hottest to coldest and groups
+// ranks into buckets: the hottest 256K ranks get a bucket each, the long
+// tail is covered by buckets growing geometrically by 1/256. A Vose alias
+// table over the buckets picks one in O(1) from a single random word; the
+// block is then uniform within the bucket. Head probabilities are exact and
+// the tail error is bounded by the bucket growth, while the table stays a
+// few MB even for a multi-TB file.
+//
+// Supported specs (the `distribution` key):
+//   uniform
+//   zipf:<theta>                      P(rank r) ~ 1 / (r+1)^theta
+//   pareto:<alpha>                    P(rank r) ~ (r+1)^-alpha - (r+2)^-alpha
+//   hotset:<fraction>:<probability>   <probability> of accesses hit <fraction> of the file
+//   hotspot:<fraction>:<probability>:<period_s>
+//                                     hotset whose hot region slides across the whole
+//                                     file once every <period_s> seconds
+//
+// Ranks are scattered over the file with a multiplicative permutation, so the
+// hot set is spread like a KV store's hot keys rather than being one
+// contiguous (and readahead-friendly) extent.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace dist {
+
+enum class Kind { Uniform, Zipf, Pareto, HotSet, HotSpot };
+
+class OffsetDistribution {
+public:
+    // False with `error` set if the spec is malformed
+    bool init(const std::string& spec, uint64_t num_blocks, std::string& error) {
+        blocks = num_blocks;
+        if (blocks == 0) {
+            error = "distribution needs at least one block";
+            return false;
+        }
+        std::vector<double> args;
+        std::string name = spec.substr(0, spec.find(':'));
+        for (size_t pos = spec.find(':'); pos != std::string::npos; pos = spec.find(':', pos + 1)) {
+            char* end;
+            args.push_back(strtod(spec.c_str() + pos + 1, &end));
+            if (end == spec.c_str() + pos + 1 || (*end != ':' && *end != '\0')) {
+                error = "Invalid number in distribution '" + spec + "'";
+                return false;
+            }
+        }
+
+        if (name == "uniform" && args.empty()) {
+            kind = Kind::Uniform;
+            add_bucket(0, blocks, 1.0);
+        } else if ((name == "zipf" || name == "pareto") && args.size() == 1 && args[0] > 0) {
+            kind = name == "zipf" ? Kind::Zipf : Kind::Pareto;
+            build_power_law(args[0]);
+        } else if (name == "hotset" && args.size() == 2 && valid_hot(args[0], args[1])) {
+            kind = Kind::HotSet;
+            build_hot(args[0], args[1]);
+        } else if (name == "hotspot" && args.size() == 3 && valid_hot(args[0], args[1]) && args[2] > 0) {
+            kind = Kind::HotSpot;
+            build_hot(args[0], args[1]);
+            shift_per_ns = static_cast<double>(blocks) / (args[2] * 1e9);
+        } else {
+            error = "Unknown distribution '" + spec +
+                    "' (uniform, zipf:THETA, pareto:ALPHA, hotset:FRAC:PROB, hotspot:FRAC:PROB:PERIOD_S)";
+            return false;
+        }
+        build_alias();
+        choose_permutation();
+        return true;
+    }
+
+    // Block index in [0, num_blocks); elapsed_ns only matters for hotspot
+    template <typename Rng>
+    uint64_t sample(Rng&& next_random, uint64_t elapsed_ns) const {
+        uint64_t r = next_random();
+        uint32_t column = static_cast<uint32_t>(((r >> 32) * table.size()) >> 32);
+        uint32_t b = static_cast<uint32_t>(r) < table[column].threshold ? column : table[column].alias;
+        uint64_t rank = bucket_lo[b];
+        if (bucket_width[b] > 1) rank += next_random() % bucket_width[b];
+        if (kind == Kind::HotSpot) {
+            rank = (rank + static_cast<uint64_t>(elapsed_ns * shift_per_ns)) % blocks;
+        }
+        return scatter(rank);
+    }
+
+    // Fewest blocks that receive `share` (0-1) of all accesses: the effective working set
+    uint64_t blocks_for_share(double share) const {
+        double acc = 0;
+        uint64_t covered = 0;
+        for (size_t b = 0; b < bucket_lo.size(); b++) {
+            if (acc + bucket_p[b] >= share) {
+                double need = (share - acc) / bucket_p[b];
+                return covered + static_cast<uint64_t>(std::ceil(need * bucket_width[b]));
+            }
+            acc += bucket_p[b];
+            covered += bucket_width[b];
+        }
+        return blocks;
+    }
+
+    Kind distribution_kind() const { return kind; }
+
+private:
+    struct AliasEntry {
+        uint32_t threshold;     // Keep this bucket if the low 32 random bits are below
+        uint32_t alias;
+    };
+
+    static constexpr uint64_t kExactHead = 1 << 18;
+    static constexpr double kTailGrowth = 1.0 / 256;
+
+    Kind kind = Kind::Uniform;
+    uint64_t blocks = 0;
+    double shift_per_ns = 0;
+    uint64_t multiplier = 1;
+    uint64_t addend = 0;
+    std::vector<uint64_t> bucket_lo;
+    std::vector<uint64_t> bucket_width;
+    std::vector<double> bucket_p;  // Normalized by build_alias()
+    std::vector<AliasEntry> table;
+
+    static bool valid_hot(double fraction, double probability) {
+        return fraction > 0 && fraction < 1 && probability >= 0 && probability <= 1;
+    }
+
+    void add_bucket(uint64_t lo, uint64_t hi, double weight) {
+        bucket_lo.push_back(lo);
+        bucket_width.push_back(hi - lo);
+        bucket_p.push_back(weight);
+    }
+
+    // Zipf: weight of [lo, hi) = sum (r+1)^-theta, exact for single ranks, midpoint integral otherwise.
+    // Pareto: weight of [lo, hi) = (lo+1)^-alpha - (hi+1)^-alpha, exact.
+    void build_power_law(double exponent) {
+        auto weight = [&](uint64_t lo, uint64_t hi) {
+            if (kind == Kind::Pareto) {
+                return std::pow(lo + 1.0, -exponent) - std::pow(hi + 1.0, -exponent);
+            }
+            if (hi - lo == 1) return std::pow(lo + 1.0, -exponent);
+            double a = lo + 0.5, b = hi + 0.5;
+            if (std::fabs(exponent - 1) < 1e-9) return std::log(b / a);
+            return (std::pow(b, 1 - exponent) - std::pow(a, 1 - exponent)) / (1 - exponent);
+        };
+        uint64_t head = std::min(blocks, kExactHead);
+        for (uint64_t r = 0; r < head; r++) add_bucket(r, r + 1, weight(r, r + 1));
+        for (uint64_t lo = head; lo < blocks;) {
+            uint64_t hi = std::min(blocks, lo + std::max<uint64_t>(1, static_cast<uint64_t>(lo * kTailGrowth)));
+            add_bucket(lo, hi, weight(lo, hi));
+            lo = hi;
+        }
+    }
+
+    void build_hot(double fraction, double probability) {
+        uint64_t hot = std::max<uint64_t>(1, static_cast<uint64_t>(blocks * fraction));
+        if (hot >= blocks) {
+            add_bucket(0, blocks, 1.0);
+            return;
+        }
+        add_bucket(0, hot, probability);
+        add_bucket(hot, blocks, 1 - probability);
+    }
+
+    // Vose's alias method
+    void build_alias() {
+        double total = std::accumulate(bucket_p.begin(), bucket_p.end(), 0.0);
+        size_t n = bucket_p.size();
+        for (auto& p : bucket_p) p /= total;
+        std::vector<double> scaled(n);
+        std::vector<uint32_t> small, large;
+        for (size_t i = 0; i < n; i++) {
+            scaled[i] = bucket_p[i] * n;
+            (scaled[i] < 1.0 ? small : large).push_back(static_cast<uint32_t>(i));
+        }
+        table.assign(n, AliasEntry{UINT32_MAX, 0});
+        while (!small.empty() && !large.empty()) {
+            uint32_t s = small.back();
+            small.pop_back();
+            uint32_t l = large.back();
+            table[s].threshold = static_cast<uint32_t>(scaled[s] * 4294967296.0);
+            table[s].alias = l;
+            scaled[l] -= 1.0 - scaled[s];
+            if (scaled[l] < 1.0) {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+        // Leftovers are 1.0 up to rounding
+        for (uint32_t i : small) table[i] = AliasEntry{UINT32_MAX, i};
+        for (uint32_t i : large) table[i] = AliasEntry{UINT32_MAX, i};
+    }
+
+    // rank -> (rank * multiplier + addend) mod blocks is a bijection when gcd(multiplier, blocks) == 1
+    void choose_permutation() {
+        if (blocks < 3) return;
+        uint64_t m = static_cast<uint64_t>(blocks * 0.6180339887498949) | 1;
+        while (std::gcd(m, blocks) != 1) m += 2;
+        multiplier = m % blocks;
+        addend = blocks / 3;
+    }
+
+    uint64_t scatter(uint64_t rank) const {
+        if (blocks <= (1ULL << 32)) return (rank * multiplier + addend) % blocks;
+        __extension__ typedef unsigned __int128 uint128;
+        return static_cast<uint64_t>((static_cast<uint128>(rank) * multiplier + addend) % blocks);
+    }
+};
+
+}  // namespace dist
@@ -0,0 +1,269 @@
+// perf_counters.h
+// CPU-side interference counters for the telemetry stream (--perf-counters).
+//
+// Page-cache and I/O counters do not show a tenant losing CPU: cache lines
+// evicted by a neighbour, being switched out, faulting its pages back in, or
+// kswapd burning a core next to it. Per tenant cgroup this opens one
+// cgroup-scoped perf event group on every online CPU (perf_event_open with
+// PERF_FLAG_PID_CGROUP, which counts only while a task of that cgroup runs
+// there):
+//
+//   cycles, instructions, llc_misses   hardware (PERF_COUNT_HW_CACHE_MISSES,
+//                                      the last-level cache on x86)
+//   context_switches, page_faults      software
+//
+// A sample is one read() per CPU of the group's values, summed over CPUs and
+// scaled by time_enabled / time_running when the PMU multiplexed the group.
+// Hardware counters missing in a VM read as 0; the software ones still count.
+//
+// kswapd has no cgroup of its own: KswapdTime sums utime + stime of the
+// kswapd threads from /proc/<pid>/stat into nanoseconds.
+//
+// Cgroup events are CPU-wide, so they need CAP_PERFMON (or CAP_SYS_ADMIN) or
+// kernel.perf_event_paranoid <= 0.
+
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace perf {
+
+struct CounterDef {
+    const char* name;  // Telemetry column
+    uint32_t type;
+    uint64_t config;
+};
+
+inline const std::vector<CounterDef>& counters() {
+    static const std::vector<CounterDef> defs = {
+        {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {"llc_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        {"context_switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+        {"page_faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS}};
+    return defs;
+}
+
+inline const std::vector<const char*>& counter_columns() {
+    static const std::vector<const char*> columns = [] {
+        std::vector<const char*> names;
+        for (const auto& c : counters()) names.push_back(c.name);
+        return names;
+    }();
+    return columns;
+}
+
+inline const std::vector<const char*>& kswapd_columns() {
+    static const std::vector<const char*> columns = {"cpu_ns", "threads"};
+    return columns;
+}
+
+inline int perf_event_open(struct perf_event_attr* attr, int pid, int cpu, int group_fd, unsigned long flags) {
+    return static_cast<int>(syscall(SYS_perf_event_open, attr, pid, cpu, group_fd, flags));
+}
+
+// CPUs of /sys/devices/system/cpu/online ("0-3,8-11")
+inline std::vector<int> online_cpus() {
+    std::vector<int> cpus;
+    FILE* f = fopen("/sys/devices/system/cpu/online", "r");
+    if (!f) return cpus;
+    int lo = 0, hi = 0;
+    char sep = 0;
+    while (fscanf(f, "%d", &lo) == 1) {
+        hi = lo;
+        sep = static_cast<char>(fgetc(f));
+        if (sep == '-') {
+            if (fscanf(f, "%d", &hi) != 1) break;
+            sep = static_cast<char>(fgetc(f));
+        }
+        for (int c = lo; c <= hi; c++) cpus.push_back(c);
+        if (sep != ',') break;
+    }
+    fclose(f);
+    return cpus;
+}
+
+// counters() of one cgroup, one event group per online CPU
+class CgroupCounters {
+public:
+    CgroupCounters() = default;
+    ~CgroupCounters() { close_all(); }
+
+    CgroupCounters(const CgroupCounters&) = delete;
+    CgroupCounters& operator=(const CgroupCounters&) = delete;
+
+    // Counters that cannot be opened (no PMU) are left out and listed in `missing`
+    bool open(const std::string& cgroup_dir, std::string& missing, std::string& error) {
+        cgroup_fd = ::open(cgroup_dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (cgroup_fd < 0) {
+            error = "Cannot open " + cgroup_dir + ": " + strerror(errno);
+            return false;
+        }
+        std::vector<int> cpus = online_cpus();
+        if (cpus.empty()) {
+            error = "Cannot read the online CPUs";
+            return false;
+        }
+        const auto& defs = counters();
+        opened.assign(defs.size(), false);
+        for (size_t cpu = 0; cpu < cpus.size(); cpu++) {
+            std::vector<int> fds;
+            for (size_t i = 0; i < defs.size(); i++) {
+                // The set of counters is settled on the first CPU; the others must open the same
+                if (cpu > 0 && !opened[i]) continue;
+                struct perf_event_attr attr;
+                memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = defs[i].type;
+                attr.config = defs[i].config;
+                attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+                int leader = fds.empty() ? -1 : fds[0];
+                int fd = perf_event_open(&attr, cgroup_fd, cpus[cpu], leader,
+                                         PERF_FLAG_PID_CGROUP | PERF_FLAG_FD_CLOEXEC);
+                if (fd < 0) {
+                    int err = errno;
+                    if (cpu == 0 && (err == ENOENT || err == EOPNOTSUPP || err == EINVAL)) {
+                        missing += (missing.empty() ? "" : ", ") + std::string(defs[i].name);
+                        continue;
+                    }
+                    error = "perf_event_open(" + std::string(defs[i].name) + ", cpu " + std::to_string(cpus[cpu]) +
+                            ") for " + cgroup_dir + ": " + strerror(err);
+                    if (err == EACCES || err == EPERM) {
+                        error += " (needs CAP_PERFMON or kernel.perf_event_paranoid <= 0)";
+                    } else if (err == EBADF) {
+                        error += " (not a cgroup v2 or perf_event cgroup)";
+                    }
+                    for (int f : fds) close(f);
+                    return false;
+                }
+                fds.push_back(fd);
+                if (cpu == 0) opened[i] = true;
+            }
+            if (fds.empty()) {
+                error = "No perf counter can be opened for " + cgroup_dir;
+                return false;
+            }
+            groups.push_back(fds);
+        }
+        for (size_t i = 0; i < defs.size(); i++) {
+            if (opened[i]) slots.push_back(i);
+        }
+        buffer.resize(3 + slots.size());
+        return true;
+    }
+
+    // values[i] for counters()[i], cumulative since open(); unopened counters read as 0
+    bool sample(uint64_t* values) {
+        for (size_t i = 0; i < counters().size(); i++) values[i] = 0;
+        bool any = false;
+        for (const auto& fds : groups) {
+            // nr, time_enabled, time_running, then one value per group member
+            ssize_t n = read(fds[0], buffer.data(), buffer.size() * sizeof(uint64_t));
+            if (n < static_cast<ssize_t>(3 * sizeof(uint64_t)) || buffer[0] != slots.size()) continue;
+            any = true;
+            uint64_t enabled = buffer[1], running = buffer[2];
+            if (running == 0) continue;  // Never scheduled on this CPU
+            for (size_t s = 0; s < slots.size(); s++) {
+                uint64_t v = buffer[3 + s];
+                if (running < enabled) {
+                    v = static_cast<uint64_t>(static_cast<long double>(v) * enabled / running);
+                }
+                values[slots[s]] += v;
+            }
+        }
+        return any;
+    }
+
+private:
+    int cgroup_fd = -1;
+    std::vector<bool> opened;
+    std::vector<size_t> slots;             // Counter index of each group member, in read order
+    std::vector<std::vector<int>> groups;  // Per CPU: leader first
+    std::vector<uint64_t> buffer;
+
+    void close_all() {
+        for (const auto& fds : groups) {
+            for (int fd : fds) close(fd);
+        }
+        groups.clear();
+        if (cgroup_fd >= 0) close(cgroup_fd);
+        cgroup_fd = -1;
+    }
+};
+
+// CPU time of the kswapd threads (one per NUMA node), found once at open()
+class KswapdTime {
+public:
+    KswapdTime() = default;
+    ~KswapdTime() {
+        for (int fd : fds) close(fd);
+    }
+
+    KswapdTime(const KswapdTime&) = delete;
+    KswapdTime& operator=(const KswapdTime&) = delete;
+
+    bool open(std::string& error) {
+        DIR* proc = opendir("/proc");
+        if (!proc) {
+            error = std::string("Cannot open /proc: ") + strerror(errno);
+            return false;
+        }
+        while (struct dirent* e = readdir(proc)) {
+            if (e->d_name[0] < '0' || e->d_name[0] > '9') continue;
+            std::string dir = std::string("/proc/") + e->d_name;
+            char comm[32] = {};
+            int comm_fd = ::open((dir + "/comm").c_str(), O_RDONLY | O_CLOEXEC);
+            if (comm_fd < 0) continue;
+            ssize_t n = read(comm_fd, comm, sizeof(comm) - 1);
+            close(comm_fd);
+            if (n <= 0 || strncmp(comm, "kswapd", 6) != 0) continue;
+            int fd = ::open((dir + "/stat").c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd >= 0) fds.push_back(fd);
+        }
+        closedir(proc);
+        if (fds.empty()) {
+            error = "No kswapd threads found in /proc";
+            return false;
+        }
+        ns_per_tick = 1000000000ULL / static_cast<uint64_t>(sysconf(_SC_CLK_TCK));
+        return true;
+    }
+
+    // values[0] = cpu_ns summed over the threads, values[1] = threads read
+    bool sample(uint64_t* values) {
+        values[0] = values[1] = 0;
+        char buf[512];
+        for (int fd : fds) {
+            ssize_t n = pread(fd, buf, sizeof(buf) - 1, 0);
+            if (n <= 0) continue;
+            buf[n] = '\0';
+            // Fields after "(comm)": state is field 3, utime 14, stime 15
+            const char* p = strrchr(buf, ')');
+            if (!p) continue;
+            unsigned long long utime = 0, stime = 0;
+            if (sscanf(p + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &utime, &stime) != 2) {
+                continue;
+            }
+            values[0] += (utime + stime) * ns_per_tick;
+            values[1]++;
+        }
+        return values[1] > 0;
+    }
+
+private:
+    std::vector<int> fds;
+    uint64_t ns_per_tick = 10000000ULL;
+};
+
+}  // namespace perf
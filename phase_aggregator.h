@@ -0,0 +1,490 @@
+// phase_aggregator.h
+// Streaming aggregation of per-phase fio JSON results.
+//
+// Each phase file is parsed exactly once with a pull parser that reads the
+// file through a fixed 64KB buffer, so memory use is bounded by nesting depth
+// rather than file size. Only the fields the analysis needs are kept: I/O
+// counters, latency moments and the clat_ns percentile table of every job.
+//
+// Phases are combined into one fio-shaped result:
+//   - counters (ios, bytes, runtime) are summed, IOPS/BW recomputed from them
+//   - latency means are weighted by I/O count
+//   - percentile tables are merged as a mixture of the phases' CDFs, each
+//     phase weighted by its I/O count
+// and a per-phase time series is written next to it as CSV.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace results {
+
+struct DirSummary {
+    uint64_t total_ios = 0;
+    uint64_t io_bytes = 0;
+    uint64_t runtime_ms = 0;
+    double iops = 0;
+    double bw_bytes = 0;
+    double lat_mean = 0;
+    double clat_mean = 0;
+    uint64_t clat_min = 0;
+    uint64_t clat_max = 0;
+    double iops_mean = 0;
+    double iops_stddev = 0;
+    uint64_t iops_samples = 0;
+    std::map<double, double> percentiles;  // percentile -> ns
+};
+
+struct PhaseSummary {
+    std::string source;
+    DirSummary dir[2];  // [0] = read, [1] = write
+};
+
+// ---------------------------------------------------------------------------
+// Minimal streaming JSON reader
+// ---------------------------------------------------------------------------
+
+class JsonReader {
+public:
+    explicit JsonReader(FILE* f) : file(f) {}
+
+    int peek() {
+        if (pos == len && !fill()) return EOF;
+        return static_cast<unsigned char>(buffer[pos]);
+    }
+
+    int get() {
+        int c = peek();
+        if (c != EOF) pos++;
+        return c;
+    }
+
+    void skip_ws() {
+        while (true) {
+            int c = peek();
+            if (c == ' ' || c == '\n' || c == '\r' || c == '\t') get();
+            else break;
+        }
+    }
+
+    // Skip anything fio printed around the JSON (warnings, banners)
+    bool seek_object() {
+        int c;
+        while ((c = peek()) != EOF && c != '{') get();
+        return c == '{';
+    }
+
+    bool read_string(std::string& out) {
+        out.clear();
+        if (get() != '"') return false;
+        while (true) {
+            int c = get();
+            if (c == EOF) return false;
+            if (c == '"') return true;
+            if (c == '\\') {
+                int e = get();
+                if (e == 'u') {
+                    for (int i = 0; i < 4; i++) get();  // Keys we care about are ASCII
+                    out.push_back('?');
+                } else if (e == 'n') out.push_back('\n');
+                else if (e == 't') out.push_back('\t');
+                else if (e != EOF) out.push_back(static_cast<char>(e));
+                continue;
+            }
+            out.push_back(static_cast<char>(c));
+        }
+    }
+
+    bool read_number(double& out) {
+        char num[64];
+        size_t n = 0;
+        while (n + 1 < sizeof(num)) {
+            int c = peek();
+            if ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E') {
+                num[n++] = static_cast<char>(get());
+            } else {
+                break;
+            }
+        }
+        num[n] = '\0';
+        if (n == 0) return false;
+        out = strtod(num, nullptr);
+        return true;
+    }
+
+    bool expect_literal(const char* lit) {
+        for (const char* p = lit; *p; p++) {
+            if (get() != *p) return false;
+        }
+        return true;
+    }
+
+private:
+    FILE* file;
+    char buffer[65536];
+    size_t pos = 0;
+    size_t len = 0;
+
+    bool fill() {
+        len = fread(buffer, 1, sizeof(buffer), file);
+        pos = 0;
+        return len > 0;
+    }
+};
+
+// Walks one top-level fio object, keeping only what PhaseSummary needs
+class FioJsonParser {
+public:
+    explicit FioJsonParser(JsonReader& r) : reader(r) {}
+
+    bool parse(std::vector<PhaseSummary>& jobs_out) {
+        jobs = &jobs_out;
+        path.clear();
+        return parse_value();
+    }
+
+private:
+    JsonReader& reader;
+    std::vector<std::string> path;
+    std::vector<PhaseSummary>* jobs = nullptr;
+    std::string scratch;
+
+    bool parse_value() {
+        reader.skip_ws();
+        int c = reader.peek();
+        if (c == '{') return parse_object();
+        if (c == '[') return parse_array();
+        if (c == '"') return reader.read_string(scratch);
+        if (c == 't') return reader.expect_literal("true");
+        if (c == 'f') return reader.expect_literal("false");
+        if (c == 'n') return reader.expect_literal("null");
+        double v;
+        if (!reader.read_number(v)) return false;
+        on_number(v);
+        return true;
+    }
+
+    bool parse_object() {
+        reader.get();  // '{'
+        if (path.size() == 2 && path[0] == "jobs") jobs->emplace_back();
+        reader.skip_ws();
+        if (reader.peek() == '}') {
+            reader.get();
+            return true;
+        }
+        while (true) {
+            reader.skip_ws();
+            std::string key;
+            if (!reader.read_string(key)) return false;
+            reader.skip_ws();
+            if (reader.get() != ':') return false;
+            path.push_back(key);
+            bool ok = parse_value();
+            path.pop_back();
+            if (!ok) return false;
+            reader.skip_ws();
+            int c = reader.get();
+            if (c == '}') return true;
+            if (c != ',') return false;
+        }
+    }
+
+    bool parse_array() {
+        reader.get();  // '['
+        path.push_back("[]");
+        reader.skip_ws();
+        if (reader.peek() == ']') {
+            reader.get();
+            path.pop_back();
+            return true;
+        }
+        while (true) {
+            if (!parse_value()) return false;
+            reader.skip_ws();
+            int c = reader.get();
+            if (c == ']') break;
+            if (c != ',') return false;
+        }
+        path.pop_back();
+        return true;
+    }
+
+    // path: jobs / [] / read|write / field [/ sub [/ percentile key]]
+    void on_number(double v) {
+        if (path.size() < 4 || path[0] != "jobs" || jobs->empty()) return;
+        int d;
+        if (path[2] == "read") d = 0;
+        else if (path[2] == "write") d = 1;
+        else return;
+        DirSummary& ds = jobs->back().dir[d];
+        const std::string& field = path[3];
+
+        if (path.size() == 4) {
+            if (field == "total_ios") ds.total_ios = static_cast<uint64_t>(v);
+            else if (field == "io_bytes") ds.io_bytes = static_cast<uint64_t>(v);
+            else if (field == "runtime") ds.runtime_ms = static_cast<uint64_t>(v);
+            else if (field == "iops") ds.iops = v;
+            else if (field == "bw_bytes") ds.bw_bytes = v;
+            else if (field == "iops_mean") ds.iops_mean = v;
+            else if (field == "iops_stddev") ds.iops_stddev = v;
+            else if (field == "iops_samples") ds.iops_samples = static_cast<uint64_t>(v);
+        } else if (path.size() == 5 && field == "lat_ns" && path[4] == "mean") {
+            ds.lat_mean = v;
+        } else if (path.size() == 5 && field == "clat_ns") {
+            if (path[4] == "mean") ds.clat_mean = v;
+            else if (path[4] == "min") ds.clat_min = static_cast<uint64_t>(v);
+            else if (path[4] == "max") ds.clat_max = static_cast<uint64_t>(v);
+        } else if (path.size() == 6 && field == "clat_ns" && path[4] == "percentile") {
+            ds.percentiles[strtod(path[5].c_str(), nullptr)] = v;
+        }
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Merging
+// ---------------------------------------------------------------------------
+
+// Fraction (0-100) of a percentile table at or below value, linear between points
+inline double cdf_at(const std::map<double, double>& table, double value) {
+    double prev_p = 0, prev_v = 0;
+    bool first = true;
+    for (const auto& [p, v] : table) {
+        if (value < v) {
+            if (first) return 0;
+            if (v == prev_v) return p;
+            return prev_p + (p - prev_p) * (value - prev_v) / (v - prev_v);
+        }
+        prev_p = p;
+        prev_v = v;
+        first = false;
+    }
+    return first ? 0 : 100;
+}
+
+// Merge percentile tables weighted by I/O count (mixture of CDFs)
+inline std::map<double, double> merge_percentiles(const std::vector<const DirSummary*>& parts) {
+    std::map<double, double> merged;
+    uint64_t total = 0;
+    std::vector<double> candidates;
+    std::vector<double> wanted;
+    for (const auto* ds : parts) {
+        if (ds->total_ios == 0 || ds->percentiles.empty()) continue;
+        total += ds->total_ios;
+        for (const auto& [p, v] : ds->percentiles) {
+            candidates.push_back(v);
+            wanted.push_back(p);
+        }
+    }
+    if (total == 0) return merged;
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    std::sort(wanted.begin(), wanted.end());
+    wanted.erase(std::unique(wanted.begin(), wanted.end()), wanted.end());
+
+    std::vector<double> cdf(candidates.size(), 0);
+    for (size_t i = 0; i < candidates.size(); i++) {
+        for (const auto* ds : parts) {
+            if (ds->total_ios == 0 || ds->percentiles.empty()) continue;
+            cdf[i] += cdf_at(ds->percentiles, candidates[i]) * ds->total_ios;
+        }
+        cdf[i] /= total;
+    }
+
+    for (double q : wanted) {
+        size_t i = 0;
+        while (i < cdf.size() && cdf[i] < q) i++;
+        double v;
+        if (i == cdf.size()) v = candidates.back();
+        else if (i == 0 || cdf[i] == cdf[i - 1]) v = candidates[i];
+        else {
+            v = candidates[i - 1] + (candidates[i] - candidates[i - 1]) *
+                (q - cdf[i - 1]) / (cdf[i] - cdf[i - 1]);
+        }
+        merged[q] = std::round(v);
+    }
+    return merged;
+}
+
+// concurrent = jobs that ran side by side (runtime overlaps); otherwise sequential phases
+inline DirSummary merge_dirs(const std::vector<const DirSummary*>& parts, bool concurrent) {
+    DirSummary out;
+    double lat_weighted = 0, clat_weighted = 0;
+    double sample_sq = 0, sample_sum = 0;
+    bool have_min = false;
+    for (const auto* ds : parts) {
+        out.total_ios += ds->total_ios;
+        out.io_bytes += ds->io_bytes;
+        out.runtime_ms = concurrent ? std::max(out.runtime_ms, ds->runtime_ms) : out.runtime_ms + ds->runtime_ms;
+        lat_weighted += ds->lat_mean * ds->total_ios;
+        clat_weighted += ds->clat_mean * ds->total_ios;
+        if (ds->total_ios > 0) {
+            out.clat_min = have_min ? std::min(out.clat_min, ds->clat_min) : ds->clat_min;
+            have_min = true;
+        }
+        out.clat_max = std::max(out.clat_max, ds->clat_max);
+        if (concurrent) {
+            out.iops_mean += ds->iops_mean;
+            out.iops_stddev = std::sqrt(out.iops_stddev * out.iops_stddev + ds->iops_stddev * ds->iops_stddev);
+            out.iops_samples = std::max(out.iops_samples, ds->iops_samples);
+        } else {
+            // Pool per-second samples: E[x^2] of each phase = var + mean^2
+            sample_sum += ds->iops_mean * ds->iops_samples;
+            sample_sq += (ds->iops_stddev * ds->iops_stddev + ds->iops_mean * ds->iops_mean) * ds->iops_samples;
+            out.iops_samples += ds->iops_samples;
+        }
+    }
+    if (!concurrent && out.iops_samples > 0) {
+        out.iops_mean = sample_sum / out.iops_samples;
+        out.iops_stddev = std::sqrt(std::max(0.0, sample_sq / out.iops_samples - out.iops_mean * out.iops_mean));
+    }
+    if (out.total_ios > 0) {
+        out.lat_mean = lat_weighted / out.total_ios;
+        out.clat_mean = clat_weighted / out.total_ios;
+    }
+    if (out.runtime_ms > 0) {
+        out.iops = out.total_ios * 1000.0 / out.runtime_ms;
+        out.bw_bytes = out.io_bytes * 1000.0 / out.runtime_ms;
+    }
+    out.percentiles = merge_percentiles(parts);
+    return out;
+}
+
+// Parse one fio JSON file; with several appended objects the last one wins (as fio status output does)
+inline bool parse_fio_json(const std::string& path, PhaseSummary& out, std::string& error) {
+    FILE* f = fopen(path.c_str(), "r");
+    if (!f) {
+        error = "Cannot open " + path;
+        return false;
+    }
+    JsonReader reader(f);
+    std::vector<PhaseSummary> jobs;
+    bool found = false;
+    while (reader.seek_object()) {
+        std::vector<PhaseSummary> candidate;
+        FioJsonParser parser(reader);
+        if (!parser.parse(candidate)) break;
+        if (!candidate.empty()) {
+            jobs = std::move(candidate);
+            found = true;
+        }
+    }
+    fclose(f);
+    if (!found) {
+        error = "No fio job results in " + path;
+        return false;
+    }
+
+    // Jobs inside one result ran concurrently (no group_reporting)
+    out.source = path;
+    for (int d = 0; d < 2; d++) {
+        std::vector<const DirSummary*> parts;
+        for (const auto& j : jobs) parts.push_back(&j.dir[d]);
+        out.dir[d] = merge_dirs(parts, true);
+    }
+    return true;
+}
+
+inline PhaseSummary merge_phases(const std::vector<PhaseSummary>& phases) {
+    PhaseSummary out;
+    for (int d = 0; d < 2; d++) {
+        std::vector<const DirSummary*> parts;
+        for (const auto& p : phases) parts.push_back(&p.dir[d]);
+        out.dir[d] = merge_dirs(parts, false);
+    }
+    return out;
+}
+
+// ---------------------------------------------------------------------------
+// Output
+// ---------------------------------------------------------------------------
+
+inline void write_dir_json(std::ostream& out, const char* key, const DirSummary& ds) {
+    out << "      \"" << key << "\" : {\n"
+        << "        \"io_bytes\" : " << ds.io_bytes << ",\n"
+        << "        \"bw_bytes\" : " << static_cast<uint64_t>(ds.bw_bytes) << ",\n"
+        << "        \"iops\" : " << ds.iops << ",\n"
+        << "        \"runtime\" : " << ds.runtime_ms << ",\n"
+        << "        \"total_ios\" : " << ds.total_ios << ",\n"
+        << "        \"clat_ns\" : {\n"
+        << "          \"min\" : " << ds.clat_min << ",\n"
+        << "          \"max\" : " << ds.clat_max << ",\n"
+        << "          \"mean\" : " << ds.clat_mean;
+    if (!ds.percentiles.empty()) {
+        out << ",\n          \"percentile\" : {\n";
+        size_t i = 0;
+        for (const auto& [p, v] : ds.percentiles) {
+            out << "            \"" << p << "\" : " << static_cast<uint64_t>(v)
+                << (++i < ds.percentiles.size() ? ",\n" : "\n");
+        }
+        out << "          }";
+    }
+    out << "\n        },\n"
+        << "        \"lat_ns\" : {\n"
+        << "          \"mean\" : " << ds.lat_mean << "\n"
+        << "        },\n"
+        << "        \"iops_mean\" : " << ds.iops_mean << ",\n"
+        << "        \"iops_stddev\" : " << ds.iops_stddev << ",\n"
+        << "        \"iops_samples\" : " << ds.iops_samples << "\n"
+        << "      }";
+}
+
+inline bool write_combined_json(const std::string& path, const std::string& jobname,
+                                const PhaseSummary& combined, size_t num_phases) {
+    std::ofstream out(path);
+    if (!out.is_open()) return false;
+    out << std::fixed << std::setprecision(6);
+    out << "{\n"
+        << "  \"fio version\" : \"phase-aggregator\",\n"
+        << "  \"phases\" : " << num_phases << ",\n"
+        << "  \"jobs\" : [\n"
+        << "    {\n"
+        << "      \"jobname\" : \"" << jobname << "\",\n";
+    write_dir_json(out, "read", combined.dir[0]);
+    out << ",\n";
+    write_dir_json(out, "write", combined.dir[1]);
+    out << "\n    }\n  ]\n}\n";
+    return true;
+}
+
+inline double percentile_or_zero(const DirSummary& ds, double p) {
+    auto it = ds.percentiles.find(p);
+    return it == ds.percentiles.end() ? 0 : it->second;
+}
+
+// One row per phase; start_s is the phase's offset from the start of the workload
+inline bool write_phase_series(const std::string& path, const std::vector<int>& phase_numbers,
+                               const std::vector<PhaseSummary>& phases) {
+    std::ofstream out(path);
+    if (!out.is_open()) return false;
+    out << "phase,start_s,runtime_s,"
+        << "read_iops,read_bw_bytes,read_lat_mean_ns,read_p50_ns,read_p99_ns,read_p999_ns,read_max_ns,"
+        << "write_iops,write_bw_bytes,write_lat_mean_ns,write_p50_ns,write_p99_ns,write_p999_ns,write_max_ns\n";
+    out << std::fixed << std::setprecision(3);
+    double start = 0;
+    for (size_t i = 0; i < phases.size(); i++) {
+        const auto& p = phases[i];
+        double runtime = std::max(p.dir[0].runtime_ms, p.dir[1].runtime_ms) / 1000.0;
+        out << phase_numbers[i] << "," << start << "," << runtime;
+        for (int d = 0; d < 2; d++) {
+            const DirSummary& ds = p.dir[d];
+            out << "," << ds.iops << "," << ds.bw_bytes << "," << ds.lat_mean
+                << "," << percentile_or_zero(ds, 50) << "," << percentile_or_zero(ds, 99)
+                << "," << percentile_or_zero(ds, 99.9) << "," << ds.clat_max;
+        }
+        out << "\n";
+        start += runtime;
+    }
+    return true;
+}
+
+}  // namespace results
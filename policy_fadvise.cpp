@@ -0,0 +1,167 @@
+// policy_fadvise.cpp
+// Example cache policy plugin (policy_plugin.h): userspace hints instead of kernel changes.
+//
+//   dontneed=TENANT[,TENANT]   Drop the tenant's test file pages from the cache
+//                              (POSIX_FADV_DONTNEED) whenever its cgroup's file
+//                              pages exceed dontneed_above. Meant for scanners: their
+//                              pages are rarely read twice, so dropping them behind
+//                              the scan leaves the cache to everyone else.
+//   dontneed_above=SIZE        Threshold of memory.stat "file" (default 0: on every
+//                              sample; without a cgroup, on every sample as well)
+//   mlock=TENANT:SIZE          Pin the first SIZE bytes of each of the tenant's files
+//                              (its hot set under a zipf distribution) with mlock for
+//                              the run. Needs RLIMIT_MEMLOCK or CAP_IPC_LOCK.
+//
+// e.g. args = dontneed=client2_bursty dontneed_above=256M mlock=client1_steady:512M
+//
+// Build: make policies
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "policy_plugin.h"
+
+namespace {
+
+uint64_t parse_size(const std::string& s) {
+    if (s.empty()) return 0;
+    char* end = nullptr;
+    uint64_t v = std::strtoull(s.c_str(), &end, 10);
+    switch (*end) {
+    case 'k': case 'K': return v << 10;
+    case 'm': case 'M': return v << 20;
+    case 'g': case 'G': return v << 30;
+    default: return v;
+    }
+}
+
+struct Pinned {
+    void* addr;
+    size_t len;
+};
+
+struct Policy {
+    void (*log)(const char*);
+    std::set<std::string> dontneed;
+    uint64_t dontneed_above = 0;
+    std::map<std::string, uint64_t> mlock_bytes;
+    std::map<std::string, std::vector<std::string>> files;
+    std::map<std::string, bool> has_cgroup;
+    std::map<std::string, uint64_t> drops;
+    std::map<std::string, std::vector<Pinned>> pinned;
+    uint64_t page_size = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+
+    void say(const std::string& message) { log(message.c_str()); }
+
+    void drop(const std::string& tenant) {
+        for (const auto& f : files[tenant]) {
+            int fd = open(f.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) continue;
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            close(fd);
+        }
+        drops[tenant]++;
+    }
+
+    void pin(const std::string& tenant, uint64_t bytes) {
+        for (const auto& f : files[tenant]) {
+            int fd = open(f.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) continue;
+            struct stat st;
+            size_t len = fstat(fd, &st) == 0 ? std::min<uint64_t>(bytes, static_cast<uint64_t>(st.st_size)) : 0;
+            void* addr = len ? mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+            close(fd);
+            if (addr == MAP_FAILED) continue;
+            if (mlock(addr, len) != 0) {
+                say("cannot mlock " + std::to_string(len >> 20) + "MB of " + f + ": " + strerror(errno));
+                munmap(addr, len);
+                continue;
+            }
+            pinned[tenant].push_back({addr, len});
+            say("pinned the first " + std::to_string(len >> 20) + "MB of " + f + " for " + tenant);
+        }
+    }
+};
+
+void* create(const char* args, void (*log)(const char*)) {
+    auto* p = new Policy();
+    p->log = log;
+    std::istringstream in(args ? args : "");
+    std::string word;
+    while (in >> word) {
+        size_t eq = word.find('=');
+        std::string key = word.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : word.substr(eq + 1);
+        if (key == "dontneed") {
+            std::istringstream names(value);
+            std::string name;
+            while (std::getline(names, name, ',')) p->dontneed.insert(name);
+        } else if (key == "dontneed_above") {
+            p->dontneed_above = parse_size(value);
+        } else if (key == "mlock" && value.find(':') != std::string::npos) {
+            p->mlock_bytes[value.substr(0, value.find(':'))] = parse_size(value.substr(value.find(':') + 1));
+        } else {
+            log(("unknown argument '" + word + "'").c_str());
+            delete p;
+            return nullptr;
+        }
+    }
+    return p;
+}
+
+void tenant_start(void* self, const fb_policy_tenant* tenant) {
+    auto* p = static_cast<Policy*>(self);
+    std::string name = tenant->name;
+    for (size_t i = 0; i < tenant->nfiles; i++) p->files[name].push_back(tenant->files[i]);
+    p->has_cgroup[name] = tenant->cgroup_dir[0] != '\0';
+    auto it = p->mlock_bytes.find(name);
+    if (it != p->mlock_bytes.end()) p->pin(name, it->second);
+}
+
+void sample(void* self, const fb_policy_sample* s) {
+    auto* p = static_cast<Policy*>(self);
+    std::string source = s->source;
+    if (source == "system") {
+        // Tenants without a cgroup have no memory.stat of their own: act on the system tick
+        for (const auto& name : p->dontneed) {
+            if (!p->has_cgroup[name] && p->files.count(name)) p->drop(name);
+        }
+        return;
+    }
+    if (!p->dontneed.count(source)) return;
+    uint64_t file_bytes = 0;
+    for (size_t i = 0; i < s->ncols; i++) {
+        if (strcmp(s->columns[i], "file") == 0) file_bytes = s->values[i];
+    }
+    if (file_bytes >= p->dontneed_above) p->drop(source);
+}
+
+void tenant_stop(void* self, const char* name) {
+    auto* p = static_cast<Policy*>(self);
+    if (p->drops.count(name)) p->say(std::string(name) + ": dropped its pages " + std::to_string(p->drops[name]) + " times");
+    for (const auto& pin : p->pinned[name]) {
+        munlock(pin.addr, pin.len);
+        munmap(pin.addr, pin.len);
+    }
+    p->pinned.erase(name);
+}
+
+void destroy(void* self) { delete static_cast<Policy*>(self); }
+
+const fb_policy_plugin kPlugin = {FB_POLICY_ABI_VERSION, "fadvise", create, tenant_start, sample, nullptr,
+                                  tenant_stop, destroy};
+
+}  // namespace
+
+extern "C" const fb_policy_plugin* fb_policy_entry(void) { return &kPlugin; }
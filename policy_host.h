@@ -0,0 +1,291 @@
+// policy_host.h
+// Runs the [policy] of the cgroup config alongside a concurrent run.
+//
+//   plugin = PATH.so   dlopen()ed and called back with the run's telemetry
+//                      (policy_plugin.h): vmstat and each tenant's memory.stat
+//                      every interval_ms, and the PSI trigger events.
+//   exec = COMMAND     started with `sh -c` once the tenants are spawned; its
+//                      process group gets SIGTERM when they finish. E.g. a
+//                      loader that attaches a cache_ext eviction policy to the
+//                      tenants' cgroups. It finds the run in its environment:
+//                        FB_POLICY_TENANTS  name=cgroup_dir, one per tenant
+//                        FB_POLICY_FILES    name=test_file, one per file
+//                        FB_POLICY_ARGS     the section's args
+//                      (space separated lists).
+//
+// Both can be set. Policies are the experiment's variable, so one that fails
+// to load fails the run instead of quietly running without it.
+
+#pragma once
+
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dlfcn.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "policy_plugin.h"
+#include "psi_monitor.h"
+#include "telemetry_sampler.h"
+
+namespace policy {
+
+struct Spec {
+    std::string plugin;     // Shared object implementing policy_plugin.h
+    std::string exec;       // External policy process
+    std::string args;       // Passed to create() and as FB_POLICY_ARGS
+    int interval_ms = 1000; // Telemetry callback period
+
+    bool enabled() const { return !plugin.empty() || !exec.empty(); }
+};
+
+// The [policy] section's settings; false with `error` on an unknown key or a bad interval
+inline bool parse_spec(const std::map<std::string, std::string>& settings, Spec& out, std::string& error) {
+    out = Spec();
+    for (const auto& [key, value] : settings) {
+        if (key == "plugin") out.plugin = value;
+        else if (key == "exec") out.exec = value;
+        else if (key == "args") out.args = value;
+        else if (key == "interval_ms") out.interval_ms = std::atoi(value.c_str());
+        else {
+            error = "[policy] unknown key '" + key + "' (plugin, exec, args, interval_ms)";
+            return false;
+        }
+    }
+    if (out.interval_ms <= 0) {
+        error = "[policy] interval_ms must be positive";
+        return false;
+    }
+    if (!out.enabled()) {
+        error = "[policy] needs plugin = PATH.so or exec = COMMAND";
+        return false;
+    }
+    return true;
+}
+
+struct Tenant {
+    std::string name;
+    std::string cgroup;
+    std::string cgroup_dir;  // Empty without cgroups
+    std::vector<std::string> files;
+};
+
+class Host {
+public:
+    using Logger = std::function<void(const std::string&)>;
+
+    Host() = default;
+    ~Host() { stop(); }
+
+    Host(const Host&) = delete;
+    Host& operator=(const Host&) = delete;
+
+    // Load the plugin, announce the tenants and start the callbacks (and the exec'd process).
+    // Subscribes to `psi` if given: clear its subscribers before stop().
+    bool start(const Spec& spec, const std::vector<Tenant>& run_tenants, psi::PsiMonitor* psi, Logger logger,
+               std::string& error) {
+        log = std::move(logger);
+        tenants = run_tenants;
+        if (!spec.plugin.empty() && !load(spec, error)) return false;
+        if (!spec.exec.empty() && !spawn(spec, error)) {
+            stop();
+            return false;
+        }
+        if (!plugin) return true;
+
+        for (const auto& t : tenants) {
+            std::vector<const char*> files;
+            for (const auto& f : t.files) files.push_back(f.c_str());
+            fb_policy_tenant info{t.name.c_str(), t.cgroup.c_str(), t.cgroup_dir.c_str(), files.data(), files.size()};
+            std::lock_guard<std::mutex> lock(callback_mutex);
+            if (plugin->tenant_start) plugin->tenant_start(self, &info);
+        }
+
+        // The sampler's counters, read on this host's own thread
+        std::string open_error;
+        auto vmstat = std::make_unique<telemetry::StatFile>("/proc/vmstat", telemetry::vmstat_columns());
+        if (vmstat->open_file(open_error)) sources.push_back({"system", std::move(vmstat)});
+        for (const auto& t : tenants) {
+            if (t.cgroup_dir.empty()) continue;
+            auto stat = std::make_unique<telemetry::StatFile>(t.cgroup_dir + "/memory.stat",
+                                                              telemetry::memory_stat_columns());
+            if (stat->open_file(open_error)) sources.push_back({t.name, std::move(stat)});
+        }
+        if (psi) {
+            psi->subscribe([this](const psi::PsiEvent& e) {
+                std::lock_guard<std::mutex> lock(callback_mutex);
+                if (!plugin || !plugin->psi_event || stopping) return;
+                fb_policy_psi event{e.timestamp_ns, e.target.c_str(), psi::resource_name(e.resource),
+                                    e.kind == psi::kFull ? 1 : 0, e.some_total_us, e.full_total_us};
+                plugin->psi_event(self, &event);
+            });
+        }
+        interval_ns = static_cast<uint64_t>(spec.interval_ms) * 1000000ULL;
+        running = true;
+        thread = std::thread([this]() { loop(); });
+        return true;
+    }
+
+    // Tenants are done: stop the callbacks, tenant_stop() and destroy() the instance, end the exec'd process
+    void stop() {
+        if (thread.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(wake_mutex);
+                running = false;
+            }
+            wake.notify_all();
+            thread.join();
+        }
+        if (plugin) {
+            std::lock_guard<std::mutex> lock(callback_mutex);
+            stopping = true;
+            for (const auto& t : tenants) {
+                if (plugin->tenant_stop) plugin->tenant_stop(self, t.name.c_str());
+            }
+            if (plugin->destroy) plugin->destroy(self);
+            plugin = nullptr;
+            self = nullptr;
+        }
+        if (current() == this) current() = nullptr;
+        if (handle) {
+            dlclose(handle);
+            handle = nullptr;
+        }
+        if (child > 0) {
+            kill(-child, SIGTERM);
+            int status = 0;
+            waitpid(child, &status, 0);
+            if (log && WIFEXITED(status) && WEXITSTATUS(status) != 0) {
+                log("WARNING: Policy process exited with status " + std::to_string(WEXITSTATUS(status)));
+            }
+            child = -1;
+        }
+    }
+
+    uint64_t ticks() const { return samples; }
+
+private:
+    struct Source {
+        std::string name;
+        std::unique_ptr<telemetry::StatFile> file;
+    };
+
+    Logger log;
+    std::vector<Tenant> tenants;
+    void* handle = nullptr;
+    const fb_policy_plugin* plugin = nullptr;
+    void* self = nullptr;
+    std::string plugin_name;
+    pid_t child = -1;
+    std::vector<Source> sources;
+    uint64_t interval_ns = 0;
+    uint64_t samples = 0;
+    std::mutex callback_mutex;  // Serializes the plugin's callbacks
+    bool stopping = false;
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+    bool running = false;
+    std::thread thread;
+
+    // The plugin's log() has no context argument: one host runs at a time
+    static Host*& current() {
+        static Host* host = nullptr;
+        return host;
+    }
+    static void plugin_log(const char* message) {
+        Host* host = current();
+        if (host && host->log) host->log("  Policy " + host->plugin_name + ": " + message);
+    }
+
+    bool load(const Spec& spec, std::string& error) {
+        handle = dlopen(spec.plugin.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (!handle) {
+            error = "Cannot load policy plugin " + spec.plugin + ": " + dlerror();
+            return false;
+        }
+        using Entry = const fb_policy_plugin* (*)();
+        auto entry = reinterpret_cast<Entry>(dlsym(handle, "fb_policy_entry"));
+        const fb_policy_plugin* table = entry ? entry() : nullptr;
+        if (!table || table->abi_version != FB_POLICY_ABI_VERSION || !table->create) {
+            error = "Policy plugin " + spec.plugin + " does not export fb_policy_entry() for ABI version " +
+                    std::to_string(FB_POLICY_ABI_VERSION);
+            stop();
+            return false;
+        }
+        plugin_name = table->name ? table->name : spec.plugin;
+        current() = this;
+        self = table->create(spec.args.c_str(), &Host::plugin_log);
+        if (!self) {
+            error = "Policy plugin " + plugin_name + " rejected args '" + spec.args + "'";
+            stop();
+            return false;
+        }
+        plugin = table;
+        return true;
+    }
+
+    bool spawn(const Spec& spec, std::string& error) {
+        std::string tenant_list, file_list;
+        for (const auto& t : tenants) {
+            tenant_list += (tenant_list.empty() ? "" : " ") + t.name + "=" + t.cgroup_dir;
+            for (const auto& f : t.files) file_list += (file_list.empty() ? "" : " ") + t.name + "=" + f;
+        }
+        child = fork();
+        if (child < 0) {
+            error = std::string("Cannot start policy process: ") + strerror(errno);
+            return false;
+        }
+        if (child == 0) {
+            setpgid(0, 0);  // Its own group, so stop() reaches whatever the command started
+            setenv("FB_POLICY_TENANTS", tenant_list.c_str(), 1);
+            setenv("FB_POLICY_FILES", file_list.c_str(), 1);
+            setenv("FB_POLICY_ARGS", spec.args.c_str(), 1);
+            execl("/bin/sh", "sh", "-c", spec.exec.c_str(), nullptr);
+            _exit(127);
+        }
+        return true;
+    }
+
+    void loop() {
+        uint64_t next = latency::monotonic_ns() + interval_ns;
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        while (running) {
+            auto deadline = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(next));
+            if (wake.wait_until(lock, deadline, [this]() { return !running; })) break;
+            lock.unlock();
+            sample_all();
+            next += interval_ns;
+            uint64_t now = latency::monotonic_ns();
+            if (next <= now) next = now + interval_ns;
+            lock.lock();
+        }
+    }
+
+    void sample_all() {
+        uint64_t values[telemetry::kMaxColumns];
+        std::lock_guard<std::mutex> lock(callback_mutex);
+        if (!plugin->sample) return;
+        for (const auto& s : sources) {
+            if (!s.file->sample(values)) continue;
+            uint64_t now = latency::monotonic_ns();
+            fb_policy_sample sample{now, s.name.c_str(), s.file->key_names().data(), values, s.file->num_keys()};
+            plugin->sample(self, &sample);
+        }
+        samples++;
+    }
+};
+
+}  // namespace policy
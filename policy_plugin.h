@@ -0,0 +1,83 @@
+// policy_plugin.h
+// ABI between the benchmark and a cache policy plugin (a shared object).
+//
+// A [policy] section of the cgroup config names the plugin:
+//
+//   [policy]
+//   plugin = ./policy_fadvise.so
+//   args = dontneed=client2_bursty mlock=client1_steady:256M
+//   interval_ms = 500
+//
+// For every concurrent run (dual, multi; once per cache mode) the benchmark
+// dlopen()s the plugin, calls fb_policy_entry() for its function table and
+// create()s an instance with `args`. Each tenant is announced with
+// tenant_start() once it has been spawned. From then on, every interval_ms
+// the plugin gets sample() calls with the system's /proc/vmstat and each
+// tenant's memory.stat, and psi_event() calls for the run's PSI triggers.
+// tenant_stop() follows when the tenants have finished, then destroy().
+//
+// Callbacks are serialized (never two at once) and run on the benchmark's
+// policy thread, so they must return quickly. A plugin acts on the tenants
+// directly: posix_fadvise() or mlock() on their files, writes to their
+// cgroup, or loading a cache_ext program for their cgroup.
+//
+// A policy that lives outside the process (a cache_ext or other BPF loader)
+// is named with `exec = COMMAND` instead; see policy_host.h.
+//
+// Plain C, so plugins can be written in C or C++ (build with
+// `make policies`).
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FB_POLICY_ABI_VERSION 1
+
+struct fb_policy_tenant {
+    const char* name;           // Tenant label, e.g. client1 or victim_2
+    const char* cgroup;         // Its key in the cgroup config (PSI targets use it)
+    const char* cgroup_dir;     // cgroupfs directory, "" when running without cgroups
+    const char* const* files;   // Test files the tenant reads and writes
+    size_t nfiles;
+};
+
+struct fb_policy_sample {
+    uint64_t timestamp_ns;      // CLOCK_MONOTONIC, same clock as the latency windows
+    const char* source;         // "system" (vmstat) or a tenant name (its memory.stat)
+    const char* const* columns; // Counter names, e.g. "file", "workingset_refault_file"
+    const uint64_t* values;
+    size_t ncols;
+};
+
+struct fb_policy_psi {
+    uint64_t timestamp_ns;
+    const char* target;         // "system" or a tenant's cgroup key
+    const char* resource;       // "memory" or "io"
+    int full;                   // 1 for a full-stall trigger, 0 for some
+    uint64_t some_total_us;
+    uint64_t full_total_us;
+};
+
+struct fb_policy_plugin {
+    uint32_t abi_version;       // FB_POLICY_ABI_VERSION
+    const char* name;
+    // NULL fails the run's policy; log() prints a line to the benchmark log
+    void* (*create)(const char* args, void (*log)(const char* message));
+    void (*tenant_start)(void* self, const struct fb_policy_tenant* tenant);
+    void (*sample)(void* self, const struct fb_policy_sample* sample);
+    void (*psi_event)(void* self, const struct fb_policy_psi* event);
+    void (*tenant_stop)(void* self, const char* name);
+    void (*destroy)(void* self);
+};
+
+// Every plugin exports this; any callback but create may be NULL
+const struct fb_policy_plugin* fb_policy_entry(void);
+
+#ifdef __cplusplus
+}
+#endif
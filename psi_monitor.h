@@ -0,0 +1,251 @@
+// psi_monitor.h
+// Event-driven pressure stall (PSI) monitoring.
+//
+// For every watched cgroup (and the system, via /proc/pressure) a "some" and
+// a "full" trigger is registered on memory.pressure and io.pressure: writing
+// "<some|full> <threshold_us> <window_us>" to the file arms it, and the kernel
+// then raises EPOLLPRI on that descriptor whenever stall time within a window
+// crosses the threshold. One thread blocks in epoll_wait on all triggers, so
+// a 50ms stall is seen a few milliseconds after the kernel notices it instead
+// of at the next sampling tick.
+//
+// Without CAP_SYS_RESOURCE the kernel only accepts windows that are a
+// multiple of 2s; such triggers are re-armed with the window rounded up and
+// the effective window is reported with each event.
+//
+// Each event is timestamped with latency::monotonic_ns() and handed to every
+// subscriber on the monitor thread; subscribers must return quickly.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "latency_recorder.h"
+
+namespace psi {
+
+using latency::monotonic_ns;
+
+enum Resource : uint8_t { kMemory = 0, kIo = 1 };
+enum StallKind : uint8_t { kSome = 0, kFull = 1 };
+
+inline const char* resource_name(Resource r) { return r == kMemory ? "memory" : "io"; }
+
+struct PsiEvent {
+    uint64_t timestamp_ns;    // CLOCK_MONOTONIC
+    std::string target;       // "system" or client name
+    Resource resource;
+    StallKind kind;
+    uint64_t some_total_us;   // Cumulative stall totals read right after the trigger
+    uint64_t full_total_us;
+    uint64_t threshold_us;
+    uint64_t window_us;       // Effective window (may be rounded up, see above)
+    int trigger_id;           // Index into triggers(), stable for the monitor's lifetime
+};
+
+struct TriggerInfo {
+    std::string target;
+    Resource resource;
+    StallKind kind;
+    uint64_t window_us;
+};
+
+class PsiMonitor {
+public:
+    using Callback = std::function<void(const PsiEvent&)>;
+
+    PsiMonitor(uint64_t threshold_us, uint64_t window_us) : threshold(threshold_us), window(window_us) {}
+
+    ~PsiMonitor() {
+        stop();
+        for (auto& t : fds) close(t);
+    }
+
+    PsiMonitor(const PsiMonitor&) = delete;
+    PsiMonitor& operator=(const PsiMonitor&) = delete;
+
+    // Arm some/full triggers on <dir>/memory.pressure and <dir>/io.pressure
+    bool add_target(const std::string& name, const std::string& dir, std::string& error) {
+        for (Resource r : {kMemory, kIo}) {
+            std::string path = dir + "/" + resource_name(r) + ".pressure";
+            for (StallKind k : {kSome, kFull}) {
+                if (!arm(name, path, r, k, error)) return false;
+            }
+        }
+        return true;
+    }
+
+    bool add_system(std::string& error) {
+        for (Resource r : {kMemory, kIo}) {
+            std::string path = std::string("/proc/pressure/") + resource_name(r);
+            for (StallKind k : {kSome, kFull}) {
+                if (!arm("system", path, r, k, error)) return false;
+            }
+        }
+        return true;
+    }
+
+    // Safe to call while running
+    void subscribe(Callback callback) {
+        std::lock_guard<std::mutex> lock(subscriber_mutex);
+        subscribers.push_back(std::move(callback));
+    }
+
+    void clear_subscribers() {
+        std::lock_guard<std::mutex> lock(subscriber_mutex);
+        subscribers.clear();
+    }
+
+    const std::vector<TriggerInfo>& triggers() const { return info; }
+    uint64_t threshold_us() const { return threshold; }
+    bool window_rounded() const { return rounded; }
+    uint64_t events_seen() const { return event_count.load(std::memory_order_relaxed); }
+
+    bool start(std::string& error) {
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (epoll_fd < 0 || stop_fd < 0) {
+            error = std::string("epoll/eventfd setup failed: ") + strerror(errno);
+            return false;
+        }
+        epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.u32 = UINT32_MAX;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, stop_fd, &ev);
+        for (size_t i = 0; i < fds.size(); i++) {
+            memset(&ev, 0, sizeof(ev));
+            ev.events = EPOLLPRI;
+            ev.data.u32 = static_cast<uint32_t>(i);
+            if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fds[i], &ev) != 0) {
+                error = "epoll_ctl failed for " + info[i].target + ": " + strerror(errno);
+                return false;
+            }
+        }
+        thread = std::thread([this]() { event_loop(); });
+        return true;
+    }
+
+    void stop() {
+        if (thread.joinable()) {
+            uint64_t one = 1;
+            [[maybe_unused]] ssize_t n = write(stop_fd, &one, sizeof(one));
+            thread.join();
+        }
+        if (epoll_fd >= 0) close(epoll_fd);
+        if (stop_fd >= 0) close(stop_fd);
+        epoll_fd = stop_fd = -1;
+    }
+
+private:
+    static constexpr uint64_t kUnprivilegedWindowUs = 2000000;
+
+    uint64_t threshold;
+    uint64_t window;
+    bool rounded = false;
+    std::vector<int> fds;
+    std::vector<TriggerInfo> info;
+    int epoll_fd = -1;
+    int stop_fd = -1;
+    std::thread thread;
+    std::mutex subscriber_mutex;
+    std::vector<Callback> subscribers;
+    std::atomic<uint64_t> event_count{0};
+
+    bool arm(const std::string& name, const std::string& path, Resource r, StallKind k, std::string& error) {
+        int fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) {
+            error = "Cannot open " + path + ": " + strerror(errno);
+            return false;
+        }
+        uint64_t effective = window;
+        bool ok = write_trigger(fd, k, effective);
+        if (!ok && errno == EINVAL && effective % kUnprivilegedWindowUs != 0) {
+            effective = (effective / kUnprivilegedWindowUs + 1) * kUnprivilegedWindowUs;
+            ok = write_trigger(fd, k, effective);
+            if (ok) rounded = true;
+        }
+        if (!ok) {
+            error = "Cannot arm PSI " + std::string(k == kSome ? "some" : "full") + " trigger on " +
+                    path + ": " + strerror(errno);
+            close(fd);
+            return false;
+        }
+        fds.push_back(fd);
+        info.push_back({name, r, k, effective});
+        return true;
+    }
+
+    bool write_trigger(int fd, StallKind k, uint64_t window_us) {
+        char spec[64];
+        int len = snprintf(spec, sizeof(spec), "%s %llu %llu", k == kSome ? "some" : "full",
+                           static_cast<unsigned long long>(threshold), static_cast<unsigned long long>(window_us));
+        // The kernel wants the terminating NUL as part of the write
+        return write(fd, spec, len + 1) >= 0;
+    }
+
+    // "some avg10=0.00 avg60=0.00 avg300=0.00 total=123\nfull ... total=45\n"
+    static void read_totals(int fd, uint64_t& some_total, uint64_t& full_total) {
+        some_total = full_total = 0;
+        char buf[256];
+        ssize_t n = pread(fd, buf, sizeof(buf) - 1, 0);
+        if (n <= 0) return;
+        buf[n] = '\0';
+        const char* p = buf;
+        for (uint64_t* out : {&some_total, &full_total}) {
+            const char* t = strstr(p, "total=");
+            if (!t) return;
+            *out = strtoull(t + 6, nullptr, 10);
+            p = t + 6;
+        }
+    }
+
+    void event_loop() {
+        epoll_event events[16];
+        while (true) {
+            int n = epoll_wait(epoll_fd, events, 16, -1);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return;
+            }
+            uint64_t now = monotonic_ns();
+            for (int i = 0; i < n; i++) {
+                uint32_t id = events[i].data.u32;
+                if (id == UINT32_MAX) return;
+                if (events[i].events & EPOLLERR) {
+                    // Cgroup went away; stop watching this trigger
+                    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fds[id], nullptr);
+                    continue;
+                }
+                if (!(events[i].events & EPOLLPRI)) continue;
+                PsiEvent event;
+                event.timestamp_ns = now;
+                event.target = info[id].target;
+                event.resource = info[id].resource;
+                event.kind = info[id].kind;
+                event.threshold_us = threshold;
+                event.window_us = info[id].window_us;
+                event.trigger_id = static_cast<int>(id);
+                read_totals(fds[id], event.some_total_us, event.full_total_us);
+                event_count.fetch_add(1, std::memory_order_relaxed);
+                std::lock_guard<std::mutex> lock(subscriber_mutex);
+                for (const auto& cb : subscribers) cb(event);
+            }
+        }
+    }
+};
+
+}  // namespace psi
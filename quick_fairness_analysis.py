@@ -2,116 +2,420 @@
 
 import json
 import os
+import struct
 import sys
 from pathlib import Path
 
+# Binary per-window latency files written by the native engine (latency_recorder.h)
+LAT_HEADER = struct.Struct('<8sIIQQ64s')
+LAT_WINDOW = struct.Struct('<QIHBBQQQQQQQQQI')
+LAT_BUCKET = struct.Struct('<II')
+LAT_BUCKET_SIZE = LAT_BUCKET.size
+LAT_SUB_BUCKETS = 256
+LAT_HALF_BUCKETS = LAT_SUB_BUCKETS // 2
+
+# Binary vmstat/memory.stat samples (telemetry_sampler.h)
+TEL_HEADER = struct.Struct('<8sIIQQ')
+TEL_COLUMNS = 8
+TEL_SOURCE = struct.Struct('<64sII' + '24s' * TEL_COLUMNS)
+TEL_SAMPLE = struct.Struct('<QHHI' + 'Q' * TEL_COLUMNS)
+TEL_FLAG_READ_ERROR = 1
+TEL_KIND_PSI_EVENT = 2
+TEL_KIND_PERF = 3
+TEL_KIND_KSWAPD = 4
+
+
+# Parsed results keyed by file name, reused while a file's size and mtime are unchanged
+PARSE_CACHE_FILE = ".analysis_cache"
+PARSE_CACHE_VERSION = 1
+
+
+def load_parse_cache(results_path):
+    """Load the per-directory parse cache, or an empty one if missing or stale."""
+    try:
+        with open(results_path / PARSE_CACHE_FILE, 'r') as f:
+            cache = json.load(f)
+        if cache.get('version') == PARSE_CACHE_VERSION:
+            return cache.get('files', {})
+    except (OSError, ValueError):
+        pass
+    return {}
+
+
+def save_parse_cache(results_path, files):
+    """Write the parse cache atomically; failures only cost a re-parse next time."""
+    tmp = results_path / (PARSE_CACHE_FILE + ".tmp")
+    try:
+        with open(tmp, 'w') as f:
+            json.dump({'version': PARSE_CACHE_VERSION, 'files': files}, f)
+        os.replace(tmp, results_path / PARSE_CACHE_FILE)
+    except OSError:
+        pass
+
 
 def load_fio_results(results_dir):
-    """Load FIO benchmark results from JSON files."""
+    """Load FIO benchmark results from JSON files, re-parsing only changed files."""
     results_path = Path(results_dir)
-    json_files = list(results_path.glob("*.json"))
+    json_files = sorted(p for p in results_path.glob("*.json") if not p.name.startswith("."))
     results = []
+    cached_files = load_parse_cache(results_path)
+    fresh_files = {}
 
     for json_file in json_files:
-        try:
-            with open(json_file, 'r') as f:
-                content = f.read()
-
-            # Handle multiple JSON objects in one file
-            json_objects = []
-            decoder = json.JSONDecoder()
-            idx = 0
-            content_to_parse = content
-            while idx < len(content_to_parse):
-                remaining = content_to_parse[idx:].lstrip()
-                if not remaining:
-                    break
-                try:
-                    obj, end_idx = decoder.raw_decode(remaining)
-                    if isinstance(obj, dict):
-                        json_objects.append(obj)
-                    idx += len(content_to_parse[idx:]) - len(remaining) + end_idx
-                except json.JSONDecodeError:
-                    break
-
-            # Use the last JSON object (most recent run)
-            if not json_objects:
-                continue
+        st = json_file.stat()
+        key = [st.st_size, st.st_mtime_ns]
+        entry = cached_files.get(json_file.name)
+        if entry and entry.get('key') == key:
+            fresh_files[json_file.name] = entry
+            if entry.get('result'):
+                results.append(entry['result'])
+            continue
+
+        result = parse_fio_file(json_file)
+        fresh_files[json_file.name] = {'key': key, 'result': result}
+        if result:
+            results.append(result)
 
-            data = json_objects[-1]
+    if fresh_files != cached_files:
+        save_parse_cache(results_path, fresh_files)
 
-            if not isinstance(data, dict) or 'jobs' not in data or not data['jobs']:
+    return results
+
+
+def parse_fio_file(json_file):
+    """Parse one fio JSON file into a flat result dict (None if it has no jobs)."""
+    try:
+        with open(json_file, 'r') as f:
+            content = f.read()
+
+        # Handle multiple JSON objects in one file
+        json_objects = []
+        decoder = json.JSONDecoder()
+        idx = 0
+        content_to_parse = content
+        while idx < len(content_to_parse):
+            remaining = content_to_parse[idx:].lstrip()
+            if not remaining:
+                break
+            try:
+                obj, end_idx = decoder.raw_decode(remaining)
+                if isinstance(obj, dict):
+                    json_objects.append(obj)
+                idx += len(content_to_parse[idx:]) - len(remaining) + end_idx
+            except json.JSONDecodeError:
+                break
+
+        # Use the last JSON object (most recent run)
+        if not json_objects:
+            return None
+
+        data = json_objects[-1]
+
+        if not isinstance(data, dict) or 'jobs' not in data or not data['jobs']:
+            return None
+
+        job = data['jobs'][0]
+        test_name = json_file.stem
+
+        # Extract metrics
+        read_metrics = job.get('read', {})
+        write_metrics = job.get('write', {})
+
+        # Helper to get p99 from clat_ns or lat_ns
+        def get_p99_ns(metrics):
+            # Try clat_ns first (completion latency - most common)
+            clat = metrics.get('clat_ns', {})
+            if 'percentile' in clat:
+                p99 = clat['percentile'].get('99.000000', 0)
+                if p99 > 0:
+                    return p99
+
+            # Fallback to lat_ns
+            lat = metrics.get('lat_ns', {})
+            if 'percentile' in lat:
+                return lat['percentile'].get('99.000000', 0)
+
+            return 0
+
+        # Helper to get max from clat_ns or lat_ns
+        def get_max_ns(metrics):
+            # Try clat_ns first (completion latency - most common)
+            clat = metrics.get('clat_ns', {})
+            if 'max' in clat:
+                return clat['max']
+
+            # Fallback to lat_ns
+            lat = metrics.get('lat_ns', {})
+            if 'max' in lat:
+                return lat['max']
+
+            return 0
+
+        result = {
+            'test_name': test_name,
+            'file_path': str(json_file),
+
+            # IOPS
+            'read_iops': read_metrics.get('iops', 0),
+            'write_iops': write_metrics.get('iops', 0),
+            'total_iops': read_metrics.get('iops', 0) + write_metrics.get('iops', 0),
+            'iops_min': read_metrics.get('iops_min', 0) if read_metrics.get('iops', 0) > 0 else write_metrics.get('iops_min', 0),
+            'iops_max': read_metrics.get('iops_max', 0) if read_metrics.get('iops', 0) > 0 else write_metrics.get('iops_max', 0),
+            'iops_stddev': read_metrics.get('iops_stddev', 0) if read_metrics.get('iops', 0) > 0 else write_metrics.get('iops_stddev', 0),
+
+            # Bandwidth (MB/s)
+            'read_bw_mbs': read_metrics.get('bw_bytes', 0) / 1024 / 1024,
+            'write_bw_mbs': write_metrics.get('bw_bytes', 0) / 1024 / 1024,
+            'total_bw_mbs': (read_metrics.get('bw_bytes', 0) + write_metrics.get('bw_bytes', 0)) / 1024 / 1024,
+
+            # Latency (microseconds)
+            'read_lat_avg_us': read_metrics.get('lat_ns', {}).get('mean', 0) / 1000,
+            'write_lat_avg_us': write_metrics.get('lat_ns', {}).get('mean', 0) / 1000,
+            'read_lat_p99_us': get_p99_ns(read_metrics) / 1000,
+            'write_lat_p99_us': get_p99_ns(write_metrics) / 1000,
+            'read_lat_max_us': get_max_ns(read_metrics) / 1000,
+            'write_lat_max_us': get_max_ns(write_metrics) / 1000,
+        }
+
+        return result
+
+    except (json.JSONDecodeError, KeyError, FileNotFoundError) as e:
+        print(f"Warning: Could not parse {json_file}: {e}")
+
+    return None
+
+
+def lat_bucket_upper(index):
+    """Highest latency (ns) that maps to a histogram bucket, as in latency_recorder.h."""
+    if index < LAT_SUB_BUCKETS:
+        return index
+    shift = (index - LAT_SUB_BUCKETS) // LAT_HALF_BUCKETS + 1
+    sub = (index - LAT_SUB_BUCKETS) % LAT_HALF_BUCKETS + LAT_HALF_BUCKETS
+    return ((sub + 1) << shift) - 1
+
+
+def load_latency_windows(lat_file, with_buckets=False):
+    """Load per-window latency records from a native engine .lat file.
+
+    with_buckets adds each window's sparse histogram as 'buckets': {index: count}.
+    """
+    windows = []
+    with open(lat_file, 'rb') as f:
+        header = f.read(LAT_HEADER.size)
+        if len(header) < LAT_HEADER.size:
+            return None, windows
+        magic, _version, _bits, epoch_ns, window_ns, client = LAT_HEADER.unpack(header)
+        if magic != b'FBLAT001':
+            return None, windows
+
+        while True:
+            raw = f.read(LAT_WINDOW.size)
+            if len(raw) < LAT_WINDOW.size:
+                break
+            (start_ns, index, phase, direction, _reserved, count, min_ns, max_ns, mean_ns,
+             p50, p90, p99, p999, p9999, nbuckets) = LAT_WINDOW.unpack(raw)
+            buckets = None
+            if with_buckets:
+                raw = f.read(nbuckets * LAT_BUCKET_SIZE)
+                buckets = dict(LAT_BUCKET.iter_unpack(raw[:len(raw) - len(raw) % LAT_BUCKET_SIZE]))
+            else:
+                f.seek(nbuckets * LAT_BUCKET_SIZE, os.SEEK_CUR)
+            windows.append({
+                'start_ns': start_ns, 'window': index, 'phase': phase,
+                'dir': 'write' if direction else 'read', 'count': count,
+                'min_us': min_ns / 1000, 'max_us': max_ns / 1000, 'mean_us': mean_ns / 1000,
+                'p50_us': p50 / 1000, 'p90_us': p90 / 1000, 'p99_us': p99 / 1000,
+                'p999_us': p999 / 1000, 'p9999_us': p9999 / 1000, 'buckets': buckets,
+            })
+
+    info = {'client': client.rstrip(b'\0').decode(), 'epoch_ns': epoch_ns, 'window_ns': window_ns}
+    return info, windows
+
+
+def print_latency_windows(results_dir):
+    """Print the per-window tail latency recorded by the native engine."""
+    lat_files = sorted(Path(results_dir).glob("*.lat"))
+    if not lat_files:
+        return
+
+    print()
+    print("## ⏱️  PER-WINDOW TAIL LATENCY (native engine)")
+    print()
+    for lat_file in lat_files:
+        info, windows = load_latency_windows(lat_file)
+        if info is None or not windows:
+            continue
+        print(f"### {info['client']}")
+        print(f"{'Window':>6} {'Phase':>5} {'Dir':<5} {'Count':>9} {'p50(μs)':>9} "
+              f"{'p99(μs)':>9} {'p999(μs)':>10} {'max(μs)':>10}")
+        for w in windows:
+            print(f"{w['window']:>6} {w['phase'] + 1:>5} {w['dir']:<5} {w['count']:>9} "
+                  f"{w['p50_us']:>9.1f} {w['p99_us']:>9.1f} {w['p999_us']:>10.1f} {w['max_us']:>10.1f}")
+        print()
+
+
+def load_phase_schedule(schedule_file):
+    """Load a concurrent run's <group>_<mode>_phase_schedule.csv: [(tenant, phase, start_ns, end_ns)]."""
+    rows = []
+    with open(schedule_file) as f:
+        for line in f:
+            if line.startswith('#') or line.startswith('tenant,'):
                 continue
+            tenant, phase, start_ns, end_ns = line.strip().split(',')
+            rows.append((tenant, int(phase), int(start_ns), int(end_ns)))
+    return rows
+
+
+def phase_overlaps(schedule):
+    """Split a schedule into intervals over which the set of running phases is constant."""
+    bounds = sorted({t for _, _, start, end in schedule for t in (start, end)})
+    segments = []
+    for seg_start, seg_end in zip(bounds, bounds[1:]):
+        active = sorted((tenant, phase) for tenant, phase, start, end in schedule
+                        if start <= seg_start and end >= seg_end)
+        if active:
+            segments.append((seg_start, seg_end, active))
+    return segments
+
+
+def histogram_percentile(counts, pct):
+    """Upper bound (ns) of the given percentile of a merged {bucket: count} histogram."""
+    total = sum(counts.values())
+    if total == 0:
+        return 0
+    rank = max(1, int(total * pct / 100 + 0.999999))
+    seen = 0
+    for index in sorted(counts):
+        seen += counts[index]
+        if seen >= rank:
+            return lat_bucket_upper(index)
+    return 0
+
+
+def print_phase_overlap(results_dir):
+    """Tail latency of every tenant bucketed by which phases of all tenants overlapped.
+
+    Concurrent runs share one epoch, and .lat windows start on it, so every
+    window lies inside exactly one overlap interval. Histograms are merged
+    per interval, so the percentiles are exact, not averaged per window.
+    """
+    schedule_files = sorted(Path(results_dir).glob("*_phase_schedule.csv"))
+    if not schedule_files:
+        return
 
-            job = data['jobs'][0]
-            test_name = json_file.stem
-
-            # Extract metrics
-            read_metrics = job.get('read', {})
-            write_metrics = job.get('write', {})
-
-            # Helper to get p99 from clat_ns or lat_ns
-            def get_p99_ns(metrics):
-                # Try clat_ns first (completion latency - most common)
-                clat = metrics.get('clat_ns', {})
-                if 'percentile' in clat:
-                    p99 = clat['percentile'].get('99.000000', 0)
-                    if p99 > 0:
-                        return p99
-
-                # Fallback to lat_ns
-                lat = metrics.get('lat_ns', {})
-                if 'percentile' in lat:
-                    return lat['percentile'].get('99.000000', 0)
-
-                return 0
-
-            # Helper to get max from clat_ns or lat_ns
-            def get_max_ns(metrics):
-                # Try clat_ns first (completion latency - most common)
-                clat = metrics.get('clat_ns', {})
-                if 'max' in clat:
-                    return clat['max']
-
-                # Fallback to lat_ns
-                lat = metrics.get('lat_ns', {})
-                if 'max' in lat:
-                    return lat['max']
-
-                return 0
-
-            result = {
-                'test_name': test_name,
-                'file_path': str(json_file),
-
-                # IOPS
-                'read_iops': read_metrics.get('iops', 0),
-                'write_iops': write_metrics.get('iops', 0),
-                'total_iops': read_metrics.get('iops', 0) + write_metrics.get('iops', 0),
-                'iops_min': read_metrics.get('iops_min', 0) if read_metrics.get('iops', 0) > 0 else write_metrics.get('iops_min', 0),
-                'iops_max': read_metrics.get('iops_max', 0) if read_metrics.get('iops', 0) > 0 else write_metrics.get('iops_max', 0),
-                'iops_stddev': read_metrics.get('iops_stddev', 0) if read_metrics.get('iops', 0) > 0 else write_metrics.get('iops_stddev', 0),
-
-                # Bandwidth (MB/s)
-                'read_bw_mbs': read_metrics.get('bw_bytes', 0) / 1024 / 1024,
-                'write_bw_mbs': write_metrics.get('bw_bytes', 0) / 1024 / 1024,
-                'total_bw_mbs': (read_metrics.get('bw_bytes', 0) + write_metrics.get('bw_bytes', 0)) / 1024 / 1024,
-
-                # Latency (microseconds)
-                'read_lat_avg_us': read_metrics.get('lat_ns', {}).get('mean', 0) / 1000,
-                'write_lat_avg_us': write_metrics.get('lat_ns', {}).get('mean', 0) / 1000,
-                'read_lat_p99_us': get_p99_ns(read_metrics) / 1000,
-                'write_lat_p99_us': get_p99_ns(write_metrics) / 1000,
-                'read_lat_max_us': get_max_ns(read_metrics) / 1000,
-                'write_lat_max_us': get_max_ns(write_metrics) / 1000,
-            }
+    print()
+    print("## 🔀 LATENCY BY PHASE OVERLAP (shared start)")
+    for schedule_file in schedule_files:
+        schedule = load_phase_schedule(schedule_file)
+        if not schedule:
+            continue
+        prefix = schedule_file.name[:-len("_phase_schedule.csv")]
+        mode = prefix.rsplit('_', 1)[-1]
+        epoch = min(start for _, _, start, _ in schedule)
+        windows = {}
+        for tenant in sorted({row[0] for row in schedule}):
+            lat_file = Path(results_dir) / f"{tenant}_{mode}.lat"
+            if lat_file.exists():
+                info, tenant_windows = load_latency_windows(lat_file, with_buckets=True)
+                if info is not None:
+                    windows[tenant] = (info['window_ns'], tenant_windows)
+        if not windows:
+            continue
 
-            results.append(result)
+        print()
+        print(f"### {prefix}")
+        print(f"{'From(s)':>8} {'To(s)':>6} {'Tenant':<16} {'Dir':<5} {'Count':>9} {'p50(μs)':>9} "
+              f"{'p99(μs)':>9} {'p999(μs)':>10}  Running")
+        for seg_start, seg_end, active in phase_overlaps(schedule):
+            running = " ".join(f"{tenant}:{phase}" for tenant, phase in active)
+            for tenant, (window_ns, tenant_windows) in windows.items():
+                for direction in ('read', 'write'):
+                    merged = {}
+                    for w in tenant_windows:
+                        if (w['dir'] != direction or w['start_ns'] < seg_start or
+                                w['start_ns'] + window_ns > seg_end):
+                            continue
+                        for index, count in w['buckets'].items():
+                            merged[index] = merged.get(index, 0) + count
+                    count = sum(merged.values())
+                    if count == 0:
+                        continue
+                    print(f"{(seg_start - epoch) / 1e9:>8.1f} {(seg_end - epoch) / 1e9:>6.1f} {tenant:<16} "
+                          f"{direction:<5} {count:>9} {histogram_percentile(merged, 50) / 1000:>9.1f} "
+                          f"{histogram_percentile(merged, 99) / 1000:>9.1f} "
+                          f"{histogram_percentile(merged, 99.9) / 1000:>10.1f}  {running}")
+
+
+def load_telemetry(tel_file):
+    """Read a telemetry file into (sources, samples); sources carry column names."""
+    with open(tel_file, 'rb') as f:
+        data = f.read()
+    if len(data) < TEL_HEADER.size:
+        return [], []
+    magic, _version, num_sources, start_ns, _interval_ns = TEL_HEADER.unpack_from(data, 0)
+    if magic != b'FBTEL001':
+        return [], []
+
+    offset = TEL_HEADER.size
+    sources = []
+    for _ in range(num_sources):
+        fields = TEL_SOURCE.unpack_from(data, offset)
+        offset += TEL_SOURCE.size
+        ncols = fields[2]
+        sources.append({
+            'name': fields[0].rstrip(b'\0').decode(errors='replace'),
+            'kind': fields[1],
+            'columns': [c.rstrip(b'\0').decode() for c in fields[3:3 + ncols]],
+        })
+
+    samples = []
+    while offset + TEL_SAMPLE.size <= len(data):
+        fields = TEL_SAMPLE.unpack_from(data, offset)
+        offset += TEL_SAMPLE.size
+        timestamp_ns, source, flags = fields[0], fields[1], fields[2]
+        if flags & TEL_FLAG_READ_ERROR or source >= len(sources):
+            continue
+        values = dict(zip(sources[source]['columns'], fields[4:]))
+        samples.append({'t_s': (timestamp_ns - start_ns) / 1e9, 'source': source, 'values': values})
+    return sources, samples
 
-        except (json.JSONDecodeError, KeyError, FileNotFoundError) as e:
-            print(f"Warning: Could not parse {json_file}: {e}")
 
-    return results
+def print_telemetry(results_dir):
+    """Summarize sampled kernel counters: peak for gauges, total delta for counters."""
+    tel_files = sorted(Path(results_dir).glob("telemetry/*.tel"))
+    if not tel_files:
+        return
+
+    print()
+    print("## 🧪 KERNEL TELEMETRY (vmstat / memory.stat / PSI / perf)")
+    print()
+    for tel_file in tel_files:
+        sources, samples = load_telemetry(tel_file)
+        if not samples:
+            continue
+        print(f"### {tel_file.stem}")
+        for idx, source in enumerate(sources):
+            rows = [s for s in samples if s['source'] == idx]
+            if not rows:
+                continue
+            if source['kind'] == TEL_KIND_PSI_EVENT:
+                some = sum(1 for r in rows if r['values']['kind_full'] == 0)
+                window_ms = rows[0]['values']['window_us'] / 1000
+                first = ', '.join(f"{r['t_s']:.3f}s" for r in rows[:5])
+                print(f"- PSI {source['name']}: {some} some / {len(rows) - some} full triggers "
+                      f"({window_ms:.0f}ms window), first at {first}")
+                continue
+            duration = rows[-1]['t_s'] - rows[0]['t_s']
+            print(f"- {source['name']} ({len(rows)} samples over {duration:.1f}s)")
+            for col in source['columns']:
+                series = [r['values'][col] for r in rows]
+                # Event counters only grow; report what happened during the run
+                if (source['kind'] in (TEL_KIND_PERF, TEL_KIND_KSWAPD) and col != 'threads' or
+                        col.startswith('pg') or col.startswith('workingset')):
+                    print(f"    {col:<26} delta {series[-1] - series[0]:>14}")
+                else:
+                    print(f"    {col:<26} peak  {max(series):>14}")
+        print()
 
 
 def get_iops(result):
@@ -488,6 +792,9 @@ def analyze_fairness_results(results_dir):
                 else:
                     print(f"  ✅ Strong pagecache benefit")
 
+    print_latency_windows(results_dir)
+    print_phase_overlap(results_dir)
+    print_telemetry(results_dir)
     print()
 
 
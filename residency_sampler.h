@@ -0,0 +1,330 @@
+// residency_sampler.h
+// Page-cache residency of the test files, sampled with mincore().
+//
+// Each test file is mapped read-only once (mapping a 32G file costs no
+// memory; mincore never faults pages in) and scanned every interval in
+// 64MB chunks through a reused vector. The resident set is kept as a
+// bitmap, one bit per page (1MB for a 32G file), and each tick records only
+// the 64-page words that changed since the previous tick, as XOR masks.
+// The first tick of a file is the delta against an empty cache, so the
+// stream replays to the exact bitmap at any tick.
+//
+// Every tick also stores resident pages per 256MB region, which is usually
+// all an eviction plot needs. On kernels with cachestat(2) (6.5+) each chunk
+// is first counted with cachestat, several times cheaper than mincore: a
+// chunk that is fully cached or fully evicted needs no mincore at all, and
+// the tick gains the file's dirty, writeback and evicted page counts.
+//
+// File layout (little endian, fixed width):
+//   ResidencyFileHeader
+//   ResidencyFileDescriptor[header.num_files]
+//   repeated: ResidencyTick
+//             uint32_t region_resident[descriptor.regions]
+//             WordDelta[tick.changed_words]
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "latency_recorder.h"
+
+#ifndef __NR_cachestat
+#define __NR_cachestat 451
+#endif
+
+namespace residency {
+
+using latency::monotonic_ns;
+
+constexpr uint64_t kRegionBytes = 256ULL << 20;
+constexpr size_t kScanChunkPages = 16384;
+
+// Tick flags
+constexpr uint16_t kFlagCachestat = 1;  // dirty/writeback/evicted columns are valid
+constexpr uint16_t kFlagScanError = 2;
+
+#pragma pack(push, 1)
+struct ResidencyFileHeader {
+    char magic[8];            // "FBRES001"
+    uint32_t version;
+    uint32_t num_files;
+    uint64_t start_ns;        // CLOCK_MONOTONIC
+    uint64_t interval_ns;
+    uint32_t page_size;
+    uint32_t region_pages;
+};
+
+struct ResidencyFileDescriptor {
+    char path[256];
+    uint64_t size_bytes;
+    uint64_t pages;
+    uint32_t regions;
+    uint32_t reserved;
+};
+
+struct ResidencyTick {
+    uint64_t timestamp_ns;    // CLOCK_MONOTONIC
+    uint16_t file;            // Index into the descriptor table
+    uint16_t flags;
+    uint32_t changed_words;
+    uint64_t resident_pages;
+    uint64_t dirty_pages;
+    uint64_t writeback_pages;
+    uint64_t evicted_pages;   // Since the file was opened (cachestat nr_evicted)
+    uint64_t scan_ns;         // Cost of this file's scan, the sampler's own overhead
+};
+
+struct WordDelta {
+    uint64_t word;            // Pages [64 * word, 64 * word + 64)
+    uint64_t flipped;         // Bits that changed: previous ^ current
+};
+#pragma pack(pop)
+
+// cachestat(2) ABI, declared here for headers that predate it
+struct CachestatRange {
+    uint64_t off;
+    uint64_t len;
+};
+
+struct Cachestat {
+    uint64_t nr_cache;
+    uint64_t nr_dirty;
+    uint64_t nr_writeback;
+    uint64_t nr_evicted;
+    uint64_t nr_recently_evicted;
+};
+
+class Sampler {
+public:
+    explicit Sampler(uint64_t interval_ns) : interval(interval_ns) {}
+
+    ~Sampler() {
+        stop();
+        for (auto& f : files) {
+            if (f.map) munmap(f.map, f.size);
+            if (f.fd >= 0) close(f.fd);
+        }
+    }
+
+    Sampler(const Sampler&) = delete;
+    Sampler& operator=(const Sampler&) = delete;
+
+    bool add_file(const std::string& path, std::string& error) {
+        File f;
+        f.fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (f.fd < 0) {
+            error = "Cannot open " + path + " for residency sampling: " + strerror(errno);
+            return false;
+        }
+        struct stat st;
+        if (fstat(f.fd, &st) != 0 || st.st_size == 0) {
+            error = path + " is empty, not sampling its residency";
+            close(f.fd);
+            return false;
+        }
+        f.size = static_cast<uint64_t>(st.st_size);
+        f.map = mmap(nullptr, f.size, PROT_READ, MAP_SHARED, f.fd, 0);
+        if (f.map == MAP_FAILED) {
+            error = "Cannot map " + path + ": " + strerror(errno);
+            close(f.fd);
+            return false;
+        }
+        f.path = path;
+        f.pages = (f.size + page_size - 1) / page_size;
+        f.bitmap.assign((f.pages + 63) / 64, 0);
+        f.regions.assign((f.size + kRegionBytes - 1) / kRegionBytes, 0);
+        files.push_back(std::move(f));
+        return true;
+    }
+
+    size_t num_files() const { return files.size(); }
+
+    bool open(const std::string& path, std::string& error) {
+        out = fopen(path.c_str(), "wb");
+        if (!out) {
+            error = "Cannot open residency file " + path + ": " + strerror(errno);
+            return false;
+        }
+        start_ns = monotonic_ns();
+        ResidencyFileHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, "FBRES001", 8);
+        header.version = 1;
+        header.num_files = static_cast<uint32_t>(files.size());
+        header.start_ns = start_ns;
+        header.interval_ns = interval;
+        header.page_size = static_cast<uint32_t>(page_size);
+        header.region_pages = static_cast<uint32_t>(kRegionBytes / page_size);
+        fwrite(&header, sizeof(header), 1, out);
+        for (const auto& f : files) {
+            ResidencyFileDescriptor d;
+            memset(&d, 0, sizeof(d));
+            strncpy(d.path, f.path.c_str(), sizeof(d.path) - 1);
+            d.size_bytes = f.size;
+            d.pages = f.pages;
+            d.regions = static_cast<uint32_t>(f.regions.size());
+            fwrite(&d, sizeof(d), 1, out);
+        }
+        return true;
+    }
+
+    void start() {
+        thread = std::thread([this]() { sample_loop(); });
+    }
+
+    void stop() {
+        if (thread.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            cv.notify_all();
+            thread.join();
+        }
+        if (out) {
+            fclose(out);
+            out = nullptr;
+        }
+    }
+
+    uint64_t ticks_written() const { return ticks.load(std::memory_order_relaxed); }
+
+private:
+    struct File {
+        std::string path;
+        int fd = -1;
+        void* map = nullptr;
+        uint64_t size = 0;
+        uint64_t pages = 0;
+        std::vector<uint64_t> bitmap;    // Resident set as of the last tick
+        std::vector<uint32_t> regions;   // Resident pages per kRegionBytes
+    };
+
+    const uint64_t page_size = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    uint64_t interval;
+    uint64_t start_ns = 0;
+    std::vector<File> files;
+    std::vector<unsigned char> vec = std::vector<unsigned char>(kScanChunkPages);
+    std::vector<WordDelta> deltas;
+    bool cachestat_supported = true;
+    FILE* out = nullptr;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping = false;
+    std::atomic<uint64_t> ticks{0};
+
+    // Store pages [first, first + n): from a mincore vector, else all resident or none; records deltas
+    void set_words(File& f, uint64_t first, uint64_t n, const unsigned char* mincore_vec, bool resident_all) {
+        const uint64_t region_pages = kRegionBytes / page_size;
+        for (uint64_t base = 0; base < n; base += 64) {
+            uint64_t count = std::min<uint64_t>(64, n - base);
+            uint64_t word = 0;
+            if (mincore_vec) {
+                for (uint64_t b = 0; b < count; b++) word |= static_cast<uint64_t>(mincore_vec[base + b] & 1) << b;
+            } else if (resident_all) {
+                word = count == 64 ? ~0ULL : (1ULL << count) - 1;
+            }
+            uint64_t index = (first + base) / 64;
+            uint64_t flipped = word ^ f.bitmap[index];
+            if (flipped) {
+                deltas.push_back({index, flipped});
+                f.bitmap[index] = word;
+            }
+            if (word) f.regions[(first + base) / region_pages] += static_cast<uint32_t>(__builtin_popcountll(word));
+        }
+    }
+
+    // Rescan one file chunk by chunk; updates its bitmap and region counts and fills `deltas`.
+    // With cachestat a chunk that is entirely cached or entirely evicted skips mincore,
+    // which also gives the tick its dirty/writeback/evicted totals.
+    bool scan(File& f, ResidencyTick& tick) {
+        deltas.clear();
+        std::fill(f.regions.begin(), f.regions.end(), 0);
+        // Chunks are a multiple of 64 pages, so bitmap words never straddle two chunks
+        for (uint64_t first = 0; first < f.pages; first += kScanChunkPages) {
+            uint64_t n = std::min<uint64_t>(kScanChunkPages, f.pages - first);
+            if (cachestat_supported) {
+                CachestatRange range{first * page_size, n * page_size};
+                Cachestat cs;
+                memset(&cs, 0, sizeof(cs));
+                if (syscall(__NR_cachestat, f.fd, &range, &cs, 0) == 0) {
+                    tick.flags |= kFlagCachestat;
+                    tick.dirty_pages += cs.nr_dirty;
+                    tick.writeback_pages += cs.nr_writeback;
+                    tick.evicted_pages += cs.nr_evicted;
+                    if (cs.nr_cache == 0 || cs.nr_cache >= n) {
+                        set_words(f, first, n, nullptr, cs.nr_cache > 0);
+                        continue;
+                    }
+                } else if (errno == ENOSYS) {
+                    cachestat_supported = false;
+                }
+            }
+            if (mincore(static_cast<char*>(f.map) + first * page_size, n * page_size, vec.data()) != 0) return false;
+            set_words(f, first, n, vec.data(), false);
+        }
+        return true;
+    }
+
+    void sample_file(size_t i, uint64_t now) {
+        File& f = files[i];
+        ResidencyTick tick;
+        memset(&tick, 0, sizeof(tick));
+        tick.timestamp_ns = now;
+        tick.file = static_cast<uint16_t>(i);
+
+        uint64_t scan_start = monotonic_ns();
+        if (!scan(f, tick)) {
+            tick.flags |= kFlagScanError;
+            deltas.clear();
+        }
+        tick.scan_ns = monotonic_ns() - scan_start;
+        for (uint32_t r : f.regions) tick.resident_pages += r;
+        tick.changed_words = static_cast<uint32_t>(deltas.size());
+
+        fwrite(&tick, sizeof(tick), 1, out);
+        fwrite(f.regions.data(), sizeof(uint32_t), f.regions.size(), out);
+        if (!deltas.empty()) fwrite(deltas.data(), sizeof(WordDelta), deltas.size(), out);
+    }
+
+    void sample_loop() {
+        uint64_t next_tick = start_ns;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            auto deadline = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(next_tick));
+            if (cv.wait_until(lock, deadline, [this]() { return stopping; })) break;
+            lock.unlock();
+            uint64_t now = monotonic_ns();
+            for (size_t i = 0; i < files.size(); i++) sample_file(i, now);
+            ticks.fetch_add(1, std::memory_order_relaxed);
+            // A scan longer than the interval skips ticks rather than running back to back
+            next_tick += interval;
+            now = monotonic_ns();
+            if (next_tick <= now) next_tick = now - (now - start_ns) % interval + interval;
+            lock.lock();
+        }
+        lock.unlock();
+        // Closing tick so the stream covers the end of the run
+        uint64_t now = monotonic_ns();
+        for (size_t i = 0; i < files.size(); i++) sample_file(i, now);
+    }
+};
+
+}  // namespace residency
@@ -0,0 +1,419 @@
+// results_analysis.h
+// Loading a finished run into the results store, and the `analyze` subcommand.
+//
+// collect() reads one output directory once, right after the run, into
+// tables:
+//   runs       run labels: mode, config, sweep axis values, repetition
+//   phases     per client/cache mode/phase/direction summary from the fio
+//              JSON; phase 0 is the whole run
+//   windows    per-window latency records from the native engine's .lat files
+//   buckets    their histogram buckets (window = row in the batch's windows)
+//   telemetry  every vmstat / memory.stat / PSI sample, one row per value
+// Every row carries the batch (append time) and run. A run appended twice,
+// e.g. a sweep point retried after a crash, is read back as its last batch
+// only.
+//
+// analyze() works on whole columns:
+//   Jain's fairness index of client throughput per run, cache mode and phase
+//   p99 per client/phase against the same key of a baseline run
+//   SLO violations: share of requests (from the buckets) and of windows
+//   (window p99) above --slo-us
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "latency_recorder.h"
+#include "phase_aggregator.h"
+#include "results_store.h"
+#include "telemetry_sampler.h"
+
+namespace analysis {
+
+using store::Table;
+using store::Type;
+
+inline std::vector<Table> make_tables() {
+    const std::pair<std::string, Type> batch{"batch", Type::U64}, run{"run", Type::Str};
+    const std::pair<std::string, Type> client{"client", Type::Str}, mode{"mode", Type::Str};
+    return {
+        Table("runs", {batch, run, {"key", Type::Str}, {"value", Type::Str}}),
+        Table("phases", {batch, run, client, mode, {"phase", Type::U64}, {"dir", Type::Str},
+                         {"ios", Type::U64}, {"iops", Type::F64}, {"bw_bytes", Type::F64}, {"p50_ns", Type::F64},
+                         {"p99_ns", Type::F64}, {"p999_ns", Type::F64}, {"max_ns", Type::U64}}),
+        Table("windows", {batch, run, client, mode, {"phase", Type::U64}, {"dir", Type::Str},
+                          {"start_ns", Type::U64}, {"count", Type::U64}, {"p50_ns", Type::U64},
+                          {"p99_ns", Type::U64}, {"p999_ns", Type::U64}, {"max_ns", Type::U64}}),
+        Table("buckets", {batch, {"window", Type::U64}, {"bucket", Type::U64}, {"count", Type::U64}}),
+        Table("telemetry", {batch, run, {"file", Type::Str}, {"source", Type::Str}, {"metric", Type::Str},
+                            {"ts_ns", Type::U64}, {"value", Type::U64}}),
+    };
+}
+
+// "client1_cached_phase2" -> client1, cached, 2; false if the name has no cache mode
+inline bool split_label(const std::string& stem, std::string& client, std::string& mode, uint64_t& phase) {
+    for (const char* m : {"_cached", "_direct"}) {
+        size_t at = stem.rfind(m);
+        if (at == std::string::npos || at == 0) continue;
+        std::string rest = stem.substr(at + strlen(m));
+        phase = 0;
+        if (!rest.empty()) {
+            if (rest.compare(0, 6, "_phase") != 0 || rest.size() == 6 ||
+                rest.find_first_not_of("0123456789", 6) != std::string::npos) {
+                continue;
+            }
+            phase = std::stoull(rest.substr(6));
+        }
+        client = stem.substr(0, at);
+        mode = m + 1;
+        return true;
+    }
+    return false;
+}
+
+inline void add_phase_rows(Table& t, uint64_t batch, const std::string& run, const std::string& client,
+                           const std::string& mode, uint64_t phase, const results::PhaseSummary& summary) {
+    for (int d = 0; d < 2; d++) {
+        const results::DirSummary& ds = summary.dir[d];
+        if (ds.total_ios == 0) continue;
+        t.col("batch").push(batch);
+        t.col("run").push(run);
+        t.col("client").push(client);
+        t.col("mode").push(mode);
+        t.col("phase").push(phase);
+        t.col("dir").push(std::string(d ? "write" : "read"));
+        t.col("ios").push(ds.total_ios);
+        t.col("iops").push(ds.iops);
+        t.col("bw_bytes").push(ds.bw_bytes);
+        t.col("p50_ns").push(results::percentile_or_zero(ds, 50));
+        t.col("p99_ns").push(results::percentile_or_zero(ds, 99));
+        t.col("p999_ns").push(results::percentile_or_zero(ds, 99.9));
+        t.col("max_ns").push(ds.clat_max);
+    }
+}
+
+inline void add_latency_file(Table& windows, Table& buckets, uint64_t batch, const std::string& run,
+                             const std::string& path) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return;
+    latency::LatencyFileHeader header;
+    std::string client, mode;
+    uint64_t ignored = 0;
+    if (fread(&header, sizeof(header), 1, f) != 1 || memcmp(header.magic, "FBLAT001", 8) != 0 ||
+        !split_label(std::string(header.client, strnlen(header.client, sizeof(header.client))), client, mode,
+                     ignored)) {
+        fclose(f);
+        return;
+    }
+    latency::WindowRecord rec;
+    std::vector<latency::BucketCount> counts;
+    while (fread(&rec, sizeof(rec), 1, f) == 1) {
+        counts.resize(rec.nbuckets);
+        if (rec.nbuckets && fread(counts.data(), sizeof(latency::BucketCount), rec.nbuckets, f) != rec.nbuckets) break;
+        uint64_t row = windows.rows();
+        windows.col("batch").push(batch);
+        windows.col("run").push(run);
+        windows.col("client").push(client);
+        windows.col("mode").push(mode);
+        windows.col("phase").push(static_cast<uint64_t>(rec.phase) + 1);
+        windows.col("dir").push(std::string(rec.dir ? "write" : "read"));
+        windows.col("start_ns").push(rec.window_start_ns);
+        windows.col("count").push(rec.count);
+        windows.col("p50_ns").push(rec.p50_ns);
+        windows.col("p99_ns").push(rec.p99_ns);
+        windows.col("p999_ns").push(rec.p999_ns);
+        windows.col("max_ns").push(rec.max_ns);
+        for (const auto& c : counts) {
+            buckets.col("batch").push(batch);
+            buckets.col("window").push(row);
+            buckets.col("bucket").push(static_cast<uint64_t>(c.index));
+            buckets.col("count").push(static_cast<uint64_t>(c.count));
+        }
+    }
+    fclose(f);
+}
+
+inline void add_telemetry_file(Table& t, uint64_t batch, const std::string& run, const std::string& path) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return;
+    telemetry::TelemetryFileHeader header;
+    if (fread(&header, sizeof(header), 1, f) != 1 || memcmp(header.magic, "FBTEL001", 8) != 0) {
+        fclose(f);
+        return;
+    }
+    std::vector<telemetry::SourceDescriptor> sources(header.num_sources);
+    if (header.num_sources &&
+        fread(sources.data(), sizeof(telemetry::SourceDescriptor), header.num_sources, f) != header.num_sources) {
+        fclose(f);
+        return;
+    }
+    std::string file = std::filesystem::path(path).stem().string();
+    telemetry::SampleRecord rec;
+    while (fread(&rec, sizeof(rec), 1, f) == 1) {
+        if (rec.source >= sources.size()) continue;
+        const auto& src = sources[rec.source];
+        std::string source(src.name, strnlen(src.name, sizeof(src.name)));
+        for (uint32_t c = 0; c < src.ncols && c < static_cast<uint32_t>(telemetry::kMaxColumns); c++) {
+            t.col("batch").push(batch);
+            t.col("run").push(run);
+            t.col("file").push(file);
+            t.col("source").push(source);
+            t.col("metric").push(std::string(src.columns[c], strnlen(src.columns[c], telemetry::kColumnNameLen)));
+            t.col("ts_ns").push(rec.timestamp_ns);
+            t.col("value").push(rec.values[c]);
+        }
+    }
+    fclose(f);
+}
+
+// Everything one run left in `dir`, as one batch appended to `store_path`
+inline bool collect(const std::string& dir, const std::string& run,
+                    const std::vector<std::pair<std::string, std::string>>& labels, const std::string& store_path,
+                    size_t& rows, std::string& error) {
+    namespace fs = std::filesystem;
+    uint64_t batch = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+            .count());
+    std::vector<Table> tables = make_tables();
+    Table& runs = tables[0];
+    Table& phases = tables[1];
+    Table& windows = tables[2];
+    Table& buckets = tables[3];
+    Table& tel = tables[4];
+
+    for (const auto& [key, value] : labels) {
+        runs.col("batch").push(batch);
+        runs.col("run").push(run);
+        runs.col("key").push(key);
+        runs.col("value").push(value);
+    }
+    std::error_code ec;
+    std::vector<fs::path> entries;
+    for (const auto& e : fs::directory_iterator(dir, ec)) entries.push_back(e.path());
+    for (const auto& e : fs::directory_iterator(dir + "/telemetry", ec)) entries.push_back(e.path());
+    std::sort(entries.begin(), entries.end());
+    for (const auto& path : entries) {
+        std::string client, mode;
+        uint64_t phase = 0;
+        if (path.extension() == ".json" && split_label(path.stem().string(), client, mode, phase)) {
+            results::PhaseSummary summary;
+            std::string parse_error;
+            if (results::parse_fio_json(path.string(), summary, parse_error)) {
+                add_phase_rows(phases, batch, run, client, mode, phase, summary);
+            }
+        } else if (path.extension() == ".lat") {
+            add_latency_file(windows, buckets, batch, run, path.string());
+        } else if (path.extension() == ".tel") {
+            add_telemetry_file(tel, batch, run, path.string());
+        }
+    }
+    rows = 0;
+    std::vector<const Table*> out;
+    for (const auto& t : tables) {
+        rows += t.rows();
+        out.push_back(&t);
+    }
+    return store::append(store_path, out, error);
+}
+
+struct Options {
+    double slo_us = 1000;
+    std::string baseline;  // Run id or prefix (empty = first run in the file)
+};
+
+// Rows of `t` whose batch is the latest one appended for their run
+inline std::vector<uint8_t> latest_batch_mask(const Table& t, const std::map<uint32_t, uint64_t>& latest_by_run,
+                                              const store::Column& run_col) {
+    const auto& batch = t.col("batch").u64;
+    std::vector<uint8_t> keep(t.rows());
+    for (size_t i = 0; i < keep.size(); i++) {
+        auto it = latest_by_run.find(run_col.codes[i]);
+        keep[i] = it != latest_by_run.end() && it->second == batch[i];
+    }
+    return keep;
+}
+
+inline bool analyze(const std::string& path, const Options& opts, std::ostream& out, std::string& error) {
+    auto started = std::chrono::steady_clock::now();
+    store::Tables tables;
+    if (!store::read(path, tables, error)) return false;
+    if (!error.empty()) {
+        out << "WARNING: " << error << "\n";
+        error.clear();
+    }
+    if (!tables.count("phases")) {
+        error = path + " has no phase results";
+        return false;
+    }
+    const Table& phases = tables.at("phases");
+    const auto& p_run = phases.col("run");
+    const auto& p_batch = phases.col("batch").u64;
+
+    // Latest batch per run code, and runs in the order they were first appended
+    std::map<uint32_t, uint64_t> latest;
+    std::vector<uint32_t> run_order;
+    for (size_t i = 0; i < phases.rows(); i++) {
+        auto [it, inserted] = latest.emplace(p_run.codes[i], p_batch[i]);
+        if (inserted) run_order.push_back(p_run.codes[i]);
+        else it->second = std::max(it->second, p_batch[i]);
+    }
+    std::vector<uint8_t> keep = latest_batch_mask(phases, latest, p_run);
+    const auto& client = phases.col("client");
+    const auto& mode = phases.col("mode");
+    const auto& phase = phases.col("phase").u64;
+    const auto& dir = phases.col("dir");
+    const auto& iops = phases.col("iops").f64;
+    const auto& p99 = phases.col("p99_ns").f64;
+    size_t scanned = phases.rows();
+
+    out << std::fixed;
+    out << "Runs: " << run_order.size() << " (" << path << ")\n";
+
+    // Jain's index: (sum x)^2 / (n * sum x^2) over client throughput
+    std::map<std::tuple<uint32_t, uint32_t, uint64_t>, std::map<uint32_t, double>> throughput;
+    for (size_t i = 0; i < phases.rows(); i++) {
+        if (keep[i]) throughput[{p_run.codes[i], mode.codes[i], phase[i]}][client.codes[i]] += iops[i];
+    }
+    out << "\nJain's fairness index (client IOPS; phase 0 = whole run)\n";
+    out << std::left << std::setw(28) << "run" << std::setw(8) << "mode" << std::right << std::setw(6) << "phase"
+        << std::setw(9) << "clients" << std::setw(8) << "jain" << "\n";
+    for (uint32_t r : run_order) {
+        for (const auto& [key, clients] : throughput) {
+            if (std::get<0>(key) != r) continue;
+            double sum = 0, sq = 0;
+            for (const auto& [c, x] : clients) {
+                sum += x;
+                sq += x * x;
+            }
+            double jain = sq > 0 ? sum * sum / (clients.size() * sq) : 0;
+            out << std::left << std::setw(28) << p_run.dict[r] << std::setw(8) << mode.dict[std::get<1>(key)]
+                << std::right << std::setw(6) << std::get<2>(key) << std::setw(9) << clients.size()
+                << std::setw(8) << std::setprecision(3) << jain << "\n";
+        }
+    }
+
+    // p99 against the baseline run
+    int base = -1;
+    for (uint32_t r : run_order) {
+        const std::string& id = p_run.dict[r];
+        if (opts.baseline.empty() || id.compare(0, opts.baseline.size(), opts.baseline) == 0) {
+            base = static_cast<int>(r);
+            break;
+        }
+    }
+    if (base < 0) {
+        error = "no run matches baseline '" + opts.baseline + "'";
+        return false;
+    }
+    using Key = std::tuple<uint32_t, uint32_t, uint64_t, uint32_t>;  // client, mode, phase, dir
+    std::map<Key, double> base_p99;
+    for (size_t i = 0; i < phases.rows(); i++) {
+        if (keep[i] && p_run.codes[i] == static_cast<uint32_t>(base)) {
+            base_p99[{client.codes[i], mode.codes[i], phase[i], dir.codes[i]}] = p99[i];
+        }
+    }
+    out << "\np99 vs baseline " << p_run.dict[base] << "\n";
+    if (run_order.size() < 2) out << "  (only one run)\n";
+    out << std::left << std::setw(28) << "run" << std::setw(16) << "client" << std::setw(8) << "mode" << std::right
+        << std::setw(6) << "phase" << std::setw(7) << "dir" << std::setw(12) << "p99_us" << std::setw(12)
+        << "base_us" << std::setw(9) << "delta" << "\n";
+    for (uint32_t r : run_order) {
+        if (r == static_cast<uint32_t>(base)) continue;
+        for (size_t i = 0; i < phases.rows(); i++) {
+            if (!keep[i] || p_run.codes[i] != r) continue;
+            auto it = base_p99.find({client.codes[i], mode.codes[i], phase[i], dir.codes[i]});
+            if (it == base_p99.end() || it->second <= 0) continue;
+            out << std::left << std::setw(28) << p_run.dict[r] << std::setw(16) << client.str(i) << std::setw(8)
+                << mode.str(i) << std::right << std::setw(6) << phase[i] << std::setw(7) << dir.str(i)
+                << std::setw(12) << std::setprecision(1) << p99[i] / 1000 << std::setw(12) << it->second / 1000
+                << std::setw(8) << (p99[i] / it->second - 1) * 100 << "%\n";
+        }
+    }
+
+    // SLO violations from the native engine's windows and buckets
+    if (tables.count("windows") && tables.count("buckets")) {
+        const Table& windows = tables.at("windows");
+        const Table& buckets = tables.at("buckets");
+        const auto& w_run = windows.col("run");
+        const auto& w_batch = windows.col("batch").u64;
+        std::vector<uint8_t> w_keep = latest_batch_mask(windows, latest, w_run);
+        // Bucket rows name their window by row within the batch; a batch's windows are contiguous
+        std::map<uint64_t, size_t> first_row;
+        for (size_t i = 0; i < windows.rows(); i++) first_row.emplace(w_batch[i], i);
+
+        const uint64_t slo_ns = static_cast<uint64_t>(opts.slo_us * 1000);
+        int first_bad = latency::kNumBuckets;
+        for (int b = 0; b < latency::kNumBuckets; b++) {
+            if (latency::bucket_upper(b) > slo_ns) {
+                first_bad = b;
+                break;
+            }
+        }
+        std::vector<uint64_t> over(windows.rows(), 0), total(windows.rows(), 0);
+        const auto& b_batch = buckets.col("batch").u64;
+        const auto& b_window = buckets.col("window").u64;
+        const auto& b_bucket = buckets.col("bucket").u64;
+        const auto& b_count = buckets.col("count").u64;
+        uint64_t cached_batch = UINT64_MAX;
+        size_t base_row = 0;
+        for (size_t i = 0; i < buckets.rows(); i++) {
+            if (b_batch[i] != cached_batch) {
+                cached_batch = b_batch[i];
+                auto it = first_row.find(cached_batch);
+                base_row = it == first_row.end() ? SIZE_MAX : it->second;
+            }
+            if (base_row == SIZE_MAX) continue;
+            size_t w = base_row + b_window[i];
+            if (w >= total.size()) continue;
+            total[w] += b_count[i];
+            if (b_bucket[i] >= static_cast<uint64_t>(first_bad)) over[w] += b_count[i];
+        }
+        scanned += windows.rows() + buckets.rows();
+
+        const auto& w_client = windows.col("client");
+        const auto& w_mode = windows.col("mode");
+        const auto& w_phase = windows.col("phase").u64;
+        const auto& w_dir = windows.col("dir");
+        const auto& w_p99 = windows.col("p99_ns").u64;
+        struct Slo { uint64_t over = 0, total = 0, windows = 0, bad_windows = 0; };
+        std::map<std::tuple<uint32_t, uint32_t, uint32_t, uint64_t, uint32_t>, Slo> slo;
+        for (size_t i = 0; i < windows.rows(); i++) {
+            if (!w_keep[i] || total[i] == 0) continue;
+            Slo& s = slo[{w_run.codes[i], w_client.codes[i], w_mode.codes[i], w_phase[i], w_dir.codes[i]}];
+            s.over += over[i];
+            s.total += total[i];
+            s.windows++;
+            s.bad_windows += w_p99[i] > slo_ns;
+        }
+        out << "\nSLO violations (latency > " << std::setprecision(0) << opts.slo_us << "us)\n";
+        out << std::left << std::setw(28) << "run" << std::setw(16) << "client" << std::setw(8) << "mode"
+            << std::right << std::setw(6) << "phase" << std::setw(7) << "dir" << std::setw(12) << "requests"
+            << std::setw(10) << "over" << std::setw(14) << "p99>SLO wins" << "\n";
+        for (const auto& [key, s] : slo) {
+            out << std::left << std::setw(28) << w_run.dict[std::get<0>(key)] << std::setw(16)
+                << w_client.dict[std::get<1>(key)] << std::setw(8) << w_mode.dict[std::get<2>(key)] << std::right
+                << std::setw(6) << std::get<3>(key) << std::setw(7) << w_dir.dict[std::get<4>(key)] << std::setw(12)
+                << s.total << std::setw(9) << std::setprecision(3) << 100.0 * s.over / s.total << "%"
+                << std::setw(8) << s.bad_windows << "/" << std::left << std::setw(5) << s.windows << std::right
+                << "\n";
+        }
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    out << "\nScanned " << scanned << " rows in " << std::setprecision(1) << ms << " ms\n";
+    return true;
+}
+
+}  // namespace analysis
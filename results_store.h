@@ -0,0 +1,281 @@
+// results_store.h
+// Append-only columnar results file, one per experiment.
+//
+// A run appends one batch of tables (phase summaries, latency windows and
+// their histogram buckets, telemetry) to <output>/results.fbc; a sweep
+// appends every point's batch to one sweep_results.fbc. Each table of a
+// batch is a block holding its columns as contiguous arrays, so a reader
+// maps a whole column with one read and analysis scans plain vectors
+// instead of re-parsing thousands of JSON files.
+//
+// File layout (little endian):
+//   char magic[8] = "FBCOL001"
+//   repeated block:
+//     BlockHeader
+//     repeated ncols: ColumnHeader, then `bytes` of data
+//       U64 / F64: nrows values
+//       Str:       uint32 code per row, uint32 ndict, then ndict x {uint32 len, bytes}
+//
+// Blocks are written under an exclusive flock, so sweep shards can share a
+// file. A block cut short by a crash ends the readable file: read() keeps
+// the complete blocks before it.
+
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+namespace store {
+
+enum class Type : uint8_t { U64 = 1, F64 = 2, Str = 3 };
+
+#pragma pack(push, 1)
+struct BlockHeader {
+    char table[24];
+    uint32_t ncols;
+    uint32_t reserved;
+    uint64_t nrows;
+};
+
+struct ColumnHeader {
+    char name[24];
+    uint8_t type;             // Type
+    uint8_t reserved[7];
+    uint64_t bytes;
+};
+#pragma pack(pop)
+
+struct Column {
+    std::string name;
+    Type type;
+    std::vector<uint64_t> u64;
+    std::vector<double> f64;
+    std::vector<uint32_t> codes;      // Str: index into dict
+    std::vector<std::string> dict;
+    std::unordered_map<std::string, uint32_t> lookup;
+
+    size_t size() const { return type == Type::U64 ? u64.size() : type == Type::F64 ? f64.size() : codes.size(); }
+
+    uint32_t intern(const std::string& s) {
+        auto it = lookup.find(s);
+        if (it != lookup.end()) return it->second;
+        uint32_t code = static_cast<uint32_t>(dict.size());
+        dict.push_back(s);
+        lookup.emplace(s, code);
+        return code;
+    }
+    void push(uint64_t v) { u64.push_back(v); }
+    void push(double v) { f64.push_back(v); }
+    void push(const std::string& s) { codes.push_back(intern(s)); }
+    const std::string& str(size_t row) const { return dict[codes[row]]; }
+};
+
+class Table {
+public:
+    Table() = default;
+    Table(std::string name, const std::vector<std::pair<std::string, Type>>& schema) : table_name(std::move(name)) {
+        for (const auto& [col, type] : schema) add_column(col, type);
+    }
+
+    const std::string& name() const { return table_name; }
+    size_t rows() const { return cols.empty() ? 0 : cols[0].size(); }
+    std::vector<Column>& columns() { return cols; }
+    const std::vector<Column>& columns() const { return cols; }
+
+    Column& col(const std::string& n) { return cols[index.at(n)]; }
+    const Column& col(const std::string& n) const { return cols[index.at(n)]; }
+    bool has(const std::string& n) const { return index.count(n) > 0; }
+
+    Column& add_column(const std::string& n, Type type) {
+        index[n] = cols.size();
+        cols.push_back(Column{n, type, {}, {}, {}, {}, {}});
+        return cols.back();
+    }
+
+private:
+    std::string table_name;
+    std::vector<Column> cols;
+    std::map<std::string, size_t> index;
+};
+
+using Tables = std::map<std::string, Table>;
+
+namespace detail {
+
+inline void put(std::string& buf, const void* p, size_t n) { buf.append(static_cast<const char*>(p), n); }
+
+inline std::string encode(const Table& t) {
+    std::string buf;
+    BlockHeader bh;
+    memset(&bh, 0, sizeof(bh));
+    strncpy(bh.table, t.name().c_str(), sizeof(bh.table) - 1);
+    bh.ncols = static_cast<uint32_t>(t.columns().size());
+    bh.nrows = t.rows();
+    put(buf, &bh, sizeof(bh));
+    for (const auto& c : t.columns()) {
+        std::string data;
+        if (c.type == Type::U64) put(data, c.u64.data(), c.u64.size() * sizeof(uint64_t));
+        if (c.type == Type::F64) put(data, c.f64.data(), c.f64.size() * sizeof(double));
+        if (c.type == Type::Str) {
+            put(data, c.codes.data(), c.codes.size() * sizeof(uint32_t));
+            uint32_t ndict = static_cast<uint32_t>(c.dict.size());
+            put(data, &ndict, sizeof(ndict));
+            for (const auto& s : c.dict) {
+                uint32_t len = static_cast<uint32_t>(s.size());
+                put(data, &len, sizeof(len));
+                put(data, s.data(), s.size());
+            }
+        }
+        ColumnHeader ch;
+        memset(&ch, 0, sizeof(ch));
+        strncpy(ch.name, c.name.c_str(), sizeof(ch.name) - 1);
+        ch.type = static_cast<uint8_t>(c.type);
+        ch.bytes = data.size();
+        put(buf, &ch, sizeof(ch));
+        buf += data;
+    }
+    return buf;
+}
+
+inline bool write_all(int fd, const std::string& buf) {
+    size_t done = 0;
+    while (done < buf.size()) {
+        ssize_t n = write(fd, buf.data() + done, buf.size() - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+}  // namespace detail
+
+// Append every non-empty table as one block each, creating the file if needed
+inline bool append(const std::string& path, const std::vector<const Table*>& tables, std::string& error) {
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        error = "Cannot open " + path + ": " + strerror(errno);
+        return false;
+    }
+    flock(fd, LOCK_EX);
+    std::string buf;
+    if (lseek(fd, 0, SEEK_END) == 0) buf.append("FBCOL001", 8);
+    for (const Table* t : tables) {
+        if (t->rows() > 0) buf += detail::encode(*t);
+    }
+    bool ok = detail::write_all(fd, buf) && fdatasync(fd) == 0;
+    if (!ok) error = "Cannot append to " + path + ": " + strerror(errno);
+    flock(fd, LOCK_UN);
+    close(fd);
+    return ok;
+}
+
+// Every table in the file, blocks of the same table concatenated (string codes remapped)
+inline bool read(const std::string& path, Tables& out, std::string& error) {
+    out.clear();
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) {
+        error = "Cannot open " + path + ": " + strerror(errno);
+        return false;
+    }
+    std::vector<char> file;
+    char chunk[1 << 16];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) file.insert(file.end(), chunk, chunk + n);
+    fclose(f);
+    if (file.size() < 8 || memcmp(file.data(), "FBCOL001", 8) != 0) {
+        error = path + " is not a results store";
+        return false;
+    }
+
+    size_t pos = 8;
+    auto take = [&](void* dst, size_t len) {
+        if (pos + len > file.size()) return false;
+        memcpy(dst, file.data() + pos, len);
+        pos += len;
+        return true;
+    };
+    while (pos < file.size()) {
+        size_t block_start = pos;
+        BlockHeader bh;
+        if (!take(&bh, sizeof(bh))) break;
+        std::string name(bh.table, strnlen(bh.table, sizeof(bh.table)));
+        Table block(name, {});
+        bool complete = true;
+        for (uint32_t c = 0; c < bh.ncols && complete; c++) {
+            ColumnHeader ch;
+            if (!take(&ch, sizeof(ch)) || pos + ch.bytes > file.size()) {
+                complete = false;
+                break;
+            }
+            Column& col = block.add_column(std::string(ch.name, strnlen(ch.name, sizeof(ch.name))),
+                                           static_cast<Type>(ch.type));
+            const char* data = file.data() + pos;
+            if (col.type == Type::U64) {
+                col.u64.resize(bh.nrows);
+                memcpy(col.u64.data(), data, bh.nrows * sizeof(uint64_t));
+            } else if (col.type == Type::F64) {
+                col.f64.resize(bh.nrows);
+                memcpy(col.f64.data(), data, bh.nrows * sizeof(double));
+            } else {
+                col.codes.resize(bh.nrows);
+                memcpy(col.codes.data(), data, bh.nrows * sizeof(uint32_t));
+                size_t p = bh.nrows * sizeof(uint32_t);
+                uint32_t ndict = 0;
+                memcpy(&ndict, data + p, sizeof(ndict));
+                p += sizeof(ndict);
+                for (uint32_t d = 0; d < ndict; d++) {
+                    uint32_t len = 0;
+                    memcpy(&len, data + p, sizeof(len));
+                    p += sizeof(len);
+                    col.dict.emplace_back(data + p, len);
+                    p += len;
+                }
+            }
+            pos += ch.bytes;
+        }
+        if (!complete) {
+            pos = block_start;
+            break;
+        }
+
+        // Concatenate onto the table read so far
+        auto it = out.find(name);
+        if (it == out.end()) {
+            for (auto& col : block.columns()) {
+                for (uint32_t d = 0; d < col.dict.size(); d++) col.lookup.emplace(col.dict[d], d);
+            }
+            out.emplace(name, std::move(block));
+            continue;
+        }
+        Table& table = it->second;
+        for (auto& src : block.columns()) {
+            if (!table.has(src.name)) {
+                error = path + ": blocks of table '" + name + "' disagree on column " + src.name;
+                return false;
+            }
+            Column& dst = table.col(src.name);
+            if (dst.type == Type::U64) dst.u64.insert(dst.u64.end(), src.u64.begin(), src.u64.end());
+            if (dst.type == Type::F64) dst.f64.insert(dst.f64.end(), src.f64.begin(), src.f64.end());
+            if (dst.type == Type::Str) {
+                std::vector<uint32_t> remap(src.dict.size());
+                for (size_t d = 0; d < src.dict.size(); d++) remap[d] = dst.intern(src.dict[d]);
+                for (uint32_t code : src.codes) dst.codes.push_back(remap[code]);
+            }
+        }
+    }
+    if (pos < file.size()) error = path + ": ignored an incomplete block at byte " + std::to_string(pos);
+    return true;
+}
+
+}  // namespace store
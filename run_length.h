@@ -0,0 +1,299 @@
+// run_length.h
+// Adaptive run length: end a phase once its p99 is known well enough.
+//
+// Every phase has a fixed runtime, which is the upper bound here. Inside each
+// tenant, an Estimator fed by the native engine's latency collector splits
+// the phase into batches: consecutive 1s windows merged until a direction has
+// kMinBatchRequests requests. It takes each batch's p99 and keeps their
+// running mean and variance (the method of batch means). The phase counts as
+// settled once it has run --adaptive-min-s windows, and once for each
+// direction that filled at least kMinBatches batches, the 95% Student-t
+// interval of the mean batch p99 is within +-ci_pct percent of it.
+//
+// A Controller (the parent of a tenant group, or the benchmark itself for a
+// single workload) watches the schedule. Phase boundaries come from one
+// shared clock (tenant_sync.h), so a phase cannot end early for one tenant
+// alone. Instead, when every tenant's current phase is settled, and is not a
+// warmup phase, the controller moves the next boundary of the whole schedule
+// to the next 1s latency window boundary, so every window still belongs to
+// one phase. It does this by growing a shared shift (whole windows) that
+// every engine subtracts from the boundaries it has not reached yet. Any
+// other check (the SLO violation interval of slo_monitor.h) can hold a cut
+// back.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "latency_recorder.h"
+#include "tenant_sync.h"
+
+namespace runlen {
+
+constexpr int kMaxTenants = 16;
+constexpr uint64_t kMinBatchRequests = 500;  // Five requests above the batch p99
+constexpr uint64_t kMinBatches = 5;
+constexpr uint64_t kPollNs = 100000000ULL;
+constexpr uint64_t kWindowNs = 1000000000ULL;  // The native engine's latency window
+
+// Two-sided 95% Student t quantile
+inline double t95(uint64_t df) {
+    static const double table[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                   2.201,  2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                   2.080,  2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (df == 0) return INFINITY;
+    return df <= 30 ? table[df - 1] : 1.96;
+}
+
+struct BatchMeans {
+    uint64_t n = 0;
+    double mean = 0;
+    double m2 = 0;
+
+    void add(double x) {
+        n++;
+        double delta = x - mean;
+        mean += delta / static_cast<double>(n);
+        m2 += delta * (x - mean);
+    }
+    double half_width() const {
+        if (n < 2) return INFINITY;
+        return t95(n - 1) * std::sqrt(m2 / static_cast<double>(n - 1) / static_cast<double>(n));
+    }
+    // Half-width relative to the mean
+    double relative() const { return mean > 0 ? half_width() / mean : INFINITY; }
+};
+
+struct TenantState {
+    std::atomic<uint32_t> settled_phase;  // 1-based phase whose p99 has settled, 0 = none
+    std::atomic<double> p99_ns;           // Mean batch p99 of the widest direction
+    std::atomic<double> relative;         // Its relative half-width
+};
+
+struct Board {
+    std::atomic<uint64_t> shift_ns;       // How far the schedule has moved forward
+    double ci_pct;
+    uint64_t min_windows;
+    TenantState tenants[kMaxTenants];
+};
+
+static_assert(std::atomic<double>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+              "the board is shared between processes");
+
+// Tenant side: batch p99s of the running phase
+class Estimator {
+public:
+    Estimator(Board* board, int index) : board(board), state(board->tenants[index]) {}
+
+    const std::atomic<uint64_t>* shift() const { return &board->shift_ns; }
+
+    // LatencyRecorder observer
+    void observe(uint64_t window_index, int phase, int dir, const latency::Histogram& h) {
+        if (phase != current_phase) {
+            current_phase = phase;
+            windows = 0;
+            for (int d = 0; d < 2; d++) {
+                batch[d].clear();
+                means[d] = BatchMeans();
+            }
+            state.settled_phase.store(0);
+        }
+        if (window_index != last_window) {
+            last_window = window_index;
+            windows++;
+        }
+        batch[dir].merge(h);
+        if (batch[dir].count >= kMinBatchRequests) {
+            means[dir].add(static_cast<double>(batch[dir].percentile(99)));
+            batch[dir].clear();
+        }
+        publish();
+    }
+
+private:
+    Board* board;
+    TenantState& state;
+    int current_phase = -1;
+    uint64_t last_window = UINT64_MAX;
+    uint64_t windows = 0;
+    latency::Histogram batch[2];
+    BatchMeans means[2];
+
+    void publish() {
+        bool any = false, settled = windows >= board->min_windows;
+        double worst = 0, p99 = 0;
+        for (int d = 0; d < 2; d++) {
+            if (means[d].n == 0) continue;  // Too few requests for one batch: does not hold the phase
+            any = true;
+            double rel = means[d].n >= kMinBatches ? means[d].relative() : INFINITY;
+            settled = settled && rel * 100 <= board->ci_pct;
+            if (rel >= worst) {
+                worst = rel;
+                p99 = means[d].mean;
+            }
+        }
+        state.p99_ns.store(p99);
+        state.relative.store(worst);
+        state.settled_phase.store(any && settled ? static_cast<uint32_t>(current_phase + 1) : 0);
+    }
+};
+
+// A move of the schedule: at `at_ns`, the boundaries ahead moved `cut_ns` earlier
+struct Cut {
+    uint64_t at_ns;
+    uint64_t cut_ns;
+};
+
+// Parent side: moves the schedule once every tenant's phase has settled
+class Controller {
+public:
+    // tenant, 0-based phase; false holds the cut back, detail is logged with the cut
+    using Check = std::function<bool(int tenant, int phase, std::string& detail)>;
+
+    Controller() = default;
+    ~Controller() {
+        stop();
+        if (board) munmap(board, sizeof(Board));
+    }
+
+    Controller(const Controller&) = delete;
+    Controller& operator=(const Controller&) = delete;
+
+    // Map the board; call before forking the tenants
+    bool open(size_t tenants, double ci_pct, int min_runtime_s, std::string& error) {
+        if (tenants > static_cast<size_t>(kMaxTenants)) {
+            error = "adaptive run length supports at most " + std::to_string(kMaxTenants) + " tenants";
+            return false;
+        }
+        void* p = mmap(nullptr, sizeof(Board), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) {
+            error = std::string("Cannot map run length board: ") + strerror(errno);
+            return false;
+        }
+        board = new (p) Board();
+        board->ci_pct = ci_pct;
+        board->min_windows = static_cast<uint64_t>(std::max(min_runtime_s, 1));
+        return true;
+    }
+
+    bool is_open() const { return board != nullptr; }
+    Estimator estimator(int index) { return Estimator(board, index); }
+
+    // Once the schedule is known; tenants[i] names the tenant of board slot i
+    void start(const std::vector<tenant_sync::PhaseWindow>& schedule, const std::vector<std::string>& tenants,
+               const std::vector<int>& warmup_phases, Check extra, std::function<void(const std::string&)> logger) {
+        planned = schedule;
+        names = tenants;
+        warmups = warmup_phases;
+        check = std::move(extra);
+        log = std::move(logger);
+        running.store(true);
+        thread = std::thread([this]() { loop(); });
+    }
+
+    void stop() {
+        if (!thread.joinable()) return;
+        running.store(false);
+        thread.join();
+    }
+
+    uint64_t saved_ns() const { return board ? board->shift_ns.load() : 0; }
+    const std::vector<Cut>& cuts() const { return cut_list; }
+
+    // The schedule as it ran: each boundary moved by the cuts made before it was reached
+    std::vector<tenant_sync::PhaseWindow> actual_schedule() const {
+        auto actual = [this](uint64_t planned_ns) {
+            uint64_t shift = 0;
+            for (const auto& c : cut_list) {
+                if (planned_ns - shift <= c.at_ns) break;
+                shift += c.cut_ns;
+            }
+            return planned_ns - shift;
+        };
+        std::vector<tenant_sync::PhaseWindow> out = planned;
+        for (auto& w : out) {
+            w.start_ns = actual(w.start_ns);
+            w.end_ns = actual(w.end_ns);
+        }
+        return out;
+    }
+
+private:
+    Board* board = nullptr;
+    std::vector<tenant_sync::PhaseWindow> planned;
+    std::vector<std::string> names;
+    std::vector<int> warmups;
+    Check check;
+    std::function<void(const std::string&)> log;
+    std::atomic<bool> running{false};
+    std::thread thread;
+    std::vector<Cut> cut_list;
+
+    void loop() {
+        while (running.load()) {
+            usleep(kPollNs / 1000);
+            try_cut();
+        }
+    }
+
+    void try_cut() {
+        uint64_t now = latency::monotonic_ns();
+        uint64_t shift = board->shift_ns.load();
+        uint64_t t = now + shift;  // Position in the planned schedule
+        uint64_t next = UINT64_MAX;
+        for (const auto& w : planned) {
+            if (w.start_ns > t) next = std::min(next, w.start_ns);
+            if (w.end_ns > t) next = std::min(next, w.end_ns);
+        }
+        if (next == UINT64_MAX) return;
+
+        std::ostringstream detail;
+        detail << std::fixed << std::setprecision(1);
+        bool any = false;
+        for (size_t i = 0; i < names.size(); i++) {
+            const tenant_sync::PhaseWindow* current = nullptr;
+            for (const auto& w : planned) {
+                if (w.tenant == names[i] && w.start_ns <= t && t < w.end_ns) current = &w;
+            }
+            if (!current) continue;  // Done with its phases
+            int phase = current->phase - 1;
+            if (phase < warmups[i]) return;
+            const TenantState& s = board->tenants[i];
+            if (s.settled_phase.load() != static_cast<uint32_t>(current->phase)) return;
+            std::string extra;
+            if (check && !check(static_cast<int>(i), phase, extra)) return;
+            detail << (any ? ", " : "") << names[i] << " phase " << current->phase << " p99 "
+                   << s.p99_ns.load() / 1000 << "us +-" << 100 * s.relative.load() << "%" << extra;
+            any = true;
+        }
+        if (!any) return;
+
+        // Whole windows only: the boundary lands on the latency windows' 1s grid (boundaries start
+        // on it), so no window straddles two phases and phase_of() assigns every window exactly
+        uint64_t cut = (next - t) / kWindowNs * kWindowNs;
+        if (cut == 0) return;  // The boundary is less than a window away anyway
+        board->shift_ns.store(shift + cut);
+        cut_list.push_back({now, cut});
+        std::ostringstream msg;
+        msg << std::fixed << std::setprecision(1) << "  Adaptive run length: settled (" << detail.str()
+            << "), next boundary moved " << cut / 1e9 << "s earlier";
+        log(msg.str());
+    }
+};
+
+}  // namespace runlen
@@ -0,0 +1,399 @@
+// slo_controller.h
+// Closed-loop, dirty-page-informed throttling of the noisy tenant.
+//
+// Every tick (default 250ms) the controller reads the noisy cgroup's
+// memory.stat (file_dirty + file_writeback) and the system's disk write
+// bandwidth (/proc/vmstat pgpgout delta, EWMA-smoothed), and projects how
+// long the backlog takes to drain:
+//
+//     drain = (file_dirty + file_writeback) / write_bw
+//
+// A long drain means the next writeback burst will occupy the device for a
+// long time, which is when the protected tenant's reads miss their p99. When
+// the protected tenant runs on the native engine its .lat file is tailed as
+// well, so the last completed window's observed p99 closes the loop.
+//
+//   tighten  if drain > drain target, or observed p99 > SLO:
+//            memory.high = max(floor, min(memory.high, memory.current) * 0.8)
+//            io.weight   = max(1, io.weight / 2)
+//   relax    after kRelaxTicks healthy ticks (drain < target/2 and p99 < 0.7 SLO):
+//            memory.high *= 1.25, io.weight *= 2, capped at their initial values
+//
+// notify_pressure() (wired to the protected tenant's PSI triggers) runs a
+// tick immediately and counts as a violation, so a stall is acted on within
+// milliseconds rather than at the next tick.
+//
+// The protected cgroup also gets an io.latency target equal to the SLO on
+// the test file's disk, so the kernel throttles the neighbour's queue depth
+// between ticks. When the protected tenant publishes a live miss ratio
+// curve (native engine, mrc_tracker.h), its memory.low follows the cache
+// size that holds 95% of the hits an unbounded cache would get, updated
+// when that moves by more than 10%. Every tick is logged as CSV with CLOCK_MONOTONIC timestamps
+// (same clock as the .lat windows and telemetry samples).
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+#include "latency_recorder.h"
+#include "mrc_tracker.h"
+#include "telemetry_sampler.h"
+
+namespace control {
+
+using latency::monotonic_ns;
+
+struct ControllerOptions {
+    uint64_t interval_ns = 250000000ULL;
+    uint64_t slo_p99_ns = 1000000ULL;
+    uint64_t drain_target_ns = 500000000ULL;
+    std::string noisy_cgroup_dir;      // Throttled tenant (client2)
+    std::string protected_cgroup_dir;  // Tenant whose p99 is guarded (client1), may be empty
+    std::string protected_lat_file;    // Its native-engine .lat file, may not exist
+    std::string protected_mrc_file;    // Its live MRC (.mrc), may not exist; empty = leave memory.low alone
+    std::string io_device;             // "MAJ:MIN" of the disk for io.latency, empty to skip
+    std::string log_file;
+};
+
+// "MAJ:MIN" of the whole disk holding `path` (io.latency rejects partitions)
+inline std::string disk_devno_for(const std::string& path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) return "";
+    std::string devno = std::to_string(major(st.st_dev)) + ":" + std::to_string(minor(st.st_dev));
+    std::string sys = "/sys/dev/block/" + devno;
+    if (access((sys + "/partition").c_str(), F_OK) == 0) {
+        FILE* f = fopen((sys + "/../dev").c_str(), "r");
+        if (!f) return devno;
+        char buf[32] = {0};
+        if (fgets(buf, sizeof(buf), f)) {
+            devno = buf;
+            devno.erase(devno.find_last_not_of(" \n") + 1);
+        }
+        fclose(f);
+    }
+    if (access(sys.c_str(), F_OK) != 0) return "";  // Not a block device (tmpfs, overlay...)
+    return devno;
+}
+
+class DirtySloController {
+public:
+    static constexpr int kRelaxTicks = 4;
+    static constexpr uint64_t kMinMemoryHigh = 64ULL << 20;
+    static constexpr uint64_t kUnlimited = UINT64_MAX;
+    static constexpr double kMemoryLowShare = 0.95;
+
+    explicit DirtySloController(ControllerOptions opts) : options(std::move(opts)) {}
+
+    ~DirtySloController() { stop(); }
+
+    bool start(std::string& error) {
+        const std::string& noisy = options.noisy_cgroup_dir;
+        memory_stat = std::make_unique<telemetry::StatFile>(
+            noisy + "/memory.stat", std::vector<const char*>{"file_dirty", "file_writeback"});
+        vmstat = std::make_unique<telemetry::StatFile>("/proc/vmstat", std::vector<const char*>{"pgpgout"});
+        if (!memory_stat->open_file(error) || !vmstat->open_file(error)) return false;
+
+        memory_high_fd = open((noisy + "/memory.high").c_str(), O_RDWR | O_CLOEXEC);
+        memory_current_fd = open((noisy + "/memory.current").c_str(), O_RDONLY | O_CLOEXEC);
+        io_weight_fd = open((noisy + "/io.weight").c_str(), O_RDWR | O_CLOEXEC);
+        if (memory_high_fd < 0 || memory_current_fd < 0) {
+            error = "memory controller not available in " + noisy;
+            return false;
+        }
+        if (io_weight_fd < 0) warnings.push_back("io.weight not available in " + noisy + ", adjusting memory.high only");
+        if (!options.protected_mrc_file.empty() && !options.protected_cgroup_dir.empty()) {
+            memory_low_fd = open((options.protected_cgroup_dir + "/memory.low").c_str(), O_RDWR | O_CLOEXEC);
+            if (memory_low_fd < 0) {
+                warnings.push_back("memory.low not available in " + options.protected_cgroup_dir +
+                                   ", not sizing it from the MRC");
+            } else {
+                initial_memory_low = read_memory_value(memory_low_fd);
+                memory_low = initial_memory_low;
+            }
+        }
+
+        initial_memory_high = read_memory_value(memory_high_fd);
+        memory_high = initial_memory_high;
+        if (io_weight_fd >= 0) {
+            initial_io_weight = read_io_weight();
+            io_weight = initial_io_weight;
+        }
+
+        if (!options.protected_cgroup_dir.empty() && !options.io_device.empty()) {
+            std::string target = options.io_device + " target=" + std::to_string(options.slo_p99_ns / 1000);
+            if (!write_control(options.protected_cgroup_dir + "/io.latency", target)) {
+                warnings.push_back("Could not set io.latency '" + target + "' on " + options.protected_cgroup_dir);
+            }
+        }
+
+        log = fopen(options.log_file.c_str(), "w");
+        if (!log) {
+            error = "Cannot open controller log " + options.log_file + ": " + strerror(errno);
+            return false;
+        }
+        fprintf(log, "timestamp_ns,trigger,dirty_bytes,writeback_bytes,write_bw_bps,drain_ms,observed_p99_us,"
+                     "action,memory_high,io_weight,memory_low\n");
+
+        thread = std::thread([this]() { control_loop(); });
+        return true;
+    }
+
+    void stop() {
+        if (thread.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            cv.notify_all();
+            thread.join();
+        }
+        if (log) {
+            fclose(log);
+            log = nullptr;
+        }
+        for (int* fd : {&memory_high_fd, &memory_current_fd, &io_weight_fd, &lat_fd, &memory_low_fd}) {
+            if (*fd >= 0) close(*fd);
+            *fd = -1;
+        }
+    }
+
+    // Called from the PSI monitor thread
+    void notify_pressure() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pressure_pending = true;
+        }
+        cv.notify_all();
+    }
+
+    int tightened() const { return tighten_count.load(); }
+    int relaxed() const { return relax_count.load(); }
+    const std::vector<std::string>& get_warnings() const { return warnings; }
+
+private:
+    ControllerOptions options;
+    std::unique_ptr<telemetry::StatFile> memory_stat;
+    std::unique_ptr<telemetry::StatFile> vmstat;
+    int memory_high_fd = -1;
+    int memory_current_fd = -1;
+    int io_weight_fd = -1;
+    int lat_fd = -1;
+    int memory_low_fd = -1;
+    uint64_t initial_memory_low = 0;
+    uint64_t memory_low = 0;
+    int64_t mrc_mtime_ns = 0;
+    uint64_t lat_offset = 0;
+    uint64_t observed_p99 = 0;
+    uint32_t observed_window = 0;
+    uint64_t initial_memory_high = kUnlimited;
+    uint64_t memory_high = kUnlimited;
+    int initial_io_weight = 100;
+    int io_weight = 100;
+    double write_bw = 0;
+    int healthy_ticks = 0;
+    FILE* log = nullptr;
+    std::vector<std::string> warnings;
+    std::atomic<int> tighten_count{0};
+    std::atomic<int> relax_count{0};
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping = false;
+    bool pressure_pending = false;
+
+    static bool write_fd(int fd, const std::string& value) {
+        return fd >= 0 && pwrite(fd, value.data(), value.size(), 0) == static_cast<ssize_t>(value.size());
+    }
+
+    static bool write_control(const std::string& path, const std::string& value) {
+        int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        bool ok = write_fd(fd, value);
+        close(fd);
+        return ok;
+    }
+
+    static uint64_t read_memory_value(int fd) {
+        char buf[64];
+        ssize_t n = pread(fd, buf, sizeof(buf) - 1, 0);
+        if (n <= 0) return kUnlimited;
+        buf[n] = '\0';
+        if (strncmp(buf, "max", 3) == 0) return kUnlimited;
+        return strtoull(buf, nullptr, 10);
+    }
+
+    // io.weight reads "default N" followed by per-device overrides
+    int read_io_weight() {
+        char buf[256];
+        ssize_t n = pread(io_weight_fd, buf, sizeof(buf) - 1, 0);
+        if (n <= 0) return 100;
+        buf[n] = '\0';
+        const char* p = strstr(buf, "default ");
+        return p ? atoi(p + 8) : atoi(buf);
+    }
+
+    // Read any complete windows appended to the protected tenant's .lat file
+    void poll_latency() {
+        if (options.protected_lat_file.empty()) return;
+        if (lat_fd < 0) {
+            lat_fd = open(options.protected_lat_file.c_str(), O_RDONLY | O_CLOEXEC);
+            if (lat_fd < 0) return;
+            lat_offset = sizeof(latency::LatencyFileHeader);
+        }
+        while (true) {
+            latency::WindowRecord rec;
+            if (pread(lat_fd, &rec, sizeof(rec), lat_offset) != static_cast<ssize_t>(sizeof(rec))) return;
+            uint64_t next = lat_offset + sizeof(rec) + static_cast<uint64_t>(rec.nbuckets) * sizeof(latency::BucketCount);
+            struct stat st;
+            if (fstat(lat_fd, &st) != 0 || static_cast<uint64_t>(st.st_size) < next) return;  // Partial record
+            lat_offset = next;
+            // Worst direction of the newest window
+            if (rec.window_index != observed_window) {
+                observed_window = rec.window_index;
+                observed_p99 = rec.p99_ns;
+            } else {
+                observed_p99 = std::max(observed_p99, rec.p99_ns);
+            }
+        }
+    }
+
+    // Follow the protected tenant's working set whenever its published MRC changes
+    void poll_mrc() {
+        if (memory_low_fd < 0) return;
+        struct stat st;
+        if (stat(options.protected_mrc_file.c_str(), &st) != 0) return;
+        int64_t mtime = st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+        if (mtime == mrc_mtime_ns) return;
+        mrc_mtime_ns = mtime;
+        std::vector<mrc::CurvePoint> points;
+        if (!mrc::read_csv(options.protected_mrc_file, points)) return;
+        uint64_t target = mrc::cache_for_share(points, kMemoryLowShare) * mrc::kPageSize;
+        uint64_t current = memory_low == kUnlimited ? 0 : memory_low;
+        uint64_t diff = target > current ? target - current : current - target;
+        if (target > 0 && diff * 10 > current) {
+            memory_low = target;
+            write_fd(memory_low_fd, std::to_string(memory_low));
+        }
+    }
+
+    void apply() {
+        write_fd(memory_high_fd, memory_high == kUnlimited ? "max" : std::to_string(memory_high));
+        if (io_weight_fd >= 0) write_fd(io_weight_fd, "default " + std::to_string(io_weight));
+    }
+
+    void tick(uint64_t now, uint64_t dt_ns, uint64_t& last_pgpgout, bool pressure) {
+        uint64_t mem[2] = {0, 0};
+        uint64_t vm[1] = {0};
+        memory_stat->sample(mem);
+        vmstat->sample(vm);
+        poll_latency();
+        poll_mrc();
+
+        // pgpgout is in KiB
+        if (last_pgpgout && dt_ns > 0) {
+            double bw = (vm[0] - last_pgpgout) * 1024.0 * 1e9 / dt_ns;
+            write_bw = write_bw == 0 ? bw : 0.7 * write_bw + 0.3 * bw;
+        }
+        last_pgpgout = vm[0];
+
+        uint64_t backlog = mem[0] + mem[1];
+        double bw_floor = std::max(write_bw, 1.0 * (1 << 20));  // Avoid infinite drain while idle
+        uint64_t drain_ns = static_cast<uint64_t>(backlog / bw_floor * 1e9);
+
+        bool p99_violated = pressure || observed_p99 > options.slo_p99_ns;
+        bool drain_violated = drain_ns > options.drain_target_ns;
+        const char* action = "hold";
+
+        if (p99_violated || drain_violated) {
+            healthy_ticks = 0;
+            uint64_t current = read_memory_value(memory_current_fd);
+            uint64_t base = std::min(memory_high, current);
+            uint64_t target = std::max(kMinMemoryHigh, static_cast<uint64_t>(base * 0.8));
+            int weight = std::max(1, io_weight / 2);
+            if (target < memory_high || weight != io_weight) {
+                memory_high = target;
+                io_weight = weight;
+                apply();
+                action = "tighten";
+                tighten_count++;
+            }
+        } else if (drain_ns < options.drain_target_ns / 2 &&
+                   observed_p99 < options.slo_p99_ns * 7 / 10) {
+            if (++healthy_ticks >= kRelaxTicks &&
+                (memory_high != initial_memory_high || io_weight != initial_io_weight)) {
+                healthy_ticks = 0;
+                uint64_t grown = memory_high / 4 * 5;
+                if (initial_memory_high == kUnlimited) {
+                    // Once far above usage the limit no longer bites: hand back "max"
+                    if (grown > 4 * read_memory_value(memory_current_fd)) grown = kUnlimited;
+                } else {
+                    grown = std::min(grown, initial_memory_high);
+                }
+                memory_high = grown;
+                io_weight = std::min(initial_io_weight, io_weight * 2);
+                apply();
+                action = "relax";
+                relax_count++;
+            }
+        } else {
+            healthy_ticks = 0;
+        }
+
+        fprintf(log, "%llu,%s,%llu,%llu,%.0f,%.1f,%.1f,%s,%s,%d,%s\n",
+                static_cast<unsigned long long>(now), pressure ? "psi" : "tick", static_cast<unsigned long long>(mem[0]),
+                static_cast<unsigned long long>(mem[1]), write_bw, drain_ns / 1e6, observed_p99 / 1e3, action,
+                memory_high == kUnlimited ? "max" : std::to_string(memory_high).c_str(), io_weight,
+                memory_low_fd < 0 ? "" : memory_low == kUnlimited ? "max" : std::to_string(memory_low).c_str());
+    }
+
+    void control_loop() {
+        uint64_t last = monotonic_ns();
+        uint64_t next_tick = last + options.interval_ns;
+        uint64_t last_pgpgout = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            auto deadline = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(next_tick));
+            cv.wait_until(lock, deadline, [this]() { return stopping || pressure_pending; });
+            if (stopping) break;
+            bool pressure = pressure_pending;
+            pressure_pending = false;
+            lock.unlock();
+            uint64_t now = monotonic_ns();
+            tick(now, now - last, last_pgpgout, pressure);
+            last = now;
+            // A pressure-driven tick doesn't move the regular schedule
+            if (!pressure) {
+                next_tick += options.interval_ns;
+                if (next_tick <= now) next_tick = now + options.interval_ns;
+            }
+            lock.lock();
+        }
+        lock.unlock();
+        if (log) fflush(log);
+        // Leave the neighbour the way it was configured
+        memory_high = initial_memory_high;
+        io_weight = initial_io_weight;
+        apply();
+        if (memory_low_fd >= 0 && memory_low != initial_memory_low) {
+            write_fd(memory_low_fd, initial_memory_low == kUnlimited ? "max" : std::to_string(initial_memory_low));
+        }
+    }
+};
+
+}  // namespace control
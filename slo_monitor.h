@@ -0,0 +1,417 @@
+// slo_monitor.h
+// Online SLO-violation metric: the share of each tenant's requests slower
+// than an SLO derived from the tenant's run alone, counted while it runs.
+//
+// The SLO of a tenant is --slo-factor (default 2) times the p99 of the same
+// tenant running alone: per phase and direction from
+// <baseline>/<tenant>_alone_<mode>_phaseN.json, falling back to the combined
+// <tenant>_alone_<mode>.json. Tenants without a baseline have no SLO.
+//
+// The parent maps a shared Board before forking, like the start barrier
+// (tenant_sync.h), and writes each tenant's thresholds into its slot. Inside
+// the tenant, a Reporter hooked to the native engine's latency collector
+// counts, for every closed 1s window, the requests in histogram buckets
+// reaching above the threshold, and publishes the per-phase totals plus a
+// running mean and variance of the per-window violation fraction of the
+// current phase (seqlock, single writer per slot).
+//
+// The parent's Monitor thread reads the slots: it logs progress every few
+// windows, answers each connection to a unix socket with a CSV snapshot, and
+// with --slo-settle ends the run early. That happens once every tenant is in
+// its last phase and the 95% confidence interval of each SLO tenant's
+// violation fraction in that phase is within +-settle percentage points.
+// Earlier phases always run in full.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "latency_recorder.h"
+#include "phase_aggregator.h"
+
+namespace slo {
+
+constexpr int kMaxTenants = 16;
+constexpr int kMaxPhases = 16;
+constexpr uint64_t kMinSettleWindows = 10;  // Windows of the last phase before an early stop
+constexpr uint64_t kReportEveryWindows = 5;
+constexpr double kZ95 = 1.96;
+
+struct PhaseCounts {
+    uint64_t requests;
+    uint64_t violations;
+};
+
+// One tenant's state; plain data, copied out under the slot's seqlock
+struct SlotData {
+    char tenant[64];
+    uint32_t active;                            // Has an SLO in some phase
+    uint32_t nphases;
+    uint64_t threshold_ns[kMaxPhases][2];       // 0 = no SLO for that phase and direction
+    uint32_t phase;                             // 0-based phase of the latest window
+    uint32_t reserved;
+    uint64_t windows;                           // Measured windows of `phase`
+    double last_fraction;                       // Violation fraction of the latest window
+    double mean;                                // Welford over the window fractions of `phase`
+    double m2;
+    PhaseCounts totals[kMaxPhases];
+};
+
+struct Slot {
+    std::atomic<uint32_t> seq;                  // Odd while the tenant updates `data`
+    SlotData data;
+};
+
+struct Board {
+    std::atomic<uint32_t> stop;                 // Engines stop their run once nonzero
+    uint32_t ntenants;
+    Slot slots[kMaxTenants];
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "the board is shared between processes");
+
+inline double ci_half_width(const SlotData& d) {
+    if (d.windows < 2) return INFINITY;
+    return kZ95 * std::sqrt(d.m2 / static_cast<double>(d.windows - 1) / static_cast<double>(d.windows));
+}
+
+// factor x p99 of the tenant alone, per phase and direction; false if there is no baseline
+inline bool load_baseline(const std::string& dir, const std::string& tenant, const std::string& cache_mode,
+                          size_t nphases, double factor, SlotData& out, std::string& error) {
+    std::string stem = dir + "/" + tenant + "_alone_" + cache_mode;
+    results::PhaseSummary combined;
+    bool have_combined = results::parse_fio_json(stem + ".json", combined, error);
+    bool any = false;
+    for (size_t i = 0; i < nphases && i < static_cast<size_t>(kMaxPhases); i++) {
+        results::PhaseSummary phase;
+        std::string phase_error;
+        const results::PhaseSummary* source = nullptr;
+        if (results::parse_fio_json(stem + "_phase" + std::to_string(i + 1) + ".json", phase, phase_error)) {
+            source = &phase;
+        } else if (have_combined) {
+            source = &combined;
+        }
+        for (int d = 0; d < 2 && source; d++) {
+            double p99 = results::percentile_or_zero(source->dir[d], 99);
+            out.threshold_ns[i][d] = static_cast<uint64_t>(p99 * factor);
+            any = any || out.threshold_ns[i][d] > 0;
+        }
+    }
+    if (!any) {
+        error = "no p99 in " + stem + "[_phaseN].json";
+        return false;
+    }
+    error.clear();
+    return true;
+}
+
+// Tenant side: turns closed latency windows into the slot's counters
+class Reporter {
+public:
+    Reporter(Board* board, int index) : board(board), slot(board->slots[index]) {
+        for (int p = 0; p < kMaxPhases; p++) {
+            for (int d = 0; d < 2; d++) first_over[p][d] = first_bucket_over(slot.data.threshold_ns[p][d]);
+        }
+    }
+
+    const std::atomic<uint32_t>* stop_flag() const { return &board->stop; }
+
+    // LatencyRecorder observer: both directions of one window arrive before the next window
+    void observe(uint64_t window_index, int phase, int dir, const latency::Histogram& h) {
+        if (window_index != window) {
+            close_window();
+            window = window_index;
+        }
+        window_phase = std::min(phase, kMaxPhases - 1);
+        if (slot.data.threshold_ns[window_phase][dir] == 0) return;
+        uint64_t over = 0;
+        for (int i = first_over[window_phase][dir]; i < latency::kNumBuckets; i++) over += h.counts[i];
+        requests += h.count;
+        violations += over;
+    }
+
+    // After the engine has stopped: count the last window
+    void finish() { close_window(); }
+
+private:
+    Board* board;
+    Slot& slot;
+    int first_over[kMaxPhases][2];
+    uint64_t window = UINT64_MAX;
+    int window_phase = 0;
+    uint64_t requests = 0;
+    uint64_t violations = 0;
+
+    // Requests in a bucket whose range reaches above the threshold count as violations
+    static int first_bucket_over(uint64_t threshold_ns) {
+        for (int i = 0; i < latency::kNumBuckets; i++) {
+            if (latency::bucket_upper(i) > threshold_ns) return i;
+        }
+        return latency::kNumBuckets;
+    }
+
+    void close_window() {
+        if (requests == 0) return;
+        uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+        slot.seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        SlotData& d = slot.data;
+        if (d.phase != static_cast<uint32_t>(window_phase)) {
+            d.phase = static_cast<uint32_t>(window_phase);
+            d.windows = 0;
+            d.mean = 0;
+            d.m2 = 0;
+        }
+        double fraction = static_cast<double>(violations) / static_cast<double>(requests);
+        d.windows++;
+        double delta = fraction - d.mean;
+        d.mean += delta / static_cast<double>(d.windows);
+        d.m2 += delta * (fraction - d.mean);
+        d.last_fraction = fraction;
+        d.totals[window_phase].requests += requests;
+        d.totals[window_phase].violations += violations;
+        slot.seq.store(seq + 2, std::memory_order_release);
+        requests = 0;
+        violations = 0;
+    }
+};
+
+struct MonitorOptions {
+    double settle_pp = 0;             // Early stop at this 95% CI half-width (percentage points), 0 = never
+    uint64_t last_phase_start_ns = 0; // CLOCK_MONOTONIC start of the latest last phase of any tenant
+    std::string socket_path;          // Empty = no socket
+};
+
+// Parent side: owns the board, reports, serves snapshots and decides the early stop
+class Monitor {
+public:
+    Monitor() = default;
+    ~Monitor() {
+        stop();
+        if (board) munmap(board, sizeof(Board));
+    }
+
+    Monitor(const Monitor&) = delete;
+    Monitor& operator=(const Monitor&) = delete;
+
+    // Map the board; call before forking the tenants
+    bool open(const std::vector<std::string>& tenants, std::string& error) {
+        if (tenants.size() > static_cast<size_t>(kMaxTenants)) {
+            error = "online SLO metrics support at most " + std::to_string(kMaxTenants) + " tenants";
+            return false;
+        }
+        void* p = mmap(nullptr, sizeof(Board), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) {
+            error = std::string("Cannot map SLO board: ") + strerror(errno);
+            return false;
+        }
+        board = new (p) Board();
+        board->ntenants = static_cast<uint32_t>(tenants.size());
+        for (size_t i = 0; i < tenants.size(); i++) {
+            strncpy(board->slots[i].data.tenant, tenants[i].c_str(), sizeof(board->slots[i].data.tenant) - 1);
+        }
+        return true;
+    }
+
+    bool is_open() const { return board != nullptr; }
+
+    // Before forking: tenant `index` gets an SLO (thresholds filled by load_baseline)
+    SlotData& setup(int index) { return board->slots[index].data; }
+
+    Reporter reporter(int index) { return Reporter(board, index); }
+
+    // After the release: start the monitor thread
+    bool start(const MonitorOptions& opts, std::function<void(const std::string&)> logger, std::string& error) {
+        options = opts;
+        log = std::move(logger);
+        if (!options.socket_path.empty() && !open_socket(error)) return false;
+        running.store(true);
+        thread = std::thread([this]() { loop(); });
+        return true;
+    }
+
+    void stop() {
+        if (!thread.joinable()) return;
+        running.store(false);
+        thread.join();
+        if (listen_fd >= 0) {
+            close(listen_fd);
+            listen_fd = -1;
+            unlink(options.socket_path.c_str());
+        }
+    }
+
+    bool stopped_early() const { return board && board->stop.load() != 0; }
+    uint64_t stop_time_ns() const { return stop_ns; }
+
+    SlotData read(int index) const {
+        const Slot& slot = board->slots[index];
+        SlotData copy;
+        while (true) {
+            uint32_t before = slot.seq.load(std::memory_order_acquire);
+            if (before & 1) continue;
+            memcpy(&copy, &slot.data, sizeof(copy));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) == before) return copy;
+        }
+    }
+
+    // tenant,phase,windows,requests,violations,fraction,window_fraction,ci95
+    std::string snapshot() const {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(6)
+            << "tenant,phase,windows,requests,violations,fraction,window_fraction,ci95\n";
+        for (uint32_t i = 0; i < board->ntenants; i++) {
+            SlotData d = read(static_cast<int>(i));
+            if (!d.active) continue;
+            const PhaseCounts& c = d.totals[d.phase];
+            double ci = ci_half_width(d);
+            out << d.tenant << "," << d.phase + 1 << "," << d.windows << "," << c.requests << "," << c.violations
+                << "," << (c.requests ? static_cast<double>(c.violations) / c.requests : 0) << ","
+                << d.last_fraction << ",";
+            if (!std::isinf(ci)) out << ci;
+            out << "\n";
+        }
+        return out.str();
+    }
+
+    // tenant,phase,threshold_read_us,threshold_write_us,requests,violations,fraction
+    bool write_summary(const std::string& path) const {
+        std::ofstream out(path);
+        if (!out) return false;
+        out << std::fixed << "tenant,phase,threshold_read_us,threshold_write_us,requests,violations,fraction\n";
+        for (uint32_t i = 0; i < board->ntenants; i++) {
+            SlotData d = read(static_cast<int>(i));
+            if (!d.active) continue;
+            for (uint32_t p = 0; p < d.nphases && p < static_cast<uint32_t>(kMaxPhases); p++) {
+                const PhaseCounts& c = d.totals[p];
+                out << d.tenant << "," << p + 1 << "," << std::setprecision(1) << d.threshold_ns[p][0] / 1000.0
+                    << "," << d.threshold_ns[p][1] / 1000.0 << "," << c.requests << "," << c.violations << ","
+                    << std::setprecision(6) << (c.requests ? static_cast<double>(c.violations) / c.requests : 0)
+                    << "\n";
+            }
+        }
+        return static_cast<bool>(out);
+    }
+
+private:
+    Board* board = nullptr;
+    MonitorOptions options;
+    std::function<void(const std::string&)> log;
+    std::atomic<bool> running{false};
+    std::thread thread;
+    int listen_fd = -1;
+    uint64_t stop_ns = 0;
+    std::vector<uint64_t> reported;  // Per slot: windows at the last log line
+    std::vector<uint32_t> reported_phase;
+
+    bool open_socket(std::string& error) {
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (options.socket_path.size() >= sizeof(addr.sun_path)) {
+            error = "socket path too long: " + options.socket_path;
+            return false;
+        }
+        strncpy(addr.sun_path, options.socket_path.c_str(), sizeof(addr.sun_path) - 1);
+        unlink(options.socket_path.c_str());
+        listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (listen_fd < 0 || bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            listen(listen_fd, 4) != 0) {
+            error = "Cannot listen on " + options.socket_path + ": " + strerror(errno);
+            if (listen_fd >= 0) close(listen_fd);
+            listen_fd = -1;
+            return false;
+        }
+        return true;
+    }
+
+    void serve_one() {
+        int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) return;
+        std::string text = snapshot();
+        size_t done = 0;
+        while (done < text.size()) {
+            ssize_t n = send(fd, text.data() + done, text.size() - done, MSG_NOSIGNAL);
+            if (n <= 0) break;
+            done += static_cast<size_t>(n);
+        }
+        close(fd);
+    }
+
+    void report() {
+        reported.resize(board->ntenants, 0);
+        reported_phase.resize(board->ntenants, UINT32_MAX);
+        for (uint32_t i = 0; i < board->ntenants; i++) {
+            SlotData d = read(static_cast<int>(i));
+            if (!d.active || d.windows == 0) continue;
+            if (d.phase == reported_phase[i] && d.windows < reported[i] + kReportEveryWindows) continue;
+            reported[i] = d.windows;
+            reported_phase[i] = d.phase;
+            const PhaseCounts& c = d.totals[d.phase];
+            std::ostringstream msg;
+            msg << std::fixed << std::setprecision(2) << "  SLO " << d.tenant << " phase " << d.phase + 1 << ": "
+                << 100.0 * c.violations / std::max<uint64_t>(c.requests, 1) << "% of " << c.requests
+                << " requests over SLO (last window " << 100 * d.last_fraction << "%";
+            double ci = ci_half_width(d);
+            if (!std::isinf(ci)) msg << ", +-" << 100 * ci << "pp over " << d.windows << " windows";
+            msg << ")";
+            log(msg.str());
+        }
+    }
+
+    // Every SLO tenant settled in the last phase; false while any tenant has an earlier phase to run
+    bool settled(std::string& detail) {
+        if (options.settle_pp <= 0 || latency::monotonic_ns() < options.last_phase_start_ns) return false;
+        std::ostringstream text;
+        text << std::fixed << std::setprecision(2);
+        bool any = false;
+        for (uint32_t i = 0; i < board->ntenants; i++) {
+            SlotData d = read(static_cast<int>(i));
+            if (!d.active) continue;
+            if (d.phase + 1 < d.nphases || d.windows < kMinSettleWindows) return false;
+            double ci = ci_half_width(d);
+            if (ci * 100 > options.settle_pp) return false;
+            text << (any ? ", " : "") << d.tenant << " " << 100 * d.mean << "% +-" << 100 * ci << "pp";
+            any = true;
+        }
+        detail = text.str();
+        return any;
+    }
+
+    void loop() {
+        while (running.load()) {
+            pollfd pfd{listen_fd, POLLIN, 0};
+            if (listen_fd >= 0 && poll(&pfd, 1, 200) > 0) serve_one();
+            else if (listen_fd < 0) usleep(200000);
+            report();
+            std::string detail;
+            if (board->stop.load() == 0 && settled(detail)) {
+                stop_ns = latency::monotonic_ns();
+                board->stop.store(1, std::memory_order_release);
+                log("  SLO result settled (" + detail + "), ending the run early");
+            }
+        }
+    }
+};
+
+}  // namespace slo
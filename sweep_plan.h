@@ -0,0 +1,203 @@
+// sweep_plan.h
+// Parameter grids for sweep mode.
+//
+// A [sweep] section in the workload config declares one axis per grid key:
+//
+//   [sweep]
+//   mode = dual
+//   repetitions = 3
+//   grid.client2_bursty.phase_1_rate_iops = 1000:20000:1000
+//   grid.client1_steady.iodepth = 1,8
+//
+// Values are comma separated; "start:stop:step" expands to an inclusive
+// integer range. The grid is the cartesian product of all axes, times the
+// repetitions. Every point is identified by an FNV-1a fingerprint of its
+// fully resolved configuration, so results are cached by content: a point
+// whose directory already holds a DONE marker is skipped, however the grid
+// around it changed.
+//
+// Points can be spread over several hosts two ways: --shard K/N makes a
+// host take every Nth point (for separate result dirs), and a per-point
+// flock lets hosts sharing one result dir (NFS) pick up whatever point
+// nobody else is running. A crashed process releases its locks; its
+// half-written point has no DONE marker and simply runs again. Only one
+// sweep runs per host (kHostLock): two on one host would share cgroup
+// names, test files and the page cache, and disturb each other's points.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+namespace sweep {
+
+// Held by the sweep running on this host
+constexpr const char* kHostLock = "/tmp/fairness_benchmark_sweep.lock";
+
+struct Axis {
+    std::string section;
+    std::string key;
+    std::vector<std::string> values;
+};
+
+struct Plan {
+    std::string mode = "dual";          // Mode each point runs: dual, multi or a workload name
+    int repetitions = 1;
+    std::vector<Axis> axes;
+};
+
+// section -> key -> value
+using Overrides = std::map<std::string, std::map<std::string, std::string>>;
+
+struct Point {
+    size_t ordinal;                     // Position in the expanded grid, used for sharding
+    int repetition;                     // 1-based
+    std::vector<std::string> values;    // One per axis
+    Overrides overrides;
+    uint64_t fingerprint = 0;
+};
+
+inline uint64_t fnv1a(const std::string& data, uint64_t hash = 0xcbf29ce484222325ULL) {
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+inline std::string hex(uint64_t v) {
+    char buf[17];
+    snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(v));
+    return buf;
+}
+
+inline std::string trim(const std::string& s) {
+    size_t b = s.find_first_not_of(" \t");
+    if (b == std::string::npos) return "";
+    return s.substr(b, s.find_last_not_of(" \t") - b + 1);
+}
+
+// "1,2,4" / "1000:5000:1000" / "4k,64k" / mixes of these
+inline bool parse_values(const std::string& spec, std::vector<std::string>& out, std::string& error) {
+    size_t start = 0;
+    while (start <= spec.size()) {
+        size_t comma = spec.find(',', start);
+        std::string item = trim(spec.substr(start, comma == std::string::npos ? std::string::npos : comma - start));
+        start = comma == std::string::npos ? spec.size() + 1 : comma + 1;
+        if (item.empty()) continue;
+        size_t c1 = item.find(':');
+        if (c1 == std::string::npos) {
+            out.push_back(item);
+            continue;
+        }
+        size_t c2 = item.find(':', c1 + 1);
+        char* e1;
+        char* e2;
+        char* e3;
+        long long first = strtoll(item.substr(0, c1).c_str(), &e1, 10);
+        long long last = strtoll(item.substr(c1 + 1, c2 == std::string::npos ? std::string::npos : c2 - c1 - 1).c_str(), &e2, 10);
+        long long step = c2 == std::string::npos ? 1 : strtoll(item.substr(c2 + 1).c_str(), &e3, 10);
+        if (*e1 || *e2 || (c2 != std::string::npos && *e3) || step <= 0 || last < first) {
+            error = "Invalid range '" + item + "' (expected start:stop[:step] with start <= stop, step > 0)";
+            return false;
+        }
+        for (long long v = first; v <= last; v += step) out.push_back(std::to_string(v));
+    }
+    if (out.empty()) {
+        error = "Empty value list '" + spec + "'";
+        return false;
+    }
+    return true;
+}
+
+// Apply one [sweep] key; false with `error` set if it is malformed
+inline bool add_key(Plan& plan, const std::string& key, const std::string& value, std::string& error) {
+    if (key == "mode") {
+        plan.mode = value;
+    } else if (key == "repetitions") {
+        plan.repetitions = atoi(value.c_str());
+        if (plan.repetitions < 1) {
+            error = "repetitions must be >= 1";
+            return false;
+        }
+    } else if (key.compare(0, 5, "grid.") == 0) {
+        size_t dot = key.find('.', 5);
+        if (dot == std::string::npos || dot == 5 || dot + 1 == key.size()) {
+            error = "Grid key '" + key + "' must be grid.<section>.<key>";
+            return false;
+        }
+        Axis axis{key.substr(5, dot - 5), key.substr(dot + 1), {}};
+        if (!parse_values(value, axis.values, error)) return false;
+        plan.axes.push_back(std::move(axis));
+    } else {
+        error = "Unknown [sweep] key '" + key + "'";
+        return false;
+    }
+    return true;
+}
+
+inline std::string axis_name(const Axis& axis) { return axis.section + "." + axis.key; }
+
+// Cartesian product of all axes (last axis varies fastest), times repetitions
+inline std::vector<Point> expand(const Plan& plan) {
+    std::vector<Point> points;
+    size_t combos = 1;
+    for (const auto& axis : plan.axes) combos *= axis.values.size();
+    for (size_t combo = 0; combo < combos; combo++) {
+        Point base{0, 0, {}, {}, 0};
+        size_t rest = combo;
+        base.values.resize(plan.axes.size());
+        for (size_t a = plan.axes.size(); a-- > 0;) {
+            const auto& axis = plan.axes[a];
+            base.values[a] = axis.values[rest % axis.values.size()];
+            rest /= axis.values.size();
+            base.overrides[axis.section][axis.key] = base.values[a];
+        }
+        for (int rep = 1; rep <= plan.repetitions; rep++) {
+            Point p = base;
+            p.ordinal = points.size();
+            p.repetition = rep;
+            points.push_back(std::move(p));
+        }
+    }
+    return points;
+}
+
+// Exclusive, non-blocking claim on a point; released on destruction or process exit
+class PointLock {
+public:
+    PointLock() = default;
+    ~PointLock() { release(); }
+    PointLock(const PointLock&) = delete;
+    PointLock& operator=(const PointLock&) = delete;
+
+    bool acquire(const std::string& path) {
+        fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) return false;
+        if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+            release();
+            return false;
+        }
+        return true;
+    }
+
+    void release() {
+        if (fd >= 0) close(fd);
+        fd = -1;
+    }
+
+private:
+    int fd = -1;
+};
+
+}  // namespace sweep
@@ -0,0 +1,336 @@
+// telemetry_sampler.h
+// Periodic sampling of kernel memory/writeback counters.
+//
+// A single thread samples /proc/vmstat and the memory.stat of each tenant
+// cgroup at a fixed interval. Files are opened once and re-read with pread
+// into buffers allocated up front; lines are matched against a short list of
+// wanted keys and parsed in place, so a sample does no allocation and no
+// syscalls beyond one pread per source.
+//
+// Timestamps come from latency::monotonic_ns(), the clock the latency
+// recorder stamps its windows with, so samples join exactly against the
+// per-window latency series.
+//
+// Counter sources (perf_counters.h) are sampled on the same tick through a
+// reader callback instead of a stat file.
+//
+// Event sources (e.g. PSI triggers) share the file: they are declared in
+// the source table like sampled sources and other threads append their
+// records through append(), serialized with the sampler's own writes.
+//
+// File layout (little endian, fixed width):
+//   TelemetryFileHeader
+//   SourceDescriptor[header.num_sources]
+//   repeated SampleRecord
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "latency_recorder.h"
+
+namespace telemetry {
+
+using latency::monotonic_ns;
+
+constexpr int kMaxColumns = 8;
+constexpr size_t kColumnNameLen = 24;
+constexpr size_t kStatBufferSize = 32768;
+
+enum SourceKind : uint32_t {
+    kSourceVmstat = 0,
+    kSourceMemoryStat = 1,
+    kSourcePsiEvent = 2,
+    kSourcePerf = 3,        // Cumulative perf counters of a tenant cgroup
+    kSourceKswapd = 4,      // Cumulative kswapd CPU time
+};
+
+// Sample flags
+constexpr uint16_t kFlagReadError = 1;
+
+#pragma pack(push, 1)
+struct TelemetryFileHeader {
+    char magic[8];            // "FBTEL001"
+    uint32_t version;
+    uint32_t num_sources;
+    uint64_t start_ns;        // CLOCK_MONOTONIC time of the first tick
+    uint64_t interval_ns;
+};
+
+struct SourceDescriptor {
+    char name[64];            // "system" or the client name
+    uint32_t kind;            // SourceKind
+    uint32_t ncols;
+    char columns[kMaxColumns][kColumnNameLen];
+};
+
+struct SampleRecord {
+    uint64_t timestamp_ns;    // CLOCK_MONOTONIC
+    uint16_t source;          // Index into the source table
+    uint16_t flags;
+    uint32_t reserved;
+    uint64_t values[kMaxColumns];
+};
+#pragma pack(pop)
+
+// Columns sampled per source kind
+inline const std::vector<const char*>& vmstat_columns() {
+    static const std::vector<const char*> columns = {
+        "nr_dirty", "nr_writeback", "nr_file_pages", "pgpgin",
+        "pgpgout", "pgscan_kswapd", "pgscan_direct", "workingset_refault_file"};
+    return columns;
+}
+
+inline const std::vector<const char*>& memory_stat_columns() {
+    static const std::vector<const char*> columns = {
+        "file", "file_dirty", "file_writeback", "workingset_refault_file",
+        "pgscan", "pgsteal", "anon"};
+    return columns;
+}
+
+// A "key value" per line stat file (vmstat, memory.stat) kept open for re-reads
+class StatFile {
+public:
+    StatFile(const std::string& file_path, const std::vector<const char*>& wanted)
+        : path(file_path), keys(wanted), buffer(kStatBufferSize) {
+        for (const char* k : keys) key_lengths.push_back(strlen(k));
+    }
+
+    ~StatFile() {
+        if (fd >= 0) close(fd);
+    }
+
+    StatFile(const StatFile&) = delete;
+    StatFile& operator=(const StatFile&) = delete;
+
+    bool open_file(std::string& error) {
+        fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            error = "Cannot open " + path + ": " + strerror(errno);
+            return false;
+        }
+        return true;
+    }
+
+    // Fill values[i] for keys[i]; keys missing from the file read as 0
+    bool sample(uint64_t* values) {
+        for (size_t i = 0; i < keys.size(); i++) values[i] = 0;
+        ssize_t n = pread(fd, buffer.data(), buffer.size() - 1, 0);
+        if (n <= 0) return false;
+
+        const char* p = buffer.data();
+        const char* end = p + n;
+        while (p < end) {
+            const char* line_end = static_cast<const char*>(memchr(p, '\n', end - p));
+            if (!line_end) line_end = end;
+            const char* space = static_cast<const char*>(memchr(p, ' ', line_end - p));
+            if (space) {
+                size_t len = space - p;
+                for (size_t i = 0; i < keys.size(); i++) {
+                    if (len == key_lengths[i] && memcmp(p, keys[i], len) == 0) {
+                        uint64_t v = 0;
+                        for (const char* d = space + 1; d < line_end && *d >= '0' && *d <= '9'; d++) {
+                            v = v * 10 + (*d - '0');
+                        }
+                        values[i] = v;
+                        break;
+                    }
+                }
+            }
+            p = line_end + 1;
+        }
+        return true;
+    }
+
+    size_t num_keys() const { return keys.size(); }
+    const std::vector<const char*>& key_names() const { return keys; }
+
+private:
+    std::string path;
+    std::vector<const char*> keys;
+    std::vector<size_t> key_lengths;
+    std::vector<char> buffer;
+    int fd = -1;
+};
+
+class Sampler {
+public:
+    explicit Sampler(uint64_t interval_ns) : interval(interval_ns) {}
+
+    ~Sampler() { stop(); }
+
+    bool add_vmstat(std::string& error) {
+        return add_source("system", kSourceVmstat, "/proc/vmstat", vmstat_columns(), error);
+    }
+
+    bool add_memory_stat(const std::string& name, const std::string& cgroup_dir, std::string& error) {
+        return add_source(name, kSourceMemoryStat, cgroup_dir + "/memory.stat", memory_stat_columns(), error);
+    }
+
+    // Fills values[i] for columns[i]; false flags the sample as a read error
+    using Reader = std::function<bool(uint64_t* values)>;
+
+    // Declare a source read by `reader` on every tick
+    void add_sampled_source(const std::string& name, SourceKind kind, const std::vector<const char*>& columns,
+                            Reader reader) {
+        Source s;
+        fill_descriptor(s.descriptor, name, kind, columns);
+        s.reader = std::move(reader);
+        sources.push_back(std::move(s));
+    }
+
+    // Declare a source whose records are pushed with append(); returns its index
+    int add_event_source(const std::string& name, SourceKind kind, const std::vector<const char*>& columns) {
+        Source s;
+        fill_descriptor(s.descriptor, name, kind, columns);
+        sources.push_back(std::move(s));
+        return static_cast<int>(sources.size() - 1);
+    }
+
+    // Thread-safe; a no-op before open() and after stop()
+    void append(int source, uint64_t timestamp_ns, const uint64_t* values, size_t count) {
+        SampleRecord rec;
+        memset(&rec, 0, sizeof(rec));
+        rec.timestamp_ns = timestamp_ns;
+        rec.source = static_cast<uint16_t>(source);
+        for (size_t i = 0; i < count && i < static_cast<size_t>(kMaxColumns); i++) rec.values[i] = values[i];
+        std::lock_guard<std::mutex> lock(write_mutex);
+        if (out) fwrite(&rec, sizeof(rec), 1, out);
+    }
+
+    size_t num_sources() const { return sources.size(); }
+
+    // Write the header and source table; call after all sources are added
+    bool open(const std::string& path, std::string& error) {
+        out = fopen(path.c_str(), "wb");
+        if (!out) {
+            error = "Cannot open telemetry file " + path + ": " + strerror(errno);
+            return false;
+        }
+        start_ns = monotonic_ns();
+        TelemetryFileHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, "FBTEL001", 8);
+        header.version = 1;
+        header.num_sources = static_cast<uint32_t>(sources.size());
+        header.start_ns = start_ns;
+        header.interval_ns = interval;
+        fwrite(&header, sizeof(header), 1, out);
+        for (const auto& s : sources) {
+            fwrite(&s.descriptor, sizeof(s.descriptor), 1, out);
+        }
+        return true;
+    }
+
+    void start() {
+        sampler = std::thread([this]() { sample_loop(); });
+    }
+
+    void stop() {
+        if (sampler.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            cv.notify_all();
+            sampler.join();
+        }
+        std::lock_guard<std::mutex> lock(write_mutex);
+        if (out) {
+            fclose(out);
+            out = nullptr;
+        }
+    }
+
+    uint64_t samples_written() const { return written.load(std::memory_order_relaxed); }
+
+private:
+    struct Source {
+        SourceDescriptor descriptor;
+        std::unique_ptr<StatFile> file;
+        Reader reader;
+    };
+
+    uint64_t interval;
+    uint64_t start_ns = 0;
+    std::vector<Source> sources;
+    FILE* out = nullptr;
+    std::thread sampler;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping = false;
+    std::mutex write_mutex;
+    std::atomic<uint64_t> written{0};
+
+    static void fill_descriptor(SourceDescriptor& d, const std::string& name, SourceKind kind,
+                                const std::vector<const char*>& columns) {
+        memset(&d, 0, sizeof(d));
+        strncpy(d.name, name.c_str(), sizeof(d.name) - 1);
+        d.kind = kind;
+        d.ncols = static_cast<uint32_t>(std::min<size_t>(columns.size(), kMaxColumns));
+        for (size_t i = 0; i < d.ncols; i++) {
+            strncpy(d.columns[i], columns[i], kColumnNameLen - 1);
+        }
+    }
+
+    bool add_source(const std::string& name, SourceKind kind, const std::string& path,
+                    const std::vector<const char*>& columns, std::string& error) {
+        Source s;
+        fill_descriptor(s.descriptor, name, kind, columns);
+        s.file = std::make_unique<StatFile>(path, columns);
+        if (!s.file->open_file(error)) return false;
+        sources.push_back(std::move(s));
+        return true;
+    }
+
+    void sample_all(uint64_t now) {
+        SampleRecord rec;
+        std::lock_guard<std::mutex> lock(write_mutex);
+        for (size_t i = 0; i < sources.size(); i++) {
+            if (!sources[i].file && !sources[i].reader) continue;  // Event source
+            memset(&rec, 0, sizeof(rec));
+            rec.timestamp_ns = now;
+            rec.source = static_cast<uint16_t>(i);
+            bool ok = sources[i].file ? sources[i].file->sample(rec.values) : sources[i].reader(rec.values);
+            if (!ok) rec.flags |= kFlagReadError;
+            fwrite(&rec, sizeof(rec), 1, out);
+        }
+        written.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void sample_loop() {
+        uint64_t next_tick = start_ns;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            auto deadline = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(next_tick));
+            if (cv.wait_until(lock, deadline, [this]() { return stopping; })) break;
+            lock.unlock();
+            uint64_t now = monotonic_ns();
+            sample_all(now);
+            // Skip ticks we overslept instead of sampling in a burst
+            next_tick += interval;
+            if (next_tick <= now) next_tick = now - (now - start_ns) % interval + interval;
+            lock.lock();
+        }
+        lock.unlock();
+        // Closing sample so the series covers the end of the run
+        sample_all(monotonic_ns());
+    }
+};
+
+}  // namespace telemetry
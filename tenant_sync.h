@@ -0,0 +1,171 @@
+// tenant_sync.h
+// Shared start of concurrently launched tenants.
+//
+// The parent maps one shared anonymous segment before forking, so every
+// tenant inherits it. A tenant prepares everything it can (test files,
+// engine setup), then arrives at the barrier and sleeps on a futex. Once all
+// tenants have arrived (or died), the parent publishes a common epoch a
+// little in the future and wakes them together.
+//
+// The epoch is CLOCK_MONOTONIC, the clock of the .lat and telemetry files.
+// Each tenant's phase i runs over [epoch + sum of earlier runtimes, + runtime
+// of phase i), so phase boundaries come from one shared clock. They do not
+// drift with each tenant's own startup, and they do not build up across
+// phases. Native engine workers sleep until the epoch and switch phases at
+// these absolute times. fio phases are started and cut off at them, so they
+// still lose each phase's fio startup time, but the loss does not carry over
+// into the next phase. write_schedule() records the boundaries so analysis can
+// group latency windows by exactly which phases overlapped.
+
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "latency_recorder.h"
+
+namespace tenant_sync {
+
+using latency::monotonic_ns;
+
+// Time between release and the epoch: tenants wake, start worker threads and map buffers
+constexpr uint64_t kStartLeadNs = 100000000ULL;
+
+// Futex wait on a word of the shared segment (not FUTEX_PRIVATE: the waiters are other processes)
+inline void futex_wait(std::atomic<uint32_t>& word, uint32_t expected, uint64_t timeout_ns) {
+    timespec ts;
+    ts.tv_sec = static_cast<time_t>(timeout_ns / 1000000000ULL);
+    ts.tv_nsec = static_cast<long>(timeout_ns % 1000000000ULL);
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, &ts, nullptr, 0);
+}
+
+inline void futex_wake_all(std::atomic<uint32_t>& word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+}
+
+struct Segment {
+    std::atomic<uint32_t> arrived;
+    std::atomic<uint32_t> released;  // 1 once epoch_ns is published, 2 if the start is cancelled
+    std::atomic<uint64_t> epoch_ns;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+              "the segment is shared between processes");
+
+class StartBarrier {
+public:
+    StartBarrier() = default;
+    ~StartBarrier() {
+        if (seg) munmap(seg, sizeof(Segment));
+    }
+
+    StartBarrier(const StartBarrier&) = delete;
+    StartBarrier& operator=(const StartBarrier&) = delete;
+
+    // Map the segment; call before forking the tenants
+    bool open(std::string& error) {
+        void* p = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) {
+            error = std::string("Cannot map start barrier: ") + strerror(errno);
+            return false;
+        }
+        seg = new (p) Segment();
+        return true;
+    }
+
+    // Tenant: report ready and block until released; returns the epoch, 0 if the start was
+    // cancelled or the parent went away
+    uint64_t arrive_and_wait() {
+        pid_t parent = getppid();
+        seg->arrived.fetch_add(1);
+        futex_wake_all(seg->arrived);
+        uint32_t state;
+        while ((state = seg->released.load()) == 0) {
+            futex_wait(seg->released, 0, 1000000000ULL);
+            if (getppid() != parent) return 0;
+        }
+        return state == 1 ? seg->epoch_ns.load() : 0;
+    }
+
+    // Parent: wait until `pids.size()` tenants have arrived or exited; returns how many arrived
+    int wait_ready(const std::vector<pid_t>& pids) {
+        const uint32_t count = static_cast<uint32_t>(pids.size());
+        while (true) {
+            uint32_t arrived = seg->arrived.load();
+            if (arrived >= count) return static_cast<int>(arrived);
+            // A tenant blocks at the barrier until release, so one that has exited never arrived
+            uint32_t exited = 0;
+            for (pid_t pid : pids) {
+                siginfo_t info;
+                info.si_pid = 0;
+                if (waitid(P_PID, pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0 && info.si_pid == pid) exited++;
+            }
+            if (arrived + exited >= count) return static_cast<int>(arrived);
+            futex_wait(seg->arrived, arrived, 100000000ULL);
+        }
+    }
+
+    // Parent: publish the epoch (kStartLeadNs from now) and wake every tenant
+    uint64_t release() {
+        uint64_t epoch = monotonic_ns() + kStartLeadNs;
+        seg->epoch_ns.store(epoch);
+        seg->released.store(1);
+        futex_wake_all(seg->released);
+        return epoch;
+    }
+
+    // Parent: wake every tenant without starting them
+    void cancel() {
+        seg->released.store(2);
+        futex_wake_all(seg->released);
+    }
+
+private:
+    Segment* seg = nullptr;
+};
+
+// One scheduled phase of one tenant, CLOCK_MONOTONIC
+struct PhaseWindow {
+    std::string tenant;
+    int phase;          // 1-based
+    uint64_t start_ns;
+    uint64_t end_ns;
+};
+
+// Phase boundaries of a tenant whose phases run back to back from the epoch
+inline void append_schedule(std::vector<PhaseWindow>& out, const std::string& tenant,
+                            const std::vector<int>& runtimes_s, uint64_t epoch_ns) {
+    uint64_t t = epoch_ns;
+    for (size_t i = 0; i < runtimes_s.size(); i++) {
+        uint64_t end = t + static_cast<uint64_t>(runtimes_s[i]) * 1000000000ULL;
+        out.push_back({tenant, static_cast<int>(i + 1), t, end});
+        t = end;
+    }
+}
+
+// tenant,phase,start_ns,end_ns
+inline bool write_schedule(const std::string& path, uint64_t epoch_ns, const std::vector<PhaseWindow>& windows) {
+    std::ofstream out(path);
+    if (!out) return false;
+    out << "# epoch_ns=" << epoch_ns << " (CLOCK_MONOTONIC)\n";
+    out << "tenant,phase,start_ns,end_ns\n";
+    for (const auto& w : windows) {
+        out << w.tenant << "," << w.phase << "," << w.start_ns << "," << w.end_ns << "\n";
+    }
+    return static_cast<bool>(out);
+}
+
+}  // namespace tenant_sync
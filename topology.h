@@ -0,0 +1,214 @@
+// topology.h
+// CPU and NUMA topology from sysfs, and the calls that place a worker on it.
+//
+// discover() reads the online CPUs, each CPU's package and core ids, and
+// the CPU list of every NUMA node, the same sources hwloc uses. Machines
+// without /sys/devices/system/node are treated as one node.
+//
+// Placement is by CPU id: spread() orders a CPU set so consecutive workers
+// land on different physical cores (SMT siblings last), alternating between
+// the set's nodes, and pin_thread() / bind_memory() put a thread and its
+// buffers there. bind_memory() calls mbind directly, so there is no libnuma
+// dependency.
+
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace topology {
+
+// "0-3,8,10-11" -> {0, 1, 2, 3, 8, 10, 11}; false on malformed input
+inline bool parse_cpulist(const std::string& text, std::vector<int>& out) {
+    out.clear();
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t comma = text.find(',', pos);
+        std::string item = text.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        pos = comma == std::string::npos ? text.size() : comma + 1;
+        item.erase(0, item.find_first_not_of(" \t\n"));
+        item.erase(item.find_last_not_of(" \t\n") + 1);
+        if (item.empty()) continue;
+        int first = 0, last = 0;
+        char tail = 0;
+        int n = sscanf(item.c_str(), "%d-%d%c", &first, &last, &tail);
+        if (n == 1 && sscanf(item.c_str(), "%d%c", &first, &tail) == 1) last = first;
+        else if (n != 2) return false;
+        if (first < 0 || last < first) return false;
+        for (int c = first; c <= last; c++) out.push_back(c);
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+    return true;
+}
+
+// Inverse of parse_cpulist, with ranges collapsed: {0, 1, 2, 5} -> "0-2,5"
+inline std::string format_cpulist(std::vector<int> cpus) {
+    std::sort(cpus.begin(), cpus.end());
+    std::string out;
+    for (size_t i = 0; i < cpus.size();) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) j++;
+        if (!out.empty()) out += ",";
+        out += std::to_string(cpus[i]);
+        if (j > i) out += "-" + std::to_string(cpus[j]);
+        i = j + 1;
+    }
+    return out;
+}
+
+struct Cpu {
+    int id;
+    int node;
+    int package;
+    int core;   // core_id, unique within a package
+};
+
+class Topology {
+public:
+    static Topology discover() {
+        Topology t;
+        std::vector<int> online;
+        if (!parse_cpulist(read_line("/sys/devices/system/cpu/online"), online) || online.empty()) {
+            long n = sysconf(_SC_NPROCESSORS_ONLN);
+            for (long c = 0; c < std::max(n, 1L); c++) online.push_back(static_cast<int>(c));
+        }
+        std::map<int, int> node_of;
+        std::vector<int> nodes;
+        parse_cpulist(read_line("/sys/devices/system/node/online"), nodes);
+        for (int node : nodes) {
+            std::vector<int> cpus;
+            parse_cpulist(read_line("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"), cpus);
+            for (int c : cpus) node_of[c] = node;
+        }
+        for (int c : online) {
+            std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(c) + "/topology/";
+            Cpu cpu;
+            cpu.id = c;
+            cpu.node = node_of.count(c) ? node_of[c] : 0;
+            cpu.package = read_int(dir + "physical_package_id", 0);
+            cpu.core = read_int(dir + "core_id", c);
+            t.cpu_list.push_back(cpu);
+        }
+        return t;
+    }
+
+    const std::vector<Cpu>& cpus() const { return cpu_list; }
+
+    std::vector<int> nodes() const {
+        std::set<int> ids;
+        for (const auto& c : cpu_list) ids.insert(c.node);
+        return std::vector<int>(ids.begin(), ids.end());
+    }
+
+    std::vector<int> node_cpus(int node) const {
+        std::vector<int> out;
+        for (const auto& c : cpu_list) {
+            if (c.node == node) out.push_back(c.id);
+        }
+        return out;
+    }
+
+    // Node of an online CPU, -1 if unknown
+    int node_of(int cpu) const {
+        for (const auto& c : cpu_list) {
+            if (c.id == cpu) return c.node;
+        }
+        return -1;
+    }
+
+    // `cpus` reordered for placement: first thread of every physical core before
+    // any SMT sibling, nodes interleaved within each round. Unknown CPUs are dropped.
+    std::vector<int> spread(const std::vector<int>& cpus) const {
+        std::map<std::tuple<int, int>, int> thread_rank;  // (package, core) -> threads seen
+        std::map<std::tuple<int, int>, int> node_rank;     // (node, smt rank) -> CPUs seen
+        std::vector<std::tuple<int, int, int, int>> order;  // (smt rank, node rank, node, cpu)
+        std::vector<Cpu> chosen;
+        for (const auto& c : cpu_list) {
+            if (std::find(cpus.begin(), cpus.end(), c.id) != cpus.end()) chosen.push_back(c);
+        }
+        for (const auto& c : chosen) {
+            int smt = thread_rank[{c.package, c.core}]++;
+            int rank = node_rank[{c.node, smt}]++;
+            order.emplace_back(smt, rank, c.node, c.id);
+        }
+        std::sort(order.begin(), order.end());
+        std::vector<int> out;
+        for (const auto& o : order) out.push_back(std::get<3>(o));
+        return out;
+    }
+
+private:
+    std::vector<Cpu> cpu_list;
+
+    static std::string read_line(const std::string& path) {
+        std::ifstream in(path);
+        std::string line;
+        std::getline(in, line);
+        return line;
+    }
+
+    static int read_int(const std::string& path, int fallback) {
+        std::string line = read_line(path);
+        return line.empty() ? fallback : atoi(line.c_str());
+    }
+};
+
+// CPUs this process may run on (its cpuset)
+inline std::vector<int> allowed_cpus() {
+    std::vector<int> out;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) return out;
+    for (int c = 0; c < CPU_SETSIZE; c++) {
+        if (CPU_ISSET(c, &set)) out.push_back(c);
+    }
+    return out;
+}
+
+// Pin the calling thread to one CPU
+inline bool pin_thread(int cpu, std::string& error) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        error = "Cannot pin to CPU " + std::to_string(cpu) + ": " + strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+// Bind [addr, addr + len) to `node` and migrate pages already touched; addr must be page aligned
+inline bool bind_memory(void* addr, size_t len, int node, std::string& error) {
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    unsigned long mask[16] = {};
+    const unsigned long bits = sizeof(unsigned long) * 8;
+    if (node < 0 || static_cast<size_t>(node) >= sizeof(mask) * 8) {
+        error = "NUMA node " + std::to_string(node) + " out of range";
+        return false;
+    }
+    mask[node / bits] |= 1UL << (node % bits);
+    len = (len + page - 1) / page * page;
+    if (syscall(__NR_mbind, addr, len, MPOL_BIND, mask, sizeof(mask) * 8, MPOL_MF_MOVE) != 0) {
+        error = "Cannot bind buffers to NUMA node " + std::to_string(node) + ": " + strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+}  // namespace topology
@@ -0,0 +1,234 @@
+// trace_replay.h
+// Captured block/KV traces for open-loop replay by the native engine.
+//
+// A trace is a header followed by fixed-width records sorted by timestamp.
+// The replayer maps the whole file read-only and walks it with a plain
+// pointer, so fetching the next event costs a load, not a syscall or a
+// parse. Read-ahead is explicit: every 8MB of progress the next window is
+// madvise(MADV_WILLNEED)ed, and windows well behind the cursor are dropped
+// from the page cache with posix_fadvise(DONTNEED), so a multi-GB trace
+// neither stalls the replay on page faults nor steals cache from the
+// tenants being measured.
+//
+// `trace-pack` converts a CSV capture ("timestamp_ns,offset,length,op",
+// op = R/W or read/write) into this format.
+//
+// File layout (little endian, fixed width):
+//   TraceHeader
+//   TraceRecord[header.num_records]
+
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace trace {
+
+enum TraceOp : uint8_t { kOpRead = 0, kOpWrite = 1 };
+
+#pragma pack(push, 1)
+struct TraceHeader {
+    char magic[8];            // "FBTRC001"
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t num_records;
+    uint64_t duration_ns;     // Last timestamp - first timestamp
+    uint64_t max_offset;      // Largest offset + length
+    uint32_t max_length;      // Largest request, sizes replay buffers
+    uint32_t num_writes;      // Saturates at UINT32_MAX; 0 = read-only trace
+};
+
+struct TraceRecord {
+    uint64_t timestamp_ns;    // Relative to the first record
+    uint64_t offset;          // Bytes
+    uint32_t length;          // Bytes
+    uint8_t op;               // TraceOp
+    uint8_t reserved[3];
+};
+#pragma pack(pop)
+
+static_assert(sizeof(TraceRecord) == 24, "TraceRecord must stay 24 bytes");
+
+// A trace mapped for replay; records() stays valid for the object's lifetime
+class TraceFile {
+public:
+    TraceFile() = default;
+    ~TraceFile() {
+        if (map) munmap(map, map_len);
+        if (fd >= 0) close(fd);
+    }
+
+    TraceFile(const TraceFile&) = delete;
+    TraceFile& operator=(const TraceFile&) = delete;
+
+    bool open_file(const std::string& path, std::string& error) {
+        fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            error = "Cannot open trace " + path + ": " + strerror(errno);
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(TraceHeader)) {
+            error = "Trace " + path + " is too short";
+            return false;
+        }
+        map_len = static_cast<size_t>(st.st_size);
+        map = mmap(nullptr, map_len, PROT_READ, MAP_SHARED, fd, 0);
+        if (map == MAP_FAILED) {
+            map = nullptr;
+            error = "Cannot map trace " + path + ": " + strerror(errno);
+            return false;
+        }
+        madvise(map, map_len, MADV_SEQUENTIAL);
+        memcpy(&hdr, map, sizeof(hdr));
+        if (memcmp(hdr.magic, "FBTRC001", 8) != 0) {
+            error = "Trace " + path + " has no FBTRC001 header (convert CSV captures with trace-pack)";
+            return false;
+        }
+        if (sizeof(TraceHeader) + hdr.num_records * sizeof(TraceRecord) > map_len) {
+            error = "Trace " + path + " is truncated";
+            return false;
+        }
+        if (hdr.num_records == 0) {
+            error = "Trace " + path + " has no records";
+            return false;
+        }
+        prefetch(0);
+        return true;
+    }
+
+    const TraceHeader& header() const { return hdr; }
+    const TraceRecord* records() const {
+        return reinterpret_cast<const TraceRecord*>(static_cast<const char*>(map) + sizeof(TraceHeader));
+    }
+
+    // Called as the replay cursor advances; cheap unless it crosses a window boundary
+    void advance(uint64_t index) {
+        uint64_t window = (sizeof(TraceHeader) + index * sizeof(TraceRecord)) / kWindow;
+        if (window == last_window) return;
+        last_window = window;
+        prefetch(window);
+        if (window >= kKeepBehind) {
+            posix_fadvise(fd, 0, static_cast<off_t>((window - kKeepBehind) * kWindow), POSIX_FADV_DONTNEED);
+        }
+    }
+
+private:
+    static constexpr size_t kWindow = 8 << 20;
+    // Windows held behind the cursor: workers replaying interleaved records trail each other
+    static constexpr uint64_t kKeepBehind = 2;
+
+    int fd = -1;
+    void* map = nullptr;
+    size_t map_len = 0;
+    TraceHeader hdr{};
+    uint64_t last_window = 0;
+
+    void prefetch(uint64_t window) {
+        size_t begin = (window + 1) * kWindow;
+        if (window == 0) begin = 0;
+        if (begin >= map_len) return;
+        size_t len = std::min(kWindow * (window == 0 ? 2 : 1), map_len - begin);
+        madvise(static_cast<char*>(map) + begin, len, MADV_WILLNEED);
+    }
+};
+
+// CSV capture -> binary trace; timestamps are rebased to the first record
+inline bool pack_csv(const std::string& in_path, const std::string& out_path, uint64_t& count,
+                     std::string& error) {
+    count = 0;
+    FILE* in = fopen(in_path.c_str(), "r");
+    if (!in) {
+        error = "Cannot open " + in_path + ": " + strerror(errno);
+        return false;
+    }
+    FILE* out = fopen(out_path.c_str(), "wb");
+    if (!out) {
+        error = "Cannot create " + out_path + ": " + strerror(errno);
+        fclose(in);
+        return false;
+    }
+    TraceHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, "FBTRC001", 8);
+    hdr.version = 1;
+    fwrite(&hdr, sizeof(hdr), 1, out);
+
+    char line[512];
+    uint64_t line_no = 0, first_ts = 0, prev_ts = 0, writes = 0;
+    bool ok = true;
+    while (fgets(line, sizeof(line), in)) {
+        line_no++;
+        char* p = line;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p == '#' || *p == '\n' || *p == '\0') continue;
+        // Skip a header row
+        if (count == 0 && !(*p >= '0' && *p <= '9')) continue;
+
+        char* end;
+        uint64_t ts = strtoull(p, &end, 10);
+        uint64_t offset = *end == ',' ? strtoull(end + 1, &end, 10) : 0;
+        uint64_t length = *end == ',' ? strtoull(end + 1, &end, 10) : 0;
+        if (*end != ',' || length == 0 || length > UINT32_MAX) {
+            error = in_path + ":" + std::to_string(line_no) + ": expected timestamp_ns,offset,length,op";
+            ok = false;
+            break;
+        }
+        char op = end[1];
+        if (op != 'R' && op != 'r' && op != 'W' && op != 'w') {
+            error = in_path + ":" + std::to_string(line_no) + ": op must be R/W or read/write";
+            ok = false;
+            break;
+        }
+        if (count == 0) first_ts = prev_ts = ts;
+        if (ts < prev_ts) {
+            error = in_path + ":" + std::to_string(line_no) + ": timestamps must not go backwards";
+            ok = false;
+            break;
+        }
+        prev_ts = ts;
+
+        TraceRecord rec;
+        memset(&rec, 0, sizeof(rec));
+        rec.timestamp_ns = ts - first_ts;
+        rec.offset = offset;
+        rec.length = static_cast<uint32_t>(length);
+        rec.op = (op == 'W' || op == 'w') ? kOpWrite : kOpRead;
+        fwrite(&rec, sizeof(rec), 1, out);
+
+        count++;
+        if (rec.op == kOpWrite) writes++;
+        hdr.duration_ns = rec.timestamp_ns;
+        hdr.max_offset = std::max(hdr.max_offset, offset + length);
+        hdr.max_length = std::max(hdr.max_length, rec.length);
+    }
+    fclose(in);
+    if (ok && count == 0) {
+        error = in_path + " contains no records";
+        ok = false;
+    }
+    hdr.num_records = count;
+    hdr.num_writes = static_cast<uint32_t>(std::min<uint64_t>(writes, UINT32_MAX));
+    if (ok) {
+        fseek(out, 0, SEEK_SET);
+        fwrite(&hdr, sizeof(hdr), 1, out);
+    }
+    if (fclose(out) != 0 && ok) {
+        error = "Cannot write " + out_path + ": " + strerror(errno);
+        ok = false;
+    }
+    if (!ok) unlink(out_path.c_str());
+    return ok;
+}
+
+}  // namespace trace
@@ -0,0 +1,309 @@
+// workload_config.h
+// Workload config model and parser shared by every benchmark mode.
+//
+// A config file is read once into raw sections (name plus key/value pairs
+// in file order). build_workloads() turns them into WorkloadConfigs,
+// applying sweep overrides, and validates every workload before anything
+// runs: an unknown key, a bad size, pattern or number is reported against
+// its section up front instead of failing halfway through a run. The
+// runner only reads the result.
+//
+// Keys are the same in every mode. Per-phase keys are phase_N_<key>; unset
+// phase fields fall back to the workload's.
+
+#pragma once
+
+#include <fstream>
+#include <istream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "file_provisioner.h"
+#include "sweep_plan.h"
+
+namespace bench {
+
+// Writer profile: dirty page accumulation and flushing (native engine; fio takes dirty_rate only).
+// Per phase, unset fields fall back to the workload's.
+struct WriterConfig {
+    std::string dirty_rate;      // Bytes/s written across the jobs, e.g. 64M (empty = unthrottled)
+    std::string sync;            // none, fsync, fdatasync or sync_file_range
+    int sync_interval_ms = 0;    // Periodic sync of the test file (0 = none)
+    int checkpoint_interval_s = 0;
+    std::string checkpoint_size; // Written in one unthrottled burst per interval, then synced
+};
+
+struct PhaseConfig {
+    int runtime = 0;
+    std::string block_size;
+    int iodepth = 0;
+    std::string pattern;
+    std::string ioengine;
+    int numjobs = 0;      // Per-phase numjobs (0 = use workload default)
+    std::string file_size; // Per-phase file_size (empty = use workload default)
+    int rate_iops = 0;    // Per-phase rate_iops (0 = unlimited)
+    double trace_speed = 0; // Per-phase replay speed for trace:<file> (0 = use workload default)
+    std::string distribution; // Per-phase block distribution (empty = use workload default)
+    WriterConfig writer;
+    std::string arrival;  // Per-phase arrival process (empty = use workload default)
+};
+
+struct WorkloadConfig {
+    std::string description;
+    std::string file_size;
+    int numjobs = 0;
+    int rate_iops = 0;    // Workload-level rate_iops (0 = unlimited)
+    // Legacy single-phase config (for backward compatibility)
+    std::string block_size;
+    int runtime = 0;
+    int iodepth = 0;
+    std::string pattern;
+    std::string ioengine;
+    // Multi-phase config
+    std::vector<PhaseConfig> phases;
+    // Multi-tenant mode
+    std::string role;     // "tenant" = launched by multi mode
+    int replicas = 0;     // Tenants launched from this section (0 = 1)
+    // Trace replay (pattern = trace:<file>)
+    double trace_speed = 0; // Replay speed multiplier (0 = 1.0, 2 = twice as fast)
+    // Random patterns: block distribution, e.g. zipf:1.2 (empty = uniform)
+    std::string distribution;
+    WriterConfig writer;
+    // How rate_iops/dirty_rate pace requests: closed (default), constant, poisson, onoff:ON_MS:OFF_MS
+    std::string arrival;
+    // Native engine worker placement: explicit CPU list, else every CPU of one NUMA node
+    std::string cpus;     // e.g. 0-3,8 (empty = not pinned)
+    int numa_node = -1;   // Pin workers to this node's CPUs and bind their buffers to its memory
+    // Leading phases that only warm the cache; --cache-state warm shortens them once a snapshot exists
+    int warmup_phases = 0;
+    // Concurrent modes: run this tenant on the agent at ADDR[:PORT] (empty = this host)
+    std::string host;
+};
+
+using Workloads = std::map<std::string, WorkloadConfig>;
+
+struct CgroupConfig {
+    std::string cgroup_name;
+    std::map<std::string, std::string> settings;
+};
+
+// Raw key/value pairs of one workload section, in file order
+struct ConfigSection {
+    std::string name;
+    std::vector<std::pair<std::string, std::string>> entries;
+};
+
+inline bool is_trace_pattern(const std::string& pattern) { return pattern.compare(0, 6, "trace:") == 0; }
+
+// Every section of an INI file in order; '#' and ';' lines are comments
+inline bool parse_sections(std::istream& in, std::vector<ConfigSection>& sections) {
+    sections.clear();
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#' || line[0] == ';') continue;
+        if (line[0] == '[' && line.back() == ']') {
+            sections.push_back({line.substr(1, line.length() - 2), {}});
+            continue;
+        }
+        size_t eq_pos = line.find('=');
+        if (eq_pos == std::string::npos || sections.empty()) continue;
+        std::string key = line.substr(0, eq_pos);
+        std::string value = line.substr(eq_pos + 1);
+        key.erase(0, key.find_first_not_of(" \t"));
+        key.erase(key.find_last_not_of(" \t") + 1);
+        value.erase(0, value.find_first_not_of(" \t"));
+        value.erase(value.find_last_not_of(" \t") + 1);
+        sections.back().entries.push_back({key, value});
+    }
+    return true;
+}
+
+inline bool read_sections(const std::string& path, std::vector<ConfigSection>& sections, std::string& error) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        error = "Cannot open config file: " + path;
+        return false;
+    }
+    return parse_sections(file, sections);
+}
+
+inline bool apply_writer_key(WriterConfig& writer, const std::string& key, const std::string& value) {
+    if (key == "dirty_rate") writer.dirty_rate = value;
+    else if (key == "sync") writer.sync = value;
+    else if (key == "sync_interval_ms") writer.sync_interval_ms = std::stoi(value);
+    else if (key == "checkpoint_interval_s") writer.checkpoint_interval_s = std::stoi(value);
+    else if (key == "checkpoint_size") writer.checkpoint_size = value;
+    else return false;
+    return true;
+}
+
+// A phase's writer profile with unset fields taken from the workload
+inline WriterConfig resolve_writer(const WriterConfig& phase, const WriterConfig& workload) {
+    WriterConfig w = phase;
+    if (w.dirty_rate.empty()) w.dirty_rate = workload.dirty_rate;
+    if (w.sync.empty()) w.sync = workload.sync;
+    if (w.sync_interval_ms == 0) w.sync_interval_ms = workload.sync_interval_ms;
+    if (w.checkpoint_interval_s == 0) w.checkpoint_interval_s = workload.checkpoint_interval_s;
+    if (w.checkpoint_size.empty()) w.checkpoint_size = workload.checkpoint_size;
+    return w;
+}
+
+// Apply one workload key; false if the key is not a workload parameter.
+// Numeric values that don't parse throw std::invalid_argument / std::out_of_range.
+inline bool apply_workload_key(WorkloadConfig& workload, std::map<int, PhaseConfig>& phase_map,
+                               const std::string& key, const std::string& value) {
+    // Check for phase-specific parameters (phase_N_*)
+    if (key.substr(0, 6) == "phase_") {
+        size_t underscore_pos = key.find('_', 6);
+        if (underscore_pos == std::string::npos) return false;
+        int phase_num = std::stoi(key.substr(6, underscore_pos - 6));
+        std::string param = key.substr(underscore_pos + 1);
+
+        // Initialize phase if needed
+        if (phase_map.find(phase_num) == phase_map.end()) {
+            phase_map[phase_num] = PhaseConfig();
+        }
+
+        if (param == "runtime") phase_map[phase_num].runtime = std::stoi(value);
+        else if (param == "block_size") phase_map[phase_num].block_size = value;
+        else if (param == "iodepth") phase_map[phase_num].iodepth = std::stoi(value);
+        else if (param == "pattern") phase_map[phase_num].pattern = value;
+        else if (param == "ioengine") phase_map[phase_num].ioengine = value;
+        else if (param == "numjobs") phase_map[phase_num].numjobs = std::stoi(value);
+        else if (param == "file_size") phase_map[phase_num].file_size = value;
+        else if (param == "rate_iops") phase_map[phase_num].rate_iops = std::stoi(value);
+        else if (param == "trace_speed") phase_map[phase_num].trace_speed = std::stod(value);
+        else if (param == "distribution") phase_map[phase_num].distribution = value;
+        else if (param == "arrival") phase_map[phase_num].arrival = value;
+        else if (!apply_writer_key(phase_map[phase_num].writer, param, value)) return false;
+    }
+    // Legacy single-phase parameters
+    else if (key == "description") workload.description = value;
+    else if (key == "file_size") workload.file_size = value;
+    else if (key == "block_size") workload.block_size = value;
+    else if (key == "runtime") workload.runtime = std::stoi(value);
+    else if (key == "numjobs") workload.numjobs = std::stoi(value);
+    else if (key == "iodepth") workload.iodepth = std::stoi(value);
+    else if (key == "pattern") workload.pattern = value;
+    else if (key == "ioengine") workload.ioengine = value;
+    else if (key == "rate_iops") workload.rate_iops = std::stoi(value);
+    else if (key == "role") workload.role = value;
+    else if (key == "replicas") workload.replicas = std::stoi(value);
+    else if (key == "trace_speed") workload.trace_speed = std::stod(value);
+    else if (key == "distribution") workload.distribution = value;
+    else if (key == "arrival") workload.arrival = value;
+    else if (key == "cpus") workload.cpus = value;
+    else if (key == "numa_node") workload.numa_node = std::stoi(value);
+    else if (key == "warmup_phases") workload.warmup_phases = std::stoi(value);
+    else if (key == "host") workload.host = value;
+    else return apply_writer_key(workload.writer, key, value);
+    return true;
+}
+
+// The single phase of a workload without phase_N_ keys; per-phase overrides stay unset
+inline PhaseConfig legacy_phase(const WorkloadConfig& config) {
+    PhaseConfig phase;
+    phase.runtime = config.runtime;
+    phase.block_size = config.block_size;
+    phase.iodepth = config.iodepth;
+    phase.pattern = config.pattern;
+    phase.ioengine = config.ioengine;
+    return phase;
+}
+
+// The phases a workload runs: its phase_N_ list, or one phase from the legacy keys
+inline std::vector<PhaseConfig> effective_phases(const WorkloadConfig& config) {
+    if (!config.phases.empty()) return config.phases;
+    return {legacy_phase(config)};
+}
+
+// Checks that need nothing but the config; engine-specific limits are checked by the engines
+inline bool validate_workload(const std::string& name, const WorkloadConfig& config, std::string& error) {
+    auto fail = [&](const std::string& message) {
+        error = "[" + name + "] " + message;
+        return false;
+    };
+    std::vector<PhaseConfig> phases = effective_phases(config);
+    for (size_t i = 0; i < phases.size(); i++) {
+        const PhaseConfig& p = phases[i];
+        std::string where = config.phases.empty() ? "" : "phase " + std::to_string(i + 1) + ": ";
+        std::string file_size = p.file_size.empty() ? config.file_size : p.file_size;
+        if (file_size.empty() || provision::parse_size(file_size) == 0) {
+            return fail(where + "file_size '" + file_size + "' is not a size like 1G");
+        }
+        if (p.pattern.empty()) return fail(where + "pattern is not set");
+        if (!is_trace_pattern(p.pattern) && provision::parse_size(p.block_size) == 0) {
+            return fail(where + "block_size '" + p.block_size + "' is not a size like 4k");
+        }
+        if (p.runtime <= 0) return fail(where + "runtime must be positive");
+        if (p.iodepth < 0 || p.numjobs < 0 || p.rate_iops < 0) {
+            return fail(where + "iodepth, numjobs and rate_iops cannot be negative");
+        }
+    }
+    if (config.numjobs < 0 || config.rate_iops < 0 || config.replicas < 0) {
+        return fail("numjobs, rate_iops and replicas cannot be negative");
+    }
+    if (config.warmup_phases < 0 || config.warmup_phases > static_cast<int>(config.phases.size())) {
+        return fail("warmup_phases must be between 0 and the number of phase_N_ phases");
+    }
+    if (!config.role.empty() && config.role != "tenant") return fail("unknown role '" + config.role + "'");
+    return true;
+}
+
+// A section's key/value pairs with sweep overrides substituted (or appended)
+inline std::vector<std::pair<std::string, std::string>> resolved_entries(const ConfigSection& section,
+                                                                         const sweep::Overrides& overrides) {
+    auto entries = section.entries;
+    auto it = overrides.find(section.name);
+    if (it == overrides.end()) return entries;
+    for (const auto& [key, value] : it->second) {
+        bool found = false;
+        for (auto& entry : entries) {
+            if (entry.first == key) {
+                entry.second = value;
+                found = true;
+            }
+        }
+        if (!found) entries.push_back({key, value});
+    }
+    return entries;
+}
+
+// Parse and validate every workload section; false with `error` naming the section on the first problem
+inline bool build_workloads(const std::vector<ConfigSection>& sections, const sweep::Overrides& overrides,
+                            Workloads& out, std::string& error) {
+    out.clear();
+    for (const auto& section : sections) {
+        WorkloadConfig workload;
+        std::map<int, PhaseConfig> phase_map; // Temporary storage for phases
+        for (const auto& [key, value] : resolved_entries(section, overrides)) {
+            bool known = false;
+            try {
+                known = apply_workload_key(workload, phase_map, key, value);
+            } catch (const std::exception&) {
+                error = "[" + section.name + "] " + key + " = " + value + ": not a number";
+                return false;
+            }
+            if (!known) {
+                error = "[" + section.name + "] " + key + ": unknown key";
+                return false;
+            }
+        }
+        // Convert phase_map to phases vector
+        for (const auto& [phase_num, phase_config] : phase_map) {
+            workload.phases.push_back(phase_config);
+        }
+        if (!validate_workload(section.name, workload, error)) return false;
+        out[section.name] = workload;
+    }
+    if (out.empty()) {
+        error = "no workload sections";
+        return false;
+    }
+    return true;
+}
+
+}  // namespace bench